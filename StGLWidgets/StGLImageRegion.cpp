@@ -18,6 +18,8 @@
 #include <StCore/StEvent.h>
 #include <StSlots/StAction.h>
 
+#include <algorithm>
+
 namespace {
 
     class ST_LOCAL StSwapLRParam : public StBoolParamNamed {
@@ -204,6 +206,20 @@ namespace {
     static const float THE_SPHERE_RADIUS     = -10.0f;
     static const float THE_PANORAMA_DEF_ZOOM = 0.45f;
 
+    static const int THE_TILES_UPLOAD_MAX = 8; //!< maximum number of tiles uploaded per frame
+
+    /**
+     * Tile request with priority.
+     */
+    struct StTileRequest {
+        StImageTileKey Key;
+        GLfloat        Distance; //!< distance to the view center
+
+        bool operator<(const StTileRequest& theOther) const {
+            return Distance < theOther.Distance;
+        }
+    };
+
 }
 
 StGLImageRegion::StGLImageRegion(StGLWidget* theParent,
@@ -250,6 +266,9 @@ StGLImageRegion::StGLImageRegion(StGLWidget* theParent,
     params.Gamma         = myProgram.params.gamma;
     params.Brightness    = myProgram.params.brightness;
     params.Saturation    = myProgram.params.saturation;
+    myTileProgram.params.gamma      = myProgram.params.gamma;
+    myTileProgram.params.brightness = myProgram.params.brightness;
+    myTileProgram.params.saturation = myProgram.params.saturation;
     params.SwapLR        = new StSwapLRParam(this);
     params.ViewMode      = new StViewModeParam(this);
     params.SeparationDX  = new StFloat32StereoParam(this, StFloat32StereoParam::StereoParamId_SepDX,  stCString("sepDX"));
@@ -392,9 +411,12 @@ StGLImageRegion::~StGLImageRegion() {
     // make sure GL objects are released within GL thread
     StGLContext& aCtx = getContext();
     myTextureQueue->getQTexture().release(aCtx);
+    myTextureQueue->stglReleasePbo(aCtx);
     myQuad.release(aCtx);
     myUVSphere.release(aCtx);
     myProgram.release(aCtx);
+    myTileProgram.release(aCtx);
+    myTileAtlas.release(aCtx);
 
     // simplify debugging - nullify pointer to this widget
     ((StSwapLRParam*        )params.SwapLR       .access())->invalidateWidget();
@@ -422,6 +444,37 @@ void StGLImageRegion::stglUpdate(const StPointD_t& thePointZo,
             params.stereoFile = aFileParams;
             onParamsChanged();
         }
+        stglUpdateTiles();
+    }
+}
+
+void StGLImageRegion::stglUpdateTiles() {
+    StGLContext& aCtx = getContext();
+    StHandle<StImageTiles> aTiles = myTextureQueue->getTiles();
+    if(!aTiles.isNull()
+    &&  aTiles->getSource() != params.stereoFile) {
+        aTiles.nullify(); // tiles of another image
+    }
+    if(aTiles != myTiles) {
+        myTiles = aTiles;
+        myTileAtlas.clear();
+        myTileRequests.clear();
+    }
+    myTileAtlas.nextFrame();
+    if(myTiles.isNull()) {
+        myTileAtlas.release(aCtx);
+        return;
+    }
+
+    myTiles->request(myTileRequests);
+    myTileRequests.clear();
+    if(!myTileAtlas.stglInit(aCtx)) {
+        return;
+    }
+
+    StImageTile aTile;
+    for(int aTileIter = 0; aTileIter < THE_TILES_UPLOAD_MAX && myTiles->pop(aTile); ++aTileIter) {
+        myTileAtlas.stglUpload(aCtx, aTile);
     }
 }
 
@@ -826,6 +879,12 @@ void StGLImageRegion::stglDrawView(unsigned int theView) {
 
             myProgram.getActiveProgram()->unuse(aCtx);
 
+            // draw full-resolution tiles over downscaled image
+            stglDrawTiles(aCtx, aLeftOrRight, anOrthoMat, aModelMat, aFrameRectPx,
+                          StGLVec2(aTextures.getPlane(0).getDataSize().x() * aTextureSize.x(),
+                                   aTextures.getPlane(0).getDataSize().y() * aTextureSize.y()),
+                          aColorScale, params.TextureFilter->getValue() == StGLImageProgram::FILTER_NEAREST);
+
             // restore changed parameters
             aParams->ScaleFactor = aScaleBack;
             aParams->PanCenter   = aPanBack;
@@ -905,6 +964,140 @@ void StGLImageRegion::stglDrawView(unsigned int theView) {
     aCtx.stglResizeViewport(aViewportBack);
 }
 
+void StGLImageRegion::stglDrawTiles(StGLContext&      theCtx,
+                                    const int         theView,
+                                    const StGLMatrix& theProjMat,
+                                    const StGLMatrix& theModelMat,
+                                    const StRectI_t&  theFrameRectPx,
+                                    const StGLVec2&   theTexSizePx,
+                                    const StGLVec3&   theColorScale,
+                                    const bool        theToUseNearest) {
+    if(myTiles.isNull()
+    || !myTiles->hasView(theView)
+    ||  myTileAtlas.getNbSlots() == 0) {
+        return;
+    }
+
+    // affine transformation of the image quad into normalized device coordinates
+    const StGLMatrix aMVP = StGLMatrix::multiply(theProjMat, theModelMat);
+    const GLfloat a00 = aMVP.getValue(0, 0), a01 = aMVP.getValue(0, 1), aTx = aMVP.getValue(0, 3);
+    const GLfloat a10 = aMVP.getValue(1, 0), a11 = aMVP.getValue(1, 1), aTy = aMVP.getValue(1, 3);
+    const GLfloat aDet = a00 * a11 - a01 * a10;
+    if(std::abs(aDet) < 1.e-7f) {
+        return;
+    }
+
+    // pick up pyramid level matching the on-screen image size
+    const int     aSizeX   = myTiles->getSizeX(theView);
+    const int     aSizeY   = myTiles->getSizeY(theView);
+    const GLfloat aHalfX   = 0.5f * GLfloat(theFrameRectPx.width());
+    const GLfloat aHalfY   = 0.5f * GLfloat(theFrameRectPx.height());
+    const GLfloat aScreenX = 2.0f * std::sqrt(a00 * a00 * aHalfX * aHalfX + a10 * a10 * aHalfY * aHalfY);
+    const GLfloat aScreenY = 2.0f * std::sqrt(a01 * a01 * aHalfX * aHalfX + a11 * a11 * aHalfY * aHalfY);
+    const GLfloat aRatio   = stMin(GLfloat(aSizeX) / aScreenX, GLfloat(aSizeY) / aScreenY);
+    int aLevel = aRatio > 1.0f ? int(std::log(aRatio) / std::log(2.0f) + 0.5f) : 0;
+
+    // visible part of the image (in texture coordinates)
+    GLfloat aMinU = 1.0f, aMaxU = 0.0f, aMinV = 1.0f, aMaxV = 0.0f;
+    for(int aCornerIter = 0; aCornerIter < 4; ++aCornerIter) {
+        const GLfloat aNdcX = (aCornerIter % 2 == 0 ? -1.0f : 1.0f) - aTx;
+        const GLfloat aNdcY = (aCornerIter / 2 == 0 ? -1.0f : 1.0f) - aTy;
+        const GLfloat anU   = 0.5f * (( a11 * aNdcX - a01 * aNdcY) / aDet + 1.0f);
+        const GLfloat aV    = 0.5f * (1.0f - (-a10 * aNdcX + a00 * aNdcY) / aDet);
+        aMinU = stMin(aMinU, anU);
+        aMaxU = stMax(aMaxU, anU);
+        aMinV = stMin(aMinV, aV);
+        aMaxV = stMax(aMaxV, aV);
+    }
+    aMinU = stMax(aMinU, 0.0f);
+    aMaxU = stMin(aMaxU, 1.0f);
+    aMinV = stMax(aMinV, 0.0f);
+    aMaxV = stMin(aMaxV, 1.0f);
+    if(aMinU >= aMaxU
+    || aMinV >= aMaxV) {
+        return;
+    }
+
+    // switch to coarser level when visible tiles do not fit into the atlas (half per view)
+    const int aTileSize = StImageTiles::TILE_SIZE;
+    int aLevelSizeX = 0, aLevelSizeY = 0, aColFrom = 0, aColTo = 0, aRowFrom = 0, aRowTo = 0;
+    for(;; ++aLevel) {
+        aLevelSizeX = myTiles->getLevelSizeX(theView, aLevel);
+        aLevelSizeY = myTiles->getLevelSizeY(theView, aLevel);
+        aColFrom = int(aMinU * GLfloat(aLevelSizeX)) / aTileSize;
+        aRowFrom = int(aMinV * GLfloat(aLevelSizeY)) / aTileSize;
+        aColTo   = stMin(int(aMaxU * GLfloat(aLevelSizeX)) / aTileSize, (aLevelSizeX - 1) / aTileSize);
+        aRowTo   = stMin(int(aMaxV * GLfloat(aLevelSizeY)) / aTileSize, (aLevelSizeY - 1) / aTileSize);
+        if((aColTo - aColFrom + 1) * (aRowTo - aRowFrom + 1) <= myTileAtlas.getNbSlots() / 2) {
+            break;
+        }
+    }
+
+    // downscaled image is good enough
+    if(GLfloat(aLevelSizeX) < 1.1f * theTexSizePx.x()
+    && GLfloat(aLevelSizeY) < 1.1f * theTexSizePx.y()) {
+        return;
+    }
+
+    myTileProgram.setColorScale(theColorScale);
+    if(!myTileProgram.init(theCtx, StImage::ImgColor_RGB, StImage::ImgScale_Full, StGLImageProgram::FragGetColor_Normal)) {
+        return;
+    }
+
+    StGLTexture&  anAtlas     = myTileAtlas.changeTexture();
+    const GLfloat anAtlasSize = GLfloat(anAtlas.getSizeX());
+    anAtlas.setMinMagFilter(theCtx, theToUseNearest ? GL_NEAREST : GL_LINEAR);
+    anAtlas.bind(theCtx);
+    myTileProgram.getActiveProgram()->use(theCtx);
+    myTileProgram.setTextureSizePx    (theCtx, StGLVec2(anAtlasSize, anAtlasSize));
+    myTileProgram.setTextureUVDataSize(theCtx, StGLVec4(0.0f, 0.0f, 0.0f, 0.0f));
+    myTileProgram.getActiveProgram()->setProjMat(theCtx, theProjMat);
+
+    const GLfloat aCenterCol = 0.5f * (aMinU + aMaxU) * GLfloat(aLevelSizeX) / GLfloat(aTileSize) - 0.5f;
+    const GLfloat aCenterRow = 0.5f * (aMinV + aMaxV) * GLfloat(aLevelSizeY) / GLfloat(aTileSize) - 0.5f;
+    std::vector<StTileRequest> aMissed;
+    StGLVec4 aTexData;
+    for(int aRow = aRowFrom; aRow <= aRowTo; ++aRow) {
+        for(int aCol = aColFrom; aCol <= aColTo; ++aCol) {
+            const StImageTileKey aKey(theView, aLevel, aCol, aRow);
+            if(!myTileAtlas.find(aKey, aTexData)) {
+                StTileRequest aRequest;
+                aRequest.Key      = aKey;
+                aRequest.Distance = (GLfloat(aCol) - aCenterCol) * (GLfloat(aCol) - aCenterCol)
+                                  + (GLfloat(aRow) - aCenterRow) * (GLfloat(aRow) - aCenterRow);
+                aMissed.push_back(aRequest);
+                continue;
+            }
+
+            // tile rectangle within the image quad
+            const int aLeft   = aCol * aTileSize;
+            const int aTop    = aRow * aTileSize;
+            const int aRight  = stMin(aLeft + aTileSize, aLevelSizeX);
+            const int aBottom = stMin(aTop  + aTileSize, aLevelSizeY);
+            const GLfloat aQuadL = -1.0f + 2.0f * GLfloat(aLeft << aLevel) / GLfloat(aSizeX);
+            const GLfloat aQuadR = -1.0f + 2.0f * GLfloat(stMin(aRight << aLevel, aSizeX)) / GLfloat(aSizeX);
+            const GLfloat aQuadT =  1.0f - 2.0f * GLfloat(aTop << aLevel) / GLfloat(aSizeY);
+            const GLfloat aQuadB =  1.0f - 2.0f * GLfloat(stMin(aBottom << aLevel, aSizeY)) / GLfloat(aSizeY);
+
+            StGLMatrix aTileMat = theModelMat;
+            aTileMat.translate(StGLVec3(0.5f * (aQuadL + aQuadR), 0.5f * (aQuadT + aQuadB), 0.0f));
+            aTileMat.scale(0.5f * (aQuadR - aQuadL), 0.5f * (aQuadT - aQuadB), 1.0f);
+            myTileProgram.setTextureMainDataSize(theCtx, aTexData);
+            myTileProgram.getActiveProgram()->setModelMat(theCtx, aTileMat);
+            myQuad.draw(theCtx, *myTileProgram.getActiveProgram());
+        }
+    }
+
+    myTileProgram.getActiveProgram()->unuse(theCtx);
+    anAtlas.unbind(theCtx);
+
+    // request missed tiles starting from the view center
+    std::sort(aMissed.begin(), aMissed.end());
+    for(std::vector<StTileRequest>::const_iterator aReqIter = aMissed.begin(); aReqIter != aMissed.end(); ++aReqIter) {
+        myTileRequests.push_back(aReqIter->Key);
+    }
+}
+
 void StGLImageRegion::doRightUnclick(const StPointD_t& theCursorZo) {
     StHandle<StStereoParams> aParams = getSource();
     if(!myIsInitialized || aParams.isNull()
@@ -1,6 +1,6 @@
 /**
  * StGLWidgets, small C++ toolkit for writing GUI using OpenGL.
- * Copyright © 2009-2016 Kirill Gavrilov <kirill@sview.ru>
+ * Copyright © 2009-2017 Kirill Gavrilov <kirill@sview.ru>
  *
  * Distributed under the Boost Software License, Version 1.0.
  * See accompanying file license-boost.txt or copy at
@@ -95,6 +95,88 @@ class StGLSeekBar::StProgramSB : public StGLProgram {
 
 };
 
+class StGLSeekBar::StPreviewProgram : public StGLProgram {
+
+        public:
+
+    StPreviewProgram() : StGLProgram("StGLSeekBarPreview") {}
+
+    StGLVarLocation getVVertexLoc()   const { return StGLVarLocation(0); }
+    StGLVarLocation getVTexCoordLoc() const { return StGLVarLocation(1); }
+
+    void setProjMat(StGLContext&      theCtx,
+                    const StGLMatrix& theProjMat) {
+        theCtx.core20fwd->glUniformMatrix4fv(uniProjMatLoc, 1, GL_FALSE, theProjMat);
+    }
+
+    using StGLProgram::use;
+    void use(StGLContext&  theCtx,
+             const GLfloat theOpacityValue,
+             const GLfloat theDispX) {
+        StGLProgram::use(theCtx);
+        theCtx.core20fwd->glUniform1f(uniOpacityLoc, theOpacityValue);
+        theCtx.core20fwd->glUniform4fv(uniDispLoc, 1, StGLVec4(theDispX, 0.0f, 0.0f, 0.0f));
+    }
+
+    virtual bool init(StGLContext& theCtx) ST_ATTR_OVERRIDE {
+        const char VERTEX_SHADER[] =
+           "uniform mat4 uProjMat;\n"
+           "uniform vec4 uDisp;\n"
+           "attribute vec4 vVertex;\n"
+           "attribute vec2 vTexCoord;\n"
+           "varying   vec2 fTexCoord;\n"
+           "void main(void) {\n"
+           "    fTexCoord = vTexCoord;\n"
+           "    gl_Position = uProjMat * (vVertex + uDisp);\n"
+           "}\n";
+
+        const char FRAGMENT_SHADER[] =
+           "uniform sampler2D uTexture;\n"
+           "uniform float     uOpacity;\n"
+           "varying vec2      fTexCoord;\n"
+           "void main(void) {\n"
+           "    gl_FragColor = vec4(texture2D(uTexture, fTexCoord).rgb, uOpacity);\n"
+           "}\n";
+
+        StGLVertexShader aVertexShader(StGLProgram::getTitle());
+        StGLAutoRelease aTmp1(theCtx, aVertexShader);
+        aVertexShader.init(theCtx, VERTEX_SHADER);
+
+        StGLFragmentShader aFragmentShader(StGLProgram::getTitle());
+        StGLAutoRelease aTmp2(theCtx, aFragmentShader);
+        aFragmentShader.init(theCtx, FRAGMENT_SHADER);
+        if(!StGLProgram::create(theCtx)
+           .attachShader(theCtx, aVertexShader)
+           .attachShader(theCtx, aFragmentShader)
+           .bindAttribLocation(theCtx, "vVertex",   getVVertexLoc())
+           .bindAttribLocation(theCtx, "vTexCoord", getVTexCoordLoc())
+           .link(theCtx)) {
+            return false;
+        }
+
+        StGLVarLocation uniTextureLoc = StGLProgram::getUniformLocation(theCtx, "uTexture");
+        if(uniTextureLoc.isValid()) {
+            StGLProgram::use(theCtx);
+            theCtx.core20fwd->glUniform1i(uniTextureLoc, StGLProgram::TEXTURE_SAMPLE_0);
+            StGLProgram::unuse(theCtx);
+        }
+
+        uniProjMatLoc = StGLProgram::getUniformLocation(theCtx, "uProjMat");
+        uniDispLoc    = StGLProgram::getUniformLocation(theCtx, "uDisp");
+        uniOpacityLoc = StGLProgram::getUniformLocation(theCtx, "uOpacity");
+        return uniProjMatLoc.isValid()
+            && uniTextureLoc.isValid()
+            && uniOpacityLoc.isValid();
+    }
+
+        private:
+
+    StGLVarLocation uniProjMatLoc;
+    StGLVarLocation uniDispLoc;
+    StGLVarLocation uniOpacityLoc;
+
+};
+
 StGLSeekBar::StGLSeekBar(StGLWidget* theParent,
                          int theTop,
                          int theMargin,
@@ -106,7 +188,9 @@ StGLSeekBar::StGLSeekBar(StGLWidget* theParent,
   myProgress(0.0f),
   myProgressPx(0),
   myClickPos(-1),
-  myMoveTolerPx(0) {
+  myMoveTolerPx(0),
+  myPreviewProgram(new StPreviewProgram()),
+  myPreviewPos(-1.0) {
     StGLWidget::signals.onMouseClick  .connect(this, &StGLSeekBar::doMouseClick);
     StGLWidget::signals.onMouseUnclick.connect(this, &StGLSeekBar::doMouseUnclick);
     myMargins.top    = theMargin;
@@ -118,8 +202,20 @@ StGLSeekBar::~StGLSeekBar() {
     if(!myProgram.isNull()) {
         myProgram->release(aCtx);
     }
+    if(!myPreviewProgram.isNull()) {
+        myPreviewProgram->release(aCtx);
+    }
     myVertices.release(aCtx);
     myColors.release(aCtx);
+    myPreviewVertices.release(aCtx);
+    myPreviewTCoords.release(aCtx);
+    myPreviewTexture.release(aCtx);
+}
+
+void StGLSeekBar::setPreview(const StHandle<StImagePlane>& theImage,
+                             const StRectI_t&              theCell) {
+    myPreviewImage = theImage;
+    myPreviewCell  = theCell;
 }
 
 void StGLSeekBar::stglResize() {
@@ -134,6 +230,12 @@ void StGLSeekBar::stglResize() {
         myProgram->setProjMat(aCtx, getRoot()->getScreenProjection());
         myProgram->unuse(aCtx);
     }
+    if(!myPreviewProgram.isNull()
+    &&  myPreviewProgram->isValid()) {
+        myPreviewProgram->use(aCtx);
+        myPreviewProgram->setProjMat(aCtx, getRoot()->getScreenProjection());
+        myPreviewProgram->unuse(aCtx);
+    }
 }
 
 void StGLSeekBar::stglUpdateVertices() {
@@ -190,6 +292,14 @@ bool StGLSeekBar::stglInit() {
 
     stglUpdateVertices();
 
+    // preview is optional
+    StArray<StGLVec2> aDummyVert(4);
+    myPreviewVertices.init(aCtx, aDummyVert);
+    myPreviewTCoords.init(aCtx, aDummyVert);
+    if(!myPreviewProgram->init(aCtx)) {
+        myPreviewProgram->release(aCtx);
+    }
+
     return myProgram->init(aCtx)
         && StGLWidget::stglInit();
 }
@@ -221,14 +331,84 @@ void StGLSeekBar::stglDraw(unsigned int theView) {
     myVertices.unBindVertexAttrib(aCtx, myProgram->getVVertexLoc());
 
     myProgram->unuse(aCtx);
+
+    if(myPreviewPos >= 0.0
+    && !myPreviewImage.isNull()) {
+        stglDrawPreview(aCtx);
+    }
     aCtx.core20fwd->glDisable(GL_BLEND);
 
     StGLWidget::stglDraw(theView);
 }
 
+void StGLSeekBar::stglDrawPreview(StGLContext& theCtx) {
+    if(!myPreviewProgram->isValid()) {
+        return;
+    }
+
+    // upload the image only when it has been changed
+    if(myPreviewTextureImage != myPreviewImage) {
+        myPreviewTextureImage = myPreviewImage;
+        if(!myPreviewTexture.init(theCtx, *myPreviewImage)) {
+            myPreviewTexture.release(theCtx);
+        }
+    }
+    if(!myPreviewTexture.isValid()
+    ||  myPreviewCell.width()  <= 0
+    ||  myPreviewCell.height() <= 0) {
+        return;
+    }
+
+    // place the preview above the bar, centered at cursor
+    const StRectI_t aBarRectPx = getRectPxAbsolute();
+    const int aSizeX   = myRoot->scale(myPreviewCell.width());
+    const int aSizeY   = myRoot->scale(myPreviewCell.height());
+    const int aCursorX = aBarRectPx.left() + myMargins.left
+                       + int(myPreviewPos * double(aBarRectPx.width() - myMargins.left - myMargins.right));
+    StRectI_t aRectPx;
+    aRectPx.bottom() = aBarRectPx.top() + myMargins.top - myRoot->scale(4);
+    aRectPx.top()    = aRectPx.bottom() - aSizeY;
+    aRectPx.left()   = stClamp(aCursorX - aSizeX / 2, aBarRectPx.left(), stMax(aBarRectPx.right() - aSizeX, aBarRectPx.left()));
+    aRectPx.right()  = aRectPx.left() + aSizeX;
+
+    StArray<StGLVec2> aVertices(4);
+    myRoot->getRectGl(aRectPx, aVertices);
+    myPreviewVertices.init(theCtx, aVertices);
+
+    const GLfloat aTexSizeX = GLfloat(myPreviewTexture.getSizeX());
+    const GLfloat aTexSizeY = GLfloat(myPreviewTexture.getSizeY());
+    const GLfloat aLeft   = GLfloat(myPreviewCell.left())   / aTexSizeX;
+    const GLfloat aRight  = GLfloat(myPreviewCell.right())  / aTexSizeX;
+    const GLfloat aTop    = GLfloat(myPreviewCell.top())    / aTexSizeY;
+    const GLfloat aBottom = GLfloat(myPreviewCell.bottom()) / aTexSizeY;
+    StArray<StGLVec2> aTexCoords(4);
+    aTexCoords[0] = StGLVec2(aRight, aTop);
+    aTexCoords[1] = StGLVec2(aRight, aBottom);
+    aTexCoords[2] = StGLVec2(aLeft,  aTop);
+    aTexCoords[3] = StGLVec2(aLeft,  aBottom);
+    myPreviewTCoords.init(theCtx, aTexCoords);
+
+    myPreviewTexture.bind(theCtx);
+    myPreviewProgram->use(theCtx, myOpacity, myRoot->getScreenDispX());
+
+    myPreviewVertices.bindVertexAttrib(theCtx, myPreviewProgram->getVVertexLoc());
+    myPreviewTCoords .bindVertexAttrib(theCtx, myPreviewProgram->getVTexCoordLoc());
+
+    theCtx.core20fwd->glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    myPreviewTCoords .unBindVertexAttrib(theCtx, myPreviewProgram->getVTexCoordLoc());
+    myPreviewVertices.unBindVertexAttrib(theCtx, myPreviewProgram->getVVertexLoc());
+
+    myPreviewProgram->unuse(theCtx);
+    myPreviewTexture.unbind(theCtx);
+}
+
 void StGLSeekBar::stglUpdate(const StPointD_t& theCursor,
                              bool theIsPreciseInput) {
     StGLWidget::stglUpdate(theCursor, theIsPreciseInput);
+    myPreviewPos = isClicked(ST_MOUSE_LEFT) || isVisibleAndPointIn(theCursor)
+                 ? stMin(stMax(getPointInEx(theCursor), 0.0), 1.0)
+                 : -1.0;
     if(!isClicked(ST_MOUSE_LEFT)) {
         return;
     }
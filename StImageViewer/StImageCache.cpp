@@ -0,0 +1,191 @@
+/**
+ * Copyright © 2017 Kirill Gavrilov <kirill@sview.ru>
+ *
+ * StImageViewer program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * StImageViewer program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StImageCache.h"
+
+namespace {
+
+    inline size_t imageSizeBytes(const StHandle<StImageFile>& theImage) {
+        if(theImage.isNull()) {
+            return 0;
+        }
+
+        size_t aSize = 0;
+        for(size_t aPlaneId = 0; aPlaneId < 4; ++aPlaneId) {
+            aSize += theImage->getPlane(aPlaneId).getSizeBytes();
+        }
+        return aSize;
+    }
+
+}
+
+size_t StDecodedImage::getSizeBytes() const {
+    return imageSizeBytes(ImageL) + imageSizeBytes(ImageR);
+}
+
+StImageCache::StImageCache(const size_t theBudget)
+: myDecodedEvent(false),
+  myBudget(theBudget),
+  mySizeBytes(0),
+  myNbHits(0),
+  myNbMisses(0),
+  myNbPrefetched(0) {
+    //
+}
+
+StImageCache::~StImageCache() {
+    //
+}
+
+void StImageCache::setBudget(const size_t theBudget) {
+    StMutexAuto aLock(myMutex);
+    myBudget = theBudget;
+    if(myBudget == 0) {
+        myEntries.clear();
+        mySizeBytes = 0;
+        return;
+    }
+    evict();
+}
+
+bool StImageCache::isPending(const StString& theKey) const {
+    for(size_t anIter = 0; anIter < myPending.size(); ++anIter) {
+        if(myPending[anIter] == theKey) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void StImageCache::unsetPending(const StString& theKey) {
+    for(size_t anIter = 0; anIter < myPending.size(); ++anIter) {
+        if(myPending[anIter] == theKey) {
+            myPending.remove(anIter);
+            return;
+        }
+    }
+}
+
+StHandle<StDecodedImage> StImageCache::acquire(const StString& theKey) {
+    for(;;) {
+        myMutex.lock();
+        myPinnedKey = theKey;
+        for(std::list<Entry>::iterator anIter = myEntries.begin(); anIter != myEntries.end(); ++anIter) {
+            if(anIter->Key == theKey) {
+                // move to the head of the list
+                myEntries.splice(myEntries.begin(), myEntries, anIter);
+                StHandle<StDecodedImage> anImage = myEntries.front().Image;
+                ++myNbHits;
+                myMutex.unlock();
+                return anImage;
+            }
+        }
+
+        if(!isPending(theKey)) {
+            myPending.add(theKey);
+            ++myNbMisses;
+            myMutex.unlock();
+            return StHandle<StDecodedImage>();
+        }
+
+        // the image is being decoded by another thread
+        myDecodedEvent.reset();
+        myMutex.unlock();
+        myDecodedEvent.wait(100);
+    }
+}
+
+bool StImageCache::tryAcquire(const StString& theKey) {
+    StMutexAuto aLock(myMutex);
+    if(myBudget == 0
+    || isPending(theKey)) {
+        return false;
+    }
+    for(std::list<Entry>::const_iterator anIter = myEntries.begin(); anIter != myEntries.end(); ++anIter) {
+        if(anIter->Key == theKey) {
+            return false;
+        }
+    }
+
+    myPending.add(theKey);
+    return true;
+}
+
+void StImageCache::release(const StString&                 theKey,
+                           const StHandle<StDecodedImage>& theImage,
+                           const bool                      theIsPrefetch) {
+    myMutex.lock();
+    unsetPending(theKey);
+    if(!theImage.isNull()
+    && myBudget != 0) {
+        Entry anEntry;
+        anEntry.Key       = theKey;
+        anEntry.Image     = theImage;
+        anEntry.SizeBytes = theImage->getSizeBytes();
+        if(theIsPrefetch) {
+            myEntries.push_back(anEntry);
+            ++myNbPrefetched;
+        } else {
+            myEntries.push_front(anEntry);
+        }
+        mySizeBytes += anEntry.SizeBytes;
+        evict();
+    }
+    myMutex.unlock();
+    myDecodedEvent.set();
+}
+
+void StImageCache::evict() {
+    for(std::list<Entry>::iterator anIter = myEntries.end(); mySizeBytes > myBudget && anIter != myEntries.begin();) {
+        --anIter;
+        if(anIter->Key == myPinnedKey) {
+            continue;
+        }
+        mySizeBytes -= anIter->SizeBytes;
+        anIter = myEntries.erase(anIter);
+    }
+}
+
+void StImageCache::remove(const StString& theKey) {
+    StMutexAuto aLock(myMutex);
+    for(std::list<Entry>::iterator anIter = myEntries.begin(); anIter != myEntries.end(); ++anIter) {
+        if(anIter->Key == theKey) {
+            mySizeBytes -= anIter->SizeBytes;
+            myEntries.erase(anIter);
+            return;
+        }
+    }
+}
+
+void StImageCache::clear() {
+    StMutexAuto aLock(myMutex);
+    myEntries.clear();
+    mySizeBytes = 0;
+}
+
+StImageCache::Counters StImageCache::getCounters() const {
+    StMutexAuto aLock(myMutex);
+    Counters aCounters;
+    aCounters.Hits       = myNbHits;
+    aCounters.Misses     = myNbMisses;
+    aCounters.Prefetched = myNbPrefetched;
+    aCounters.Entries    = myEntries.size();
+    aCounters.SizeBytes  = mySizeBytes;
+    aCounters.Budget     = myBudget;
+    return aCounters;
+}
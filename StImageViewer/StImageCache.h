@@ -0,0 +1,184 @@
+/**
+ * Copyright © 2017 Kirill Gavrilov <kirill@sview.ru>
+ *
+ * StImageViewer program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * StImageViewer program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __StImageCache_h_
+#define __StImageCache_h_
+
+#include "StImageLoader.h"
+
+#include <StThreads/StCondition.h>
+#include <StThreads/StMutex.h>
+
+#include <list>
+
+/**
+ * Decoded image file(s) with properties not depending on viewing parameters.
+ */
+struct StDecodedImage {
+
+    StHandle<StImageFile> ImageL;            //!< left  (or single) image
+    StHandle<StImageFile> ImageR;            //!< right image (optional)
+    StHandle<StImageInfo> Info;              //!< image info template (without dimensions and load time)
+    double                LoadTimeMSec;      //!< decoding time
+    GLfloat               ZRotateZero;       //!< rotation angle from metadata
+    GLint                 SeparationNeutral; //!< parallax from metadata in pixels
+    bool                  HasZRotateZero;    //!< ZRotateZero has been read from metadata
+    bool                  HasSeparation;     //!< SeparationNeutral has been read from metadata
+
+    StDecodedImage() : LoadTimeMSec(0.0), ZRotateZero(0.0f), SeparationNeutral(0), HasZRotateZero(false), HasSeparation(false) {}
+
+    /**
+     * @return memory occupied by decoded image planes
+     */
+    ST_LOCAL size_t getSizeBytes() const;
+
+};
+
+/**
+ * Thread-safe LRU cache of decoded images limited by memory budget.
+ * Each key can be decoded only by a single thread at once - other threads requesting the same key
+ * will wait for decoding results instead of decoding the same file twice.
+ */
+class StImageCache {
+
+        public:
+
+    /**
+     * Cache statistics.
+     */
+    struct Counters {
+        size_t Hits;       //!< number of acquire() calls satisfied from the cache
+        size_t Misses;     //!< number of acquire() calls which required decoding
+        size_t Prefetched; //!< number of images decoded in advance
+        size_t Entries;    //!< number of cached images
+        size_t SizeBytes;  //!< memory occupied by cached images
+        size_t Budget;     //!< memory budget
+    };
+
+        public:
+
+    /**
+     * Main constructor.
+     * @param theBudget memory budget in bytes, 0 disables caching
+     */
+    ST_LOCAL StImageCache(const size_t theBudget);
+
+    /**
+     * Destructor.
+     */
+    ST_LOCAL ~StImageCache();
+
+    /**
+     * Change memory budget (evict entries if needed).
+     */
+    ST_LOCAL void setBudget(const size_t theBudget);
+
+    /**
+     * @return true if memory budget is not zero
+     */
+    ST_LOCAL bool isEnabled() const {
+        return myBudget != 0;
+    }
+
+    /**
+     * Find decoded image or reserve the key for decoding by caller.
+     * When the key is being decoded by another thread, the method waits for results.
+     * The key is pinned as currently displayed image, so that it is never evicted by prefetched images.
+     * @param theKey the key
+     * @return decoded image or NULL if caller should decode the image and call release()
+     */
+    ST_LOCAL StHandle<StDecodedImage> acquire(const StString& theKey);
+
+    /**
+     * Reserve the key for decoding by caller without blocking.
+     * @param theKey the key
+     * @return true if image is neither cached nor being decoded, so that caller should decode it and call release()
+     */
+    ST_LOCAL bool tryAcquire(const StString& theKey);
+
+    /**
+     * Put decoding results into the cache and release the key reserved by acquire() or tryAcquire().
+     * Prefetched images are inserted as least recently used, so that they are evicted first.
+     * @param theKey        the key
+     * @param theImage      decoded image, NULL on decoding failure
+     * @param theIsPrefetch flag indicating image decoded in advance
+     */
+    ST_LOCAL void release(const StString&                 theKey,
+                          const StHandle<StDecodedImage>& theImage,
+                          const bool                      theIsPrefetch);
+
+    /**
+     * Remove image from the cache.
+     */
+    ST_LOCAL void remove(const StString& theKey);
+
+    /**
+     * Remove all images from the cache.
+     */
+    ST_LOCAL void clear();
+
+    /**
+     * @return cache statistics
+     */
+    ST_LOCAL Counters getCounters() const;
+
+        private:
+
+    struct Entry {
+        StString                 Key;
+        StHandle<StDecodedImage> Image;
+        size_t                   SizeBytes;
+    };
+
+    /**
+     * Find the key within pending list.
+     */
+    ST_LOCAL bool isPending(const StString& theKey) const;
+
+    /**
+     * Remove the key from pending list.
+     */
+    ST_LOCAL void unsetPending(const StString& theKey);
+
+    /**
+     * Remove least recently used entries to fit memory budget.
+     * The pinned entry is always preserved.
+     */
+    ST_LOCAL void evict();
+
+        private:
+
+    mutable StMutex        myMutex;        //!< lock for all fields
+    std::list<Entry>       myEntries;      //!< cached images, most recently used first
+    StArrayList<StString>  myPending;      //!< keys being decoded right now
+    StString               myPinnedKey;    //!< key of currently displayed image, see acquire()
+    StCondition            myDecodedEvent; //!< event signaled when pending key has been released
+    size_t                 myBudget;       //!< memory budget
+    size_t                 mySizeBytes;    //!< memory occupied by cached images
+    size_t                 myNbHits;       //!< hits counter
+    size_t                 myNbMisses;     //!< misses counter
+    size_t                 myNbPrefetched; //!< prefetched images counter
+
+        private: //! @name no copies, please
+
+    StImageCache(const StImageCache& theCopy);
+    const StImageCache& operator=(const StImageCache& theCopy);
+
+};
+
+#endif // __StImageCache_h_
@@ -17,11 +17,13 @@
  */
 
 #include "StImageLoader.h"
+#include "StImageCache.h"
 #include "StImagePluginInfo.h"
 #include "StImageViewerStrings.h"
 #include "StImageViewerGUI.h"
 
 #include <StAV/StAVImage.h>
+#include <StImage/StDevILImage.h>
 #include <StThreads/StThread.h>
 
 using namespace StImageViewerStrings;
@@ -44,6 +46,65 @@ namespace {
         return SV_THREAD_RETURN 0;
     }
 
+    static SV_THREAD_FUNCTION prefetchThreadFunction(void* theImageLoader) {
+        StImageLoader* anImageLoader = (StImageLoader* )theImageLoader;
+        anImageLoader->prefetchLoop();
+        return SV_THREAD_RETURN 0;
+    }
+
+    static SV_THREAD_FUNCTION decodeThreadFunction(void* theImageLoader) {
+        StImageLoader* anImageLoader = (StImageLoader* )theImageLoader;
+        anImageLoader->decodeLoop();
+        return SV_THREAD_RETURN 0;
+    }
+
+    /**
+     * Memory budget for decoded images cache.
+     */
+    static const size_t THE_CACHE_BUDGET = 256 * 1024 * 1024;
+
+    /**
+     * Number of playlist items to prefetch in each direction.
+     */
+    static const size_t THE_PREFETCH_RADIUS = 2;
+
+    /**
+     * Memory budget for full-resolution image kept for displaying tiles;
+     * larger images are released after downscaling as usual.
+     */
+    static const size_t THE_TILES_SOURCE_BUDGET = 512 * 1024 * 1024;
+
+    /**
+     * @return memory occupied by image planes
+     */
+    static size_t imageSizeBytes(const StImage& theImage) {
+        size_t aSize = 0;
+        for(size_t aPlaneId = 0; aPlaneId < 4; ++aPlaneId) {
+            aSize += theImage.getPlane(aPlaneId).getSizeBytes();
+        }
+        return aSize;
+    }
+
+    /**
+     * @return true if file node (or any of its sub-nodes) is opened through content protocol
+     */
+    static bool isContentProtocolNode(const StHandle<StFileNode>& theNode) {
+        if(StFileNode::isContentProtocolPath(theNode->getPath())) {
+            return true;
+        }
+        for(size_t aSubIter = 0; aSubIter < theNode->size(); ++aSubIter) {
+            if(StFileNode::isContentProtocolPath(theNode->getValue(aSubIter)->getPath())) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Minimal number of pixels in JPEG image without thumbnail to decode a preview at reduced resolution.
+     */
+    static const size_t THE_PREVIEW_MIN_PIXELS = 8 * 1000 * 1000;
+
 }
 
 StImageLoader::StImageLoader(const StImageFile::ImageClass      theImageLib,
@@ -62,24 +123,190 @@ StImageLoader::StImageLoader(const StImageFile::ImageClass      theImageLib,
   myMaxTexDim(theMaxTexDim),
   myTextureQueue(theTextureQueue),
   myMsgQueue(theMsgQueue),
+  myCache(new StImageCache(THE_CACHE_BUDGET)),
+  myPrefetchEvent(false),
+  myDecodeEvent(false),
+  myDecodeDone(false),
+  myDecodeJob(NULL),
   myImageLib(theImageLib),
   myAction(Action_NONE),
   myToStickPano360(false),
+  myToTileImages(false),
   myToFlipCubeZ6x1(false),
   myToFlipCubeZ3x2(false) {
       myPlayList->setExtensions(myMimeList.getExtensionsList());
       myThread = new StThread(threadFunction, (void* )this, "StImageLoader");
+      myDecodeThread = new StThread(decodeThreadFunction, (void* )this, "StImageDecodeR");
+
+      // keep one core for the main loading thread
+      const int aNbPrefetch = stMax(1, stMin(StThread::countLogicalProcessors() - 1, 2));
+      for(int aThreadIter = 0; aThreadIter < aNbPrefetch; ++aThreadIter) {
+          myPrefetchThreads.push_back(new StThread(prefetchThreadFunction, (void* )this, "StImagePrefetch"));
+      }
 }
 
 StImageLoader::~StImageLoader() {
     myAction = Action_Quit;
     myLoadNextEvent.set(); // stop the thread
+    myPrefetchEvent.set();
     myThread->wait();
     myThread.nullify();
+    myDecodeEvent.set(); // main loop is stopped, so that helper has no job
+    myDecodeThread->wait();
+    myDecodeThread.nullify();
+    for(size_t aThreadIter = 0; aThreadIter < myPrefetchThreads.size(); ++aThreadIter) {
+        myPrefetchThreads[aThreadIter]->wait();
+    }
+    myPrefetchThreads.clear();
+    myPrefetchQueue.clear();
+    myCache.nullify();
+}
+
+void StImageLoader::setImageLib(const StImageFile::ImageClass theImageLib) {
+    myImageLib = theImageLib;
+    myCache->clear();
+}
+
+void StImageLoader::setTileImages(bool theToTile) {
+    if(myToTileImages == theToTile) {
+        return;
+    }
+
+    // images decoded with reduced resolution are useless for tiles and vice versa
+    myToTileImages = theToTile;
+    myCache->clear();
 }
 
 void StImageLoader::setCompressMemory(const bool theToCompress) {
     myTextureQueue->setCompressMemory(theToCompress);
+    myCache->setBudget(theToCompress ? 0 : THE_CACHE_BUDGET);
+    if(theToCompress) {
+        myPrefetchLock.lock();
+        myPrefetchQueue.clear();
+        myPrefetchLock.unlock();
+    }
+}
+
+void StImageLoader::schedulePrefetch() {
+    std::vector< StHandle<StFileNode> > aNeighbours;
+    if(myCache->isEnabled()) {
+        myPlayList->getNeighbourFiles(THE_PREFETCH_RADIUS, aNeighbours);
+    }
+
+    // resource manager should be used only by the main loading thread, so that content:// files are not prefetched
+    for(size_t aNodeIter = 0; aNodeIter < aNeighbours.size();) {
+        if(isContentProtocolNode(aNeighbours[aNodeIter])) {
+            aNeighbours.erase(aNeighbours.begin() + aNodeIter);
+        } else {
+            ++aNodeIter;
+        }
+    }
+
+    myPrefetchLock.lock();
+    myPrefetchQueue.swap(aNeighbours);
+    if(!myPrefetchQueue.empty()) {
+        myPrefetchEvent.set();
+    }
+    myPrefetchLock.unlock();
+}
+
+void StImageLoader::prefetchLoop() {
+    for(;;) {
+        myPrefetchEvent.wait();
+        if(myAction == Action_Quit) {
+            return;
+        }
+
+        StHandle<StFileNode> aNode;
+        myPrefetchLock.lock();
+        if(myPrefetchQueue.empty()) {
+            myPrefetchEvent.reset();
+        } else {
+            aNode = myPrefetchQueue.front();
+            myPrefetchQueue.erase(myPrefetchQueue.begin());
+        }
+        myPrefetchLock.unlock();
+        if(aNode.isNull()) {
+            continue;
+        }
+
+        size_t aSizeHintX = 0, aSizeHintY = 0;
+        getSizeHint(aNode, aSizeHintX, aSizeHintY);
+        const StString aKey = cacheKey(aNode, aSizeHintX, aSizeHintY);
+        if(!myCache->tryAcquire(aKey)) {
+            continue;
+        }
+
+        StString anError;
+        StHandle<StDecodedImage> aDecoded = decodeImage(aNode, aSizeHintX, aSizeHintY, anError, false);
+        myCache->release(aKey, aDecoded, true);
+    }
+}
+
+/**
+ * Decoding job for the second view of stereo pair, performed in parallel to the first one.
+ * Each view uses its own decoder instance.
+ */
+struct StImageLoader::DecodeJob {
+
+    StHandle<StImageFile>  Image;     //!< decoder instance
+    StString               FilePath;  //!< file path
+    StImageFile::ImageType ImageType; //!< image type
+    uint8_t*               Data;      //!< data in memory (optional)
+    int                    DataSize;  //!< data size
+    bool                   IsLoaded;  //!< decoding result
+    bool                   IsAsync;   //!< job has been passed to helper thread
+
+    DecodeJob(const StHandle<StImageFile>& theImage,
+              const StString&              theFilePath,
+              StImageFile::ImageType       theImageType,
+              uint8_t*                     theData,
+              int                          theDataSize)
+    : Image(theImage), FilePath(theFilePath), ImageType(theImageType), Data(theData), DataSize(theDataSize), IsLoaded(false), IsAsync(false) {}
+
+    void perform() {
+        IsLoaded = Image->load(FilePath, ImageType, Data, DataSize);
+    }
+
+};
+
+void StImageLoader::decodeLoop() {
+    for(;;) {
+        myDecodeEvent.wait();
+        myDecodeEvent.reset();
+
+        // the job should be finished even on quit, as the main loop waits for it
+        DecodeJob* aJob = myDecodeJob;
+        if(aJob != NULL) {
+            aJob->perform();
+            myDecodeJob = NULL;
+            myDecodeDone.set();
+        } else if(myAction == Action_Quit) {
+            return;
+        }
+    }
+}
+
+void StImageLoader::startDecodeJob(DecodeJob& theJob,
+                                   const bool theToUseHelper) {
+    // DevIL serializes decoding with global mutex - parallel decoding would give nothing
+    theJob.IsAsync = theToUseHelper
+                  && StHandle<StDevILImage>::downcast(theJob.Image).isNull();
+    if(!theJob.IsAsync) {
+        return;
+    }
+
+    myDecodeDone.reset();
+    myDecodeJob = &theJob;
+    myDecodeEvent.set();
+}
+
+void StImageLoader::waitDecodeJob(DecodeJob& theJob) {
+    if(theJob.IsAsync) {
+        myDecodeDone.wait();
+    } else {
+        theJob.perform();
+    }
 }
 
 void StImageLoader::processLoadFail(const StString& theErrorDesc) {
@@ -117,7 +344,8 @@ inline StHandle<StImage> scaledImage(StHandle<StImageFile>& theRef,
                                      const size_t           theMaxSizeY,
                                      StCubemap              theCubemap,
                                      const size_t*          theCubeCoeffs,
-                                     StPairRatio            thePairRatio) {
+                                     StPairRatio            thePairRatio,
+                                     const bool             theToRelease) {
     if(theRef->isNull()) {
         return theRef;
     }
@@ -165,7 +393,9 @@ inline StHandle<StImage> scaledImage(StHandle<StImageFile>& theRef,
             ST_ERROR_LOG("Scale failed!");
             return theRef;
         }
-        theRef->close();
+        if(theToRelease) {
+            theRef->close();
+        }
         return anImage;
     }
 
@@ -182,7 +412,9 @@ inline StHandle<StImage> scaledImage(StHandle<StImageFile>& theRef,
         ST_ERROR_LOG("Scale failed!");
         return theRef;
     }
-    theRef->close();
+    if(theToRelease) {
+        theRef->close();
+    }
     return anImage;
 }
 
@@ -201,24 +433,82 @@ inline StString formatSize(size_t theSizeX,
     return aText;
 }
 
-bool StImageLoader::loadImage(const StHandle<StFileNode>& theSource,
-                              StHandle<StStereoParams>&   theParams) {
+StString StImageLoader::cacheKey(const StHandle<StFileNode>& theSource,
+                                 const size_t                theSizeHintX,
+                                 const size_t                theSizeHintY) {
+    StString aKey = theSource->getPath();
+    for(size_t aSubIter = 0; aSubIter < theSource->size(); ++aSubIter) {
+        aKey += StString('\n') + theSource->getValue(aSubIter)->getPath();
+    }
+    aKey += StString('\n') + theSizeHintX + "x" + theSizeHintY;
+    return aKey;
+}
+
+void StImageLoader::getSizeHint(const StHandle<StFileNode>& theSource,
+                                size_t&                     theSizeX,
+                                size_t&                     theSizeY) const {
+    theSizeX = 0;
+    theSizeY = 0;
+    if(myToTileImages) {
+        // full-resolution image is needed for tiles
+        return;
+    }
+
+    // oversized images will be downscaled to fit texture limits anyway,
+    // so let decoder skip unused resolution (the final fractional step is done by scaledImage())
+    const StString aFilePath = theSource->getPath();
+    StFormat aFormatHint = myStFormatByUser;
+    if(aFormatHint == StFormat_AUTO
+    && StImageFile::guessImageType(aFilePath, theSource->getMIME()) == StImageFile::ST_TYPE_JPS) {
+        aFormatHint = StFormat_SideBySide_RL;
+    }
+    if(aFormatHint == StFormat_AUTO) {
+        const StString aFirstPath = theSource->size() >= 2 ? theSource->getValue(0)->getPath() : aFilePath;
+        StString aFolder, aTitleString;
+        StFileNode::getFolderAndFile(aFirstPath, aFolder, aTitleString);
+        bool isAnamorphByName = false;
+        aFormatHint = st::formatFromName(aTitleString, isAnamorphByName);
+    }
+
+    // the same limits as applied by loadImage() to the whole image
+    theSizeX = size_t(myMaxTexDim);
+    theSizeY = size_t(myMaxTexDim);
+    if(theSource->size() < 2) {
+        const StPairRatio aPairRatio = st::formatToPairRatio(aFormatHint);
+        if(aPairRatio == StPairRatio_HalfWidth) {
+            theSizeX *= 2;
+        } else if(aPairRatio == StPairRatio_HalfHeight) {
+            theSizeY *= 2;
+        }
+    }
+    if(myToStickPano360) {
+        // packed cubemap (6:1 or 3:2) might be detected only after decoding
+        theSizeX *= 6;
+        theSizeY *= 2;
+    }
+}
+
+StHandle<StDecodedImage> StImageLoader::decodeImage(const StHandle<StFileNode>& theSource,
+                                                    const size_t                theSizeHintX,
+                                                    const size_t                theSizeHintY,
+                                                    StString&                   theError,
+                                                    const bool                  theToUseHelper) {
     const StString               aFilePath = theSource->getPath();
     const StImageFile::ImageType anImgType = StImageFile::guessImageType(aFilePath, theSource->getMIME());
 
-    StHandle<StImageFile> anImageFileL = StImageFile::create(myImageLib, anImgType);
-    StHandle<StImageFile> anImageFileR = StImageFile::create(myImageLib, anImgType);
+    StHandle<StDecodedImage> aDecoded = new StDecodedImage();
+    StHandle<StImageFile>& anImageFileL = aDecoded->ImageL;
+    StHandle<StImageFile>& anImageFileR = aDecoded->ImageR;
+    anImageFileL = StImageFile::create(myImageLib, anImgType);
+    anImageFileR = StImageFile::create(myImageLib, anImgType);
     if(anImageFileL.isNull()
     || anImageFileR.isNull()) {
-        processLoadFail("No any image library was found!");
-        return false;
+        theError = "No any image library was found!";
+        return StHandle<StDecodedImage>();
     }
 
-    // clear active
-    myTextureQueue->clear();
-
     StHandle<StImageInfo> anImgInfo = new StImageInfo();
-    anImgInfo->Id        = theParams;
+    aDecoded->Info       = anImgInfo;
     anImgInfo->Path      = aFilePath;
     anImgInfo->ImageType = anImgType;
     anImgInfo->IsSavable = false;
@@ -236,8 +526,11 @@ bool StImageLoader::loadImage(const StHandle<StFileNode>& theSource,
         anImgInfo->Info.add(StArgument(tr(INFO_FILE_NAME), aTitleString));
     }
 
+    // size hint is part of the cache key - decoding parameters should not be re-evaluated here
+    anImageFileL->setSizeHint(theSizeHintX, theSizeHintY);
+    anImageFileR->setSizeHint(theSizeHintX, theSizeHintY);
+
     StTimer aLoadTimer(true);
-    StFormat  aSrcFormatCurr = myStFormatByUser;
     if(anImgType == StImageFile::ST_TYPE_MPO
     || anImgType == StImageFile::ST_TYPE_JPEG
     || anImgType == StImageFile::ST_TYPE_JPS) {
@@ -248,6 +541,7 @@ bool StImageLoader::loadImage(const StHandle<StFileNode>& theSource,
 
         // special procedure to divide MPO (Multi Picture Object)
         StJpegParser aParser;
+        aParser.setMappingAllowed(true);
         double anHParallax = 0.0; // parallax in percents
         const bool isParsed = aParser.readFile(aFilePath, aFileDescriptor);
 
@@ -296,15 +590,11 @@ bool StImageLoader::loadImage(const StHandle<StFileNode>& theSource,
                 anEntry.changeValue() = aTime;
             }
         }
-        if(myStFormatByUser == StFormat_AUTO
-        && aParser.getSrcFormat() != StFormat_AUTO) {
-            aSrcFormatCurr = aParser.getSrcFormat();
-        }
 
         //aParser.fillDictionary(anImgInfo->Info, true);
         if(!isParsed) {
-            processLoadFail(StString("Can not read the file \"") + aFilePath + '\"');
-            return false;
+            theError = StString("Can not read the file \"") + aFilePath + '\"';
+            return StHandle<StDecodedImage>();
         }
 
         anImgInfo->IsSavable = anImg2.isNull();
@@ -316,23 +606,35 @@ bool StImageLoader::loadImage(const StHandle<StFileNode>& theSource,
 
         // read image from memory
         const StJpegParser::Orient anOrient = anImg1->getOrientation();
-        theParams->setZRotateZero((GLfloat )StJpegParser::getRotationAngle(anOrient));
+        aDecoded->ZRotateZero    = (GLfloat )StJpegParser::getRotationAngle(anOrient);
+        aDecoded->HasZRotateZero = true;
         anImg1->getParallax(anHParallax);
-        if(!anImageFileL->load(aFilePath, StImageFile::ST_TYPE_JPEG,
-                               (uint8_t* )anImg1->Data, (int )anImg1->Length)
-        && !anImageFileL->load(aFilePath, StImageFile::ST_TYPE_JPEG,
-                               (uint8_t* )aParser.getBuffer(), (int )aParser.getSize())) {
-            processLoadFail(formatError(aFilePath, anImageFileL->getState()));
-            return false;
-        }
 
+        // decode the second view in parallel
+        DecodeJob aJobR(anImageFileR, aFilePath, StImageFile::ST_TYPE_JPEG, NULL, 0);
         if(!anImg2.isNull()) {
-            // read image from memory
             anImg2->getParallax(anHParallax); // in MPO parallax generally stored ONLY in second frame
-            if(!anImageFileR->load(aFilePath, StImageFile::ST_TYPE_JPEG,
-                                   (uint8_t* )anImg2->Data, (int )anImg2->Length)) {
-                processLoadFail(formatError(aFilePath, anImageFileR->getState()));
-                return false;
+            aJobR.Data     = (uint8_t* )anImg2->Data;
+            aJobR.DataSize = (int )anImg2->Length;
+            startDecodeJob(aJobR, theToUseHelper);
+        }
+
+        const bool isLoadedL = anImageFileL->load(aFilePath, StImageFile::ST_TYPE_JPEG,
+                                                  (uint8_t* )anImg1->Data, (int )anImg1->Length)
+                            || anImageFileL->load(aFilePath, StImageFile::ST_TYPE_JPEG,
+                                                  (uint8_t* )aParser.getBuffer(), (int )aParser.getSize());
+        if(!anImg2.isNull()) {
+            waitDecodeJob(aJobR);
+        }
+        if(!isLoadedL) {
+            theError = formatError(aFilePath, anImageFileL->getState());
+            return StHandle<StDecodedImage>();
+        }
+
+        if(!anImg2.isNull()) {
+            if(!aJobR.IsLoaded) {
+                theError = formatError(aFilePath, anImageFileR->getState());
+                return StHandle<StDecodedImage>();
             }
 
             // convert percents to pixels
@@ -341,7 +643,8 @@ bool StImageLoader::loadImage(const StHandle<StFileNode>& theSource,
                 StDictEntry& anEntry  = anImgInfo->Info.addChange("Exif.Fujifilm.Parallax");
                 anEntry.changeValue() = StString(anHParallax);
             }
-            theParams->setSeparationNeutral(aParallaxPx);
+            aDecoded->SeparationNeutral = aParallaxPx;
+            aDecoded->HasSeparation     = true;
         } else if(anImgType == StImageFile::ST_TYPE_MPO) {
             ST_DEBUG_LOG("MPO image \"" + aFilePath + "\" is invalid!");
         }
@@ -350,43 +653,46 @@ bool StImageLoader::loadImage(const StHandle<StFileNode>& theSource,
         const StString aFilePathRight = theSource->getValue(1)->getPath();
 
         // loading image with format autodetection
-        StRawFile aRawFileL;
+        StRawFile aRawFileL, aRawFileR;
         if(StFileNode::isContentProtocolPath(aFilePathLeft)) {
             int aFileDescriptor = myResMgr->openFileDescriptor(aFilePathLeft);
+            aRawFileL.setMappingAllowed(true);
             aRawFileL.readFile(aFilePathLeft, aFileDescriptor);
         }
-        if(!anImageFileL->load(aFilePathLeft, anImgType, (uint8_t* )aRawFileL.getBuffer(), (int )aRawFileL.getSize())) {
-            processLoadFail(formatError(aFilePathLeft, anImageFileL->getState()));
-            return false;
-        }
-        aRawFileL.freeBuffer();
-
-        StRawFile aRawFileR;
         if(StFileNode::isContentProtocolPath(aFilePathRight)) {
             int aFileDescriptor = myResMgr->openFileDescriptor(aFilePathRight);
+            aRawFileR.setMappingAllowed(true);
             aRawFileR.readFile(aFilePathRight, aFileDescriptor);
         }
-        if(!anImageFileR->load(aFilePathRight, anImgType, (uint8_t* )aRawFileR.getBuffer(), (int )aRawFileR.getSize())) {
-            processLoadFail(formatError(aFilePathRight, anImageFileR->getState()));
-            return false;
+
+        // decode the right view in parallel
+        DecodeJob aJobR(anImageFileR, aFilePathRight, anImgType, (uint8_t* )aRawFileR.getBuffer(), (int )aRawFileR.getSize());
+        startDecodeJob(aJobR, theToUseHelper);
+        const bool isLoadedL = anImageFileL->load(aFilePathLeft, anImgType, (uint8_t* )aRawFileL.getBuffer(), (int )aRawFileL.getSize());
+        waitDecodeJob(aJobR);
+        if(!isLoadedL) {
+            theError = formatError(aFilePathLeft, anImageFileL->getState());
+            return StHandle<StDecodedImage>();
+        }
+        if(!aJobR.IsLoaded) {
+            theError = formatError(aFilePathRight, anImageFileR->getState());
+            return StHandle<StDecodedImage>();
         }
     } else {
         StRawFile aRawFile;
         if(StFileNode::isContentProtocolPath(aFilePath)) {
             int aFileDescriptor = myResMgr->openFileDescriptor(aFilePath);
+            aRawFile.setMappingAllowed(true);
             aRawFile.readFile(aFilePath, aFileDescriptor);
         }
         if(!anImageFileL->load(aFilePath, anImgType, (uint8_t* )aRawFile.getBuffer(), (int )aRawFile.getSize())) {
-            processLoadFail(formatError(aFilePath, anImageFileL->getState()));
-            return false;
+            theError = formatError(aFilePath, anImageFileL->getState());
+            return StHandle<StDecodedImage>();
         }
 
         anImgInfo->StInfoStream = anImageFileL->getFormat();
-        if(myStFormatByUser == StFormat_AUTO) {
-            aSrcFormatCurr = anImgInfo->StInfoStream;
-        }
     }
-    const double aLoadTimeMSec = aLoadTimer.getElapsedTimeInMilliSec();
+    aDecoded->LoadTimeMSec = aLoadTimer.getElapsedTimeInMilliSec();
 
     // copy metadata
     for(size_t aTagIter = 0; aTagIter < anImageFileL->getMetadata().size(); ++aTagIter) {
@@ -397,8 +703,187 @@ bool StImageLoader::loadImage(const StHandle<StFileNode>& theSource,
     // detect information from file name
     bool isAnamorphByName = false;
     anImgInfo->StInfoFileName = st::formatFromName(aTitleString, isAnamorphByName);
-    if(aSrcFormatCurr == StFormat_AUTO
-    && anImgInfo->StInfoFileName != StFormat_AUTO) {
+    return aDecoded;
+}
+
+bool StImageLoader::loadPreview(const StHandle<StFileNode>&     theSource,
+                                const StHandle<StStereoParams>& theParams) {
+    const StString               aFilePath = theSource->getPath();
+    const StImageFile::ImageType anImgType = StImageFile::guessImageType(aFilePath, theSource->getMIME());
+    if(theSource->size() >= 2
+    || myToStickPano360
+    || theParams->ViewingMode != StViewSurface_Plain
+    || (anImgType != StImageFile::ST_TYPE_MPO
+     && anImgType != StImageFile::ST_TYPE_JPEG
+     && anImgType != StImageFile::ST_TYPE_JPS)) {
+        return false;
+    }
+
+    int aFileDescriptor = -1;
+    if(StFileNode::isContentProtocolPath(aFilePath)) {
+        aFileDescriptor = myResMgr->openFileDescriptor(aFilePath);
+    }
+
+    StJpegParser aParser;
+    aParser.setMappingAllowed(true);
+    if(!aParser.readFile(aFilePath, aFileDescriptor)) {
+        return false;
+    }
+
+    // pick up views in the same way as decodeImage() does
+    StHandle<StJpegParser::Image> anImg1, anImg2;
+    size_t aMaxSizeX = 0;
+    size_t aMaxSizeY = 0;
+    for(StHandle<StJpegParser::Image> anImgIter = aParser.getImage(0); !anImgIter.isNull();
+        anImgIter = anImgIter->Next) {
+        aMaxSizeX = stMax(aMaxSizeX, anImgIter->SizeX);
+        aMaxSizeY = stMax(aMaxSizeY, anImgIter->SizeY);
+    }
+    for(StHandle<StJpegParser::Image> anImgIter = aParser.getImage(0); !anImgIter.isNull();
+        anImgIter = anImgIter->Next) {
+        if(anImgIter->SizeX == aMaxSizeX
+        && anImgIter->SizeY == aMaxSizeY) {
+            if(anImg1.isNull()) {
+                anImg1 = anImgIter;
+            } else if(anImg2.isNull()) {
+                anImg2 = anImgIter;
+            }
+        }
+    }
+    if(anImg1.isNull()
+    || aMaxSizeX == 0
+    || aMaxSizeY == 0) {
+        return false;
+    }
+
+    // embedded thumbnails are used only when they preserve image proportions (no black bars)
+    bool hasThumbs = true;
+    for(int aViewIter = 0; aViewIter < 2; ++aViewIter) {
+        const StHandle<StJpegParser::Image>& anImg = aViewIter == 0 ? anImg1 : anImg2;
+        if(anImg.isNull()) {
+            continue;
+        }
+
+        const StHandle<StJpegParser::Image>& aThumb = anImg->Thumb;
+        if(aThumb.isNull()
+        || aThumb->SizeX == 0
+        || aThumb->SizeY == 0
+        || std::abs(double(aThumb->SizeX) * double(aMaxSizeY) / (double(aThumb->SizeY) * double(aMaxSizeX)) - 1.0) > 0.02) {
+            hasThumbs = false;
+        }
+    }
+
+    StHandle<StImageFile> aPreviewL = StImageFile::create(myImageLib, StImageFile::ST_TYPE_JPEG);
+    StHandle<StImageFile> aPreviewR = StImageFile::create(myImageLib, StImageFile::ST_TYPE_JPEG);
+    if(aPreviewL.isNull()
+    || aPreviewR.isNull()) {
+        return false;
+    }
+
+    if(hasThumbs) {
+        if(!aPreviewL->load(aFilePath, StImageFile::ST_TYPE_JPEG, (uint8_t* )anImg1->Thumb->Data, (int )anImg1->Thumb->Length)
+        || (!anImg2.isNull()
+         && !aPreviewR->load(aFilePath, StImageFile::ST_TYPE_JPEG, (uint8_t* )anImg2->Thumb->Data, (int )anImg2->Thumb->Length))) {
+            return false;
+        }
+    } else {
+    #ifdef ST_LIBAV_FORK
+        return false; // reduced resolution decoding is unavailable
+    #else
+        // decode 1/8 of resolution skipping most of DCT coefficients, only for large images
+        if(myImageLib != StImageFile::ST_LIBAV
+        || aMaxSizeX * aMaxSizeY < THE_PREVIEW_MIN_PIXELS) {
+            return false;
+        }
+
+        aPreviewL->setSizeHint(1, 1);
+        aPreviewR->setSizeHint(1, 1);
+        if(!aPreviewL->load(aFilePath, StImageFile::ST_TYPE_JPEG, (uint8_t* )anImg1->Data, (int )anImg1->Length)
+        || (!anImg2.isNull()
+         && !aPreviewR->load(aFilePath, StImageFile::ST_TYPE_JPEG, (uint8_t* )anImg2->Data, (int )anImg2->Length))) {
+            return false;
+        }
+    #endif
+    }
+
+    StFormat aSrcFormat = myStFormatByUser;
+    if(aSrcFormat == StFormat_AUTO) {
+        aSrcFormat = aParser.getSrcFormat();
+    }
+    if(aSrcFormat == StFormat_AUTO) {
+        StString aFolder, aTitleString;
+        bool isAnamorphByName = false;
+        StFileNode::getFolderAndFile(aFilePath, aFolder, aTitleString);
+        aSrcFormat = st::formatFromName(aTitleString, isAnamorphByName);
+    }
+    if(!aPreviewR->isNull()) {
+        aSrcFormat = StFormat_SeparateFrames;
+    }
+
+    theParams->setZRotateZero((GLfloat )StJpegParser::getRotationAngle(anImg1->getOrientation()));
+    myTextureQueue->setConnectedStream(true);
+    if(!myTextureQueue->push(*aPreviewL, *aPreviewR, theParams, aSrcFormat, StCubemap_OFF, 0.0)) {
+        return false;
+    }
+    myTextureQueue->stglSwapFB(0);
+    ST_DEBUG_LOG("StImageLoader, preview " + aPreviewL->getSizeX() + "x" + aPreviewL->getSizeY()
+               + (hasThumbs ? " from embedded thumbnail" : " from reduced decoding"));
+    return true;
+}
+
+bool StImageLoader::loadImage(const StHandle<StFileNode>& theSource,
+                              StHandle<StStereoParams>&   theParams) {
+    // clear active
+    myTextureQueue->clear();
+
+    // take decoded image from cache or decode it right now
+    size_t aSizeHintX = 0, aSizeHintY = 0;
+    getSizeHint(theSource, aSizeHintX, aSizeHintY);
+    const StString aKey = cacheKey(theSource, aSizeHintX, aSizeHintY);
+    StHandle<StDecodedImage> aDecoded = myCache->acquire(aKey);
+    const bool isCached = !aDecoded.isNull();
+    bool hasPreview = false;
+    if(!isCached) {
+        // show something while the full image is being decoded
+        hasPreview = loadPreview(theSource, theParams);
+
+        StString anError;
+        aDecoded = decodeImage(theSource, aSizeHintX, aSizeHintY, anError, true);
+        myCache->release(aKey, aDecoded, false);
+        if(aDecoded.isNull()) {
+            processLoadFail(anError);
+            return false;
+        }
+    }
+#ifdef ST_DEBUG
+    const StImageCache::Counters aCounters = myCache->getCounters();
+    ST_DEBUG_LOG("StImageLoader, cache " + (isCached ? "hit" : "miss")
+               + " (hits: " + aCounters.Hits + ", misses: " + aCounters.Misses + ", prefetched: " + aCounters.Prefetched
+               + ", " + aCounters.Entries + " images, " + (aCounters.SizeBytes / (1024 * 1024)) + " MiB)");
+#endif
+
+    // schedule decoding of neighbors
+    schedulePrefetch();
+
+    // cached images should not be released after scaling
+    StHandle<StImageFile> anImageFileL = aDecoded->ImageL;
+    StHandle<StImageFile> anImageFileR = aDecoded->ImageR;
+    const bool toReleaseSrc = !myCache->isEnabled();
+
+    StHandle<StImageInfo> anImgInfo = new StImageInfo(*aDecoded->Info);
+    anImgInfo->Id = theParams;
+    if(aDecoded->HasZRotateZero) {
+        theParams->setZRotateZero(aDecoded->ZRotateZero);
+    }
+    if(aDecoded->HasSeparation) {
+        theParams->setSeparationNeutral(aDecoded->SeparationNeutral);
+    }
+
+    StFormat aSrcFormatCurr = myStFormatByUser;
+    if(aSrcFormatCurr == StFormat_AUTO) {
+        aSrcFormatCurr = anImgInfo->StInfoStream;
+    }
+    if(aSrcFormatCurr == StFormat_AUTO) {
         aSrcFormatCurr = anImgInfo->StInfoFileName;
     }
 
@@ -409,10 +894,10 @@ bool StImageLoader::loadImage(const StHandle<StFileNode>& theSource,
     size_t aSizeY1 = anImageFileL->getSizeY();
     size_t aSizeX2 = anImageFileR->getSizeX();
     size_t aSizeY2 = anImageFileR->getSizeY();
-    theParams->Src1SizeX = aSizeX1;
-    theParams->Src1SizeY = aSizeY1;
-    theParams->Src2SizeX = aSizeX2;
-    theParams->Src2SizeY = aSizeY2;
+    theParams->Src1SizeX = anImageFileL->getSrcSizeX();
+    theParams->Src1SizeY = anImageFileL->getSrcSizeY();
+    theParams->Src2SizeX = anImageFileR->getSrcSizeX();
+    theParams->Src2SizeY = anImageFileR->getSrcSizeY();
     StPairRatio aPairRatio = StPairRatio_1;
     if(anImageFileR->isNull()) {
         aPairRatio = st::formatToPairRatio(aSrcFormatCurr);
@@ -466,10 +951,38 @@ bool StImageLoader::loadImage(const StHandle<StFileNode>& theSource,
         }
     }
 
-    StHandle<StImage> anImageL = scaledImage(anImageFileL, aSizeXLim, aSizeYLim, aSrcCubemap, aCubeCoeffs, aPairRatio);
-    StHandle<StImage> anImageR = scaledImage(anImageFileR, aSizeXLim, aSizeYLim, aSrcCubemap, aCubeCoeffs, aPairRatio);
+    // image decoded for tiles (taken from cache or not) should not be reduced, see getSizeHint()
+    ST_ASSERT(aSizeHintX != 0
+           || (anImageFileL->getSrcSizeX() == anImageFileL->getSizeX()
+            && anImageFileR->getSrcSizeX() == anImageFileR->getSizeX()),
+              "StImageLoader::loadImage() - reduced-resolution image is used for tiles");
+
+    // full-resolution image is kept for displaying tiles in flat mode, within memory budget
+    bool toTile = aSizeHintX == 0
+               && aSrcCubemap == StCubemap_OFF
+               && imageSizeBytes(*anImageFileL) + imageSizeBytes(*anImageFileR) <= THE_TILES_SOURCE_BUDGET;
+    switch(aSrcFormatCurr) {
+        case StFormat_Mono:
+        case StFormat_SideBySide_LR:
+        case StFormat_SideBySide_RL:
+        case StFormat_TopBottom_LR:
+        case StFormat_TopBottom_RL:
+        case StFormat_SeparateFrames:
+        case StFormat_AnaglyphRedCyan:
+        case StFormat_AnaglyphGreenMagenta:
+        case StFormat_AnaglyphYellowBlue:
+        case StFormat_AUTO:
+            break;
+        default:
+            toTile = false;
+            break;
+    }
+
+    StTimer aScaleTimer(true);
+    StHandle<StImage> anImageL = scaledImage(anImageFileL, aSizeXLim, aSizeYLim, aSrcCubemap, aCubeCoeffs, aPairRatio, toReleaseSrc && !toTile);
+    StHandle<StImage> anImageR = scaledImage(anImageFileR, aSizeXLim, aSizeYLim, aSrcCubemap, aCubeCoeffs, aPairRatio, toReleaseSrc && !toTile);
 #ifdef ST_DEBUG
-    const double aScaleTimeMSec = aLoadTimer.getElapsedTimeInMilliSec() - aLoadTimeMSec;
+    const double aScaleTimeMSec = aScaleTimer.getElapsedTimeInMilliSec();
     if(anImageL != anImageFileL) {
         ST_DEBUG_LOG("Image is downscaled to fit texture limits in " + aScaleTimeMSec + " ms!");
     }
@@ -485,6 +998,9 @@ bool StImageLoader::loadImage(const StHandle<StFileNode>& theSource,
 #endif
 
     // finally push image data in Texture Queue
+    if(hasPreview) {
+        myTextureQueue->clear(); // drop the preview if it has not been shown yet
+    }
     myTextureQueue->setConnectedStream(true);
 
     {
@@ -499,6 +1015,40 @@ bool StImageLoader::loadImage(const StHandle<StFileNode>& theSource,
         myTextureQueue->push(anImageRefL, anImageRefR, theParams, aSrcFormatCurr, aSrcCubemap, 0.0);
     }
 
+    if(toTile
+    && (anImageL != anImageFileL || anImageR != anImageFileR)) {
+        // views within the full-resolution image(s), the same as defined by StGLTextureData for textures
+        const int aSizeX = int(anImageFileL->getSizeX());
+        const int aSizeY = int(anImageFileL->getSizeY());
+        StRectI_t aRectL(0, aSizeY, 0, aSizeX);
+        StRectI_t aRectR(0, int(anImageFileR->getSizeY()), 0, int(anImageFileR->getSizeX()));
+        StHandle<StImage> anImageTilesR = anImageFileR;
+        if(anImageFileR->isNull()) {
+            switch(aSrcFormatCurr) {
+                case StFormat_SideBySide_LR:
+                case StFormat_SideBySide_RL: {
+                    const bool isLR = aSrcFormatCurr == StFormat_SideBySide_LR;
+                    aRectL = StRectI_t(0, aSizeY, isLR ? 0 : aSizeX / 2, isLR ? aSizeX / 2 : aSizeX);
+                    aRectR = StRectI_t(0, aSizeY, isLR ? aSizeX / 2 : 0, isLR ? aSizeX : aSizeX / 2);
+                    anImageTilesR = anImageFileL;
+                    break;
+                }
+                case StFormat_TopBottom_LR:
+                case StFormat_TopBottom_RL: {
+                    const bool isLR = aSrcFormatCurr == StFormat_TopBottom_LR;
+                    aRectL = StRectI_t(isLR ? 0 : aSizeY / 2, isLR ? aSizeY / 2 : aSizeY, 0, aSizeX);
+                    aRectR = StRectI_t(isLR ? aSizeY / 2 : 0, isLR ? aSizeY : aSizeY / 2, 0, aSizeX);
+                    anImageTilesR = anImageFileL;
+                    break;
+                }
+                default: {
+                    break;
+                }
+            }
+        }
+        myTextureQueue->setTiles(new StImageTiles(theParams, anImageFileL, aRectL, anImageTilesR, aRectR));
+    }
+
     if(!stAreEqual(anImageFileL->getPixelRatio(), 1.0f, 0.001f)) {
         anImgInfo->Info.add(StArgument(tr(INFO_PIXEL_RATIO),
                                        StString(anImageFileL->getPixelRatio())));
@@ -525,7 +1075,7 @@ bool StImageLoader::loadImage(const StHandle<StFileNode>& theSource,
         anImgInfo->Info.add(StArgument(tr(INFO_COLOR_MODEL),
                                        aModelL));
     }
-    anImgInfo->Info.add(StArgument(tr(INFO_LOAD_TIME), StString(aLoadTimeMSec) + " " + tr(INFO_TIME_MSEC)));
+    anImgInfo->Info.add(StArgument(tr(INFO_LOAD_TIME), StString(aDecoded->LoadTimeMSec) + " " + tr(INFO_TIME_MSEC)));
     myLock.lock();
     myImgInfo = anImgInfo;
     myLock.unlock();
@@ -535,6 +1085,7 @@ bool StImageLoader::loadImage(const StHandle<StFileNode>& theSource,
     anImageR.nullify();
     anImageFileL.nullify();
     anImageFileR.nullify();
+    aDecoded.nullify();
 
     myTextureQueue->stglSwapFB(0);
 
@@ -714,6 +1265,8 @@ void StImageLoader::mainLoop() {
                 if(!saveImageInfo(anInfo)) {
                     break;
                 }
+                // the key depends on decoding options as well - drop all decoded copies
+                myCache->clear();
                 // re-load image file
             }
             case Action_NONE:
@@ -30,7 +30,9 @@
 #include <StThreads/StProcess.h>
 #include <StThreads/StResourceManager.h>
 
+class StImageCache;
 class StThread;
+struct StDecodedImage;
 
 struct StImageInfo {
 
@@ -125,12 +127,21 @@ class StImageLoader {
         myStFormatByUser = theSrcFormat;
     }
 
-    ST_LOCAL void setImageLib(const StImageFile::ImageClass theImageLib) {
-        myImageLib = theImageLib;
+    /**
+     * Change image library (drops decoded images cache).
+     */
+    ST_LOCAL void setImageLib(const StImageFile::ImageClass theImageLib);
+
+    /**
+     * @return cache of decoded images
+     */
+    ST_LOCAL const StHandle<StImageCache>& getImageCache() const {
+        return myCache;
     }
 
     /**
      * Release unused memory as fast as possible.
+     * Disables decoded images cache and prefetching.
      */
     ST_LOCAL void setCompressMemory(const bool theToCompress);
 
@@ -141,6 +152,11 @@ class StImageLoader {
         myToStickPano360 = theToStick;
     }
 
+    /**
+     * Keep full-resolution copy of images exceeding texture limits to display their tiles in flat mode.
+     */
+    ST_LOCAL void setTileImages(bool theToTile);
+
     /**
      * Flip Z within 6x1 cubemap input.
      */
@@ -165,8 +181,81 @@ class StImageLoader {
 
     } signals;
 
+        public:
+
+    /**
+     * Prefetch thread loop decoding neighbor playlist items into the cache.
+     */
+    ST_LOCAL void prefetchLoop();
+
+    /**
+     * Helper thread loop decoding the second view of stereo pair for the main loading thread.
+     */
+    ST_LOCAL void decodeLoop();
+
         private:
 
+    struct DecodeJob;
+
+    /**
+     * Decode image file(s) into memory.
+     * This method is thread-safe and does not modify the texture queue.
+     * @param theSource      file to decode
+     * @param theSizeHintX   width  limit for reduced-resolution decoding, see getSizeHint()
+     * @param theSizeHintY   height limit for reduced-resolution decoding, see getSizeHint()
+     * @param theError       error description on failure
+     * @param theToUseHelper decode the second view of stereo pair by helper thread in parallel,
+     *                       should be used only by the main loading thread (prefetch threads are already concurrent)
+     * @return decoded image or NULL on failure
+     */
+    ST_LOCAL StHandle<StDecodedImage> decodeImage(const StHandle<StFileNode>& theSource,
+                                                  const size_t                theSizeHintX,
+                                                  const size_t                theSizeHintY,
+                                                  StString&                   theError,
+                                                  const bool                  theToUseHelper);
+
+    /**
+     * Compute dimensions limits for reduced-resolution decoding of the file
+     * according to current stereo format, panorama and tiles options.
+     * Zero dimensions are returned when image should be decoded in full resolution.
+     */
+    ST_LOCAL void getSizeHint(const StHandle<StFileNode>& theSource,
+                              size_t&                     theSizeX,
+                              size_t&                     theSizeY) const;
+
+    /**
+     * Start decoding job by helper thread or perform it immediately if helper should not be used.
+     */
+    ST_LOCAL void startDecodeJob(DecodeJob& theJob,
+                                 const bool theToUseHelper);
+
+    /**
+     * Wait for the job started by startDecodeJob().
+     */
+    ST_LOCAL void waitDecodeJob(DecodeJob& theJob);
+
+    /**
+     * @return the key identifying the file node decoded with specified size hint within decoded images cache
+     */
+    ST_LOCAL static StString cacheKey(const StHandle<StFileNode>& theSource,
+                                      const size_t                theSizeHintX,
+                                      const size_t                theSizeHintY);
+
+    /**
+     * Replace prefetch queue by neighbors of current playlist item.
+     */
+    ST_LOCAL void schedulePrefetch();
+
+    /**
+     * Push quick preview of JPEG / MPO file into the texture queue to be shown while the file is decoded.
+     * Embedded EXIF thumbnails are used when available, otherwise large images are decoded at 1/8 of resolution.
+     * @param theSource file to preview
+     * @param theParams stereo parameters of the file
+     * @return true if preview has been pushed
+     */
+    ST_LOCAL bool loadPreview(const StHandle<StFileNode>&     theSource,
+                              const StHandle<StStereoParams>& theParams);
+
     ST_LOCAL bool loadImage(const StHandle<StFileNode>& theSource,
                             StHandle<StStereoParams>&   theParams);
     ST_LOCAL bool saveImage(const StHandle<StFileNode>& theSource,
@@ -209,10 +298,22 @@ class StImageLoader {
     StHandle<StImageInfo>       myImgInfo;       //!< info about currently loaded image
     StHandle<StImageInfo>       myInfoToSave;    //!< modified info to be saved
     StHandle<StMsgQueue>        myMsgQueue;      //!< messages queue
+    StHandle<StImageCache>      myCache;         //!< decoded images cache
+
+    std::vector< StHandle<StThread> >   myPrefetchThreads; //!< prefetch threads
+    std::vector< StHandle<StFileNode> > myPrefetchQueue;   //!< files to prefetch, most important first
+    StMutex                     myPrefetchLock;  //!< lock for prefetch queue
+    StCondition                 myPrefetchEvent; //!< event signaling non-empty prefetch queue
+
+    StHandle<StThread>          myDecodeThread;  //!< helper thread decoding the second view of stereo pair
+    StCondition                 myDecodeEvent;   //!< event signaling new job for helper thread
+    StCondition                 myDecodeDone;    //!< event signaling that helper thread has finished the job
+    DecodeJob* volatile         myDecodeJob;     //!< job for helper thread
 
     volatile StImageFile::ImageClass myImageLib;
     volatile Action            myAction;
     volatile bool              myToStickPano360; //!< stick to panorama 360 mode
+    volatile bool              myToTileImages;   //!< display full-resolution tiles of images exceeding texture limits
     volatile bool              myToFlipCubeZ6x1; //!< flip Z within 6x1 cubemap input
     volatile bool              myToFlipCubeZ3x2; //!< flip Z within 3x2 cubemap input
 
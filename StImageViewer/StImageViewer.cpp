@@ -103,6 +103,7 @@ void StImageViewer::updateStrings() {
     params.ToShowPlayList->setName(tr(PLAYLIST));
     params.ToShowAdjustImage->setName(tr(MENU_VIEW_IMAGE_ADJUST));
     params.ToStickPanorama->setName(tr(MENU_VIEW_STICK_PANORAMA360));
+    params.ToTileImages->setName(tr(MENU_VIEW_TILE_LARGE_IMAGES));
     params.ToFlipCubeZ6x1->setName(tr(MENU_VIEW_FLIPZ_CUBE6x1));
     params.ToFlipCubeZ3x2->setName(tr(MENU_VIEW_FLIPZ_CUBE3x2));
     params.ToTrackHead->setName(tr(MENU_VIEW_TRACK_HEAD));
@@ -168,6 +169,8 @@ StImageViewer::StImageViewer(const StHandle<StResourceManager>& theResMgr,
     params.ToShowAdjustImage->signals.onChanged = stSlot(this, &StImageViewer::doShowAdjustImage);
     params.ToStickPanorama = new StBoolParamNamed(false, stCString("toStickPano360"));
     params.ToStickPanorama->signals.onChanged = stSlot(this, &StImageViewer::doChangeStickPano360);
+    params.ToTileImages  = new StBoolParamNamed(false, stCString("toTileLargeImages"));
+    params.ToTileImages->signals.onChanged = stSlot(this, &StImageViewer::doChangeTileImages);
     params.ToFlipCubeZ6x1= new StBoolParamNamed(true,  stCString("toFlipCube6x1"));
     params.ToFlipCubeZ6x1->signals.onChanged = stSlot(this, &StImageViewer::doChangeFlipCubeZ);
     params.ToFlipCubeZ3x2= new StBoolParamNamed(false, stCString("toFlipCube3x2"));
@@ -203,6 +206,7 @@ StImageViewer::StImageViewer(const StHandle<StResourceManager>& theResMgr,
     mySettings->loadParam (params.LastUpdateDay);
     mySettings->loadParam (params.CheckUpdatesDays);
     mySettings->loadParam (params.ToStickPanorama);
+    mySettings->loadParam (params.ToTileImages);
     mySettings->loadParam (params.ToFlipCubeZ6x1);
     mySettings->loadParam (params.ToFlipCubeZ3x2);
     myToCheckPoorOrient = !mySettings->loadParam(params.ToTrackHead);
@@ -363,6 +367,7 @@ void StImageViewer::saveAllParams() {
         mySettings->saveParam(params.CheckUpdatesDays);
         mySettings->saveString(ST_SETTING_IMAGELIB,  StImageFile::imgLibToString(params.imageLib));
         mySettings->saveParam (params.ToStickPanorama);
+        mySettings->saveParam (params.ToTileImages);
         mySettings->saveParam (params.ToFlipCubeZ6x1);
         mySettings->saveParam (params.ToFlipCubeZ3x2);
         mySettings->saveParam (params.ToTrackHead);
@@ -529,6 +534,7 @@ bool StImageViewer::init() {
     myLoader->signals.onLoaded.connect(this, &StImageViewer::doLoaded);
     myLoader->setCompressMemory(myWindow->isMobile());
     myLoader->setStickPano360(params.ToStickPanorama->getValue());
+    myLoader->setTileImages(params.ToTileImages->getValue());
     myLoader->setFlipCubeZ6x1(params.ToFlipCubeZ6x1->getValue());
     myLoader->setFlipCubeZ3x2(params.ToFlipCubeZ3x2->getValue());
 
@@ -1212,6 +1218,18 @@ void StImageViewer::doPanoramaOnOff(const size_t ) {
                                             : StViewSurface_Sphere);
 }
 
+void StImageViewer::doChangeTileImages(const bool ) {
+    if(myLoader.isNull()) {
+        return;
+    }
+
+    myLoader->setTileImages(params.ToTileImages->getValue());
+    if(!myGUI->myImage->getSource().isNull()
+    && !myPlayList->isEmpty()) {
+        myLoader->doLoadNext();
+    }
+}
+
 void StImageViewer::doChangeStickPano360(const bool ) {
     if(myLoader.isNull()) {
         return;
@@ -132,6 +132,7 @@ class StImageViewer : public StApplication {
         StHandle<StInt32ParamNamed>   LastUpdateDay;    //!< the last time update has been checked
         StHandle<StInt32ParamNamed>   SrcStereoFormat;  //!< source format
         StHandle<StBoolParamNamed>    ToStickPanorama;  //!< force panorama input for all files
+        StHandle<StBoolParamNamed>    ToTileImages;     //!< display full-resolution tiles of images exceeding texture limits
         StHandle<StBoolParamNamed>    ToFlipCubeZ6x1;   //!< flip Z coordinate within Cube map 6x1
         StHandle<StBoolParamNamed>    ToFlipCubeZ3x2;   //!< flip Z coordinate within Cube map 3x2
         StHandle<StBoolParamNamed>    ToTrackHead;      //!< enable/disable head-tracking
@@ -189,6 +190,7 @@ class StImageViewer : public StApplication {
     ST_LOCAL void doSetStereoOutput(const size_t theMode);
     ST_LOCAL void doPanoramaOnOff(const size_t );
     ST_LOCAL void doChangeStickPano360(const bool );
+    ST_LOCAL void doChangeTileImages(const bool );
     ST_LOCAL void doChangeFlipCubeZ(const bool );
     ST_LOCAL void doShowPlayList(const bool theToShow);
     ST_LOCAL void doShowAdjustImage(const bool theToShow);
@@ -418,6 +418,7 @@ StGLMenu* StImageViewerGUI::createSmoothFilterMenu() {
                    myImage->params.TextureFilter, StGLImageProgram::FILTER_NEAREST);
     aMenu->addItem(tr(MENU_VIEW_TEXFILTER_LINEAR),
                    myImage->params.TextureFilter, StGLImageProgram::FILTER_LINEAR);
+    aMenu->addItem(myPlugin->params.ToTileImages);
     return aMenu;
 }
 
@@ -783,6 +784,7 @@ void StImageViewerGUI::doMobileSettings(const size_t ) {
     aParams.add(myImage->params.DisplayMode);
     aRend->getOptions(aParams);
     aParams.add(myPlugin->params.ToStickPanorama);
+    aParams.add(myPlugin->params.ToTileImages);
     aParams.add(myPlugin->params.ToFlipCubeZ6x1);
     aParams.add(myPlugin->params.ToFlipCubeZ3x2);
     aParams.add(myPlugin->params.ToShowFps);
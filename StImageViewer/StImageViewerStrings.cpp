@@ -133,6 +133,8 @@ void loadDefaults(StLangMap& theStrings) {
                "Cubemap 6x1 - flip Z");
     theStrings(MENU_VIEW_FLIPZ_CUBE3x2,
                "Cubemap 3x2 - flip Z");
+    theStrings(MENU_VIEW_TILE_LARGE_IMAGES,
+               "Full resolution for large images");
     theStrings(MENU_VIEW_DISPLAY_MODE_STEREO,
                "Stereo");
     theStrings(MENU_VIEW_DISPLAY_MODE_LEFT,
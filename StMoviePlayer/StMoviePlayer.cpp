@@ -29,6 +29,7 @@
 #include <StSocket/StCheckUpdates.h>
 #include <StSettings/StSettings.h>
 #include <StStrings/StStringStream.h>
+#include <StStrings/stUtfTools.h>
 #include <StCore/StSearchMonitors.h>
 
 #include <StGL/StGLContext.h>
@@ -80,6 +81,15 @@ namespace {
     static const char ST_ARGUMENT_WINTOP[]     = "windowTop";
     static const char ST_ARGUMENT_WINWIDTH[]   = "windowWidth";
     static const char ST_ARGUMENT_WINHEIGHT[]  = "windowHeight";
+    static const char ST_ARGUMENT_BENCHMARK_REPORT[] = "benchmarkReport";
+
+#ifdef ST_HAVE_MONGOOSE
+    static const size_t  THE_WEB_POLL_TIMEOUT_MS = 20000; //!< long-poll request timeout
+    static const size_t  THE_WEB_KEEPALIVE_MS    = 15000; //!< interval of keep-alive comments within event stream
+    static const int32_t THE_WEB_MAX_WAITERS     = 8;     //!< waiting connections limit (mongoose runs 20 worker threads)
+    static const long    THE_WEB_LIST_PAGE       = 100;   //!< default playlist page size
+    static const long    THE_WEB_LIST_PAGE_MAX   = 1000;  //!< maximum playlist page size
+#endif
 
 }
 
@@ -183,15 +193,22 @@ StMoviePlayer::StMoviePlayer(const StHandle<StResourceManager>& theResMgr,
 : StApplication(theResMgr, theParentWin, theOpenInfo),
   myPlayList(new StPlayList(4, true)),
   myEventLoaded(false),
+  myEventBenchmarkDone(false),
   mySeekOnLoad(-1.0),
   myAudioOnLoad(-1),
   mySubsOnLoad(-1),
   //
   myWebCtx(NULL),
+  myWebEvent(new StCondition(false)),
+  myWebState("}"),
+  myWebStamp(0),
+  myWebNbWaiters(0),
+  myWebToStop(false),
   //
   myToUpdateALList(false),
   myToCheckUpdates(true),
-  myToCheckPoorOrient(true) {
+  myToCheckPoorOrient(true),
+  myToQuitOnBenchmark(false) {
     mySettings = new StSettings(myResMgr, ST_DRAWER_PLUGIN_NAME);
     myLangMap  = new StTranslations(myResMgr, StMoviePlayer::ST_DRAWER_PLUGIN_NAME);
     myOpenDialog = new StMovieOpenDialog(this);
@@ -733,8 +750,19 @@ void StMoviePlayer::doDeleteFileEnd(const size_t ) {
 void StMoviePlayer::doStopWebUI() {
 #ifdef ST_HAVE_MONGOOSE
     if(myWebCtx != NULL) {
+        // release connections waiting for state change, mg_stop() waits for all worker threads
+        myWebMutex.lock();
+        myWebToStop = true;
+        myWebEvent->set();
+        myWebMutex.unlock();
+
         mg_stop(myWebCtx);
         myWebCtx = NULL;
+
+        myWebMutex.lock();
+        myWebToStop = false;
+        myWebEvent  = new StCondition(false);
+        myWebMutex.unlock();
     }
 #endif
 }
@@ -840,6 +868,7 @@ bool StMoviePlayer::init() {
                               myResMgr, myLangMap, myPlayList, aTextureQueue, aSubQueue);
         myVideo->signals.onError  = stSlot(myMsgQueue.access(), &StMsgQueue::doPushError);
         myVideo->signals.onLoaded = stSlot(this,                &StMoviePlayer::doLoaded);
+        myVideo->signals.onBenchmarkDone = stSlot(this,         &StMoviePlayer::doBenchmarkDone);
         myVideo->params.UseGpu       = params.UseGpu;
         myVideo->params.UseOpenJpeg  = params.UseOpenJpeg;
         myVideo->params.ToSearchSubs = params.ToSearchSubs;
@@ -894,6 +923,7 @@ void StMoviePlayer::parseArguments(const StArgumentsMap& theArguments) {
     StArgument anArgShuffle    = theArguments[params.IsShuffle->getKey()];
     StArgument anArgLoopSingle = theArguments[params.ToLoopSingle->getKey()];
     StArgument anArgBenchmark  = theArguments[params.Benchmark->getKey()];
+    StArgument anArgBenchReport= theArguments[ST_ARGUMENT_BENCHMARK_REPORT];
     StArgument anArgShowMenu   = theArguments[params.ToShowMenu->getKey()];
     StArgument anArgShowTopbar = theArguments[params.ToShowTopbar->getKey()];
 
@@ -955,6 +985,13 @@ void StMoviePlayer::parseArguments(const StArgumentsMap& theArguments) {
     if(anArgBenchmark.isValid()) {
         params.Benchmark->setValue(!anArgBenchmark.isValueOff());
     }
+    if(anArgBenchReport.isValid()
+    && !anArgBenchReport.getValue().isEmpty()) {
+        // unattended benchmark - save the report and quit when playback is finished
+        myVideo->setBenchmarkReport(anArgBenchReport.getValue());
+        myToQuitOnBenchmark = true;
+        params.Benchmark->setValue(true);
+    }
     if(anArgShowMenu.isValid()) {
         params.ToShowMenu->setValue(!anArgShowMenu.isValueOff());
     }
@@ -1449,6 +1486,11 @@ void StMoviePlayer::beforeDraw() {
     if(myEventLoaded.checkReset()) {
         doUpdateStateLoaded();
     }
+    if(myEventBenchmarkDone.checkReset()
+    && myToQuitOnBenchmark) {
+        StApplication::exit(0);
+        return;
+    }
 
     if(myToCheckUpdates && !myUpdates.isNull() && myUpdates->isInitialized()) {
         if(myUpdates->isNeedUpdate()) {
@@ -1473,6 +1515,17 @@ void StMoviePlayer::beforeDraw() {
     }
     if(myGUI->mySeekBar != NULL) {
         myGUI->mySeekBar->setProgress(GLfloat(aPosition));
+
+        // show thumbnail while hovering or dragging the seek bar
+        StHandle<StThumbnailsAtlas> anAtlas;
+        StRectI_t aCell;
+        const double aPreviewPos = myGUI->mySeekBar->getPreviewProgress();
+        if(aPreviewPos >= 0.0
+        && myVideo->getThumbnails()->getThumbnail(aPreviewPos, anAtlas, aCell)) {
+            myGUI->mySeekBar->setPreview(anAtlas->Image, aCell);
+        } else {
+            myGUI->mySeekBar->setPreview(StHandle<StImagePlane>(), aCell);
+        }
     }
     myGUI->stglUpdate(myWindow->getMousePos(), myWindow->isPreciseCursor());
 
@@ -1556,6 +1609,7 @@ void StMoviePlayer::beforeDraw() {
         myWindow->setTargetFps(double(params.TargetFps->getValue()));
     }
 
+    updateWebState();
 }
 
 void StMoviePlayer::doUpdateOpenALDeviceList(const size_t ) {
@@ -1643,7 +1697,8 @@ void StMoviePlayer::doSwitchLoopSingle(const bool theValue) {
 }
 
 void StMoviePlayer::doSwitchVSync(const bool theValue) {
-    StApplication::params.VSyncMode->setValue(theValue ? StGLContext::VSync_ON : StGLContext::VSync_OFF);
+    const bool isBenchmark = !params.Benchmark.isNull() && params.Benchmark->getValue();
+    StApplication::params.VSyncMode->setValue(theValue && !isBenchmark ? StGLContext::VSync_ON : StGLContext::VSync_OFF);
 }
 
 void StMoviePlayer::doSwitchAudioDevice(const int32_t /*theDevId*/) {
@@ -1811,6 +1866,10 @@ void StMoviePlayer::doLoaded() {
     myEventLoaded.set();
 }
 
+void StMoviePlayer::doBenchmarkDone() {
+    myEventBenchmarkDone.set();
+}
+
 void StMoviePlayer::doListFirst(const size_t ) {
     if(myPlayList->walkToFirst()) {
         myVideo->doLoadNext();
@@ -1966,6 +2025,8 @@ void StMoviePlayer::doHideSystemBars(const bool ) {
 }
 
 void StMoviePlayer::doSetBenchmark(const bool theValue) {
+    // do not wait for vertical sync while measuring decoding pipeline
+    doSwitchVSync(params.IsVSyncOn->getValue());
     if(myVideo.isNull()) {
         return;
     }
@@ -2016,6 +2077,7 @@ int StMoviePlayer::beginRequest(mg_connection*         theConnection,
 
     // process AJAX requests
     StString aContent;
+    const char* aContentType = "text/plain; charset=utf-8";
     if(anURI.isEquals(stCString("/prev"))) {
         invokeAction(Action_ListPrev);
         aContent = "open previous item in playlist...";
@@ -2054,6 +2116,35 @@ int StMoviePlayer::beginRequest(mg_connection*         theConnection,
         myVideo->pushPlayEvent(ST_PLAYEVENT_RESUME);
         myVideo->doLoadNext();
         aContent = "open item...";
+    } else if(anURI.isEquals(stCString("/state"))) {
+        // return playback state, optionally waiting for its change (long-poll)
+        StCLocale aCLocale;
+        const int32_t aStamp = !aQuery.isEmpty() ? int32_t(stStringToLong(aQuery.toCString(), 10, aCLocale)) : -1;
+        if(aStamp != -1
+        && beginWebWaiter()) {
+            waitWebState(aStamp, THE_WEB_POLL_TIMEOUT_MS, aContent);
+            endWebWaiter();
+        } else {
+            waitWebState(-1, 0, aContent);
+        }
+        aContentType = "application/json; charset=utf-8";
+    } else if(anURI.isEquals(stCString("/events"))) {
+        if(beginWebWaiter()) {
+            sendWebEvents(theConnection);
+            endWebWaiter();
+            return 1;
+        }
+        const char anAnswer[] = "HTTP/1.1 503 Service Unavailable\r\n"
+                                "Content-Length: 0\r\n"
+                                "\r\n";
+        mg_write(theConnection, anAnswer, sizeof(anAnswer) - 1);
+        return 1;
+    } else if(anURI.isEquals(stCString("/playlist.json"))) {
+        aContent     = formatWebPlaylist(aQuery);
+        aContentType = "application/json; charset=utf-8";
+    } else if(anURI.isEquals(stCString("/metrics"))) {
+        aContent     = myVideo->formatMetrics();
+        aContentType = "text/plain; version=0.0.4; charset=utf-8";
     } else if(anURI.isEquals(stCString("/version"))) {
         aContent = StVersionInfo::getSDKVersionString();
     } else if(anURI.isEquals(stCString("/playlist"))) {
@@ -2089,10 +2180,10 @@ int StMoviePlayer::beginRequest(mg_connection*         theConnection,
     }
 
     const StString anAnswer = StString("HTTP/1.1 200 OK\r\n"
-                                       //"Content-Type: text/html; charset=utf-8\r\n"
-                                       "Content-Type: text/plain; charset=utf-8\r\n"
-                                       "Content-Length: ") + aContent.getSize() + "\r\n"
-                                        "\r\n" + aContent;
+                                       "Content-Type: ") + aContentType + "\r\n"
+                                     + "Cache-Control: no-cache\r\n"
+                                     + "Content-Length: " + aContent.getSize() + "\r\n"
+                                     + "\r\n" + aContent;
 
     // send HTTP reply to the client
     mg_write(theConnection, anAnswer.toCString(), anAnswer.getSize());
@@ -2102,6 +2193,189 @@ int StMoviePlayer::beginRequest(mg_connection*         theConnection,
     return 1;
 }
 
+StMoviePlayer::WebState StMoviePlayer::readWebState() {
+    WebState aState;
+    double aDuration = 0.0, aPts = 0.0;
+    bool isVideoPlayed = false, isAudioPlayed = false;
+    aState.IsPlaying = myVideo->getPlaybackState(aDuration, aPts, isVideoPlayed, isAudioPlayed);
+    aState.Serial    = myPlayList->getSerial();
+    aState.Item      = myPlayList->getCurrentId();
+    aState.Volume    = int(gainToVolume(params.AudioGain) * 100.0f);
+    aState.Pts       = int(aPts);
+    aState.Duration  = int(aDuration);
+    return aState;
+}
+
+StString StMoviePlayer::formatWebState(const WebState& theState) {
+    StString aState;
+#ifdef ST_HAVE_MONGOOSE
+    aState = StString(",\"serial\":") + theState.Serial
+           + ",\"item\":"     + theState.Item
+           + ",\"volume\":"   + theState.Volume
+           + ",\"pts\":"      + theState.Pts
+           + ",\"duration\":" + theState.Duration
+           + ",\"playing\":"  + (theState.IsPlaying ? "true" : "false")
+           + ",\"title\":\""   + stUtfTools::escapeJson(myPlayList->getCurrentTitle()) + "\"}";
+#else
+    (void )theState;
+#endif
+    return aState;
+}
+
+void StMoviePlayer::updateWebState() {
+#ifdef ST_HAVE_MONGOOSE
+    if(myWebCtx == NULL) {
+        return;
+    }
+
+    // state is published only for waiting connections, other requests format it on their own
+    myWebMutex.lock();
+    const bool hasWaiters = myWebNbWaiters > 0;
+    myWebMutex.unlock();
+    if(!hasWaiters) {
+        return;
+    }
+
+    const WebState aValues = readWebState();
+    if(aValues == myWebValues) {
+        return;
+    }
+
+    myWebValues = aValues;
+    const StString aState = formatWebState(aValues);
+    myWebMutex.lock();
+    if(myWebState != aState) {
+        ++myWebStamp;
+        myWebState = aState;
+
+        // wake up all waiting connections
+        StHandle<StCondition> anEvent = myWebEvent;
+        myWebEvent = new StCondition(false);
+        anEvent->set();
+    }
+    myWebMutex.unlock();
+#endif
+}
+
+int32_t StMoviePlayer::waitWebState(const int32_t theStamp,
+                                    const size_t  theTimeMs,
+                                    StString&     theState) {
+    if(theStamp == -1) {
+        // published state might be outdated, since it is not updated while nobody waits for it
+        const StString aState = formatWebState(readWebState());
+        myWebMutex.lock();
+        const int32_t aStamp = myWebStamp;
+        theState = StString("{\"stamp\":") + aStamp + aState;
+        myWebMutex.unlock();
+        return aStamp;
+    }
+
+    myWebMutex.lock();
+    if(theStamp == myWebStamp
+    && !myWebToStop) {
+        StHandle<StCondition> anEvent = myWebEvent;
+        myWebMutex.unlock();
+        anEvent->wait(theTimeMs);
+        myWebMutex.lock();
+    }
+    const int32_t aStamp = myWebStamp;
+    theState = StString("{\"stamp\":") + aStamp + myWebState;
+    myWebMutex.unlock();
+    return aStamp;
+}
+
+bool StMoviePlayer::beginWebWaiter() {
+    myWebMutex.lock();
+    const bool isAllowed = myWebNbWaiters < THE_WEB_MAX_WAITERS
+                       && !myWebToStop;
+    if(isAllowed) {
+        ++myWebNbWaiters;
+    }
+    myWebMutex.unlock();
+    return isAllowed;
+}
+
+void StMoviePlayer::endWebWaiter() {
+    myWebMutex.lock();
+    --myWebNbWaiters;
+    myWebMutex.unlock();
+}
+
+void StMoviePlayer::sendWebEvents(mg_connection* theConnection) {
+#ifdef ST_HAVE_MONGOOSE
+    const char aHeader[] = "HTTP/1.1 200 OK\r\n"
+                           "Content-Type: text/event-stream; charset=utf-8\r\n"
+                           "Cache-Control: no-cache\r\n"
+                           "\r\n";
+    if(mg_write(theConnection, aHeader, sizeof(aHeader) - 1) <= 0) {
+        return;
+    }
+
+    StString aState;
+    for(int32_t aStamp = -1; !myWebToStop;) {
+        const int32_t aNewStamp = waitWebState(aStamp, THE_WEB_KEEPALIVE_MS, aState);
+        if(myWebToStop) {
+            break;
+        }
+
+        // comment line keeps the connection alive through proxies and detects closed connections
+        const StString aMsg = aNewStamp != aStamp
+                            ? (StString("id: ") + aNewStamp + "\ndata: " + aState + "\n\n")
+                            : StString(": keep-alive\n\n");
+        aStamp = aNewStamp;
+        if(mg_write(theConnection, aMsg.toCString(), aMsg.getSize()) <= 0) {
+            break;
+        }
+    }
+#else
+    (void )theConnection;
+#endif
+}
+
+StString StMoviePlayer::formatWebPlaylist(const StString& theQuery) {
+    StString aContent;
+#ifdef ST_HAVE_MONGOOSE
+    // read serial before items - client will re-request the list on serial change anyway
+    const int32_t aSerial = myPlayList->getSerial();
+    long aClientSerial = -1;
+    long aFrom  = 0;
+    long aCount = THE_WEB_LIST_PAGE;
+    char aBuff[32];
+    StCLocale aCLocale;
+    if(mg_get_var(theQuery.toCString(), theQuery.getSize(), "serial", aBuff, sizeof(aBuff)) > 0) {
+        aClientSerial = stStringToLong(aBuff, 10, aCLocale);
+    }
+    if(mg_get_var(theQuery.toCString(), theQuery.getSize(), "from", aBuff, sizeof(aBuff)) > 0) {
+        aFrom = stMax(stStringToLong(aBuff, 10, aCLocale), 0L);
+    }
+    if(mg_get_var(theQuery.toCString(), theQuery.getSize(), "count", aBuff, sizeof(aBuff)) > 0) {
+        aCount = stMin(stMax(stStringToLong(aBuff, 10, aCLocale), 1L), THE_WEB_LIST_PAGE_MAX);
+    }
+
+    if(aClientSerial == long(aSerial)) {
+        // client already has this playlist
+        return StString("{\"serial\":") + aSerial + ",\"unchanged\":true}";
+    }
+
+    StArrayList<StString> aList(size_t(aCount) + 1);
+    myPlayList->getSubList(aList, size_t(aFrom), size_t(aFrom + aCount));
+    aContent = StString("{\"serial\":") + aSerial
+             + ",\"total\":" + myPlayList->getItemsCount()
+             + ",\"from\":"  + int(aFrom)
+             + ",\"items\":[";
+    for(size_t anIter = 0; anIter < aList.size(); ++anIter) {
+        if(anIter != 0) {
+            aContent += ",";
+        }
+        aContent += StString("\"") + stUtfTools::escapeJson(aList[anIter]) + "\"";
+    }
+    aContent += "]}";
+#else
+    (void )theQuery;
+#endif
+    return aContent;
+}
+
 int StMoviePlayer::beginRequestHandler(mg_connection* theConnection) {
 #ifdef ST_HAVE_MONGOOSE
     const mg_request_info* aRequestInfo = mg_get_request_info(theConnection);
@@ -24,6 +24,7 @@
 #include <StSettings/StFloat32Param.h>
 #include <StGLStereo/StFormatEnum.h>
 #include <StThreads/StCondition.h>
+#include <StThreads/StMutex.h>
 #include <StThreads/StThread.h>
 
 #include <StGLWidgets/StGLImageRegion.h>
@@ -112,6 +113,11 @@ class StMoviePlayer : public StApplication {
      */
     ST_LOCAL void doLoaded();
 
+    /**
+     * Handler for benchmark report saved event.
+     */
+    ST_LOCAL void doBenchmarkDone();
+
     ST_LOCAL void doPlayListReverse(const size_t dummy = 0);
     ST_LOCAL void doListFirst(const size_t dummy = 0);
     ST_LOCAL void doListPrev(const size_t dummy = 0);
@@ -364,6 +370,79 @@ class StMoviePlayer : public StApplication {
     ST_LOCAL int beginRequest(mg_connection*         theConnection,
                               const mg_request_info& theRequestInfo);
 
+    /**
+     * Playback state exposed to web UI clients.
+     */
+    struct WebState {
+        int32_t Serial;    //!< playlist serial
+        size_t  Item;      //!< current item
+        int     Volume;    //!< volume in percents
+        int     Pts;       //!< position, rounded to seconds to limit the rate of events
+        int     Duration;  //!< duration in seconds
+        bool    IsPlaying; //!< playback state
+
+        WebState() : Serial(-1), Item(size_t(-1)), Volume(0), Pts(0), Duration(0), IsPlaying(false) {}
+
+        bool operator==(const WebState& theOther) const {
+            return Serial    == theOther.Serial
+                && Item      == theOther.Item
+                && Volume    == theOther.Volume
+                && Pts       == theOther.Pts
+                && Duration  == theOther.Duration
+                && IsPlaying == theOther.IsPlaying;
+        }
+    };
+
+    /**
+     * Read current playback state for web UI.
+     */
+    ST_LOCAL WebState readWebState();
+
+    /**
+     * Format web UI state as JSON fields following the counter.
+     */
+    ST_LOCAL StString formatWebState(const WebState& theState);
+
+    /**
+     * Publish playback state (current item, volume, position, playlist serial) for web UI clients.
+     * Should be called from rendering thread.
+     * The state is formatted only when it has been changed and there are connections waiting for it.
+     */
+    ST_LOCAL void updateWebState();
+
+    /**
+     * Wait until web UI state differs from specified one.
+     * @param theStamp  state counter known to the client, -1 to return actual state immediately
+     * @param theTimeMs maximum waiting time
+     * @param theState  current state formatted as JSON
+     * @return current state counter
+     */
+    ST_LOCAL int32_t waitWebState(const int32_t theStamp,
+                                  const size_t  theTimeMs,
+                                  StString&     theState);
+
+    /**
+     * Register the connection waiting for state changes (long-poll or event stream).
+     * @return false if too many connections are already waiting
+     */
+    ST_LOCAL bool beginWebWaiter();
+
+    /**
+     * Unregister the waiting connection.
+     */
+    ST_LOCAL void endWebWaiter();
+
+    /**
+     * Send state changes to the client as Server-Sent Events until connection is closed.
+     */
+    ST_LOCAL void sendWebEvents(mg_connection* theConnection);
+
+    /**
+     * Format the page of the playlist as JSON.
+     * @param theQuery query string with optional "serial", "from" and "count" arguments
+     */
+    ST_LOCAL StString formatWebPlaylist(const StString& theQuery);
+
     ST_LOCAL void doStopWebUI();
     ST_LOCAL void doStartWebUI();
     ST_LOCAL void doSwitchWebUI(const int32_t theValue);
@@ -381,16 +460,25 @@ class StMoviePlayer : public StApplication {
     StHandle<StMovieOpenDialog> myOpenDialog;      //!< file open dialog
 
     StCondition                 myEventLoaded;     //!< indicate that new file was open
+    StCondition                 myEventBenchmarkDone; //!< indicate that benchmark report has been saved
     StTimer                     myInactivityTimer; //!< timer initialized when application goes into paused state
     double                      mySeekOnLoad;      //!< seeking target
     int32_t                     myAudioOnLoad;     //!< audio     track on load
     int32_t                     mySubsOnLoad;      //!< subtitles track on load
 
     mg_context*                 myWebCtx;          //!< web UI context
+    StMutex                     myWebMutex;        //!< lock for web UI state
+    StHandle<StCondition>       myWebEvent;        //!< event signaled (and replaced by new one) on web UI state change
+    StString                    myWebState;        //!< last published web UI state (JSON fields after the counter)
+    WebState                    myWebValues;       //!< values of last published web UI state, accessed only by rendering thread
+    int32_t                     myWebStamp;        //!< web UI state counter
+    int32_t                     myWebNbWaiters;    //!< number of connections waiting for state change
+    volatile bool               myWebToStop;       //!< flag to release waiting connections
 
     bool                        myToUpdateALList;
     bool                        myToCheckUpdates;
     bool                        myToCheckPoorOrient; //!< switch off orientation sensor with poor quality
+    bool                        myToQuitOnBenchmark; //!< quit when benchmark report has been saved
 
     friend class StMoviePlayerGUI;
     friend class StMovieOpenDialog;
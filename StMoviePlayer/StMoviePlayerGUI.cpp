@@ -2111,9 +2111,19 @@ void StMoviePlayerGUI::stglDraw(unsigned int theView) {
         myImage->getTextureQueue()->getQueueInfo(myFpsWidget->changePlayQueued(),
                                                  myFpsWidget->changePlayQueueLength(),
                                                  myFpsWidget->changePlayFps());
+        StString anExtraInfo = myPlugin->getMainWindow()->getStatistics();
+        const double anIOFill = myPlugin->myVideo->getIOBufferFill();
+        if(anIOFill >= 0.0) {
+            char aBuffer[64];
+            stsprintf(aBuffer, sizeof(aBuffer), "I/O buffer %3d%%", int(anIOFill * 100.0 + 0.5));
+            if(!anExtraInfo.isEmpty()) {
+                anExtraInfo += "\n";
+            }
+            anExtraInfo += aBuffer;
+        }
         myFpsWidget->update(myPlugin->getMainWindow()->isStereoOutput(),
                             myPlugin->getMainWindow()->getTargetFps(),
-                            myPlugin->getMainWindow()->getStatistics());
+                            anExtraInfo);
     }
     StGLRootWidget::stglDraw(theView);
 }
@@ -1,5 +1,5 @@
 /**
- * Copyright © 2009-2016 Kirill Gavrilov <kirill@sview.ru>
+ * Copyright © 2009-2017 Kirill Gavrilov <kirill@sview.ru>
  *
  * StMoviePlayer program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -20,25 +20,13 @@
 
 namespace {
 
-    const StAVPacket ST_START_PACKET(NULL, StAVPacket::START_PACKET);
-    const StAVPacket ST_END_PACKET  (NULL, StAVPacket::END_PACKET);
-    const StAVPacket ST_FLUSH_PACKET(NULL, StAVPacket::FLUSH_PACKET);
-    const StAVPacket ST_QUIT_PACKET (NULL, StAVPacket::QUIT_PACKET);
+    /**
+     * Extra slots for special packets pushed regardless of queue limit.
+     */
+    static const size_t THE_RING_RESERVE = 8;
 
 }
 
-// auxiliary structure
-struct StAVPacketQueue::QueueItem {
-
-    StHandle<StAVPacket> myItem; //!< handle for packet
-    QueueItem* myNext; //!< link to the next queue item
-
-    ST_LOCAL QueueItem(const StAVPacket& thePacket)
-    : myItem(new StAVPacket(thePacket)), // copy with content
-      myNext(NULL) {}
-
-};
-
 StAVPacketQueue::StAVPacketQueue(const size_t theSizeLimit)
 : myFormatCtx(NULL),
   myStream(NULL),
@@ -58,29 +46,40 @@ StAVPacketQueue::StAVPacketQueue(const size_t theSizeLimit)
   myPlayEvent(ST_PLAYEVENT_NONE),
   myIsPlaying(false),
   myIsAttachedPic(false),
+  myPushEvent(false),
   // queue
-  myFront(NULL),
-  myBack(NULL),
+  myRing(NULL),
+  myRingSize(theSizeLimit + THE_RING_RESERVE),
+  myFront(0),
   mySize(0),
   mySizeLimit(theSizeLimit),
+  mySizePeak(0),
+  myBytesQueued(0),
+  myBytesPeak(0),
   mySizeSeconds(0.0),
+  myPopEvent(false),
   myMutex() {
-    //
+    myRing = new StAVPacket[myRingSize];
 }
 
 StAVPacketQueue::~StAVPacketQueue() {
-    while(!isEmpty()) {
-        pop();
-    }
+    clear();
     deinit();
+    delete[] myRing;
 }
 
 void StAVPacketQueue::clear() {
     myMutex.lock();
-    while(!isEmpty()) {
-        pop();
+    for(size_t anIter = 0; anIter < mySize; ++anIter) {
+        StAVPacket& aSlot = myRing[(myFront + anIter) % myRingSize];
+        aSlot.free();
+        aSlot.setSource(StHandle<StStereoParams>());
     }
+    myFront       = 0;
+    mySize        = 0;
+    myBytesQueued = 0;
     mySizeSeconds = 0.0;
+    myPopEvent.set();
     myMutex.unlock();
 }
 
@@ -162,50 +161,95 @@ StString StAVPacketQueue::getCodecInfo() const {
     return anInfo;
 }
 
-StHandle<StAVPacket> StAVPacketQueue::pop() {
+bool StAVPacketQueue::pop(StAVPacket& thePacket) {
     myMutex.lock();
-        if(isEmpty()) {
+        if(mySize == 0) {
             myMutex.unlock();
-            return StHandle<StAVPacket>();
+            return false;
         }
-        QueueItem* anItem = myFront;
-        myFront = myFront->myNext;
-        StHandle<StAVPacket> aPacket = anItem->myItem;
-        delete anItem;
+        StAVPacket& aSlot = myRing[myFront];
+        myFront = (myFront + 1) % myRingSize;
         --mySize;
-        mySizeSeconds -= aPacket->getDurationSeconds();
+        myBytesQueued -= size_t(aSlot.getSize());
+        mySizeSeconds -= aSlot.getDurationSeconds();
+        thePacket.moveFrom(aSlot);
+        aSlot.setSource(StHandle<StStereoParams>());
+        myPopEvent.set();
     myMutex.unlock();
-    return aPacket;
+    return true;
 }
 
-void StAVPacketQueue::push(const StAVPacket& thePacket) {
+void StAVPacketQueue::growRing() {
+    const size_t aRingSizeNew = myRingSize * 2;
+    StAVPacket*  aRingNew     = new StAVPacket[aRingSizeNew];
+    for(size_t anIter = 0; anIter < mySize; ++anIter) {
+        aRingNew[anIter].moveFrom(myRing[(myFront + anIter) % myRingSize]);
+    }
+    delete[] myRing;
+    myRing     = aRingNew;
+    myRingSize = aRingSizeNew;
+    myFront    = 0;
+}
+
+void StAVPacketQueue::push(StAVPacket& thePacket) {
     myMutex.lock();
-        QueueItem* anItem = new QueueItem(thePacket);
-        if(isEmpty()) {
-            myFront = myBack = anItem;
-        } else {
-            myBack->myNext = anItem;
-            myBack = anItem;
+        if(mySize == myRingSize) {
+            growRing();
         }
+        StAVPacket& aSlot = myRing[(myFront + mySize) % myRingSize];
+        aSlot.moveFrom(thePacket);
         ++mySize;
-        mySizeSeconds += thePacket.getDurationSeconds();
+        myBytesQueued += size_t(aSlot.getSize());
+        mySizeSeconds += aSlot.getDurationSeconds();
+        mySizePeak  = stMax(mySizePeak,  mySize);
+        myBytesPeak = stMax(myBytesPeak, myBytesQueued);
+        myPushEvent.set();
     myMutex.unlock();
 }
 
+bool StAVPacketQueue::waitPackets(const size_t theTimeMilliseconds) {
+    myPushEvent.wait(theTimeMilliseconds);
+    myMutex.lock();
+        // reset the event under queue lock to not miss concurrent push
+        const bool hasPackets = mySize != 0;
+        if(!hasPackets) {
+            myPushEvent.reset();
+        }
+    myMutex.unlock();
+    return hasPackets;
+}
+
+bool StAVPacketQueue::waitSpace(const size_t theTimeMilliseconds) {
+    myPopEvent.wait(theTimeMilliseconds);
+    myMutex.lock();
+        // reset the event under queue lock to not miss concurrent pop
+        const bool isFullQueue = isFullUnlocked();
+        if(isFullQueue) {
+            myPopEvent.reset();
+        }
+    myMutex.unlock();
+    return !isFullQueue;
+}
+
+void StAVPacketQueue::pushSpecial(const int thePacketType) {
+    StAVPacket aPacket(StHandle<StStereoParams>(), thePacketType);
+    push(aPacket);
+}
+
 void StAVPacketQueue::pushStart() {
-    StAVPacketQueue::push(ST_START_PACKET);
+    pushSpecial(StAVPacket::START_PACKET);
 }
 
 void StAVPacketQueue::pushEnd() {
-    StAVPacketQueue::push(ST_END_PACKET);
+    pushSpecial(StAVPacket::END_PACKET);
 }
 
 void StAVPacketQueue::pushQuit() {
-    StAVPacketQueue::push(ST_QUIT_PACKET);
+    pushSpecial(StAVPacket::QUIT_PACKET);
 }
 
 void StAVPacketQueue::pushFlush() {
-    StAVPacketQueue::push(ST_FLUSH_PACKET);
+    pushSpecial(StAVPacket::FLUSH_PACKET);
     myToFlush = true;
 }
 
@@ -252,4 +296,5 @@ void StAVPacketQueue::pushPlayEvent(const StPlayEvent_t theEventId,
     }
     myPlayEvent = theEventId;
     myEventMutex.unlock();
+    myPushEvent.set();
 }
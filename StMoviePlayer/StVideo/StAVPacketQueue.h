@@ -1,5 +1,5 @@
 /**
- * Copyright © 2009-2016 Kirill Gavrilov <kirill@sview.ru>
+ * Copyright © 2009-2017 Kirill Gavrilov <kirill@sview.ru>
  *
  * StMoviePlayer program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -19,6 +19,7 @@
 #ifndef __StAVPacketQueue_h_
 #define __StAVPacketQueue_h_
 
+#include <StThreads/StCondition.h>
 #include <StThreads/StMutex.h>
 #include <StTemplates/StHandle.h>
 #include <StSlots/StSignal.h>
@@ -38,7 +39,10 @@ typedef enum {
 
 /**
  * This is a simple thread safe queue implementation
- * specialized for AVPacketClass
+ * specialized for AVPacketClass.
+ * Packets are stored within preallocated ring buffer of slots,
+ * which are recycled without memory allocation;
+ * packet data is moved by reference from demuxer to decoder.
  */
 class StAVPacketQueue {
 
@@ -64,27 +68,59 @@ class StAVPacketQueue {
     ST_LOCAL virtual void deinit();
 
     /**
-     * @return packet (StAVPacket* ) - first packet in queue.
+     * Retrieve first packet in queue.
+     * @param thePacket packet to move content into
+     * @return false if queue is empty
      */
-    ST_LOCAL StHandle<StAVPacket> pop();
+    ST_LOCAL bool pop(StAVPacket& thePacket);
 
     /**
-     * @param thePacket (StAVPacket& ) - packet to add (will be copied with content).
-     * @return true on success.
+     * Add packet to the queue.
+     * @param thePacket packet to add (content will be moved, so that packet can be reused for next read)
      */
-    ST_LOCAL void push(const StAVPacket& thePacket);
+    ST_LOCAL void push(StAVPacket& thePacket);
 
     ST_LOCAL void pushStart();
     ST_LOCAL void pushEnd();
     ST_LOCAL void pushQuit();
-    ST_LOCAL void pushFlush();
+    ST_LOCAL virtual void pushFlush();
+
+    /**
+     * Wait until new packet or playback event is pushed into the queue.
+     * Should be called by decoding thread instead of polling empty queue.
+     * @param theTimeMilliseconds wait limit
+     * @return true if queue is not empty
+     */
+    ST_LOCAL bool waitPackets(const size_t theTimeMilliseconds);
+
+    /**
+     * Wake up decoding thread waiting for packets.
+     */
+    ST_LOCAL void wakeUp() {
+        myPushEvent.set();
+    }
+
+    /**
+     * Wait until packet is popped from the full queue (or queue is cleared).
+     * Should be called by demuxing thread instead of polling full queue.
+     * @param theTimeMilliseconds wait limit
+     * @return true if queue is not full
+     */
+    ST_LOCAL bool waitSpace(const size_t theTimeMilliseconds);
+
+    /**
+     * Wake up demuxing thread waiting for free space in the queue.
+     */
+    ST_LOCAL void wakeUpPusher() {
+        myPopEvent.set();
+    }
 
     /**
      * Returns true if queue is empty.
      */
     ST_LOCAL bool isEmpty() const {
         myMutex.lock();
-            bool aResult = myFront == NULL;
+            bool aResult = mySize == 0;
         myMutex.unlock();
         return aResult;
     }
@@ -94,7 +130,7 @@ class StAVPacketQueue {
      */
     ST_LOCAL bool isFull() const {
         myMutex.lock();
-            bool aResult = (mySize >= mySizeLimit) || (mySizeSeconds >= 5.0);
+            bool aResult = isFullUnlocked();
             //if(mySize >= mySizeLimit) { ST_DEBUG_LOG("stream" + streamId + " sizeSeconds= " + sizeSeconds + "; mySize= " + mySize); }
         myMutex.unlock();
         return aResult;
@@ -114,6 +150,46 @@ class StAVPacketQueue {
         return aSize;
     }
 
+    /**
+     * @return cumulative length of packets in queue in seconds
+     */
+    ST_LOCAL double getSizeSeconds() const {
+        myMutex.lock();
+            double aSize = mySizeSeconds;
+        myMutex.unlock();
+        return aSize;
+    }
+
+    /**
+     * @return peak number of packets in queue
+     */
+    ST_LOCAL size_t getSizePeak() const {
+        myMutex.lock();
+            size_t aSize = mySizePeak;
+        myMutex.unlock();
+        return aSize;
+    }
+
+    /**
+     * @return size of packets data in queue in bytes
+     */
+    ST_LOCAL size_t getBytesQueued() const {
+        myMutex.lock();
+            size_t aSize = myBytesQueued;
+        myMutex.unlock();
+        return aSize;
+    }
+
+    /**
+     * @return peak size of packets data in queue in bytes
+     */
+    ST_LOCAL size_t getBytesPeak() const {
+        myMutex.lock();
+            size_t aSize = myBytesPeak;
+        myMutex.unlock();
+        return aSize;
+    }
+
     /**
      * @return true if queue initialized.
      */
@@ -258,16 +334,40 @@ class StAVPacketQueue {
     StPlayEvent_t    myPlayEvent;      //!< playback control event
     bool             myIsPlaying;      //!< playback state
     bool             myIsAttachedPic;  //!< flag indicating the stream is attached image
+    StCondition      myPushEvent;      //!< event signaled on new packet or playback event, reset by waitPackets() on empty queue
 
-        private: //! @name Private fields
+        private: //! @name Private methods
 
-    struct QueueItem;
+    /**
+     * Push special packet.
+     */
+    ST_LOCAL void pushSpecial(const int thePacketType);
+
+    /**
+     * Enlarge ring buffer - should not happen in normal situation
+     * (only special packets might be pushed into full queue).
+     */
+    ST_LOCAL void growRing();
+
+    /**
+     * Returns true if queue is full, should be called under lock.
+     */
+    ST_LOCAL bool isFullUnlocked() const {
+        return (mySize >= mySizeLimit) || (mySizeSeconds >= 5.0);
+    }
+
+        private: //! @name Private fields
 
-    QueueItem*       myFront;          //!< queue front packet (first to pop)
-    QueueItem*       myBack;           //!< queue back  packet (last  to pop)
+    StAVPacket*      myRing;           //!< ring buffer of preallocated packets
+    size_t           myRingSize;       //!< number of slots in ring buffer
+    size_t           myFront;          //!< index of queue front packet (first to pop)
     size_t           mySize;           //!< packets number in queue
     size_t           mySizeLimit;      //!< packets limit
+    size_t           mySizePeak;       //!< peak packets number in queue
+    size_t           myBytesQueued;    //!< cumulative packets data size in bytes
+    size_t           myBytesPeak;      //!< peak packets data size in bytes
     double           mySizeSeconds;    //!< cumulative packets length in seconds
+    StCondition      myPopEvent;       //!< event signaled on popped packet or cleared queue, reset by waitSpace() on full queue
     mutable StMutex  myMutex;          //!< lock for thread-safety
 
     StString         myCodecName;      //!< active codec name
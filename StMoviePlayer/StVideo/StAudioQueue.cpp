@@ -282,6 +282,7 @@ void StAudioQueue::stalEmpty() {
         }
         alSourcei(myAlSources[aSrcId], AL_BUFFER, 0);
     }
+    myAlBufQueued = 0;
     ///alSourceRewindv(THE_NUM_AL_SOURCES, myAlSources);
 }
 
@@ -335,6 +336,7 @@ StAudioQueue::StAudioQueue(const std::string& theAlDeviceName,
   myAlIsListOrient(false),
   myAlCanBFormat(false),
   myAlIsBFormat(false),
+  myAlBufQueued(0),
   myAlHrtf(theAlHrtf),
   myAlHrtfPrev(theAlHrtf),
   myDbgPrevQueued(-1),
@@ -915,6 +917,7 @@ bool StAudioQueue::stalQueue(const double thePts) {
     ALenum aState = stalGetSourceState();
     alGetSourcei(myAlSources[0], AL_BUFFERS_PROCESSED, &aProcessed);
     alGetSourcei(myAlSources[0], AL_BUFFERS_QUEUED,    &aQueued);
+    myAlBufQueued = int(aQueued - aProcessed);
 
 #ifdef ST_DEBUG
     if(myDbgPrevQueued != aQueued) {
@@ -1106,10 +1109,10 @@ void StAudioQueue::stalFillBuffers(const double thePts,
     }
 }
 
-void StAudioQueue::decodePacket(const StHandle<StAVPacket>& thePacket,
-                                double&                     thePts) {
-    const uint8_t* anAudioPktData = thePacket->getData();
-    int anAudioPktSize = thePacket->getSize();
+void StAudioQueue::decodePacket(const StAVPacket& thePacket,
+                                double&           thePts) {
+    const uint8_t* anAudioPktData = thePacket.getData();
+    int anAudioPktSize = thePacket.getSize();
     bool checkMoreFrames = false;
     int isGotFrame = 0;
     // packet could store multiple frames
@@ -1194,7 +1197,7 @@ void StAudioQueue::decodePacket(const StHandle<StAVPacket>& thePacket,
                 aPtsU = myFrame.Frame->pts;
             #endif
                 if(aPtsU == stAV::NOPTS_VALUE) {
-                    aPtsU = thePacket->getPts();
+                    aPtsU = thePacket.getPts();
                 }
 
                 if(aPtsU != stAV::NOPTS_VALUE) {
@@ -1237,23 +1240,22 @@ void StAudioQueue::decodeLoop() {
     myIsAlValid = (stalInit() ? ST_AL_INIT_OK : ST_AL_INIT_KO);
 
     double aPts = 0.0;
-    StHandle<StAVPacket> aPacket;
+    StAVPacket aPacket;
     for(;;) {
         // wait for upcoming packets
         if(isEmpty()) {
             myDowntimeEvent.set();
             parseEvents();
-            StThread::sleep(10);
+            waitPackets(10); // short limit to handle volume / orientation changes
             ///ST_DEBUG_LOG_AT("AQ is empty");
             continue;
         }
         myDowntimeEvent.reset();
 
-        aPacket = pop();
-        if(aPacket.isNull()) {
+        if(!pop(aPacket)) {
             continue;
         }
-        switch(aPacket->getType()) {
+        switch(aPacket.getType()) {
             case StAVPacket::FLUSH_PACKET: {
                 // got the special FLUSH packet - flush FFmpeg codec buffers
                 if(myCodecCtx != NULL && myCodec != NULL) {
@@ -1292,7 +1294,7 @@ void StAudioQueue::decodeLoop() {
 
         // we got the data packet, so decode it
         decodePacket(aPacket, aPts);
-        aPacket.nullify();
+        aPacket.free();
     }
 }
 
@@ -91,6 +91,13 @@ class StAudioQueue : public StAVPacketQueue {
         return (stalGetSourceState() == AL_PLAYING);
     }
 
+    /**
+     * @return number of OpenAL buffers queued for playback, as seen on last queue update
+     */
+    ST_LOCAL int getBuffersQueued() const {
+        return myAlBufQueued;
+    }
+
         public: //!< @name playback control methods
 
     ST_LOCAL virtual void pushPlayEvent(const StPlayEvent_t theEventId,
@@ -214,8 +221,8 @@ class StAudioQueue : public StAVPacketQueue {
 
     ST_LOCAL bool parseEvents();
 
-    ST_LOCAL void decodePacket(const StHandle<StAVPacket>& thePacket,
-                               double& thePts);
+    ST_LOCAL void decodePacket(const StAVPacket& thePacket,
+                               double&           thePts);
 
         private:
 
@@ -372,6 +379,7 @@ class StAudioQueue : public StAVPacketQueue {
     bool               myAlIsListOrient;//!< flag indicating that listener orientation is not identity
     bool               myAlCanBFormat;  //!< flag indicating that B-Format can be forced (e.g. 4-channels input and extension is available)
     bool               myAlIsBFormat;   //!< flag indicating that using B-Format is enabled (forcibly) for 4-channels input
+    volatile int       myAlBufQueued;   //!< number of queued buffers, see getBuffersQueued()
 
     StAlHrtfRequest    myAlHrtf;
     StAlHrtfRequest    myAlHrtfPrev;
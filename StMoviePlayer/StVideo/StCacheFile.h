@@ -0,0 +1,60 @@
+/**
+ * Copyright © 2017 Kirill Gavrilov <kirill@sview.ru>
+ *
+ * StMoviePlayer program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * StMoviePlayer program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __StCacheFile_h_
+#define __StCacheFile_h_
+
+#include <stTypes.h>
+
+#include <vector>
+
+/**
+ * Helpers for (de)serialization of binary cache files (keyframe indexes, thumbnail atlases).
+ * Values are stored in native byte order - cache files are not supposed to be moved between machines.
+ */
+namespace stCache {
+
+    /**
+     * Append value to the byte array.
+     */
+    template<typename Type>
+    inline void appendValue(std::vector<char>& theBuffer,
+                            const Type&        theValue) {
+        const char* aBytes = (const char* )&theValue;
+        theBuffer.insert(theBuffer.end(), aBytes, aBytes + sizeof(Type));
+    }
+
+    /**
+     * Read value from the byte array.
+     * @return false if array is too short
+     */
+    template<typename Type>
+    inline bool readValue(const stUByte_t*& theIter,
+                          const stUByte_t*  theEnd,
+                          Type&             theValue) {
+        if(size_t(theEnd - theIter) < sizeof(Type)) {
+            return false;
+        }
+        stMemCpy(&theValue, theIter, sizeof(Type));
+        theIter += sizeof(Type);
+        return true;
+    }
+
+}
+
+#endif // __StCacheFile_h_
@@ -0,0 +1,323 @@
+/**
+ * Copyright © 2017 Kirill Gavrilov <kirill@sview.ru>
+ *
+ * StMoviePlayer program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * StMoviePlayer program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StKeyframeIndex.h"
+#include "StCacheFile.h"
+
+#include <StFile/StFolder.h>
+#include <StFile/StRawFile.h>
+#include <StStrings/StLogger.h>
+
+#include <algorithm>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+namespace {
+
+    static const char     THE_INDEX_MAGIC[8] = { 's', 'V', 'K', 'F', 'I', 'D', 'X', '\0' };
+    static const uint32_t THE_INDEX_VERSION  = 1;
+
+    using stCache::appendValue;
+    using stCache::readValue;
+
+    /**
+     * Comparison of entry timestamp, for std::lower_bound().
+     */
+    inline bool isEntryBefore(const StKeyframeIndex::Entry& theEntry,
+                              const int64_t                 thePts) {
+        return theEntry.Pts < thePts;
+    }
+
+    /**
+     * Comparison of entry timestamp, for std::upper_bound().
+     */
+    inline bool isPtsBefore(const int64_t                 thePts,
+                            const StKeyframeIndex::Entry& theEntry) {
+        return thePts < theEntry.Pts;
+    }
+
+}
+
+bool StKeyframeIndex::getFileStats(const StString& thePath,
+                                   uint64_t&       theSize,
+                                   int64_t&        theTime) {
+#ifdef _WIN32
+    StStringUtfWide aPathWide;
+    aPathWide.fromUnicode(thePath);
+    struct __stat64 aStat;
+    if(::_wstat64(aPathWide.toCString(), &aStat) != 0) {
+        return false;
+    }
+#else
+    struct stat aStat;
+    if(::stat(thePath.toCString(), &aStat) != 0) {
+        return false;
+    }
+#endif
+    theSize = uint64_t(aStat.st_size);
+    theTime = int64_t(aStat.st_mtime);
+    return true;
+}
+
+StString StKeyframeIndex::getCacheFileName(const StString& theFilePath,
+                                           const char*     theExtension) {
+    // FNV-1a hash of the path
+    uint64_t aHash = 14695981039346656037ULL;
+    const char* aStr = theFilePath.toCString();
+    for(size_t aByteIter = 0; aByteIter < theFilePath.getSize(); ++aByteIter) {
+        aHash ^= uint64_t((unsigned char )aStr[aByteIter]);
+        aHash *= 1099511628211ULL;
+    }
+
+    char aName[64];
+    stsprintf(aName, sizeof(aName), "%016llx.%s", (unsigned long long )aHash, theExtension);
+    return StString(aName);
+}
+
+StKeyframeIndex::StKeyframeIndex()
+: myFileSize(0),
+  myFileTime(0),
+  myStreamId(-1),
+  myLastEntry(size_t(-1)),
+  myIsModified(false) {
+    //
+}
+
+StKeyframeIndex::~StKeyframeIndex() {
+    close();
+}
+
+bool StKeyframeIndex::open(const StString& theCacheFolder,
+                           const StString& theFilePath,
+                           const int       theStreamId) {
+    close();
+    if(theCacheFolder.isEmpty()
+    || theStreamId < 0
+    || !getFileStats(theFilePath, myFileSize, myFileTime)) {
+        return false;
+    }
+
+    myMutex.lock();
+    myCachePath = theCacheFolder + "keyframes" + SYS_FS_SPLITTER + getCacheFileName(theFilePath, "idx");
+    myFilePath  = theFilePath;
+    myStreamId  = theStreamId;
+    const bool isLoaded = load();
+    if(!isLoaded) {
+        myEntries.clear();
+    }
+    myIsModified = false;
+    myMutex.unlock();
+    return isLoaded;
+}
+
+void StKeyframeIndex::close() {
+    myMutex.lock();
+    if(myIsModified
+    && !myEntries.empty()) {
+        save();
+    }
+    myEntries.clear();
+    myCachePath.clear();
+    myFilePath.clear();
+    myFileSize   = 0;
+    myFileTime   = 0;
+    myStreamId   = -1;
+    myLastEntry  = size_t(-1);
+    myIsModified = false;
+    myMutex.unlock();
+}
+
+size_t StKeyframeIndex::size() const {
+    myMutex.lock();
+    const size_t aSize = myEntries.size();
+    myMutex.unlock();
+    return aSize;
+}
+
+void StKeyframeIndex::add(const int64_t thePts,
+                          const int64_t thePos) {
+    myMutex.lock();
+    if(myStreamId < 0) {
+        myMutex.unlock();
+        return;
+    }
+
+    // keyframes normally come in increasing order - try appending first
+    size_t anIndex = myEntries.size();
+    if(!myEntries.empty()
+    &&  myEntries.back().Pts >= thePts) {
+        anIndex = size_t(std::lower_bound(myEntries.begin(), myEntries.end(), thePts, isEntryBefore) - myEntries.begin());
+    }
+
+    if(anIndex < myEntries.size()
+    && myEntries[anIndex].Pts == thePts) {
+        // already indexed
+        if(myEntries[anIndex].Pos < 0
+        && thePos >= 0) {
+            myEntries[anIndex].Pos = thePos;
+            myIsModified = true;
+        }
+    } else {
+        Entry anEntry;
+        anEntry.Pts     = thePts;
+        anEntry.Pos     = thePos;
+        anEntry.HasNext = false;
+        myEntries.insert(myEntries.begin() + anIndex, anEntry);
+        if(myLastEntry != size_t(-1)
+        && myLastEntry >= anIndex) {
+            ++myLastEntry;
+        }
+        myIsModified = true;
+    }
+
+    // link with the previous keyframe read within the same run
+    if(myLastEntry != size_t(-1)
+    && myLastEntry + 1 == anIndex
+    && !myEntries[myLastEntry].HasNext) {
+        myEntries[myLastEntry].HasNext = true;
+        myIsModified = true;
+    }
+    myLastEntry = anIndex;
+    myMutex.unlock();
+}
+
+void StKeyframeIndex::addEnd() {
+    myMutex.lock();
+    if(myLastEntry != size_t(-1)
+    && myLastEntry + 1 == myEntries.size()
+    && !myEntries[myLastEntry].HasNext) {
+        myEntries[myLastEntry].HasNext = true;
+        myIsModified = true;
+    }
+    myLastEntry = size_t(-1);
+    myMutex.unlock();
+}
+
+void StKeyframeIndex::resetRun() {
+    myMutex.lock();
+    myLastEntry = size_t(-1);
+    myMutex.unlock();
+}
+
+bool StKeyframeIndex::find(const int64_t theTarget,
+                           Entry&        theEntry) const {
+    myMutex.lock();
+    const size_t anUpper = size_t(std::upper_bound(myEntries.begin(), myEntries.end(), theTarget, isPtsBefore) - myEntries.begin());
+    bool isFound = false;
+    if(anUpper != 0
+    && myEntries[anUpper - 1].HasNext) {
+        // the next keyframe (or end of file) is known to be after the target
+        theEntry = myEntries[anUpper - 1];
+        isFound  = true;
+    }
+    myMutex.unlock();
+    return isFound;
+}
+
+bool StKeyframeIndex::load() {
+    StRawFile aFile;
+    if(!StFileNode::isFileExists(myCachePath)
+    || !aFile.readFile(myCachePath)) {
+        return false;
+    }
+
+    const stUByte_t* anIter = aFile.getBuffer();
+    const stUByte_t* anEnd  = anIter + aFile.getSize();
+    char     aMagic[sizeof(THE_INDEX_MAGIC)];
+    uint32_t aVersion   = 0;
+    uint64_t aFileSize  = 0;
+    int64_t  aFileTime  = 0;
+    int32_t  aStreamId  = 0;
+    uint32_t aPathLen   = 0;
+    if(!readValue(anIter, anEnd, aMagic)
+    || std::memcmp(aMagic, THE_INDEX_MAGIC, sizeof(THE_INDEX_MAGIC)) != 0
+    || !readValue(anIter, anEnd, aVersion)
+    ||  aVersion != THE_INDEX_VERSION
+    || !readValue(anIter, anEnd, aFileSize)
+    || !readValue(anIter, anEnd, aFileTime)
+    || !readValue(anIter, anEnd, aStreamId)
+    || !readValue(anIter, anEnd, aPathLen)
+    ||  size_t(anEnd - anIter) < size_t(aPathLen)) {
+        return false;
+    }
+
+    // file might be replaced or modified since index creation
+    const StString aPath((const char* )anIter, size_t(aPathLen));
+    anIter += aPathLen;
+    if(aPath      != myFilePath
+    || aFileSize  != myFileSize
+    || aFileTime  != myFileTime
+    || aStreamId  != myStreamId) {
+        return false;
+    }
+
+    uint32_t aNbEntries = 0;
+    if(!readValue(anIter, anEnd, aNbEntries)
+    ||  size_t(anEnd - anIter) < size_t(aNbEntries) * (sizeof(int64_t) * 2 + 1)) {
+        return false;
+    }
+
+    myEntries.resize(aNbEntries);
+    for(uint32_t anEntryIter = 0; anEntryIter < aNbEntries; ++anEntryIter) {
+        Entry& anEntry = myEntries[anEntryIter];
+        uint8_t aHasNext = 0;
+        readValue(anIter, anEnd, anEntry.Pts);
+        readValue(anIter, anEnd, anEntry.Pos);
+        readValue(anIter, anEnd, aHasNext);
+        anEntry.HasNext = aHasNext != 0;
+        if(anEntryIter != 0
+        && myEntries[anEntryIter - 1].Pts >= anEntry.Pts) {
+            return false;
+        }
+    }
+    ST_DEBUG_LOG("StKeyframeIndex, " + aNbEntries + " keyframes loaded from cache for " + myFilePath);
+    return true;
+}
+
+bool StKeyframeIndex::save() const {
+    StString aCacheFolder, aCacheName, aCacheRoot, aDummy;
+    StFileNode::getFolderAndFile(myCachePath,  aCacheFolder, aCacheName);
+    StFileNode::getFolderAndFile(aCacheFolder, aCacheRoot,   aDummy);
+    StFolder::createFolder(aCacheRoot);
+    StFolder::createFolder(aCacheFolder);
+
+    std::vector<char> aBuffer;
+    aBuffer.reserve(64 + myFilePath.getSize() + myEntries.size() * (sizeof(int64_t) * 2 + 1));
+    aBuffer.insert(aBuffer.end(), THE_INDEX_MAGIC, THE_INDEX_MAGIC + sizeof(THE_INDEX_MAGIC));
+    appendValue(aBuffer, THE_INDEX_VERSION);
+    appendValue(aBuffer, myFileSize);
+    appendValue(aBuffer, myFileTime);
+    appendValue(aBuffer, int32_t(myStreamId));
+    appendValue(aBuffer, uint32_t(myFilePath.getSize()));
+    aBuffer.insert(aBuffer.end(), myFilePath.toCString(), myFilePath.toCString() + myFilePath.getSize());
+    appendValue(aBuffer, uint32_t(myEntries.size()));
+    for(size_t anEntryIter = 0; anEntryIter < myEntries.size(); ++anEntryIter) {
+        const Entry& anEntry = myEntries[anEntryIter];
+        appendValue(aBuffer, anEntry.Pts);
+        appendValue(aBuffer, anEntry.Pos);
+        appendValue(aBuffer, uint8_t(anEntry.HasNext ? 1 : 0));
+    }
+
+    StRawFile aFile;
+    if(!aFile.openFile(StRawFile::WRITE, myCachePath)
+    ||  aFile.write(&aBuffer[0], aBuffer.size()) != aBuffer.size()) {
+        ST_DEBUG_LOG("StKeyframeIndex, unable to save cache file " + myCachePath);
+        return false;
+    }
+    return true;
+}
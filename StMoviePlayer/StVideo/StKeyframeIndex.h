@@ -0,0 +1,161 @@
+/**
+ * Copyright © 2017 Kirill Gavrilov <kirill@sview.ru>
+ *
+ * StMoviePlayer program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * StMoviePlayer program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __StKeyframeIndex_h_
+#define __StKeyframeIndex_h_
+
+#include <StStrings/StString.h>
+#include <StThreads/StMutex.h>
+
+#include <vector>
+
+/**
+ * Index of video keyframes (timestamp and byte offset) of single file.
+ * Index is filled by demuxer during playback and persisted in cache folder,
+ * the cache file is identified by file path, size and modification time.
+ *
+ * Since playback may jump over parts of the file, each entry keeps a flag indicating
+ * that the following keyframe in the index is really the next one within the file,
+ * so that only contiguous parts of the index are used for seeking.
+ */
+class StKeyframeIndex {
+
+        public:
+
+    /**
+     * Index entry.
+     */
+    struct Entry {
+        int64_t Pts;         //!< keyframe timestamp in stream time base units
+        int64_t Pos;         //!< byte offset of the packet within the file (-1 if unknown)
+        bool    HasNext;     //!< the next entry is known to be the next keyframe (or end of file for the last one)
+    };
+
+    /**
+     * Retrieve file size and modification time, used to validate cache files.
+     */
+    ST_LOCAL static bool getFileStats(const StString& thePath,
+                                      uint64_t&       theSize,
+                                      int64_t&        theTime);
+
+    /**
+     * Return cache file name (without folder) for specified file path.
+     * @param theFilePath  path to the file
+     * @param theExtension cache file extension
+     */
+    ST_LOCAL static StString getCacheFileName(const StString& theFilePath,
+                                              const char*     theExtension);
+
+        public:
+
+    /**
+     * Empty constructor.
+     */
+    ST_LOCAL StKeyframeIndex();
+
+    /**
+     * Destructor, saves the index.
+     */
+    ST_LOCAL ~StKeyframeIndex();
+
+    /**
+     * Bind the index to the new file and load cached index, if any.
+     * Previous index is saved.
+     * @param theCacheFolder folder to store index files
+     * @param theFilePath    path to the video file (should be local file)
+     * @param theStreamId    video stream index within the file
+     * @return true if cached index has been loaded
+     */
+    ST_LOCAL bool open(const StString& theCacheFolder,
+                       const StString& theFilePath,
+                       const int       theStreamId);
+
+    /**
+     * Save and release the index.
+     */
+    ST_LOCAL void close();
+
+    /**
+     * @return stream index within the file or -1 if index is not opened
+     */
+    ST_LOCAL int getStreamId() const {
+        return myStreamId;
+    }
+
+    /**
+     * @return number of indexed keyframes
+     */
+    ST_LOCAL size_t size() const;
+
+    /**
+     * Register keyframe read by demuxer.
+     */
+    ST_LOCAL void add(const int64_t thePts,
+                      const int64_t thePos);
+
+    /**
+     * Register end of file reached by demuxer.
+     */
+    ST_LOCAL void addEnd();
+
+    /**
+     * Break the sequence of registered keyframes (on seeking).
+     */
+    ST_LOCAL void resetRun();
+
+    /**
+     * Find the keyframe for seeking to specified timestamp.
+     * @param theTarget seeking target in stream time base units
+     * @param theEntry  found keyframe - the last one not after the target
+     * @return false if indexed data does not cover the target
+     */
+    ST_LOCAL bool find(const int64_t theTarget,
+                       Entry&        theEntry) const;
+
+        private:
+
+    /**
+     * Read the index from cache file.
+     */
+    ST_LOCAL bool load();
+
+    /**
+     * Write the index into cache file.
+     */
+    ST_LOCAL bool save() const;
+
+        private:
+
+    mutable StMutex    myMutex;      //!< lock for thread-safety
+    std::vector<Entry> myEntries;    //!< keyframes sorted by timestamp
+    StString           myCachePath;  //!< path to cache file
+    StString           myFilePath;   //!< indexed file path
+    uint64_t           myFileSize;   //!< indexed file size
+    int64_t            myFileTime;   //!< indexed file modification time
+    int                myStreamId;   //!< indexed stream
+    size_t             myLastEntry;  //!< entry added last in current run, or size_t(-1)
+    bool               myIsModified; //!< index has been modified since loading
+
+        private: //! @name no copies, please
+
+    StKeyframeIndex(const StKeyframeIndex& theCopy);
+    const StKeyframeIndex& operator=(const StKeyframeIndex& theCopy);
+
+};
+
+#endif // __StKeyframeIndex_h_
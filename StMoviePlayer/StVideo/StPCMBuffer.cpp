@@ -21,6 +21,14 @@
 #include <stAssert.h>
 #include <StStrings/StLogger.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define ST_PCM_SSE2
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+    #include <arm_neon.h>
+    #define ST_PCM_NEON
+#endif
+
 /**
  * 1 second of 48khz 32bit audio (old AVCODEC_MAX_AUDIO_FRAME_SIZE).
  */
@@ -296,9 +304,12 @@ inline void sampleConv(const float& theSrcSample, uint8_t& theOutSample) {
     theOutSample = uint8_t(theSrcSample * 128.0f + 127.0f);
 }
 
-// float -> int16_t, lossy
+// float -> int16_t, lossy, saturated
 inline void sampleConv(const float& theSrcSample, int16_t& theOutSample) {
-    theOutSample = int16_t(theSrcSample * ST_INT16_MAX_F);
+    const float aSample = theSrcSample * ST_INT16_MAX_F;
+    theOutSample = int16_t(aSample >= 32767.0f
+                         ? 32767.0f
+                         : (aSample <= -32768.0f ? -32768.0f : aSample));
 }
 
 // float -> int32_t
@@ -341,6 +352,453 @@ inline void sampleConv(const double& theSrcSample, double& theOutSample) {
     theOutSample = theSrcSample;
 }
 
+namespace {
+
+    /**
+     * Number of frames converted at once when (de)interleaving.
+     * Temporary planes should fit into L1 cache.
+     */
+    static const size_t ST_PCM_BLOCK_FRAMES = 256;
+
+    /**
+     * Convert contiguous array of samples - generic version.
+     */
+    template<typename sampleSrc_t, typename sampleOut_t>
+    inline void convArray(const sampleSrc_t* theSrc,
+                          sampleOut_t*       theOut,
+                          const size_t       theNbSamples) {
+        for(size_t aSmplIter = 0; aSmplIter < theNbSamples; ++aSmplIter) {
+            sampleConv(theSrc[aSmplIter], theOut[aSmplIter]);
+        }
+    }
+
+    /**
+     * Copy contiguous array of samples - same format.
+     */
+    template<typename sample_t>
+    inline void convArray(const sample_t* theSrc,
+                          sample_t*       theOut,
+                          const size_t    theNbSamples) {
+        stMemCpy(theOut, theSrc, theNbSamples * sizeof(sample_t));
+    }
+
+    // int16_t -> float
+    inline void convArray(const int16_t* theSrc,
+                          float*         theOut,
+                          const size_t   theNbSamples) {
+        size_t aSmplIter = 0;
+    #if defined(ST_PCM_SSE2)
+        const __m128 aScale = _mm_set1_ps(ST_INT16_MAX_INV_F);
+        for(; aSmplIter + 8 <= theNbSamples; aSmplIter += 8) {
+            const __m128i aVec = _mm_loadu_si128((const __m128i* )(theSrc + aSmplIter));
+            const __m128i aLo  = _mm_srai_epi32(_mm_unpacklo_epi16(aVec, aVec), 16);
+            const __m128i aHi  = _mm_srai_epi32(_mm_unpackhi_epi16(aVec, aVec), 16);
+            _mm_storeu_ps(theOut + aSmplIter,     _mm_mul_ps(_mm_cvtepi32_ps(aLo), aScale));
+            _mm_storeu_ps(theOut + aSmplIter + 4, _mm_mul_ps(_mm_cvtepi32_ps(aHi), aScale));
+        }
+    #elif defined(ST_PCM_NEON)
+        for(; aSmplIter + 8 <= theNbSamples; aSmplIter += 8) {
+            const int16x8_t aVec = vld1q_s16(theSrc + aSmplIter);
+            vst1q_f32(theOut + aSmplIter,     vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16 (aVec))), ST_INT16_MAX_INV_F));
+            vst1q_f32(theOut + aSmplIter + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(aVec))), ST_INT16_MAX_INV_F));
+        }
+    #endif
+        for(; aSmplIter < theNbSamples; ++aSmplIter) {
+            sampleConv(theSrc[aSmplIter], theOut[aSmplIter]);
+        }
+    }
+
+    // int32_t -> float
+    inline void convArray(const int32_t* theSrc,
+                          float*         theOut,
+                          const size_t   theNbSamples) {
+        size_t aSmplIter = 0;
+    #if defined(ST_PCM_SSE2)
+        const __m128 aScale = _mm_set1_ps(ST_INT32_MAX_INV_F);
+        for(; aSmplIter + 4 <= theNbSamples; aSmplIter += 4) {
+            const __m128i aVec = _mm_loadu_si128((const __m128i* )(theSrc + aSmplIter));
+            _mm_storeu_ps(theOut + aSmplIter, _mm_mul_ps(_mm_cvtepi32_ps(aVec), aScale));
+        }
+    #elif defined(ST_PCM_NEON)
+        for(; aSmplIter + 4 <= theNbSamples; aSmplIter += 4) {
+            vst1q_f32(theOut + aSmplIter, vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(theSrc + aSmplIter)), ST_INT32_MAX_INV_F));
+        }
+    #endif
+        for(; aSmplIter < theNbSamples; ++aSmplIter) {
+            sampleConv(theSrc[aSmplIter], theOut[aSmplIter]);
+        }
+    }
+
+    // float -> int16_t, saturated
+    inline void convArray(const float* theSrc,
+                          int16_t*     theOut,
+                          const size_t theNbSamples) {
+        size_t aSmplIter = 0;
+    #if defined(ST_PCM_SSE2)
+        const __m128 aScale = _mm_set1_ps(ST_INT16_MAX_F);
+        const __m128 aMin   = _mm_set1_ps(-32768.0f);
+        const __m128 aMax   = _mm_set1_ps( 32767.0f);
+        for(; aSmplIter + 8 <= theNbSamples; aSmplIter += 8) {
+            const __m128 aLo = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(theSrc + aSmplIter),     aScale), aMin), aMax);
+            const __m128 aHi = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(theSrc + aSmplIter + 4), aScale), aMin), aMax);
+            _mm_storeu_si128((__m128i* )(theOut + aSmplIter),
+                             _mm_packs_epi32(_mm_cvttps_epi32(aLo), _mm_cvttps_epi32(aHi)));
+        }
+    #elif defined(ST_PCM_NEON)
+        for(; aSmplIter + 8 <= theNbSamples; aSmplIter += 8) {
+            const int32x4_t aLo = vcvtq_s32_f32(vmulq_n_f32(vld1q_f32(theSrc + aSmplIter),     ST_INT16_MAX_F));
+            const int32x4_t aHi = vcvtq_s32_f32(vmulq_n_f32(vld1q_f32(theSrc + aSmplIter + 4), ST_INT16_MAX_F));
+            vst1q_s16(theOut + aSmplIter, vcombine_s16(vqmovn_s32(aLo), vqmovn_s32(aHi)));
+        }
+    #endif
+        for(; aSmplIter < theNbSamples; ++aSmplIter) {
+            sampleConv(theSrc[aSmplIter], theOut[aSmplIter]);
+        }
+    }
+
+    /**
+     * Interleave planes - generic version.
+     * @param thePlanes  planes in order of interleaved channels
+     * @param theChNb    channels number
+     * @param theOut     interleaved output
+     * @param theFrames  number of samples in each plane
+     */
+    template<typename sample_t>
+    inline void interleaveGeneric(const sample_t* const* thePlanes,
+                                  const size_t           theChNb,
+                                  sample_t*              theOut,
+                                  const size_t           theFrames) {
+        for(size_t aChIter = 0; aChIter < theChNb; ++aChIter) {
+            const sample_t* aPlane = thePlanes[aChIter];
+            sample_t*       anOut  = theOut + aChIter;
+            for(size_t aFrameIter = 0; aFrameIter < theFrames; ++aFrameIter, anOut += theChNb) {
+                *anOut = aPlane[aFrameIter];
+            }
+        }
+    }
+
+    /**
+     * De-interleave into planes - generic version.
+     */
+    template<typename sample_t>
+    inline void deinterleaveGeneric(const sample_t*   theSrc,
+                                    const size_t      theChNb,
+                                    sample_t* const*  thePlanes,
+                                    const size_t      theFrames) {
+        for(size_t aChIter = 0; aChIter < theChNb; ++aChIter) {
+            sample_t*       aPlane = thePlanes[aChIter];
+            const sample_t* aSrc   = theSrc + aChIter;
+            for(size_t aFrameIter = 0; aFrameIter < theFrames; ++aFrameIter, aSrc += theChNb) {
+                aPlane[aFrameIter] = *aSrc;
+            }
+        }
+    }
+
+    /**
+     * Interleave planes of 32-bit samples (float or int32_t).
+     */
+    inline size_t interleave32(const float* const* thePlanes,
+                               const size_t        theChNb,
+                               float*              theOut,
+                               const size_t        theFrames) {
+        size_t aFrameIter = 0;
+    #if defined(ST_PCM_SSE2)
+        switch(theChNb) {
+            case 2: {
+                for(; aFrameIter + 4 <= theFrames; aFrameIter += 4) {
+                    const __m128 aCh0 = _mm_loadu_ps(thePlanes[0] + aFrameIter);
+                    const __m128 aCh1 = _mm_loadu_ps(thePlanes[1] + aFrameIter);
+                    float* anOut = theOut + aFrameIter * 2;
+                    _mm_storeu_ps(anOut,     _mm_unpacklo_ps(aCh0, aCh1));
+                    _mm_storeu_ps(anOut + 4, _mm_unpackhi_ps(aCh0, aCh1));
+                }
+                break;
+            }
+            case 6: {
+                for(; aFrameIter + 4 <= theFrames; aFrameIter += 4) {
+                    __m128 aRow0 = _mm_loadu_ps(thePlanes[0] + aFrameIter);
+                    __m128 aRow1 = _mm_loadu_ps(thePlanes[1] + aFrameIter);
+                    __m128 aRow2 = _mm_loadu_ps(thePlanes[2] + aFrameIter);
+                    __m128 aRow3 = _mm_loadu_ps(thePlanes[3] + aFrameIter);
+                    _MM_TRANSPOSE4_PS(aRow0, aRow1, aRow2, aRow3);
+                    const __m128 aCh4 = _mm_loadu_ps(thePlanes[4] + aFrameIter);
+                    const __m128 aCh5 = _mm_loadu_ps(thePlanes[5] + aFrameIter);
+                    const __m128 aPair01 = _mm_unpacklo_ps(aCh4, aCh5);
+                    const __m128 aPair23 = _mm_unpackhi_ps(aCh4, aCh5);
+                    float* anOut = theOut + aFrameIter * 6;
+                    _mm_storeu_ps(anOut,      aRow0);
+                    _mm_storeu_ps(anOut + 4,  _mm_movelh_ps(aPair01, aRow1));
+                    _mm_storeu_ps(anOut + 8,  _mm_shuffle_ps(aRow1, aPair01, _MM_SHUFFLE(3, 2, 3, 2)));
+                    _mm_storeu_ps(anOut + 12, aRow2);
+                    _mm_storeu_ps(anOut + 16, _mm_movelh_ps(aPair23, aRow3));
+                    _mm_storeu_ps(anOut + 20, _mm_shuffle_ps(aRow3, aPair23, _MM_SHUFFLE(3, 2, 3, 2)));
+                }
+                break;
+            }
+            case 8: {
+                for(; aFrameIter + 4 <= theFrames; aFrameIter += 4) {
+                    __m128 aRow0 = _mm_loadu_ps(thePlanes[0] + aFrameIter);
+                    __m128 aRow1 = _mm_loadu_ps(thePlanes[1] + aFrameIter);
+                    __m128 aRow2 = _mm_loadu_ps(thePlanes[2] + aFrameIter);
+                    __m128 aRow3 = _mm_loadu_ps(thePlanes[3] + aFrameIter);
+                    __m128 aRow4 = _mm_loadu_ps(thePlanes[4] + aFrameIter);
+                    __m128 aRow5 = _mm_loadu_ps(thePlanes[5] + aFrameIter);
+                    __m128 aRow6 = _mm_loadu_ps(thePlanes[6] + aFrameIter);
+                    __m128 aRow7 = _mm_loadu_ps(thePlanes[7] + aFrameIter);
+                    _MM_TRANSPOSE4_PS(aRow0, aRow1, aRow2, aRow3);
+                    _MM_TRANSPOSE4_PS(aRow4, aRow5, aRow6, aRow7);
+                    float* anOut = theOut + aFrameIter * 8;
+                    _mm_storeu_ps(anOut,      aRow0);
+                    _mm_storeu_ps(anOut + 4,  aRow4);
+                    _mm_storeu_ps(anOut + 8,  aRow1);
+                    _mm_storeu_ps(anOut + 12, aRow5);
+                    _mm_storeu_ps(anOut + 16, aRow2);
+                    _mm_storeu_ps(anOut + 20, aRow6);
+                    _mm_storeu_ps(anOut + 24, aRow3);
+                    _mm_storeu_ps(anOut + 28, aRow7);
+                }
+                break;
+            }
+        }
+    #elif defined(ST_PCM_NEON)
+        if(theChNb == 2) {
+            for(; aFrameIter + 4 <= theFrames; aFrameIter += 4) {
+                float32x4x2_t aPair;
+                aPair.val[0] = vld1q_f32(thePlanes[0] + aFrameIter);
+                aPair.val[1] = vld1q_f32(thePlanes[1] + aFrameIter);
+                vst2q_f32(theOut + aFrameIter * 2, aPair);
+            }
+        }
+    #else
+        (void )thePlanes;
+        (void )theChNb;
+        (void )theOut;
+        (void )theFrames;
+    #endif
+        return aFrameIter;
+    }
+
+    /**
+     * De-interleave 32-bit samples (float or int32_t) into planes.
+     */
+    inline size_t deinterleave32(const float*  theSrc,
+                                 const size_t  theChNb,
+                                 float* const* thePlanes,
+                                 const size_t  theFrames) {
+        size_t aFrameIter = 0;
+    #if defined(ST_PCM_SSE2)
+        switch(theChNb) {
+            case 2: {
+                for(; aFrameIter + 4 <= theFrames; aFrameIter += 4) {
+                    const float* aSrc = theSrc + aFrameIter * 2;
+                    const __m128 aVec0 = _mm_loadu_ps(aSrc);
+                    const __m128 aVec1 = _mm_loadu_ps(aSrc + 4);
+                    _mm_storeu_ps(thePlanes[0] + aFrameIter, _mm_shuffle_ps(aVec0, aVec1, _MM_SHUFFLE(2, 0, 2, 0)));
+                    _mm_storeu_ps(thePlanes[1] + aFrameIter, _mm_shuffle_ps(aVec0, aVec1, _MM_SHUFFLE(3, 1, 3, 1)));
+                }
+                break;
+            }
+            case 6: {
+                for(; aFrameIter + 4 <= theFrames; aFrameIter += 4) {
+                    const float* aSrc = theSrc + aFrameIter * 6;
+                    const __m128 aVec1 = _mm_loadu_ps(aSrc + 4);
+                    const __m128 aVec2 = _mm_loadu_ps(aSrc + 8);
+                    const __m128 aVec4 = _mm_loadu_ps(aSrc + 16);
+                    const __m128 aVec5 = _mm_loadu_ps(aSrc + 20);
+                    __m128 aRow0 = _mm_loadu_ps(aSrc);
+                    __m128 aRow1 = _mm_shuffle_ps(aVec1, aVec2, _MM_SHUFFLE(1, 0, 3, 2));
+                    __m128 aRow2 = _mm_loadu_ps(aSrc + 12);
+                    __m128 aRow3 = _mm_shuffle_ps(aVec4, aVec5, _MM_SHUFFLE(1, 0, 3, 2));
+                    const __m128 aPair01 = _mm_shuffle_ps(aVec1, aVec2, _MM_SHUFFLE(3, 2, 1, 0));
+                    const __m128 aPair23 = _mm_shuffle_ps(aVec4, aVec5, _MM_SHUFFLE(3, 2, 1, 0));
+                    _MM_TRANSPOSE4_PS(aRow0, aRow1, aRow2, aRow3);
+                    _mm_storeu_ps(thePlanes[0] + aFrameIter, aRow0);
+                    _mm_storeu_ps(thePlanes[1] + aFrameIter, aRow1);
+                    _mm_storeu_ps(thePlanes[2] + aFrameIter, aRow2);
+                    _mm_storeu_ps(thePlanes[3] + aFrameIter, aRow3);
+                    _mm_storeu_ps(thePlanes[4] + aFrameIter, _mm_shuffle_ps(aPair01, aPair23, _MM_SHUFFLE(2, 0, 2, 0)));
+                    _mm_storeu_ps(thePlanes[5] + aFrameIter, _mm_shuffle_ps(aPair01, aPair23, _MM_SHUFFLE(3, 1, 3, 1)));
+                }
+                break;
+            }
+            case 8: {
+                for(; aFrameIter + 4 <= theFrames; aFrameIter += 4) {
+                    const float* aSrc = theSrc + aFrameIter * 8;
+                    __m128 aRow0 = _mm_loadu_ps(aSrc);
+                    __m128 aRow4 = _mm_loadu_ps(aSrc + 4);
+                    __m128 aRow1 = _mm_loadu_ps(aSrc + 8);
+                    __m128 aRow5 = _mm_loadu_ps(aSrc + 12);
+                    __m128 aRow2 = _mm_loadu_ps(aSrc + 16);
+                    __m128 aRow6 = _mm_loadu_ps(aSrc + 20);
+                    __m128 aRow3 = _mm_loadu_ps(aSrc + 24);
+                    __m128 aRow7 = _mm_loadu_ps(aSrc + 28);
+                    _MM_TRANSPOSE4_PS(aRow0, aRow1, aRow2, aRow3);
+                    _MM_TRANSPOSE4_PS(aRow4, aRow5, aRow6, aRow7);
+                    _mm_storeu_ps(thePlanes[0] + aFrameIter, aRow0);
+                    _mm_storeu_ps(thePlanes[1] + aFrameIter, aRow1);
+                    _mm_storeu_ps(thePlanes[2] + aFrameIter, aRow2);
+                    _mm_storeu_ps(thePlanes[3] + aFrameIter, aRow3);
+                    _mm_storeu_ps(thePlanes[4] + aFrameIter, aRow4);
+                    _mm_storeu_ps(thePlanes[5] + aFrameIter, aRow5);
+                    _mm_storeu_ps(thePlanes[6] + aFrameIter, aRow6);
+                    _mm_storeu_ps(thePlanes[7] + aFrameIter, aRow7);
+                }
+                break;
+            }
+        }
+    #elif defined(ST_PCM_NEON)
+        if(theChNb == 2) {
+            for(; aFrameIter + 4 <= theFrames; aFrameIter += 4) {
+                const float32x4x2_t aPair = vld2q_f32(theSrc + aFrameIter * 2);
+                vst1q_f32(thePlanes[0] + aFrameIter, aPair.val[0]);
+                vst1q_f32(thePlanes[1] + aFrameIter, aPair.val[1]);
+            }
+        }
+    #else
+        (void )theSrc;
+        (void )theChNb;
+        (void )thePlanes;
+        (void )theFrames;
+    #endif
+        return aFrameIter;
+    }
+
+    /**
+     * Interleave planes of 16-bit samples.
+     */
+    inline size_t interleave16(const int16_t* const* thePlanes,
+                               const size_t          theChNb,
+                               int16_t*              theOut,
+                               const size_t          theFrames) {
+        size_t aFrameIter = 0;
+        if(theChNb != 2) {
+            return aFrameIter;
+        }
+    #if defined(ST_PCM_SSE2)
+        for(; aFrameIter + 8 <= theFrames; aFrameIter += 8) {
+            const __m128i aCh0 = _mm_loadu_si128((const __m128i* )(thePlanes[0] + aFrameIter));
+            const __m128i aCh1 = _mm_loadu_si128((const __m128i* )(thePlanes[1] + aFrameIter));
+            int16_t* anOut = theOut + aFrameIter * 2;
+            _mm_storeu_si128((__m128i* )anOut,       _mm_unpacklo_epi16(aCh0, aCh1));
+            _mm_storeu_si128((__m128i* )(anOut + 8), _mm_unpackhi_epi16(aCh0, aCh1));
+        }
+    #elif defined(ST_PCM_NEON)
+        for(; aFrameIter + 8 <= theFrames; aFrameIter += 8) {
+            int16x8x2_t aPair;
+            aPair.val[0] = vld1q_s16(thePlanes[0] + aFrameIter);
+            aPair.val[1] = vld1q_s16(thePlanes[1] + aFrameIter);
+            vst2q_s16(theOut + aFrameIter * 2, aPair);
+        }
+    #else
+        (void )thePlanes;
+        (void )theOut;
+        (void )theFrames;
+    #endif
+        return aFrameIter;
+    }
+
+    /**
+     * De-interleave 16-bit samples into planes.
+     */
+    inline size_t deinterleave16(const int16_t*  theSrc,
+                                 const size_t    theChNb,
+                                 int16_t* const* thePlanes,
+                                 const size_t    theFrames) {
+        size_t aFrameIter = 0;
+        if(theChNb != 2) {
+            return aFrameIter;
+        }
+    #if defined(ST_PCM_SSE2)
+        for(; aFrameIter + 8 <= theFrames; aFrameIter += 8) {
+            const int16_t* aSrc = theSrc + aFrameIter * 2;
+            const __m128i aVec0 = _mm_loadu_si128((const __m128i* )aSrc);
+            const __m128i aVec1 = _mm_loadu_si128((const __m128i* )(aSrc + 8));
+            // each 32-bit lane holds (left, right) pair
+            const __m128i aCh0 = _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(aVec0, 16), 16),
+                                                 _mm_srai_epi32(_mm_slli_epi32(aVec1, 16), 16));
+            const __m128i aCh1 = _mm_packs_epi32(_mm_srai_epi32(aVec0, 16),
+                                                 _mm_srai_epi32(aVec1, 16));
+            _mm_storeu_si128((__m128i* )(thePlanes[0] + aFrameIter), aCh0);
+            _mm_storeu_si128((__m128i* )(thePlanes[1] + aFrameIter), aCh1);
+        }
+    #elif defined(ST_PCM_NEON)
+        for(; aFrameIter + 8 <= theFrames; aFrameIter += 8) {
+            const int16x8x2_t aPair = vld2q_s16(theSrc + aFrameIter * 2);
+            vst1q_s16(thePlanes[0] + aFrameIter, aPair.val[0]);
+            vst1q_s16(thePlanes[1] + aFrameIter, aPair.val[1]);
+        }
+    #else
+        (void )theSrc;
+        (void )thePlanes;
+        (void )theFrames;
+    #endif
+        return aFrameIter;
+    }
+
+    /**
+     * Interleave planes, using vectorized kernel when available.
+     */
+    template<typename sample_t>
+    inline void interleave(const sample_t* const* thePlanes,
+                           const size_t           theChNb,
+                           sample_t*              theOut,
+                           const size_t           theFrames) {
+        size_t aDone = 0;
+        if(sizeof(sample_t) == 4) {
+            aDone = interleave32((const float* const* )thePlanes, theChNb, (float* )theOut, theFrames);
+        } else if(sizeof(sample_t) == 2) {
+            aDone = interleave16((const int16_t* const* )thePlanes, theChNb, (int16_t* )theOut, theFrames);
+        }
+        if(aDone == theFrames) {
+            return;
+        }
+
+        const sample_t* aPlanesTail[ST_AUDIO_CHANNELS_MAX];
+        for(size_t aChIter = 0; aChIter < theChNb; ++aChIter) {
+            aPlanesTail[aChIter] = thePlanes[aChIter] + aDone;
+        }
+        interleaveGeneric(aPlanesTail, theChNb, theOut + aDone * theChNb, theFrames - aDone);
+    }
+
+    /**
+     * De-interleave into planes, using vectorized kernel when available.
+     */
+    template<typename sample_t>
+    inline void deinterleave(const sample_t*  theSrc,
+                             const size_t     theChNb,
+                             sample_t* const* thePlanes,
+                             const size_t     theFrames) {
+        size_t aDone = 0;
+        if(sizeof(sample_t) == 4) {
+            aDone = deinterleave32((const float* )theSrc, theChNb, (float* const* )thePlanes, theFrames);
+        } else if(sizeof(sample_t) == 2) {
+            aDone = deinterleave16((const int16_t* )theSrc, theChNb, (int16_t* const* )thePlanes, theFrames);
+        }
+        if(aDone == theFrames) {
+            return;
+        }
+
+        sample_t* aPlanesTail[ST_AUDIO_CHANNELS_MAX];
+        for(size_t aChIter = 0; aChIter < theChNb; ++aChIter) {
+            aPlanesTail[aChIter] = thePlanes[aChIter] + aDone;
+        }
+        deinterleaveGeneric(theSrc + aDone * theChNb, theChNb, aPlanesTail, theFrames - aDone);
+    }
+
+    /**
+     * @return true if channels are stored in natural order
+     */
+    inline bool isIdentityOrder(const StChannelMap& theChMap) {
+        for(size_t aChIter = 0; aChIter < theChMap.count; ++aChIter) {
+            if(theChMap.Order[aChIter] != aChIter) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+}
+
 template<typename sampleSrc_t, typename sampleOut_t>
 bool StPCMBuffer::addConvert(const StPCMBuffer& theBuffer) {
     if(myPlanesNb > 1 && myPlanesNb != myChMap.count) {
@@ -371,81 +829,61 @@ bool StPCMBuffer::addConvert(const StPCMBuffer& theBuffer) {
         getChannelDataEnd(aChIter, aBuffersOut[aChIter]);
     }
 
-    switch(myChMap.channels) {
-        case StChannelMap::CH10: {
-            for(size_t sampleSrcId(0), sampleOutId(0); sampleSrcId < aSamplesSrcCount; sampleSrcId += aSmplSrcInc, sampleOutId += aSmplOutInc) {
-                sampleConv(aBuffersSrc[0][sampleSrcId], aBuffersOut[0][sampleOutId]);
-            }
-            myPlaneSize += anAddedPlaneSize;
-            return true;
+    const size_t aChNb     = myChMap.count;
+    const size_t aFramesNb = aSamplesSrcCount / aSmplSrcInc;
+    if(aSmplSrcInc == 1 && aSmplOutInc == 1) {
+        // planar -> planar (or mono -> mono)
+        for(size_t aChIter = 0; aChIter < aChNb; ++aChIter) {
+            convArray(aBuffersSrc[aChIter], aBuffersOut[aChIter], aFramesNb);
         }
-        case StChannelMap::CH20: {
-            for(size_t sampleSrcId(0), sampleOutId(0); sampleSrcId < aSamplesSrcCount; sampleSrcId += aSmplSrcInc, sampleOutId += aSmplOutInc) {
-                sampleConv(aBuffersSrc[0][sampleSrcId], aBuffersOut[0][sampleOutId]);
-                sampleConv(aBuffersSrc[1][sampleSrcId], aBuffersOut[1][sampleOutId]);
-            }
-            myPlaneSize += anAddedPlaneSize;
-            return true;
-        }
-        case StChannelMap::CH30: {
-            for(size_t sampleSrcId(0), sampleOutId(0); sampleSrcId < aSamplesSrcCount; sampleSrcId += aSmplSrcInc, sampleOutId += aSmplOutInc) {
-                sampleConv(aBuffersSrc[0][sampleSrcId], aBuffersOut[0][sampleOutId]);
-                sampleConv(aBuffersSrc[1][sampleSrcId], aBuffersOut[1][sampleOutId]);
-                sampleConv(aBuffersSrc[2][sampleSrcId], aBuffersOut[2][sampleOutId]);
-            }
-            myPlaneSize += anAddedPlaneSize;
-            return true;
-        }
-        case StChannelMap::CH40: {
-            for(size_t sampleSrcId(0), sampleOutId(0); sampleSrcId < aSamplesSrcCount; sampleSrcId += aSmplSrcInc, sampleOutId += aSmplOutInc) {
-                sampleConv(aBuffersSrc[0][sampleSrcId], aBuffersOut[0][sampleOutId]);
-                sampleConv(aBuffersSrc[1][sampleSrcId], aBuffersOut[1][sampleOutId]);
-                sampleConv(aBuffersSrc[2][sampleSrcId], aBuffersOut[2][sampleOutId]);
-                sampleConv(aBuffersSrc[3][sampleSrcId], aBuffersOut[3][sampleOutId]);
-            }
-            myPlaneSize += anAddedPlaneSize;
-            return true;
-        }
-        case StChannelMap::CH50: {
-            for(size_t sampleSrcId(0), sampleOutId(0); sampleSrcId < aSamplesSrcCount; sampleSrcId += aSmplSrcInc, sampleOutId += aSmplOutInc) {
-                sampleConv(aBuffersSrc[0][sampleSrcId], aBuffersOut[0][sampleOutId]);
-                sampleConv(aBuffersSrc[1][sampleSrcId], aBuffersOut[1][sampleOutId]);
-                sampleConv(aBuffersSrc[2][sampleSrcId], aBuffersOut[2][sampleOutId]);
-                sampleConv(aBuffersSrc[3][sampleSrcId], aBuffersOut[3][sampleOutId]);
-                sampleConv(aBuffersSrc[4][sampleSrcId], aBuffersOut[4][sampleOutId]);
+    } else if(aSmplSrcInc == 1) {
+        // planar -> interleaved, convert block of samples into temporary planes
+        // ordered as output channels and interleave them at once
+        sampleOut_t aBlock[ST_AUDIO_CHANNELS_MAX * ST_PCM_BLOCK_FRAMES];
+        const sampleOut_t* aPlanesOut[ST_AUDIO_CHANNELS_MAX] = {};
+        sampleOut_t* anOut = (sampleOut_t* )(getPlane(0) + myPlaneSize);
+        for(size_t aFrameFrom = 0; aFrameFrom < aFramesNb; aFrameFrom += ST_PCM_BLOCK_FRAMES) {
+            const size_t aFramesBlock = stMin(aFramesNb - aFrameFrom, ST_PCM_BLOCK_FRAMES);
+            for(size_t aChIter = 0; aChIter < aChNb; ++aChIter) {
+                sampleOut_t* aPlane = aBlock + aChIter * ST_PCM_BLOCK_FRAMES;
+                convArray(aBuffersSrc[aChIter] + aFrameFrom, aPlane, aFramesBlock);
+                aPlanesOut[myChMap.Order[aChIter]] = aPlane;
             }
-            myPlaneSize += anAddedPlaneSize;
-            return true;
-        }
-        case StChannelMap::CH51: {
-            for(size_t sampleSrcId(0), sampleOutId(0); sampleSrcId < aSamplesSrcCount; sampleSrcId += aSmplSrcInc, sampleOutId += aSmplOutInc) {
-                sampleConv(aBuffersSrc[0][sampleSrcId], aBuffersOut[0][sampleOutId]);
-                sampleConv(aBuffersSrc[1][sampleSrcId], aBuffersOut[1][sampleOutId]);
-                sampleConv(aBuffersSrc[2][sampleSrcId], aBuffersOut[2][sampleOutId]);
-                sampleConv(aBuffersSrc[3][sampleSrcId], aBuffersOut[3][sampleOutId]);
-                sampleConv(aBuffersSrc[4][sampleSrcId], aBuffersOut[4][sampleOutId]);
-                sampleConv(aBuffersSrc[5][sampleSrcId], aBuffersOut[5][sampleOutId]);
+            interleave(aPlanesOut, aChNb, anOut + aFrameFrom * aChNb, aFramesBlock);
+        }
+    } else if(aSmplOutInc == 1) {
+        // interleaved -> planar, de-interleave block of samples into temporary planes
+        sampleSrc_t aBlock[ST_AUDIO_CHANNELS_MAX * ST_PCM_BLOCK_FRAMES];
+        sampleSrc_t* aPlanesSrc[ST_AUDIO_CHANNELS_MAX] = {};
+        const sampleSrc_t* aSrc = (const sampleSrc_t* )theBuffer.getPlane(0);
+        for(size_t aChIter = 0; aChIter < aChNb; ++aChIter) {
+            aPlanesSrc[theBuffer.myChMap.Order[aChIter]] = aBlock + aChIter * ST_PCM_BLOCK_FRAMES;
+        }
+        for(size_t aFrameFrom = 0; aFrameFrom < aFramesNb; aFrameFrom += ST_PCM_BLOCK_FRAMES) {
+            const size_t aFramesBlock = stMin(aFramesNb - aFrameFrom, ST_PCM_BLOCK_FRAMES);
+            deinterleave(aSrc + aFrameFrom * aChNb, aChNb, aPlanesSrc, aFramesBlock);
+            for(size_t aChIter = 0; aChIter < aChNb; ++aChIter) {
+                convArray(aBlock + aChIter * ST_PCM_BLOCK_FRAMES, aBuffersOut[aChIter] + aFrameFrom, aFramesBlock);
             }
-            myPlaneSize += anAddedPlaneSize;
-            return true;
-        }
-        case StChannelMap::CH71: {
-            for(size_t sampleSrcId(0), sampleOutId(0); sampleSrcId < aSamplesSrcCount; sampleSrcId += aSmplSrcInc, sampleOutId += aSmplOutInc) {
-                sampleConv(aBuffersSrc[0][sampleSrcId], aBuffersOut[0][sampleOutId]);
-                sampleConv(aBuffersSrc[1][sampleSrcId], aBuffersOut[1][sampleOutId]);
-                sampleConv(aBuffersSrc[2][sampleSrcId], aBuffersOut[2][sampleOutId]);
-                sampleConv(aBuffersSrc[3][sampleSrcId], aBuffersOut[3][sampleOutId]);
-                sampleConv(aBuffersSrc[4][sampleSrcId], aBuffersOut[4][sampleOutId]);
-                sampleConv(aBuffersSrc[5][sampleSrcId], aBuffersOut[5][sampleOutId]);
-                sampleConv(aBuffersSrc[6][sampleSrcId], aBuffersOut[6][sampleOutId]);
-                sampleConv(aBuffersSrc[7][sampleSrcId], aBuffersOut[7][sampleOutId]);
+        }
+    } else if(isIdentityOrder(myChMap)
+           && isIdentityOrder(theBuffer.myChMap)) {
+        // interleaved -> interleaved, format conversion only
+        convArray((const sampleSrc_t* )theBuffer.getPlane(0),
+                  (sampleOut_t* )(getPlane(0) + myPlaneSize),
+                  aFramesNb * aChNb);
+    } else {
+        // interleaved -> interleaved with remapping
+        for(size_t aChIter = 0; aChIter < aChNb; ++aChIter) {
+            const sampleSrc_t* aSrc = aBuffersSrc[aChIter];
+            sampleOut_t*       anOut = aBuffersOut[aChIter];
+            for(size_t aFrameIter = 0; aFrameIter < aFramesNb; ++aFrameIter, aSrc += aSmplSrcInc, anOut += aSmplOutInc) {
+                sampleConv(*aSrc, *anOut);
             }
-            myPlaneSize += anAddedPlaneSize;
-            return true;
         }
-        default:
-            return false;
     }
+    myPlaneSize += anAddedPlaneSize;
+    return true;
 }
 
 bool StPCMBuffer::addData(const StPCMBuffer& theBuffer) {
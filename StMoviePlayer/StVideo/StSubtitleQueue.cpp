@@ -111,20 +111,19 @@ void StSubtitleQueue::decodeLoop() {
     double aPts = 0.0;
     double aDuration = 0.0;
     AVSubtitle aSubtitle;
-
+    StAVPacket aPacket;
     for(;;) {
         if(isEmpty()) {
             evDowntime.set();
-            StThread::sleep(10);
+            waitPackets(100);
             continue;
         }
         evDowntime.reset();
 
-        StHandle<StAVPacket> aPacket = pop();
-        if(aPacket.isNull()) {
+        if(!pop(aPacket)) {
             continue;
         }
-        switch(aPacket->getType()) {
+        switch(aPacket.getType()) {
             case StAVPacket::FLUSH_PACKET: {
                 // got the special FLUSH packet - flush FFmpeg codec buffers
                 if(myCodecCtx != NULL && myCodec != NULL) {
@@ -148,20 +147,20 @@ void StSubtitleQueue::decodeLoop() {
             }
         }
 
-        aPts      = unitsToSeconds(aPacket->getPts()) - myPtsStartBase;
-        aDuration = unitsToSeconds(aPacket->getConvergenceDuration());
+        aPts      = unitsToSeconds(aPacket.getPts()) - myPtsStartBase;
+        aDuration = unitsToSeconds(aPacket.getConvergenceDuration());
         if(myCodec != NULL) {
             // decode subtitle item
         #if(LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(52, 23, 0))
             avcodec_decode_subtitle2(myCodecCtx, &aSubtitle,
-                                     &isFrameFinished, aPacket->getAVpkt());
+                                     &isFrameFinished, aPacket.getAVpkt());
         #else
             avcodec_decode_subtitle(myCodecCtx, &aSubtitle,
                                     &isFrameFinished,
-                                    aPacket->getData(), aPacket->getSize());
+                                    aPacket.getData(), aPacket.getSize());
         #endif
 
-            if(isFrameFinished != 0 && aPacket->getPts() != stAV::NOPTS_VALUE) {
+            if(isFrameFinished != 0 && aPacket.getPts() != stAV::NOPTS_VALUE) {
                 for(unsigned aRectId = 0; aRectId < aSubtitle.num_rects; ++aRectId) {
                     AVSubtitleRect* aRect = aSubtitle.rects[aRectId];
                     if(aRect == NULL) {
@@ -251,12 +250,12 @@ void StSubtitleQueue::decodeLoop() {
         } else {
             // just plain text
             StHandle<StSubItem> aNewSubItem = new StSubItem(aPts, aPts + aDuration);
-            aNewSubItem->Text = (const char* )aPacket->getData();
+            aNewSubItem->Text = (const char* )aPacket.getData();
             aNewSubItem->Text.replaceFast(ST_CRLF_REDUNDANT, ST_CRLF_REPLACEMENT); // remove redundant CR symbols
             myOutQueue->push(aNewSubItem);
         }
 
         // and now packet finished
-        aPacket.nullify();
+        aPacket.free();
     }
 }
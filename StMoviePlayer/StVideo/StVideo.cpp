@@ -28,6 +28,37 @@ namespace {
     static const char ST_AUDIOS_MIME_STRING[] = ST_VIDEO_PLUGIN_AUDIO_MIME_CHAR;
     static const char ST_SUBTIT_MIME_STRING[] = ST_VIDEO_PLUGIN_SUBTIT_MIME_CHAR;
 
+    static const size_t THE_READ_AHEAD_CHUNK     = 512 * 1024; //!< size of single read-ahead request
+    static const size_t THE_READ_AHEAD_NB_CHUNKS = 64;         //!< read-ahead ring size limit (32 MiB per file, less for smaller files)
+    static const double THE_PREOPEN_AHEAD_SEC    = 10.0;       //!< time before the end to start opening the next item
+    static const size_t THE_EVENTS_WAIT_MSEC     = 20;         //!< wait limit for packets loop to poll unsignaled state (parameters, I/O buffer fill)
+    static const size_t THE_SPACE_WAIT_MSEC      = 100;        //!< wait limit for demuxing thread pushing into full queue
+
+    /**
+     * Append metric description in Prometheus text format.
+     */
+    static void appendMetric(StString&   theText,
+                             const char* theName,
+                             const char* theType,
+                             const char* theHelp) {
+        theText += StString("# HELP ") + theName + " " + theHelp + "\n"
+                 + "# TYPE " + theName + " " + theType + "\n";
+    }
+
+    /**
+     * Append metric sample in Prometheus text format.
+     */
+    static void appendMetricValue(StString&    theText,
+                                  const char*  theName,
+                                  const char*  theStream,
+                                  const double theValue) {
+        char aBuff[64];
+        stsprintf(aBuff, sizeof(aBuff), "%.9g", theValue);
+        theText += StString(theName)
+                 + (theStream != NULL ? (StString("{stream=\"") + theStream + "\"}") : StString())
+                 + " " + aBuff + "\n";
+    }
+
     static SV_THREAD_FUNCTION threadFunction(void* theStVideo) {
         StVideo* aStVideo  = (StVideo* )theStVideo;
         aStVideo->mainLoop();
@@ -118,12 +149,15 @@ StVideo::StVideo(const std::string&                 theALDeviceName,
   myToSeekBack(false),
   myPlayEvent(ST_PLAYEVENT_NONE),
   myTargetFps(0.0),
+  myIOBufferFill(-1.0),
+  myAVDrift(0.0),
   //
   myAudioDelayMSec(0),
   myIsBenchmark(false),
   toSave(StImageFile::ST_TYPE_NONE),
   toQuit(false),
-  myQuitEvent(false) {
+  myQuitEvent(false),
+  myDemuxEvent(false) {
     // initialize FFmpeg library if not yet performed
     stAV::init();
 
@@ -151,6 +185,9 @@ StVideo::StVideo(const std::string&                 theALDeviceName,
     mySubtitles = new StSubtitleQueue(theSubtitlesQueue);
     mySubtitles->signals.onError.connect(this, &StVideo::doOnErrorRedirect);
 
+    myThumbnails = new StVideoThumbnails(myResMgr->getCacheFolder());
+    myPreopener  = new StVideoPreopener(myTracksExt);
+
     // launch working thread
     myThread = new StThread(threadFunction, (void* )this, "StVideo");
 }
@@ -283,6 +320,8 @@ void StVideo::close() {
     myCtxList.clear();
     myFileIOList.clear();
     myPlayCtxList.clear();
+    myKeyframes.close();
+    myThumbnails->close();
     mySlaveCtx    = NULL;
     mySlaveStream = -1;
 
@@ -299,6 +338,36 @@ void StVideo::close() {
 
 void StVideo::setBenchmark(bool toPerformBenchmark) {
     myIsBenchmark = toPerformBenchmark;
+    myTextureQueue->changeLatencyMeter().setEnabled(toPerformBenchmark);
+}
+
+void StVideo::setBenchmarkReport(const StString& thePath) {
+    myEventMutex.lock();
+    myBenchmarkReport = thePath;
+    myEventMutex.unlock();
+}
+
+void StVideo::saveBenchmarkReport() {
+    StLatencyMeter& aMeter = myTextureQueue->changeLatencyMeter();
+    if(!myIsBenchmark
+    || !aMeter.isEnabled()) {
+        return;
+    }
+
+    myEventMutex.lock();
+    const StString aPath = myBenchmarkReport;
+    myEventMutex.unlock();
+    const StString aTitle = !myCurrNode.isNull() ? myCurrNode->getPath() : StString();
+    ST_DEBUG_LOG("Benchmark report:\n" + aMeter.formatCsv(aTitle));
+    if(!aPath.isEmpty()) {
+        if(!aMeter.saveReport(aPath, aTitle)) {
+            signals.onError(StString("Benchmark report can not be saved to '") + aPath + "'");
+        }
+    }
+
+    // start new measurements for next file
+    aMeter.reset();
+    signals.onBenchmarkDone();
 }
 
 void StVideo::setAudioDelay(const float theDelaySec) {
@@ -306,12 +375,20 @@ void StVideo::setAudioDelay(const float theDelaySec) {
     myVideoMaster->setAudioDelay(myAudioDelayMSec);
 }
 
-bool StVideo::addFile(const StString& theFileToLoad,
-                      const StHandle<StStereoParams>& theNewParams,
-                      StStreamsInfo&  theInfo) {
-    // open video file
-    StString aFileName, aDummy;
-    StFileNode::getFolderAndFile(theFileToLoad, aDummy, aFileName);
+bool StVideo::openInput(const StString&          theFileToLoad,
+                        AVFormatContext*&        theFormatCtx,
+                        StHandle<StAVIOContext>& theIOContext,
+                        const bool               theToReadAhead) {
+    // file might be already opened in background (without read-ahead)
+    if(myPreopener->take(theFileToLoad, theFormatCtx, theIOContext)) {
+        StHandle<StAVIOFileContext> aFileCtx = StHandle<StAVIOFileContext>::downcast(theIOContext);
+        if(theToReadAhead
+        && !aFileCtx.isNull()) {
+            aFileCtx->setReadAhead(THE_READ_AHEAD_CHUNK, THE_READ_AHEAD_NB_CHUNKS);
+        }
+        return true;
+    }
+
     AVFormatContext* aFormatCtx = NULL;
 
     StHandle<StAVIOContext> anIOContext;
@@ -320,11 +397,25 @@ bool StVideo::addFile(const StString& theFileToLoad,
         if(aFileDescriptor != -1) {
             StHandle<StAVIOFileContext> aFileCtx = new StAVIOFileContext();
             if(aFileCtx->openFromDescriptor(aFileDescriptor, "rb")) {
+                if(theToReadAhead) {
+                    aFileCtx->setReadAhead(THE_READ_AHEAD_CHUNK, THE_READ_AHEAD_NB_CHUNKS);
+                }
                 aFormatCtx = avformat_alloc_context();
                 aFormatCtx->pb = aFileCtx->getAvioContext();
                 anIOContext = aFileCtx;
             }
         }
+    } else if(theToReadAhead
+           && !StFileNode::isRemoteProtocolPath(theFileToLoad)
+           &&  StFileNode::isFileExists(theFileToLoad)) {
+        // read local files in background to smooth out stalls of slow storage (high-bitrate files on HDD / NAS)
+        StHandle<StAVIOFileContext> aFileCtx = new StAVIOFileContext();
+        if(aFileCtx->openFile(theFileToLoad)
+        && aFileCtx->setReadAhead(THE_READ_AHEAD_CHUNK, THE_READ_AHEAD_NB_CHUNKS)) {
+            aFormatCtx = avformat_alloc_context();
+            aFormatCtx->pb = aFileCtx->getAvioContext();
+            anIOContext = aFileCtx;
+        }
     }
 
 #if(LIBAVFORMAT_VERSION_INT >= AV_VERSION_INT(53, 2, 0))
@@ -362,6 +453,24 @@ bool StVideo::addFile(const StString& theFileToLoad,
         return false;
     }
 
+    theFormatCtx = aFormatCtx;
+    theIOContext = anIOContext;
+    return true;
+}
+
+bool StVideo::addFile(const StString& theFileToLoad,
+                      const StHandle<StStereoParams>& theNewParams,
+                      StStreamsInfo&  theInfo,
+                      const bool      theToReadAhead) {
+    // open video file
+    StString aFileName, aDummy;
+    StFileNode::getFolderAndFile(theFileToLoad, aDummy, aFileName);
+    AVFormatContext* aFormatCtx = NULL;
+    StHandle<StAVIOContext> anIOContext;
+    if(!openInput(theFileToLoad, aFormatCtx, anIOContext, theToReadAhead)) {
+        return false;
+    }
+
 #ifdef ST_DEBUG
 #if(LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(52, 101, 0))
     av_dump_format(aFormatCtx, 0, theFileToLoad.toCString(), false);
@@ -409,6 +518,12 @@ bool StVideo::addFile(const StString& theFileToLoad,
                 myVideoMaster->setSlave(NULL);
 
                 if(myVideoMaster->isInitialized()) {
+                    if(!stAV::isAttachedPicture(aStream)
+                    && !StFileNode::isRemoteProtocolPath(theFileToLoad)
+                    && !StFileNode::isContentProtocolPath(theFileToLoad)) {
+                        myKeyframes.open(myResMgr->getCacheFolder(), theFileToLoad, aStreamId);
+                        myThumbnails->open(theFileToLoad);
+                    }
                     myAudio->setTrackHeadOrientation(params.ToTrackHeadAudio->getValue() && theNewParams->ViewingMode != StViewSurface_Plain);
 
                     const int aSizeX      = myVideoMaster->sizeX();
@@ -548,12 +663,22 @@ bool StVideo::addFile(const StString& theFileToLoad,
     return true;
 }
 
+void StVideo::preopenNext() {
+    StHandle<StFileNode> aNextFile;
+    if(myPlayList->getNextFile(aNextFile)) {
+        myPreopener->request(aNextFile, params.ToSearchSubs->getValue());
+    }
+}
+
 bool StVideo::openSource(const StHandle<StFileNode>&     theNewSource,
                          const StHandle<StStereoParams>& theNewParams,
                          const StHandle<StFileNode>&     theNewPlsFile) {
     // just for safe - close previously opened video
     close();
 
+    // wait for the item being opened in background
+    const bool isPreopened = myPreopener->waitFor(theNewSource);
+
     const bool toUseGpu      = params.UseGpu->getValue();
     const bool toUseOpenJpeg = params.UseOpenJpeg->getValue();
     myVideoMaster->setUseGpu(toUseGpu);
@@ -570,14 +695,14 @@ bool StVideo::openSource(const StHandle<StFileNode>&     theNewSource,
     if(!theNewSource->isEmpty()) {
         bool isLoaded = false;
         for(size_t aNode = 0; aNode < theNewSource->size(); ++aNode) {
-            isLoaded = addFile(theNewSource->getValue(aNode)->getPath(), theNewParams, aStreamsInfo) || isLoaded;
+            isLoaded = addFile(theNewSource->getValue(aNode)->getPath(), theNewParams, aStreamsInfo, true) || isLoaded;
         }
         if(!isLoaded) {
             return false;
         }
     } else {
         const StString aFullPath = theNewSource->getPath();
-        if(!addFile(aFullPath, theNewParams, aStreamsInfo)) {
+        if(!addFile(aFullPath, theNewParams, aStreamsInfo, true)) {
             return false;
         }
 
@@ -585,30 +710,18 @@ bool StVideo::openSource(const StHandle<StFileNode>&     theNewSource,
         if(params.ToSearchSubs->getValue()
         && myVideoMaster->isInitialized()
         && !StFileNode::isRemoteProtocolPath(aFullPath)) {
-            StString aFolder, aFileName;
-            StFileNode::getFolderAndFile(aFullPath, aFolder, aFileName);
-            if(aFileName.getLength() > 8) { // ignore too short names
-                StString aName, anExtension, aTrackName, aTrackExtension;
-                StFileNode::getNameAndExtension(aFileName, aName, anExtension);
-                if(myTracksFolder.getPath() != aFolder) {
-                    // notice that playlist re-loading is not checked here...
-                    myTracksFolder.setSubPath(aFolder);
-                    myTracksFolder.init(myTracksExt, 1);
-                }
-                for(size_t aNodeIter = 0; aNodeIter < myTracksFolder.size(); ++aNodeIter) {
-                    const StFileNode* aNode          = myTracksFolder.getValue(aNodeIter);
-                    const StString&   aTrackFileName = aNode->getSubPath();
-                    StFileNode::getNameAndExtension(aTrackFileName, aTrackName, aTrackExtension);
-                    if(aFileName != aTrackFileName
-                    && aTrackName.isStartsWithIgnoreCase(aName)) {
-                        //myPlayList->addToNode(aCurrFile, aFilePath);
-                        //myPlayList->getCurrentFile(theNewSource, theNewParams)
-                        addFile(aNode->getPath(), theNewParams, aStreamsInfo);
-                    }
-                }
+            StArrayList<StString> aTracks(8);
+            if(!isPreopened
+            || !myPreopener->getTracks(aTracks)) {
+                StVideoPreopener::findTracks(aFullPath, myTracksFolder, myTracksExt, aTracks);
+            }
+            for(size_t aTrackIter = 0; aTrackIter < aTracks.size(); ++aTrackIter) {
+                addFile(aTracks[aTrackIter], theNewParams, aStreamsInfo, false);
             }
         }
     }
+    // release pre-opened files left unused
+    myPreopener->clear();
 
     // read general information about streams
     for(size_t aCtxIter = 0; aCtxIter < myCtxList.size(); ++aCtxIter) {
@@ -733,6 +846,7 @@ void StVideo::doFlushSoft() {
 
 void StVideo::doSeek(const double theSeekPts,
                      const bool   toSeekBack) {
+    myKeyframes.resetRun();
     for(size_t ctxId = 0; ctxId < myPlayCtxList.size(); ++ctxId) {
         doSeekContext(myPlayCtxList[ctxId], theSeekPts, toSeekBack);
     }
@@ -747,7 +861,8 @@ void StVideo::doSeekContext(AVFormatContext* theFormatCtx,
     // try seek the Video stream first to got key frame
     bool isSeekDone = false;
     if(myVideoMaster->isInContext(theFormatCtx)) {
-        isSeekDone = doSeekStream(theFormatCtx, myVideoMaster->getId(), theSeekPts, toSeekBack);
+        isSeekDone = doSeekIndexed(theFormatCtx, myVideoMaster->getId(), theSeekPts)
+                  || doSeekStream (theFormatCtx, myVideoMaster->getId(), theSeekPts, toSeekBack);
     } else if(myVideoSlave->isInContext(theFormatCtx)) {
         isSeekDone = doSeekStream(theFormatCtx, myVideoSlave->getId(), theSeekPts, toSeekBack);
     }
@@ -797,6 +912,31 @@ bool StVideo::doSeekStream(AVFormatContext* theFormatCtx,
     return isSeekDone;
 }
 
+bool StVideo::doSeekIndexed(AVFormatContext* theFormatCtx,
+                            const signed int theStreamId,
+                            const double     theSeekPts) {
+    if(myKeyframes.getStreamId() != theStreamId) {
+        return false;
+    }
+
+    AVStream* aStream = theFormatCtx->streams[theStreamId];
+    const int64_t aSeekTarget = stAV::secondsToUnits(aStream, theSeekPts + stAV::unitsToSeconds(aStream, aStream->start_time));
+    StKeyframeIndex::Entry aKeyframe;
+    if(!myKeyframes.find(aSeekTarget, aKeyframe)) {
+        return false;
+    }
+
+    // byte offset is the most precise target for stream-oriented formats without own index (MPEG-TS, MPEG-PS),
+    // while container formats are seeked to exact keyframe timestamp
+    if(aKeyframe.Pos >= 0
+    && (theFormatCtx->iformat->flags & AVFMT_TS_DISCONT)   != 0
+    && (theFormatCtx->iformat->flags & AVFMT_NO_BYTE_SEEK) == 0
+    && av_seek_frame(theFormatCtx, theStreamId, aKeyframe.Pos, AVSEEK_FLAG_BYTE) >= 0) {
+        return true;
+    }
+    return av_seek_frame(theFormatCtx, theStreamId, aKeyframe.Pts, AVSEEK_FLAG_BACKWARD) >= 0;
+}
+
 bool StVideo::pushPacket(StHandle<StAVPacketQueue>& theAVPacketQueue,
                          StAVPacket& thePacket) {
     if(theAVPacketQueue->isFull()) {
@@ -807,6 +947,209 @@ bool StVideo::pushPacket(StHandle<StAVPacketQueue>& theAVPacketQueue,
     return true;
 }
 
+bool StVideo::pushPacket(AVFormatContext* theFormatCtx,
+                         StAVPacket&      thePacket) {
+    if(myVideoMaster->isInContext(theFormatCtx, thePacket.getStreamId())) {
+        if(!pushPacket(myVideoMaster, thePacket)) {
+            return false;
+        }
+        const double aTagerFpsNew = myVideoTimer->getAverFps();
+        if(myTargetFps != aTagerFpsNew) {
+            myEventMutex.lock();
+            myTargetFps = aTagerFpsNew;
+            myEventMutex.unlock();
+        }
+    } else if(myVideoSlave->isInContext(theFormatCtx, thePacket.getStreamId())) {
+        return pushPacket(myVideoSlave, thePacket);
+    } else if(myAudio->isInContext(theFormatCtx, thePacket.getStreamId())) {
+        return pushPacket(myAudio, thePacket);
+    } else if(mySubtitles->isInContext(theFormatCtx, thePacket.getStreamId())) {
+        return pushPacket(mySubtitles, thePacket);
+    }
+    return true;
+}
+
+void StVideo::waitPacketQueue(AVFormatContext*  theFormatCtx,
+                              const StAVPacket& thePacket) {
+    const signed int aStreamId = thePacket.getStreamId();
+    if(myVideoMaster->isInContext(theFormatCtx, aStreamId)) {
+        myVideoMaster->waitSpace(THE_SPACE_WAIT_MSEC);
+    } else if(myVideoSlave->isInContext(theFormatCtx, aStreamId)) {
+        myVideoSlave->waitSpace(THE_SPACE_WAIT_MSEC);
+    } else if(myAudio->isInContext(theFormatCtx, aStreamId)) {
+        myAudio->waitSpace(THE_SPACE_WAIT_MSEC);
+    } else if(mySubtitles->isInContext(theFormatCtx, aStreamId)) {
+        mySubtitles->waitSpace(THE_SPACE_WAIT_MSEC);
+    }
+}
+
+/**
+ * Demuxing thread reading packets from single format context.
+ */
+struct StVideo::StDemuxer {
+
+    StVideo*           Owner;       //!< owner
+    AVFormatContext*   Context;     //!< format context to read
+    StAVPacket         Packet;      //!< packet which has been read but not yet pushed
+    StHandle<StThread> Thread;      //!< demuxing thread
+    StCondition        EventResume; //!< event to resume reading after pause
+    StCondition        EventPaused; //!< event indicating that thread has been paused
+    StCondition        EventWakeUp; //!< event to wake up thread waiting at end of file
+    volatile bool      ToPause;     //!< flag to pause reading
+    volatile bool      ToQuit;      //!< flag to stop the thread
+    volatile bool      IsEof;       //!< end of file has been reached
+    bool               HasPacket;   //!< Packet is not yet pushed
+
+    StDemuxer(StVideo*                        theOwner,
+              AVFormatContext*                theContext,
+              const StHandle<StStereoParams>& theParams)
+    : Owner(theOwner),
+      Context(theContext),
+      Packet(theParams),
+      EventResume(false),
+      EventPaused(false),
+      EventWakeUp(false),
+      ToPause(false),
+      ToQuit(false),
+      IsEof(false),
+      HasPacket(false) {}
+
+};
+
+SV_THREAD_FUNCTION StVideo::demuxThreadFunction(void* theDemuxer) {
+    StDemuxer* aDemuxer = (StDemuxer* )theDemuxer;
+    aDemuxer->Owner->demuxLoop(*aDemuxer);
+    return SV_THREAD_RETURN 0;
+}
+
+void StVideo::demuxLoop(StDemuxer& theDemuxer) {
+    StLatencyMeter& aLatencyMeter = myTextureQueue->changeLatencyMeter();
+    StTimer aDemuxTimer(false);
+    for(;;) {
+        if(theDemuxer.ToQuit) {
+            break;
+        } else if(theDemuxer.ToPause) {
+            theDemuxer.EventResume.reset();
+            theDemuxer.EventPaused.set();
+            theDemuxer.EventResume.wait();
+            continue;
+        } else if(theDemuxer.IsEof) {
+            // wait for seeking or stop, flags are checked after reset to not miss concurrent request
+            theDemuxer.EventWakeUp.reset();
+            if(!theDemuxer.ToPause
+            && !theDemuxer.ToQuit) {
+                theDemuxer.EventWakeUp.wait();
+            }
+            continue;
+        }
+
+        if(!theDemuxer.HasPacket) {
+            // read next packet
+            aDemuxTimer.restart();
+            if(av_read_frame(theDemuxer.Context, theDemuxer.Packet.getAVpkt()) < 0) {
+                theDemuxer.IsEof = true;
+                if(myVideoMaster->isInContext(theDemuxer.Context)) {
+                    myKeyframes.addEnd();
+                }
+                myDemuxEvent.set();
+                continue;
+            }
+            theDemuxer.HasPacket = true;
+            if(myVideoMaster->isInContext(theDemuxer.Context, theDemuxer.Packet.getStreamId())) {
+                if(aLatencyMeter.isEnabled()) {
+                    aLatencyMeter.addSample(StLatencyMeter::Stage_Demux, aDemuxTimer.getElapsedTimeInMicroSec());
+                }
+
+                // register keyframe in index
+                const AVPacket* aPkt = theDemuxer.Packet.getAVpkt();
+                const int64_t   aPts = aPkt->pts != stAV::NOPTS_VALUE ? aPkt->pts : aPkt->dts;
+                if(theDemuxer.Packet.isKeyFrame()
+                && aPts != stAV::NOPTS_VALUE) {
+                    myKeyframes.add(aPts, aPkt->pos);
+                }
+            }
+        }
+
+        // push packet to appropriate queue
+        if(!pushPacket(theDemuxer.Context, theDemuxer.Packet)) {
+            // pause and stop requests wake up the waiting thread
+            waitPacketQueue(theDemuxer.Context, theDemuxer.Packet);
+            continue;
+        }
+        theDemuxer.Packet.free();
+        theDemuxer.HasPacket = false;
+    }
+    theDemuxer.Packet.free();
+    theDemuxer.HasPacket = false;
+}
+
+void StVideo::startDemuxers() {
+    for(size_t aCtxId = 0; aCtxId < myPlayCtxList.size(); ++aCtxId) {
+        StDemuxer* aDemuxer = new StDemuxer(this, myPlayCtxList[aCtxId], myCurrParams);
+        aDemuxer->Thread = new StThread(demuxThreadFunction, (void* )aDemuxer, "StVideoDemuxer");
+        myDemuxers.push_back(aDemuxer);
+    }
+}
+
+void StVideo::stopDemuxers() {
+    for(size_t aDemuxIter = 0; aDemuxIter < myDemuxers.size(); ++aDemuxIter) {
+        StDemuxer* aDemuxer = myDemuxers[aDemuxIter];
+        aDemuxer->ToQuit = true;
+        aDemuxer->EventResume.set();
+    }
+    wakeUpDemuxers();
+    for(size_t aDemuxIter = 0; aDemuxIter < myDemuxers.size(); ++aDemuxIter) {
+        StDemuxer* aDemuxer = myDemuxers[aDemuxIter];
+        aDemuxer->Thread->wait();
+        aDemuxer->Thread.nullify();
+        delete aDemuxer;
+    }
+    myDemuxers.clear();
+}
+
+void StVideo::pauseDemuxers() {
+    for(size_t aDemuxIter = 0; aDemuxIter < myDemuxers.size(); ++aDemuxIter) {
+        myDemuxers[aDemuxIter]->ToPause = true;
+    }
+    wakeUpDemuxers();
+    for(size_t aDemuxIter = 0; aDemuxIter < myDemuxers.size(); ++aDemuxIter) {
+        myDemuxers[aDemuxIter]->EventPaused.wait();
+    }
+}
+
+void StVideo::resumeDemuxers(const bool toReset) {
+    for(size_t aDemuxIter = 0; aDemuxIter < myDemuxers.size(); ++aDemuxIter) {
+        StDemuxer* aDemuxer = myDemuxers[aDemuxIter];
+        if(toReset) {
+            aDemuxer->Packet.free();
+            aDemuxer->HasPacket = false;
+            aDemuxer->IsEof     = false;
+        }
+        aDemuxer->EventPaused.reset();
+        aDemuxer->ToPause = false;
+        aDemuxer->EventResume.set();
+    }
+}
+
+void StVideo::wakeUpDemuxers() {
+    for(size_t aDemuxIter = 0; aDemuxIter < myDemuxers.size(); ++aDemuxIter) {
+        myDemuxers[aDemuxIter]->EventWakeUp.set();
+    }
+    myVideoMaster->wakeUpPusher();
+    myVideoSlave ->wakeUpPusher();
+    myAudio      ->wakeUpPusher();
+    mySubtitles  ->wakeUpPusher();
+}
+
+bool StVideo::isDemuxersEof() const {
+    for(size_t aDemuxIter = 0; aDemuxIter < myDemuxers.size(); ++aDemuxIter) {
+        if(!myDemuxers[aDemuxIter]->IsEof) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void StVideo::checkInitVideoStreams() {
     const bool toUseGpu      = params.UseGpu->getValue();
     const bool toDecodeSlave = myVideoMaster->getStereoFormatByUser() == StFormat_AUTO
@@ -816,6 +1159,7 @@ void StVideo::checkInitVideoStreams() {
                            || (myVideoSlave->isInitialized() && myVideoSlave->isGpuFailed());
     if(toUseGpu      != myVideoMaster->toUseGpu()
     || toDecodeSlave != myVideoSlave->isInitialized()) {
+        pauseDemuxers();
         doFlush();
         if(myVideoMaster->isInitialized()) {
             const StString   aFileNameMaster = myVideoMaster->getFileName();
@@ -853,9 +1197,90 @@ void StVideo::checkInitVideoStreams() {
             myVideoMaster->setUseGpu(toUseGpu);
             myVideoSlave ->setUseGpu(toUseGpu);
         }
+        resumeDemuxers(false);
     }
 }
 
+void StVideo::updateIOBufferFill() {
+    double aFill = -1.0;
+    for(size_t anIOIter = 0; anIOIter < myFileIOList.size(); ++anIOIter) {
+        StHandle<StAVIOFileContext> aFileCtx = StHandle<StAVIOFileContext>::downcast(myFileIOList[anIOIter]);
+        if(aFileCtx.isNull()
+        || !aFileCtx->hasReadAhead()) {
+            continue;
+        }
+        const double aCtxFill = aFileCtx->getBufferFill();
+        aFill = aFill < 0.0 ? aCtxFill : stMin(aFill, aCtxFill);
+    }
+    myIOBufferFill = aFill;
+}
+
+StString StVideo::formatMetrics() {
+    StString aText;
+    const StAVPacketQueue* aQueues[4] = { myVideoMaster.access(), myVideoSlave.access(), myAudio.access(), mySubtitles.access() };
+    const char* aQueueNames[4] = { "video", "video_slave", "audio", "subtitles" };
+
+    appendMetric(aText, "sview_packet_queue_packets", "gauge", "Number of packets in demuxer queue.");
+    for(size_t aQueueIter = 0; aQueueIter < 4; ++aQueueIter) {
+        if(aQueues[aQueueIter]->isInitialized()) {
+            appendMetricValue(aText, "sview_packet_queue_packets", aQueueNames[aQueueIter], double(aQueues[aQueueIter]->getSize()));
+        }
+    }
+    appendMetric(aText, "sview_packet_queue_seconds", "gauge", "Duration of packets in demuxer queue.");
+    for(size_t aQueueIter = 0; aQueueIter < 4; ++aQueueIter) {
+        if(aQueues[aQueueIter]->isInitialized()) {
+            appendMetricValue(aText, "sview_packet_queue_seconds", aQueueNames[aQueueIter], aQueues[aQueueIter]->getSizeSeconds());
+        }
+    }
+    appendMetric(aText, "sview_packet_queue_bytes", "gauge", "Size of packets data in demuxer queue.");
+    for(size_t aQueueIter = 0; aQueueIter < 4; ++aQueueIter) {
+        if(aQueues[aQueueIter]->isInitialized()) {
+            appendMetricValue(aText, "sview_packet_queue_bytes", aQueueNames[aQueueIter], double(aQueues[aQueueIter]->getBytesQueued()));
+        }
+    }
+
+    int    aQueued = 0, aQueueLen = 0;
+    double aFps    = 0.0;
+    myTextureQueue->getQueueInfo(aQueued, aQueueLen, aFps);
+    appendMetric     (aText, "sview_texture_queue_frames", "gauge", "Number of decoded frames in texture queue.");
+    appendMetricValue(aText, "sview_texture_queue_frames", NULL, double(aQueued));
+    appendMetric     (aText, "sview_texture_queue_capacity", "gauge", "Texture queue capacity.");
+    appendMetricValue(aText, "sview_texture_queue_capacity", NULL, double(aQueueLen));
+    appendMetric     (aText, "sview_playback_fps", "gauge", "Average playback frame rate.");
+    appendMetricValue(aText, "sview_playback_fps", NULL, stMax(aFps, 0.0));
+    appendMetric     (aText, "sview_dropped_frames_total", "counter", "Frames dropped to catch up audio.");
+    appendMetricValue(aText, "sview_dropped_frames_total", NULL, double(myTextureQueue->getDroppedFrames()));
+    appendMetric     (aText, "sview_av_drift_seconds", "gauge", "Difference between next video frame and audio timestamps.");
+    appendMetricValue(aText, "sview_av_drift_seconds", NULL, myAVDrift);
+
+    const StVideoQueue* aVideoQueues[2] = { myVideoMaster.access(), myVideoSlave.access() };
+    appendMetric(aText, "sview_decoded_frames_total", "counter", "Number of decoded video frames.");
+    for(size_t aQueueIter = 0; aQueueIter < 2; ++aQueueIter) {
+        uint64_t aNbFrames = 0;
+        double   aDecodeSec = 0.0;
+        aVideoQueues[aQueueIter]->getDecodeStats(aNbFrames, aDecodeSec);
+        appendMetricValue(aText, "sview_decoded_frames_total", aQueueNames[aQueueIter], double(aNbFrames));
+    }
+    appendMetric(aText, "sview_decode_seconds_total", "counter", "Time spent in video decoder.");
+    for(size_t aQueueIter = 0; aQueueIter < 2; ++aQueueIter) {
+        uint64_t aNbFrames = 0;
+        double   aDecodeSec = 0.0;
+        aVideoQueues[aQueueIter]->getDecodeStats(aNbFrames, aDecodeSec);
+        appendMetricValue(aText, "sview_decode_seconds_total", aQueueNames[aQueueIter], aDecodeSec);
+    }
+
+    appendMetric     (aText, "sview_openal_buffers_queued", "gauge", "Number of OpenAL buffers waiting for playback.");
+    appendMetricValue(aText, "sview_openal_buffers_queued", NULL, double(myAudio->getBuffersQueued()));
+    appendMetric     (aText, "sview_openal_buffers", "gauge", "Number of OpenAL buffers per source.");
+    appendMetricValue(aText, "sview_openal_buffers", NULL, double(THE_NUM_AL_BUFFERS));
+
+    if(myIOBufferFill >= 0.0) {
+        appendMetric     (aText, "sview_io_buffer_fill_ratio", "gauge", "Fill level of file read-ahead buffer.");
+        appendMetricValue(aText, "sview_io_buffer_fill_ratio", NULL, myIOBufferFill);
+    }
+    return aText;
+}
+
 void StVideo::packetsLoop() {
 #ifdef ST_DEBUG
     double aPtsbar  = 10.0;
@@ -890,10 +1315,7 @@ void StVideo::packetsLoop() {
     // indicate new file opened
     signals.onLoaded();
 
-    StArrayList<StAVPacket> anAVPackets(myCtxList.size());
-    StArrayList<bool> aQueueIsFull(myCtxList.size());
     myPlayCtxList.clear();
-    size_t anEmptyQueues = 0;
     size_t aCtxId = 0;
     for(aCtxId = 0; aCtxId < myCtxList.size(); ++aCtxId) {
         aFormatCtx = myCtxList[aCtxId];
@@ -905,8 +1327,6 @@ void StVideo::packetsLoop() {
         }
 
         myPlayCtxList.add(aFormatCtx);
-        anAVPackets.add(StAVPacket(myCurrParams));
-        aQueueIsFull.add(false);
     }
 
     // reset target FPS
@@ -914,56 +1334,20 @@ void StVideo::packetsLoop() {
     myTargetFps = 0.0;
     myEventMutex.unlock();
 
-    for(;;) {
-        anEmptyQueues = 0;
-        for(aCtxId = 0; aCtxId < myPlayCtxList.size(); ++aCtxId) {
-            aFormatCtx = myPlayCtxList[aCtxId];
-            StAVPacket& aPacket = anAVPackets[aCtxId];
-            if(!aQueueIsFull[aCtxId]) {
-                // read next packet
-                if(av_read_frame(aFormatCtx, aPacket.getAVpkt()) < 0) {
-                    ++anEmptyQueues;
-                    continue;
-                }
-            }
-
-            // push packet to appropriate queue
-            if(myVideoMaster->isInContext(aFormatCtx, aPacket.getStreamId())) {
-                aQueueIsFull[aCtxId] = !pushPacket(myVideoMaster, aPacket);
-                if(aQueueIsFull[aCtxId]) {
-                    continue;
-                }
-                const double aTagerFpsNew = myVideoTimer->getAverFps();
-                if(myTargetFps != aTagerFpsNew) {
-                    myEventMutex.lock();
-                    myTargetFps = aTagerFpsNew;
-                    myEventMutex.unlock();
-                }
-            } else if(myVideoSlave->isInContext(aFormatCtx, aPacket.getStreamId())) {
-                aQueueIsFull[aCtxId] = !pushPacket(myVideoSlave, aPacket);
-                if(aQueueIsFull[aCtxId]) {
-                    continue;
-                }
-            } else if(myAudio->isInContext(aFormatCtx, aPacket.getStreamId())) {
-                aQueueIsFull[aCtxId] = !pushPacket(myAudio, aPacket);
-                if(aQueueIsFull[aCtxId]) {
-                    continue;
-                }
-            } else if(mySubtitles->isInContext(aFormatCtx, aPacket.getStreamId())) {
-                aQueueIsFull[aCtxId] = !pushPacket(mySubtitles, aPacket);
-                if(aQueueIsFull[aCtxId]) {
-                    continue;
-                }
-            }
-            aPacket.free();
-        }
+    bool isNextRequested = false;
 
+    // each context is read by dedicated thread, so that slow sources (network, dual-file stereo) do not stall each other;
+    // this thread only dispatches events, pausing demuxers before touching contexts and queues
+    startDemuxers();
+    for(;;) {
         // check events
         checkInitVideoStreams();
+        updateIOBufferFill();
 
         if(!myVideoTimer.isNull()) {
             myVideoTimer->setAudioDelay(myAudioDelayMSec);
             myVideoTimer->setBenchmark(myIsBenchmark);
+            myAVDrift = myVideoTimer->getDiffVA() * 0.001;
         }
 
         aPlayEvent = popPlayEvent(aSeekPts, toSeekBack);
@@ -989,6 +1373,7 @@ void StVideo::packetsLoop() {
                     myQuitEvent.set();
                 }
 
+                stopDemuxers();
                 doFlush();
                 if(myAudio->isInitialized()) {
                     myAudio->pushPlayEvent(ST_PLAYEVENT_SEEK, 0.0);
@@ -999,6 +1384,7 @@ void StVideo::packetsLoop() {
             }
         } else if(params.activeAudio->wasChanged()) {
             double aCurrPts = getPts();
+            stopDemuxers();
             doFlushSoft();
             const bool toPlayNewAudio = isPlaying();
             if(myAudio->isInitialized()) {
@@ -1035,9 +1421,6 @@ void StVideo::packetsLoop() {
 
             // exclude inactive contexts
             myPlayCtxList.clear();
-            anAVPackets.clear();
-            aQueueIsFull.clear();
-            anEmptyQueues = 0;
             for(aCtxId = 0; aCtxId < myCtxList.size(); ++aCtxId) {
                 aFormatCtx = myCtxList[aCtxId];
                 if(!myVideoMaster->isInContext(aFormatCtx)
@@ -1047,9 +1430,8 @@ void StVideo::packetsLoop() {
                     continue;
                 }
                 myPlayCtxList.add(aFormatCtx);
-                anAVPackets.add(StAVPacket(myCurrParams));
-                aQueueIsFull.add(false);
             }
+            startDemuxers();
 
             pushPlayEvent(ST_PLAYEVENT_SEEK, aCurrPts);
             if(toPlayNewAudio) {
@@ -1057,6 +1439,7 @@ void StVideo::packetsLoop() {
             }
         } else if(params.activeSubtitles->wasChanged()) {
             double aCurrPts = getPts();
+            stopDemuxers();
             doFlushSoft();
             if(mySubtitles->isInitialized()) {
                 mySubtitles->pushEnd();
@@ -1089,9 +1472,6 @@ void StVideo::packetsLoop() {
 
             // exclude inactive contexts
             myPlayCtxList.clear();
-            anAVPackets.clear();
-            aQueueIsFull.clear();
-            anEmptyQueues = 0;
             for(aCtxId = 0; aCtxId < myCtxList.size(); ++aCtxId) {
                 aFormatCtx = myCtxList[aCtxId];
                 if(!myVideoMaster->isInContext(aFormatCtx)
@@ -1101,23 +1481,15 @@ void StVideo::packetsLoop() {
                     continue;
                 }
                 myPlayCtxList.add(aFormatCtx);
-                anAVPackets.add(StAVPacket(myCurrParams));
-                aQueueIsFull.add(false);
             }
+            startDemuxers();
 
             pushPlayEvent(ST_PLAYEVENT_SEEK, aCurrPts);
         } else if(aPlayEvent == ST_PLAYEVENT_SEEK) {
+            // seek all contexts at once to keep dual-file stereo in sync, ignore current packets
+            pauseDemuxers();
             doSeek(aSeekPts, toSeekBack);
-            // ignore current packet
-            for(aCtxId = 0; aCtxId < myPlayCtxList.size(); ++aCtxId) {
-                aQueueIsFull[aCtxId] = false;
-                anAVPackets[aCtxId].free();
-            }
-        }
-
-        ///
-        if(aQueueIsFull[0]) {
-            StThread::sleep(2);
+            resumeDemuxers(true);
         }
 
     #ifdef ST_DEBUG
@@ -1125,12 +1497,22 @@ void StVideo::packetsLoop() {
         if(aPts > aPtsbar) {
             aPtsbar = aPts + 10.0;
             ST_DEBUG_LOG("Current position: " + StFormatTime::formatSeconds(aPts)
-                      + " from "              + StFormatTime::formatSeconds(myDuration));
+                      + " from "              + StFormatTime::formatSeconds(myDuration)
+                      + (myIOBufferFill >= 0.0 ? (StString(", I/O buffer ") + int(myIOBufferFill * 100.0) + "%") : StString()));
         }
     #endif
 
+        // open the next item in advance to switch without a gap
+        const double aDuration = getDuration();
+        if(!isNextRequested
+        && (isDemuxersEof()
+         || (aDuration > 0.0 && getPts() > aDuration - THE_PREOPEN_AHEAD_SEC))) {
+            isNextRequested = true;
+            preopenNext();
+        }
+
         // All packets sent
-        if(anEmptyQueues == myPlayCtxList.size()) {
+        if(isDemuxersEof()) {
             bool areFlushed = false;
             // It seems FFmpeg fail to seek the stream after all packets were read...
             // Thus - we just wait until queues process all packets
@@ -1164,7 +1546,14 @@ void StVideo::packetsLoop() {
             myCurrParams->Timestamp = 0.0f;
             break;
         }
+
+        // wait for playback event or end of file; parameters are still polled within wait limit
+        myDemuxEvent.wait(THE_EVENTS_WAIT_MSEC);
+        myDemuxEvent.reset();
     }
+    stopDemuxers();
+    myIOBufferFill = -1.0;
+    myAVDrift      = 0.0;
 
     // now send 'end-packet'
     if(myVideoMaster->isInitialized()) myVideoMaster->pushEnd();
@@ -1360,6 +1749,7 @@ void StVideo::mainLoop() {
         packetsLoop();
 
         myVideoTimer.nullify();
+        saveBenchmarkReport();
 
         myEventMutex.lock();
         if(!myFilesToDelete.isEmpty()) {
@@ -23,6 +23,9 @@
 #include "StAudioQueue.h"   // audio queue class
 #include "StSubtitleQueue.h"// subtitles queue class
 #include "StVideoTimer.h"   // video refresher class
+#include "StKeyframeIndex.h"
+#include "StVideoThumbnails.h"
+#include "StVideoPreopener.h"
 #include "StParamActiveStream.h"
 
 #include <StAV/StAVIOFileContext.h>
@@ -33,6 +36,8 @@
 #include <StImage/StImageFile.h>
 #include <StSettings/StTranslations.h>
 
+#include <vector>
+
 // forward declarations
 class StSubQueue;
 
@@ -135,13 +140,42 @@ class StVideo {
 
     /**
      * Ignore sync rules and perform swap when ready.
+     * Enables per-stage latency measurements as well.
      */
     ST_LOCAL void setBenchmark(bool toPerformBenchmark);
 
+    /**
+     * Set file path to save benchmark report (JSON for .json extension, CSV otherwise)
+     * after playback of each file in benchmark mode.
+     * Empty path disables reports.
+     */
+    ST_LOCAL void setBenchmarkReport(const StString& thePath);
+
     ST_LOCAL double getAverFps() const {
         return myTargetFps;
     }
 
+    /**
+     * @return fill level (0..1) of file read-ahead buffer (the lowest one for multiple files)
+     *         or negative value if read-ahead is not used
+     */
+    ST_LOCAL double getIOBufferFill() const {
+        return myIOBufferFill;
+    }
+
+    /**
+     * Format playback pipeline health counters (packet queues, texture queue, A/V sync, decoding, OpenAL buffers)
+     * in Prometheus text exposition format.
+     */
+    ST_LOCAL StString formatMetrics();
+
+    /**
+     * @return seek-bar thumbnails generator for active file
+     */
+    ST_LOCAL const StHandle<StVideoThumbnails>& getThumbnails() const {
+        return myThumbnails;
+    }
+
     /**
      * @return true if audio stream loaded
      */
@@ -285,6 +319,11 @@ class StVideo {
          * @param theUserData (const StString& ) - error description.
          */
         StSignal<void (const StCString& )> onError;
+
+        /**
+         * Emit callback Slot when benchmark report has been saved (file playback finished).
+         */
+        StSignal<void ()> onBenchmarkDone;
     } signals;
 
     ST_LOCAL bool getPlaybackState(double& theDuration,
@@ -325,6 +364,7 @@ class StVideo {
             myEventMutex.lock();
                 myPlayEvent = theEventId;
             myEventMutex.unlock();
+            myDemuxEvent.set();
             return;
         }
         double aPrevPts = getPts();
@@ -336,6 +376,7 @@ class StVideo {
                 myPtsSeek    = theSeekParam;
                 myToSeekBack = myPtsSeek < aPrevPts;
             myEventMutex.unlock();
+            myDemuxEvent.set();
         }
     }
 
@@ -352,12 +393,28 @@ class StVideo {
         signals.onError(theMsgText);
     }
 
+    /**
+     * Open format context for the file (or take one opened in background) and retrieve stream information.
+     * @param theToReadAhead enable read-ahead for local file (should be used only for main video input)
+     */
+    ST_LOCAL bool openInput(const StString&          theFileToLoad,
+                            AVFormatContext*&        theFormatCtx,
+                            StHandle<StAVIOContext>& theIOContext,
+                            const bool               theToReadAhead);
+
+    /**
+     * Start opening the next playlist item in background.
+     */
+    ST_LOCAL void preopenNext();
+
     /**
      * Private method to append one format context (one file).
+     * @param theToReadAhead enable read-ahead, should be set only for main video input (not for external tracks)
      */
     ST_LOCAL bool addFile(const StString& theFileToLoad,
                           const StHandle<StStereoParams>& theNewParams,
-                          StStreamsInfo&  theInfo);
+                          StStreamsInfo&  theInfo,
+                          const bool      theToReadAhead);
 
     ST_LOCAL bool openSource(const StHandle<StFileNode>&     theNewSource,
                              const StHandle<StStereoParams>& theNewParams,
@@ -370,6 +427,16 @@ class StVideo {
 
     ST_LOCAL void packetsLoop();
 
+    /**
+     * Update read-ahead buffer fill level of opened files.
+     */
+    ST_LOCAL void updateIOBufferFill();
+
+    /**
+     * Save benchmark report for the file which playback has been finished.
+     */
+    ST_LOCAL void saveBenchmarkReport();
+
     /**
      * Clear packets queue and push Flush event to decoders.
      */
@@ -389,9 +456,79 @@ class StVideo {
                                 const signed int theStreamId,
                                 const double     theSeekPts,
                                 const bool       toSeekBack);
+
+    /**
+     * Seek the master video stream to the keyframe found in the keyframe index.
+     * @return false if index does not cover the target or seeking has failed
+     */
+    ST_LOCAL bool doSeekIndexed(AVFormatContext* theFormatCtx,
+                                const signed int theStreamId,
+                                const double     theSeekPts);
     ST_LOCAL bool pushPacket(StHandle<StAVPacketQueue>& theAVPacketQueue,
                              StAVPacket& thePacket);
 
+    /**
+     * Push packet read from specified context into the queue of appropriate stream.
+     * Packets of inactive streams are ignored.
+     * @return false if destination queue is full
+     */
+    ST_LOCAL bool pushPacket(AVFormatContext* theFormatCtx,
+                             StAVPacket&      thePacket);
+
+    /**
+     * Wait until the queue of specified packet gets free space.
+     */
+    ST_LOCAL void waitPacketQueue(AVFormatContext*  theFormatCtx,
+                                  const StAVPacket& thePacket);
+
+        private: //! @name demuxing threads
+
+    struct StDemuxer;
+
+    /**
+     * Create demuxing thread for each context in myPlayCtxList.
+     */
+    ST_LOCAL void startDemuxers();
+
+    /**
+     * Stop and release demuxing threads.
+     */
+    ST_LOCAL void stopDemuxers();
+
+    /**
+     * Pause all demuxing threads and wait until they stop reading packets.
+     * Format contexts and packet queues can be safely modified after this call.
+     */
+    ST_LOCAL void pauseDemuxers();
+
+    /**
+     * Resume demuxing threads paused by pauseDemuxers().
+     * @param toReset drop pending packets and reset end-of-file state (after seeking)
+     */
+    ST_LOCAL void resumeDemuxers(const bool toReset);
+
+    /**
+     * Wake up demuxing threads waiting at end of file or for free space in queues.
+     */
+    ST_LOCAL void wakeUpDemuxers();
+
+    /**
+     * @return true if all demuxing threads have reached end of file
+     */
+    ST_LOCAL bool isDemuxersEof() const;
+
+    /**
+     * Packets reading loop of single demuxing thread.
+     */
+    ST_LOCAL void demuxLoop(StDemuxer& theDemuxer);
+
+    /**
+     * Demuxing thread function.
+     */
+    ST_LOCAL static SV_THREAD_FUNCTION demuxThreadFunction(void* theDemuxer);
+
+        private: //! @name auxiliary methods
+
     /**
      * Re-initialize video streams if needed (source format change, GPU decoding).
      */
@@ -441,12 +578,16 @@ class StVideo {
     StArrayList< StHandle<StAVIOContext> >
                                   myFileIOList;  //!< associated IO context
     StArrayList<AVFormatContext*> myPlayCtxList; //!< currently played contexts
+    std::vector<StDemuxer*>       myDemuxers;    //!< demuxing thread for each played context
 
     StHandle<StVideoQueue>        myVideoMaster;  //!< Master video decoding thread
     StHandle<StVideoQueue>        myVideoSlave;   //!< Slave  video decoding thread
     StHandle<StAudioQueue>        myAudio;        //!< audio decoding thread
     StHandle<StSubtitleQueue>     mySubtitles;    //!< subtitles decoding thread
     AVFormatContext*              mySlaveCtx;     //!< Slave video format context
+    StKeyframeIndex               myKeyframes;    //!< keyframe index of master video stream
+    StHandle<StVideoThumbnails>   myThumbnails;   //!< seek-bar thumbnails generator
+    StHandle<StVideoPreopener>    myPreopener;    //!< background opener of the next playlist item
     signed int                    mySlaveStream;  //!< Slave video stream id
 
     StHandle<StPlayList>          myPlayList;     //!< play list
@@ -469,11 +610,15 @@ class StVideo {
     bool                          myToSeekBack;   //!< seeking direction
     StPlayEvent_t                 myPlayEvent;    //!< playback event
     double                        myTargetFps;
+    volatile double               myIOBufferFill; //!< read-ahead buffer fill level, see getIOBufferFill()
+    volatile double               myAVDrift;      //!< difference between video and audio timestamps in seconds
     volatile int                  myAudioDelayMSec;//!< audio/video sync delay
     volatile bool                 myIsBenchmark;
+    StString                      myBenchmarkReport; //!< path to benchmark report
     volatile StImageFile::ImageType toSave;
     volatile bool                 toQuit;         //!< flag indicating that all working threads should be closed
     StCondition                   myQuitEvent;    //!< condition indicating that working thread has saved playback state to playlist
+    StCondition                   myDemuxEvent;   //!< event signaled on playback event or end of file to wake up packets loop
 
 };
 
@@ -0,0 +1,306 @@
+/**
+ * Copyright © 2017 Kirill Gavrilov <kirill@sview.ru>
+ *
+ * StMoviePlayer program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * StMoviePlayer program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StVideoPreopener.h"
+
+#include <StAV/StAVIOFileContext.h>
+#include <StStrings/StLogger.h>
+
+void StVideoPreopener::findTracks(const StString&              theFilePath,
+                                  StFolder&                    theFolder,
+                                  const StArrayList<StString>& theExtensions,
+                                  StArrayList<StString>&       theTracks) {
+    theTracks.clear();
+    StString aFolder, aFileName;
+    StFileNode::getFolderAndFile(theFilePath, aFolder, aFileName);
+    if(aFileName.getLength() <= 8) {
+        return; // ignore too short names
+    }
+
+    StString aName, anExtension, aTrackName, aTrackExtension;
+    StFileNode::getNameAndExtension(aFileName, aName, anExtension);
+    if(theFolder.getPath() != aFolder) {
+        // notice that playlist re-loading is not checked here...
+        theFolder.setSubPath(aFolder);
+        theFolder.init(theExtensions, 1);
+    }
+    for(size_t aNodeIter = 0; aNodeIter < theFolder.size(); ++aNodeIter) {
+        const StFileNode* aNode          = theFolder.getValue(aNodeIter);
+        const StString&   aTrackFileName = aNode->getSubPath();
+        StFileNode::getNameAndExtension(aTrackFileName, aTrackName, aTrackExtension);
+        if(aFileName != aTrackFileName
+        && aTrackName.isStartsWithIgnoreCase(aName)) {
+            theTracks.add(aNode->getPath());
+        }
+    }
+}
+
+StString StVideoPreopener::getNodeKey(const StHandle<StFileNode>& theNode) {
+    if(theNode.isNull()) {
+        return StString();
+    } else if(theNode->isEmpty()) {
+        return theNode->getPath();
+    }
+
+    StString aKey;
+    for(size_t aNodeIter = 0; aNodeIter < theNode->size(); ++aNodeIter) {
+        aKey += theNode->getValue(aNodeIter)->getPath() + "\n";
+    }
+    return aKey;
+}
+
+StVideoPreopener::StVideoPreopener(const StArrayList<StString>& theTracksExt)
+: myEventJob(false),
+  myEventDone(true),
+  myTracksExt(theTracksExt),
+  myTracks(8),
+  myGeneration(0),
+  myToFindTracks(false),
+  myHasTracks(false),
+  myHasJob(false),
+  myToQuit(false) {
+    myThread = new StThread(workerThreadFunction, (void* )this, "StVideoPreopener");
+}
+
+StVideoPreopener::~StVideoPreopener() {
+    myMutex.lock();
+    myToQuit = true;
+    ++myGeneration;
+    myMutex.unlock();
+    myEventJob.set();
+    myThread->wait();
+    myThread.nullify();
+
+    myMutex.lock();
+    release();
+    myMutex.unlock();
+}
+
+void StVideoPreopener::request(const StHandle<StFileNode>& theNode,
+                               const bool                  theToFindTracks) {
+    const StString aKey = getNodeKey(theNode);
+    myMutex.lock();
+    if(aKey == myNodeKey
+    && theToFindTracks == myToFindTracks) {
+        myMutex.unlock();
+        return;
+    }
+
+    ++myGeneration;
+    release();
+    myNode         = theNode;
+    myNodeKey      = aKey;
+    myToFindTracks = theToFindTracks;
+    myHasJob       = !aKey.isEmpty();
+    myEventDone.reset();
+    myMutex.unlock();
+    myEventJob.set();
+}
+
+bool StVideoPreopener::waitFor(const StHandle<StFileNode>& theNode) {
+    const StString aKey = getNodeKey(theNode);
+    myMutex.lock();
+    if(myNodeKey.isEmpty()
+    || aKey != myNodeKey) {
+        myMutex.unlock();
+        clear();
+        return false;
+    }
+    myMutex.unlock();
+
+    myEventDone.wait();
+    return true;
+}
+
+bool StVideoPreopener::take(const StString&          thePath,
+                            AVFormatContext*&        theFormatCtx,
+                            StHandle<StAVIOContext>& theIOContext) {
+    myMutex.lock();
+    for(std::vector<Input>::iterator anIter = myInputs.begin(); anIter != myInputs.end(); ++anIter) {
+        if(anIter->Path == thePath) {
+            theFormatCtx = anIter->FormatCtx;
+            theIOContext = anIter->IOContext;
+            myInputs.erase(anIter);
+            myMutex.unlock();
+            ST_DEBUG_LOG("StVideoPreopener, using pre-opened file " + thePath);
+            return true;
+        }
+    }
+    myMutex.unlock();
+    return false;
+}
+
+bool StVideoPreopener::getTracks(StArrayList<StString>& theTracks) const {
+    myMutex.lock();
+    const bool hasTracks = myHasTracks;
+    if(hasTracks) {
+        theTracks = myTracks;
+    }
+    myMutex.unlock();
+    return hasTracks;
+}
+
+void StVideoPreopener::clear() {
+    myMutex.lock();
+    ++myGeneration;
+    release();
+    myNode.nullify();
+    myNodeKey.clear();
+    myHasJob = false;
+    myMutex.unlock();
+}
+
+void StVideoPreopener::release() {
+    for(size_t anIter = 0; anIter < myInputs.size(); ++anIter) {
+        closeInput(myInputs[anIter]);
+    }
+    myInputs.clear();
+    myTracks.clear();
+    myHasTracks = false;
+}
+
+void StVideoPreopener::closeInput(Input& theInput) {
+    if(theInput.FormatCtx != NULL) {
+    #if(LIBAVFORMAT_VERSION_INT >= AV_VERSION_INT(53, 17, 0))
+        avformat_close_input(&theInput.FormatCtx);
+    #else
+        av_close_input_file(theInput.FormatCtx);
+        theInput.FormatCtx = NULL;
+    #endif
+    }
+    theInput.IOContext.nullify();
+}
+
+bool StVideoPreopener::openInput(const StString& thePath,
+                                 Input&          theInput) const {
+    theInput.Path      = thePath;
+    theInput.FormatCtx = NULL;
+    theInput.IOContext.nullify();
+    if(StFileNode::isRemoteProtocolPath(thePath)
+    || StFileNode::isContentProtocolPath(thePath)
+    || !StFileNode::isFileExists(thePath)) {
+        return false;
+    }
+
+    // the same I/O setup as for files opened by StVideo::addFile(), but read-ahead is enabled only when file is taken
+    StHandle<StAVIOFileContext> aFileCtx = new StAVIOFileContext();
+    if(aFileCtx->openFile(thePath)) {
+        theInput.FormatCtx     = avformat_alloc_context();
+        theInput.FormatCtx->pb = aFileCtx->getAvioContext();
+        theInput.IOContext     = aFileCtx;
+    }
+
+#if(LIBAVFORMAT_VERSION_INT >= AV_VERSION_INT(53, 2, 0))
+    if(avformat_open_input(&theInput.FormatCtx, thePath.toCString(), NULL, NULL) != 0) {
+#else
+    if(av_open_input_file (&theInput.FormatCtx, thePath.toCString(), NULL, 0, NULL) != 0) {
+#endif
+        closeInput(theInput);
+        return false;
+    }
+
+#if(LIBAVFORMAT_VERSION_INT >= AV_VERSION_INT(53, 6, 0))
+    if(avformat_find_stream_info(theInput.FormatCtx, NULL) < 0) {
+#else
+    if(av_find_stream_info(theInput.FormatCtx) < 0) {
+#endif
+        closeInput(theInput);
+        return false;
+    }
+    return true;
+}
+
+void StVideoPreopener::prepare(const StString& thePath,
+                               const int       theGen) {
+    Input anInput;
+    if(!openInput(thePath, anInput)) {
+        return;
+    }
+
+    myMutex.lock();
+    if(myGeneration != theGen) {
+        closeInput(anInput);
+    } else {
+        myInputs.push_back(anInput);
+    }
+    myMutex.unlock();
+}
+
+SV_THREAD_FUNCTION StVideoPreopener::workerThreadFunction(void* thePreopener) {
+    StVideoPreopener* aPreopener = (StVideoPreopener* )thePreopener;
+    aPreopener->workerLoop();
+    return SV_THREAD_RETURN 0;
+}
+
+void StVideoPreopener::workerLoop() {
+    for(;;) {
+        myEventJob.wait();
+        myMutex.lock();
+        if(myToQuit) {
+            myEventDone.set();
+            myMutex.unlock();
+            return;
+        }
+
+        myEventJob.reset();
+        const StHandle<StFileNode> aNode     = myNode;
+        const int                  aGen      = myGeneration;
+        const bool                 toFind    = myToFindTracks;
+        const bool                 hasJob    = myHasJob;
+        myHasJob = false;
+        myMutex.unlock();
+        if(!hasJob
+        ||  aNode.isNull()) {
+            myEventDone.set();
+            continue;
+        }
+
+        if(!aNode->isEmpty()) {
+            for(size_t aNodeIter = 0; aNodeIter < aNode->size() && myGeneration == aGen; ++aNodeIter) {
+                prepare(aNode->getValue(aNodeIter)->getPath(), aGen);
+            }
+        } else {
+            const StString aPath = aNode->getPath();
+            prepare(aPath, aGen);
+
+            StArrayList<StString> aTracks(8);
+            if(toFind
+            && myGeneration == aGen
+            && !StFileNode::isRemoteProtocolPath(aPath)
+            && !StFileNode::isContentProtocolPath(aPath)) {
+                findTracks(aPath, myTracksFolder, myTracksExt, aTracks);
+                for(size_t aTrackIter = 0; aTrackIter < aTracks.size() && myGeneration == aGen; ++aTrackIter) {
+                    prepare(aTracks[aTrackIter], aGen);
+                }
+
+                myMutex.lock();
+                if(myGeneration == aGen) {
+                    myTracks    = aTracks;
+                    myHasTracks = true;
+                }
+                myMutex.unlock();
+            }
+        }
+
+        myMutex.lock();
+        if(myGeneration == aGen) {
+            myEventDone.set();
+        }
+        myMutex.unlock();
+    }
+}
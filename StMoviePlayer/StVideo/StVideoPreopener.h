@@ -0,0 +1,181 @@
+/**
+ * Copyright © 2017 Kirill Gavrilov <kirill@sview.ru>
+ *
+ * StMoviePlayer program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * StMoviePlayer program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __StVideoPreopener_h_
+#define __StVideoPreopener_h_
+
+#include <StAV/StAVIOContext.h>
+#include <StFile/StFolder.h>
+#include <StThreads/StCondition.h>
+#include <StThreads/StMutex.h>
+#include <StThreads/StThread.h>
+
+#include <vector>
+
+/**
+ * Background opener of the next playlist item.
+ * Opens and probes the files (including external audio / subtitle tracks found in the same folder)
+ * before the current item has been finished, so that switching to the next item
+ * does not stall on I/O and stream probing.
+ * Only local files are handled.
+ */
+class StVideoPreopener {
+
+        public:
+
+    /**
+     * Find external tracks (subtitles, audio) for the video file.
+     * @param theFilePath   path to the video file
+     * @param theFolder     cached folder content, re-initialized if folder differs
+     * @param theExtensions extensions of track files
+     * @param theTracks     output list of track paths
+     */
+    ST_LOCAL static void findTracks(const StString&              theFilePath,
+                                    StFolder&                    theFolder,
+                                    const StArrayList<StString>& theExtensions,
+                                    StArrayList<StString>&       theTracks);
+
+        public:
+
+    /**
+     * Main constructor.
+     * Files are opened without read-ahead (to not waste memory on the files which might be never played),
+     * which should be enabled by the caller taking the main input.
+     * @param theTracksExt extensions of external track files
+     */
+    ST_LOCAL StVideoPreopener(const StArrayList<StString>& theTracksExt);
+
+    /**
+     * Destructor, stops the worker thread and closes prepared files.
+     */
+    ST_LOCAL ~StVideoPreopener();
+
+    /**
+     * Start opening of specified item (does nothing if the same item has been already requested).
+     * Previously prepared item is released.
+     * @param theNode         file node (single file or stereo pair)
+     * @param theToFindTracks search for external tracks
+     */
+    ST_LOCAL void request(const StHandle<StFileNode>& theNode,
+                          const bool                  theToFindTracks);
+
+    /**
+     * Wait until specified item is prepared.
+     * Prepared data is released when another item has been requested.
+     * @param theNode file node to be opened
+     * @return true if the item has been requested
+     */
+    ST_LOCAL bool waitFor(const StHandle<StFileNode>& theNode);
+
+    /**
+     * Take ownership over prepared file.
+     * @param thePath      file path
+     * @param theFormatCtx opened format context with retrieved stream information
+     * @param theIOContext I/O context used by format context (might be NULL)
+     * @return false if file has not been prepared
+     */
+    ST_LOCAL bool take(const StString&          thePath,
+                       AVFormatContext*&        theFormatCtx,
+                       StHandle<StAVIOContext>& theIOContext);
+
+    /**
+     * Retrieve the list of external tracks found for prepared item.
+     * @param theTracks output list of track paths
+     * @return false if tracks search has not been performed
+     */
+    ST_LOCAL bool getTracks(StArrayList<StString>& theTracks) const;
+
+    /**
+     * Cancel the job and close prepared files.
+     */
+    ST_LOCAL void clear();
+
+        private:
+
+    /**
+     * Opened file.
+     */
+    struct Input {
+        StString                Path;      //!< file path
+        AVFormatContext*        FormatCtx; //!< format context
+        StHandle<StAVIOContext> IOContext; //!< I/O context
+    };
+
+    /**
+     * @return unique key for the file node
+     */
+    ST_LOCAL static StString getNodeKey(const StHandle<StFileNode>& theNode);
+
+    /**
+     * Close the file.
+     */
+    ST_LOCAL static void closeInput(Input& theInput);
+
+    /**
+     * Open and probe the file.
+     */
+    ST_LOCAL bool openInput(const StString& thePath,
+                            Input&          theInput) const;
+
+    /**
+     * Open the file and append it to the list of prepared ones (if job has not been cancelled).
+     */
+    ST_LOCAL void prepare(const StString& thePath,
+                          const int       theGen);
+
+    /**
+     * Release prepared files, should be called under lock.
+     */
+    ST_LOCAL void release();
+
+    /**
+     * Worker thread loop.
+     */
+    ST_LOCAL void workerLoop();
+
+    /**
+     * Worker thread function.
+     */
+    ST_LOCAL static SV_THREAD_FUNCTION workerThreadFunction(void* thePreopener);
+
+        private:
+
+    mutable StMutex       myMutex;        //!< lock for all fields
+    StHandle<StThread>    myThread;       //!< worker thread
+    StCondition           myEventJob;     //!< event signaled on new job
+    StCondition           myEventDone;    //!< event signaled when job is finished
+    StArrayList<StString> myTracksExt;    //!< extensions of external tracks
+    StFolder              myTracksFolder; //!< cached folder content, used only by worker thread
+    StHandle<StFileNode>  myNode;         //!< requested item
+    StString              myNodeKey;      //!< requested item key
+    std::vector<Input>    myInputs;       //!< prepared files
+    StArrayList<StString> myTracks;       //!< found external tracks
+    volatile int          myGeneration;   //!< job counter, incremented on each request() / clear()
+    volatile bool         myToFindTracks; //!< search external tracks for requested item
+    volatile bool         myHasTracks;    //!< tracks search has been done
+    volatile bool         myHasJob;       //!< pending job flag
+    volatile bool         myToQuit;       //!< flag to stop the worker
+
+        private: //! @name no copies, please
+
+    StVideoPreopener(const StVideoPreopener& theCopy);
+    const StVideoPreopener& operator=(const StVideoPreopener& theCopy);
+
+};
+
+#endif // __StVideoPreopener_h_
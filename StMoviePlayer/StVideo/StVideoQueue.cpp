@@ -155,6 +155,7 @@ StVideoQueue::StVideoQueue(const StHandle<StGLTextureQueue>& theTextureQueue,
   myDowntimeState(true),
   myTextureQueue(theTextureQueue),
   myHasDataState(false),
+  myNoDataState(true),
   myMaster(theMaster),
 #if defined(__APPLE__)
   myCodecH264HW(avcodec_find_decoder_by_name("h264_vda")),
@@ -166,8 +167,6 @@ StVideoQueue::StVideoQueue(const StHandle<StGLTextureQueue>& theTextureQueue,
   myIsGpuFailed(false),
   myUseOpenJpeg(false),
   //
-  myToRgbCtx(NULL),
-  myToRgbPixFmt(stAV::PIX_FMT::NONE),
   myToRgbIsBroken(false),
   //
   myAvDiscard(AVDISCARD_DEFAULT),
@@ -183,6 +182,8 @@ StVideoQueue::StVideoQueue(const StHandle<StGLTextureQueue>& theTextureQueue,
   myAudioClock(0.0),
   myAudioDelayMSec(0),
   myFramesCounter(1),
+  myStatsNbFrames(0),
+  myStatsDecodeSec(0.0),
   myWasFlushed(false),
   myStFormatByUser(StFormat_AUTO),
   myStFormatByName(StFormat_AUTO),
@@ -504,9 +505,8 @@ void StVideoQueue::deinit() {
     myDataAdp.nullify();
 
     myDataRGB.nullify();
-    sws_freeContext(myToRgbCtx);
-    myToRgbCtx      = NULL;
-    myToRgbPixFmt   = stAV::PIX_FMT::NONE;
+    myPoolRGB.release();
+    myToRgbCtx.release();
     myToRgbIsBroken = false;
 
     myFramesCounter = 1;
@@ -558,6 +558,8 @@ void StVideoQueue::prepareFrame(const StFormat theSrcFormat) {
         myDataAdp.changePlane(0).initWrapper(StImagePlane::ImgRGB48, myFrame.getPlane(0),
                                              size_t(aFrameSizeX), size_t(aFrameSizeY),
                                              myFrame.getLineSize(0));
+        myFrameBufRef->moveReferenceFrom(myFrame.Frame);
+        myDataAdp.setBufferCounter(myFrameBufRef);
     } else if(aPixFmt == stAV::PIX_FMT::RGB24) {
         myDataAdp.setColorModel(StImage::ImgColor_RGB);
         myDataAdp.setColorScale(StImage::ImgScale_Full);
@@ -565,6 +567,8 @@ void StVideoQueue::prepareFrame(const StFormat theSrcFormat) {
         myDataAdp.changePlane(0).initWrapper(StImagePlane::ImgRGB, myFrame.getPlane(0),
                                              size_t(aFrameSizeX), size_t(aFrameSizeY),
                                              myFrame.getLineSize(0));
+        myFrameBufRef->moveReferenceFrom(myFrame.Frame);
+        myDataAdp.setBufferCounter(myFrameBufRef);
 #if(LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(53, 5, 0))
     } else if(stAV::isFormatYUVPlanar(myFrame.Frame,
 #else
@@ -633,55 +637,62 @@ void StVideoQueue::prepareFrame(const StFormat theSrcFormat) {
         myFrameBufRef->moveReferenceFrom(myFrame.Frame);
         myDataAdp.setBufferCounter(myFrameBufRef);
     } else if(!myToRgbIsBroken) {
-        if(myToRgbCtx    == NULL
-        || myToRgbPixFmt != aPixFmt
-        || size_t(aFrameSizeX) != myDataRGB.getSizeX()
-        || size_t(aFrameSizeY) != myDataRGB.getSizeY()) {
-            // initialize software scaler/converter
-        //#if LIBSWSCALE_VERSION_MAJOR >= 3
-            //myToRgbCtx = sws_getCachedContext(myToRgbCtx,
-            //                                  aFrameSizeX, aFrameSizeY, aPixFmt,
-            //                                  aFrameSizeX, aFrameSizeY, stAV::PIX_FMT::RGB24
-            //                                  SWS_BICUBIC, NULL, NULL, NULL);
-        //#else
-            sws_freeContext(myToRgbCtx);
-            myToRgbCtx = sws_getContext(aFrameSizeX, aFrameSizeY, aPixFmt,              // source
-                                        aFrameSizeX, aFrameSizeY, stAV::PIX_FMT::RGB24, // destination
-                                        SWS_BICUBIC, NULL, NULL, NULL);
-        //#endif
-            myToRgbPixFmt = aPixFmt;
-            if(myToRgbCtx == NULL
-            || aFrameSizeX <= 0
-            || aFrameSizeY <= 0) {
-                signals.onError(stCString("FFmpeg: Failed to create SWScaler context"));
-                myToRgbIsBroken = true;
-            } else {
-                if(!myDataRGB.initTrash(StImagePlane::ImgRGB, size_t(aFrameSizeX), size_t(aFrameSizeY))) {
+        // initialize software scaler/converter, does nothing if frame format has not been changed
+        if(!myToRgbCtx.init(aFrameSizeX, aFrameSizeY, aPixFmt,               // source
+                            aFrameSizeX, aFrameSizeY, stAV::PIX_FMT::RGB24)) { // destination
+            signals.onError(stCString("FFmpeg: Failed to create SWScaler context"));
+            myToRgbIsBroken = true;
+            return;
+        }
+
+        // converted frame is allocated from the pool when possible,
+        // so that texture queue could keep the reference instead of copying the data
+        const size_t aRowBytesRGB = getAligned(size_t(aFrameSizeX) * 3, 32);
+        uint8_t*     aDataRGB     = NULL;
+    #if(LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(55, 45, 101))
+        AVBufferRef* aBufferRGB = NULL;
+        if(myPoolRGB.init(int(aRowBytesRGB * size_t(aFrameSizeY)))) {
+            aBufferRGB = myPoolRGB.getBuffer();
+        }
+        av_frame_unref(myFrameRGB.Frame);
+        if(aBufferRGB != NULL) {
+            myDataRGB.nullify();
+            myFrameRGB.Frame->buf[0] = aBufferRGB;
+            aDataRGB = aBufferRGB->data;
+        }
+    #endif
+        if(aDataRGB == NULL) {
+            if(size_t(aFrameSizeX) != myDataRGB.getSizeX()
+            || size_t(aFrameSizeY) != myDataRGB.getSizeY()) {
+                if(!myDataRGB.initTrash(StImagePlane::ImgRGB, size_t(aFrameSizeX), size_t(aFrameSizeY), aRowBytesRGB)) {
                     signals.onError(stCString("FFmpeg: Failed allocation of RGB frame (out of memory)"));
                     myToRgbIsBroken = true;
-                } else {
-                    myFrameRGB.Frame->data[0]     = (uint8_t* )myDataRGB.changeData();
-                    myFrameRGB.Frame->linesize[0] = (int      )myDataRGB.getSizeRowBytes();
-                    for(int aPlaneIter = 1; aPlaneIter < AV_NUM_DATA_POINTERS; ++aPlaneIter) {
-                        myFrameRGB.Frame->data    [aPlaneIter] = NULL;
-                        myFrameRGB.Frame->linesize[aPlaneIter] = 0;
-                    }
+                    return;
                 }
             }
+            aDataRGB = myDataRGB.changeData();
+        }
+
+        myFrameRGB.Frame->data[0]     = aDataRGB;
+        myFrameRGB.Frame->linesize[0] = (int )aRowBytesRGB;
+        for(int aPlaneIter = 1; aPlaneIter < AV_NUM_DATA_POINTERS; ++aPlaneIter) {
+            myFrameRGB.Frame->data    [aPlaneIter] = NULL;
+            myFrameRGB.Frame->linesize[aPlaneIter] = 0;
         }
+        myToRgbCtx.scale(myFrame.Frame->data,    myFrame.Frame->linesize,
+                         myFrameRGB.Frame->data, myFrameRGB.Frame->linesize);
 
-        if(!myToRgbIsBroken) {
-            sws_scale(myToRgbCtx,
-                      myFrame.Frame->data, myFrame.Frame->linesize,
-                      0, aFrameSizeY,
-                      myFrameRGB.Frame->data, myFrameRGB.Frame->linesize);
-
-            myDataAdp.setColorModel(StImage::ImgColor_RGB);
-            myDataAdp.setColorScale(StImage::ImgScale_Full);
-            myDataAdp.setPixelRatio(getPixelRatio());
-            myDataAdp.changePlane(0).initWrapper(StImagePlane::ImgRGB, myDataRGB.changeData(),
-                                                 size_t(aFrameSizeX), size_t(aFrameSizeY));
+        myDataAdp.setColorModel(StImage::ImgColor_RGB);
+        myDataAdp.setColorScale(StImage::ImgScale_Full);
+        myDataAdp.setPixelRatio(getPixelRatio());
+        myDataAdp.changePlane(0).initWrapper(StImagePlane::ImgRGB, aDataRGB,
+                                             size_t(aFrameSizeX), size_t(aFrameSizeY), aRowBytesRGB);
+    #if(LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(55, 45, 101))
+        if(aBufferRGB != NULL) {
+            myFrameBufRef->moveReferenceFrom(myFrameRGB.Frame);
+            myDataAdp.setBufferCounter(myFrameBufRef);
         }
+    #endif
     } else {
         //ST_DEBUG_LOG("Frame skipped - unsupported pixel format!");
     }
@@ -694,7 +705,7 @@ void StVideoQueue::pushFrame(const StImage&     theSrcDataLeft,
                              const StCubemap    theCubemapFormat,
                              const double       theSrcPTS) {
     while(!myToFlush && myTextureQueue->isFull()) {
-        StThread::sleep(10);
+        myTextureQueue->waitPop(100);
     }
 
     if(myToFlush) {
@@ -743,23 +754,25 @@ void StVideoQueue::decodeLoop() {
     double aSlavePts = 0.0;
     myFramePts = 0.0;
     StImage* aSlaveData = NULL;
-    StHandle<StAVPacket> aPacket;
+    StAVPacket aPacket;
     StImage anEmptyImg;
     StString aTagValue;
     bool isStarted = false;
+    StLatencyMeter& aLatencyMeter = myTextureQueue->changeLatencyMeter();
+    StTimer aDecodeTimer(false);  // accumulates decoding time of packets until the frame is finished
+    StTimer aConvertTimer(false);
     for(;;) {
         if(isEmpty()) {
             myDowntimeState.set();
-            StThread::sleep(10);
+            waitPackets(100);
             continue;
         }
         myDowntimeState.reset();
 
-        aPacket = pop();
-        if(aPacket.isNull()) {
+        if(!pop(aPacket)) {
             continue;
         }
-        switch(aPacket->getType()) {
+        switch(aPacket.getType()) {
             case StAVPacket::FLUSH_PACKET: {
                 // got the special FLUSH packet - flush FFMPEG codec buffers
                 if(myCodecCtx != NULL && myCodec != NULL) {
@@ -773,22 +786,25 @@ void StVideoQueue::decodeLoop() {
                 myVideoClock = 0.0;
                 myToFlush    = false;
                 myWasFlushed = true;
+                aDecodeTimer.stop();
                 continue;
             }
             case StAVPacket::START_PACKET: {
                 myAudioClock = 0.0;
                 myVideoClock = 0.0;
                 myHasDataState.reset();
+                myNoDataState.set();
                 isStarted = true;
                 continue;
             }
             case StAVPacket::END_PACKET: {
                 if(!myMaster.isNull()) {
                     while(myHasDataState.check() && !myMaster->isInDowntime()) {
-                        StThread::sleep(10);
+                        myNoDataState.wait(10);
                     }
                     // wake up Master
                     myDataAdp.nullify();
+                    myNoDataState.reset();
                     myHasDataState.set();
                 } else {
                     if(!mySlave.isNull()) {
@@ -797,7 +813,7 @@ void StVideoQueue::decodeLoop() {
                     StTimer stTimerWaitEmpty(true);
                     double waitTime = anAverageDelaySec * myTextureQueue->getSize() + 0.1;
                     while(!myTextureQueue->isEmpty() && stTimerWaitEmpty.getElapsedTimeInSec() < waitTime && !myToQuit) {
-                        StThread::sleep(2);
+                        myTextureQueue->waitPop(10);
                     }
                 }
                 if(myToQuit) {
@@ -812,35 +828,48 @@ void StVideoQueue::decodeLoop() {
 
         // wait master retrieve previous data
         while(!myMaster.isNull() && myHasDataState.check()) {
-            //
+            myNoDataState.wait(100);
         }
 
         // decode video frame
+        const bool toMeasure = aLatencyMeter.isEnabled();
+        aDecodeTimer.resume();
     #if(LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(52, 23, 0))
         bool toTryGpu  = myUseGpu && !myIsGpuFailed;
-        avcodec_decode_video2(myCodecCtx, myFrame.Frame, &isFrameFinished, aPacket->getAVpkt());
+        avcodec_decode_video2(myCodecCtx, myFrame.Frame, &isFrameFinished, aPacket.getAVpkt());
         bool isGpuUsed = myUseGpu && !myIsGpuFailed;
         if(isGpuUsed != toTryGpu) {
             if(!initCodec(myCodecAuto, isGpuUsed)) {
                 signals.onError(stCString("FFmpeg: Could not re-open video codec"));
                 deinit();
-                aPacket.nullify();
+                aPacket.free();
+                aDecodeTimer.stop();
                 continue;
             }
             isFrameFinished = 0;
-            avcodec_decode_video2(myCodecCtx, myFrame.Frame, &isFrameFinished, aPacket->getAVpkt());
+            avcodec_decode_video2(myCodecCtx, myFrame.Frame, &isFrameFinished, aPacket.getAVpkt());
         }
     #else
         avcodec_decode_video(myCodecCtx, myFrame.Frame, &isFrameFinished,
-                             aPacket->getData(), aPacket->getSize());
+                             aPacket.getData(), aPacket.getSize());
     #endif
+        aDecodeTimer.pause();
         if(isFrameFinished == 0) {
             // need more packets to decode whole frame
-            aPacket.nullify();
+            aPacket.free();
             continue;
         }
 
-        if(aPacket->isKeyFrame()) {
+        if(toMeasure) {
+            aLatencyMeter.addSample(StLatencyMeter::Stage_Decode, aDecodeTimer.getElapsedTimeInMicroSec());
+        }
+        myStatsMutex.lock();
+        ++myStatsNbFrames;
+        myStatsDecodeSec += aDecodeTimer.getElapsedTimeInSec();
+        myStatsMutex.unlock();
+        aDecodeTimer.stop();
+
+        if(aPacket.isKeyFrame()) {
             myFramesCounter = 1;
         }
 
@@ -854,11 +883,11 @@ void StVideoQueue::decodeLoop() {
         myFramePts -= myPtsStartBase; // normalize PTS
     #else
         // Save global pts to be stored in pFrame in first call
-        myVideoPktPts = aPacket->getPts();
+        myVideoPktPts = aPacket.getPts();
 
         myFramePts = 0.0;
-        if(aPacket->getDts() != stAV::NOPTS_VALUE) {
-            myFramePts = double(aPacket->getDts());
+        if(aPacket.getDts() != stAV::NOPTS_VALUE) {
+            myFramePts = double(aPacket.getDts());
         } else {
             int64_t aPktPtsSync = stAV::NOPTS_VALUE;
         #ifdef ST_USE64PTR
@@ -918,6 +947,7 @@ void StVideoQueue::decodeLoop() {
         }
 
         // copy frame back from GPU to CPU memory
+        aConvertTimer.restart();
         if(!myHWAccelCtx.isNull()) {
             myHWAccelCtx->retrieveFrame(*this, myFrame.Frame);
         }
@@ -956,7 +986,7 @@ void StVideoQueue::decodeLoop() {
         }
         // override source format stored in metadata
         StFormat  aSrcFormat     = myStFormatByUser;
-        StCubemap aCubemapFormat = aPacket->getSource()->ViewingMode == StViewSurface_Cubemap ? StCubemap_Packed : StCubemap_OFF;
+        StCubemap aCubemapFormat = aPacket.getSource()->ViewingMode == StViewSurface_Cubemap ? StCubemap_Packed : StCubemap_OFF;
         if(aSrcFormat == StFormat_AUTO) {
             // prefer info stored in the stream itself
             aSrcFormat = myStFormatInStream;
@@ -972,10 +1002,13 @@ void StVideoQueue::decodeLoop() {
         }*/
 
         prepareFrame(aSrcFormat);
+        if(toMeasure) {
+            aLatencyMeter.addSample(StLatencyMeter::Stage_Convert, aConvertTimer.getElapsedTimeInMicroSec());
+        }
 
         if(!mySlave.isNull()) {
             if(isStarted) {
-                StHandle<StStereoParams> aParams = aPacket->getSource();
+                StHandle<StStereoParams> aParams = aPacket.getSource();
                 if(!aParams.isNull()) {
                     aParams->setSeparationNeutral(myHParallax);
                     aParams->setZRotateZero((float )myRotateDeg);
@@ -992,9 +1025,9 @@ void StVideoQueue::decodeLoop() {
                     const double aPtsDiff = myFramePts - aSlavePts;
                     if(aPtsDiff > 0.5 * anAverageDelaySec) {
                         // wait for more recent frame from slave thread
+                        // (waitData() blocks until slave thread provides next frame)
                         mySlave->unlockData();
                         aSlaveData = NULL;
-                        StThread::sleep(10);
                         continue;
                     } else if(aPtsDiff < -0.5 * anAverageDelaySec) {
                         // too far...
@@ -1006,21 +1039,22 @@ void StVideoQueue::decodeLoop() {
                         break;
                     }
 
-                    pushFrame(myDataAdp, *aSlaveData, aPacket->getSource(), StFormat_SeparateFrames, aCubemapFormat, myFramePts);
+                    pushFrame(myDataAdp, *aSlaveData, aPacket.getSource(), StFormat_SeparateFrames, aCubemapFormat, myFramePts);
 
                     aSlaveData = NULL;
                     mySlave->unlockData();
                 } else {
-                    pushFrame(myDataAdp, anEmptyImg, aPacket->getSource(), aSrcFormat, aCubemapFormat, myFramePts);
+                    pushFrame(myDataAdp, anEmptyImg, aPacket.getSource(), aSrcFormat, aCubemapFormat, myFramePts);
                 }
                 break;
             }
         } else if(!myMaster.isNull()) {
             // push data to Master
+            myNoDataState.reset();
             myHasDataState.set();
         } else {
             if(isStarted) {
-                StHandle<StStereoParams> aParams = aPacket->getSource();
+                StHandle<StStereoParams> aParams = aPacket.getSource();
                 if(!aParams.isNull()) {
                     aParams->setSeparationNeutral(myHParallax);
                     aParams->setZRotateZero((float )myRotateDeg);
@@ -1031,17 +1065,23 @@ void StVideoQueue::decodeLoop() {
             // simple one-stream case
             if(aSrcFormat == StFormat_FrameSequence) {
                 if(isOddNumber(myFramesCounter)) {
-                    myCachedFrame.fill(myDataAdp, false);
+                    // keep reference to decoded frame when possible
+                    if(!myCachedFrame.initReference(myDataAdp)
+                    ||  myCachedFrame.getBufferCounter().isNull()) {
+                        myCachedFrame.nullify();
+                        myCachedFrame.setBufferCounter(NULL);
+                        myCachedFrame.fill(myDataAdp, false);
+                    }
                 } else {
-                    pushFrame(myCachedFrame, myDataAdp, aPacket->getSource(), StFormat_FrameSequence, aCubemapFormat, myFramePts);
+                    pushFrame(myCachedFrame, myDataAdp, aPacket.getSource(), StFormat_FrameSequence, aCubemapFormat, myFramePts);
                 }
                 ++myFramesCounter;
             } else {
-                pushFrame(myDataAdp, anEmptyImg, aPacket->getSource(), aSrcFormat, aCubemapFormat, myFramePts);
+                pushFrame(myDataAdp, anEmptyImg, aPacket.getSource(), aSrcFormat, aCubemapFormat, myFramePts);
             }
         }
 
         myFrame.reset();
-        aPacket.nullify(); // and now packet finished
+        aPacket.free(); // and now packet finished
     }
 }
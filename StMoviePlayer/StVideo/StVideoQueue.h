@@ -22,7 +22,9 @@
 #include <StGLStereo/StGLTextureQueue.h>
 
 #include "StAVPacketQueue.h"
+#include <StAV/StAVBufferPool.h>
 #include <StAV/StAVImage.h>
+#include <StAV/StAVScaler.h>
 
 // forward declarations
 class StVideoQueue;
@@ -149,6 +151,7 @@ class StVideoQueue : public StAVPacketQueue {
 
     ST_LOCAL void unlockData() {
         myHasDataState.reset();
+        myNoDataState.set();
     }
 
     ST_LOCAL void setAClock(const double thePts) {
@@ -224,6 +227,14 @@ class StVideoQueue : public StAVPacketQueue {
      */
     ST_LOCAL virtual void deinit() ST_ATTR_OVERRIDE;
 
+    /**
+     * Push flush packet and wake up decoding thread waiting for free slot in textures queue.
+     */
+    ST_LOCAL virtual void pushFlush() ST_ATTR_OVERRIDE {
+        StAVPacketQueue::pushFlush();
+        myTextureQueue->wakeUp();
+    }
+
 #ifdef ST_AV_OLDSYNC
     ST_LOCAL void syncVideo(AVFrame* srcFrame, double* pts);
 #endif
@@ -285,6 +296,19 @@ class StVideoQueue : public StAVPacketQueue {
         return myTextureQueue->getPTSCurr();
     }
 
+    /**
+     * Retrieve cumulative decoding statistics.
+     * @param theNbFrames number of decoded frames
+     * @param theTimeSec  overall time spent in decoder in seconds
+     */
+    ST_LOCAL void getDecodeStats(uint64_t& theNbFrames,
+                                 double&   theTimeSec) const {
+        myStatsMutex.lock();
+        theNbFrames = myStatsNbFrames;
+        theTimeSec  = myStatsDecodeSec;
+        myStatsMutex.unlock();
+    }
+
         private:
 
     /**
@@ -359,7 +383,8 @@ private:
     StCondition                myDowntimeState;   //!< event to indicate downtime state
     StHandle<StGLTextureQueue> myTextureQueue;    //!< decoded frames queue
 
-    StCondition                myHasDataState;
+    StCondition                myHasDataState;    //!< event signaled when slave decoded frame for master
+    StCondition                myNoDataState;     //!< event signaled when master released slave frame (inverse to myHasDataState)
     StHandle<StVideoQueue>     myMaster;          //!< handle to Master decoding thread
     StHandle<StVideoQueue>     mySlave;           //!< handle to Slave  decoding thread
 
@@ -373,9 +398,9 @@ private:
     bool                       myUseOpenJpeg;     //!< use OpenJPEG (libopenjpeg) instead of built-in jpeg2000 decoder
 
     StAVFrame                  myFrameRGB;        //!< frame, converted to RGB (soft)
-    StImagePlane               myDataRGB;         //!< RGB buffer data (for swscale)
-    SwsContext*                myToRgbCtx;        //!< software scaler context
-    AVPixelFormat              myToRgbPixFmt;     //!< current swscale context - from pixel format
+    StImagePlane               myDataRGB;         //!< RGB buffer data (for swscale, when buffer pool is unavailable)
+    StAVBufferPool             myPoolRGB;         //!< pool of RGB buffers (for swscale)
+    StAVScaler                 myToRgbCtx;        //!< software scaler (sliced, multi-threaded)
     bool                       myToRgbIsBroken;   //!< indicates broke swscale context - to RGB conversion is impossible
 
     StAVFrame                  myFrame;           //!< original decoded video frame
@@ -397,6 +422,9 @@ private:
     volatile int               myAudioDelayMSec;
 
     int64_t                    myFramesCounter;
+    mutable StMutex            myStatsMutex;      //!< lock for decoding statistics
+    uint64_t                   myStatsNbFrames;   //!< number of decoded frames
+    double                     myStatsDecodeSec;  //!< overall decoding time in seconds
     StImage                    myCachedFrame;
     bool                       myWasFlushed;
 
@@ -0,0 +1,617 @@
+/**
+ * Copyright © 2017 Kirill Gavrilov <kirill@sview.ru>
+ *
+ * StMoviePlayer program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * StMoviePlayer program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StVideoThumbnails.h"
+#include "StKeyframeIndex.h"
+#include "StCacheFile.h"
+
+#include <StAV/StAVFrame.h>
+#include <StAV/StAVPacket.h>
+#include <StAV/StAVScaler.h>
+#include <StFile/StFolder.h>
+#include <StFile/StRawFile.h>
+#include <StStrings/StLogger.h>
+
+#include <algorithm>
+
+#ifdef _WIN32
+    #include <sys/utime.h>
+#else
+    #include <utime.h>
+#endif
+
+#if defined(__linux__)
+    #include <sys/resource.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+namespace {
+
+    static const char     THE_ATLAS_MAGIC[8]   = { 's', 'V', 'T', 'H', 'U', 'M', 'B', '\0' };
+    static const uint32_t THE_ATLAS_VERSION    = 1;
+    static const int      THE_NB_COLS          = 10;  //!< thumbnails in atlas row
+    static const int      THE_NB_THUMBS        = 100; //!< thumbnails per file
+    static const int      THE_CELL_SIZE_X      = 160; //!< thumbnail width
+    static const int      THE_PUBLISH_STEP     = 8;   //!< number of thumbnails between atlas snapshots
+    static const int      THE_MAX_PACKETS      = 256; //!< maximum number of packets to read for single thumbnail
+    static const int      THE_THUMB_PAUSE_MS   = 10;  //!< pause between thumbnails to keep the worker in background
+    static const size_t   THE_CACHE_NB_ATLASES = 8;   //!< number of atlases kept in memory
+    static const size_t   THE_DISK_NB_ATLASES  = 64;  //!< maximum number of atlases in disk cache
+    static const uint64_t THE_DISK_CACHE_BYTES = 256 * 1024 * 1024; //!< maximum size of disk cache
+
+    /**
+     * Lower the priority of the calling thread.
+     */
+    static void setLowPriority() {
+    #if defined(_WIN32)
+        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+    #elif defined(__linux__)
+        // nice value is per-thread on Linux
+        setpriority(PRIO_PROCESS, (id_t )syscall(SYS_gettid), 10);
+    #endif
+    }
+
+    using stCache::appendValue;
+    using stCache::readValue;
+
+    /**
+     * Update modification time of the file to current time.
+     * Used to mark cache file as recently used.
+     */
+    static void touchFile(const StString& thePath) {
+    #ifdef _WIN32
+        StStringUtfWide aPathWide;
+        aPathWide.fromUnicode(thePath);
+        ::_wutime(aPathWide.toCString(), NULL);
+    #else
+        ::utime(thePath.toCString(), NULL);
+    #endif
+    }
+
+    /**
+     * Cache file description.
+     */
+    struct StCacheFileInfo {
+        StString Path;
+        uint64_t Size;
+        int64_t  Time;
+    };
+
+    /**
+     * Comparison for sorting cache files from the most recently used.
+     */
+    inline bool isCacheFileNewer(const StCacheFileInfo& theFile1,
+                                 const StCacheFileInfo& theFile2) {
+        return theFile1.Time > theFile2.Time;
+    }
+
+    /**
+     * Return number of atlas rows.
+     */
+    inline int getNbRows(const StThumbnailsAtlas& theAtlas) {
+        return (theAtlas.NbThumbs + theAtlas.NbCols - 1) / theAtlas.NbCols;
+    }
+
+    /**
+     * Close the format context.
+     */
+    static void closeFormatCtx(AVFormatContext*& theFormatCtx) {
+        if(theFormatCtx == NULL) {
+            return;
+        }
+    #if(LIBAVFORMAT_VERSION_INT >= AV_VERSION_INT(53, 17, 0))
+        avformat_close_input(&theFormatCtx);
+    #else
+        av_close_input_file(theFormatCtx);
+        theFormatCtx = NULL;
+    #endif
+    }
+
+}
+
+StVideoThumbnails::StVideoThumbnails(const StString& theCacheFolder)
+: myEventJob(false),
+  myCacheFolder(theCacheFolder),
+  myGeneration(0),
+  myHasJob(false),
+  myToQuit(false) {
+    myThread = new StThread(workerThreadFunction, (void* )this, "StVideoThumbnails");
+}
+
+StVideoThumbnails::~StVideoThumbnails() {
+    myMutex.lock();
+    myToQuit = true;
+    myMutex.unlock();
+    myEventJob.set();
+    myThread->wait();
+    myThread.nullify();
+}
+
+void StVideoThumbnails::open(const StString& theFilePath) {
+    myMutex.lock();
+    if(myFilePath == theFilePath) {
+        myMutex.unlock();
+        return;
+    }
+
+    ++myGeneration;
+    myFilePath = theFilePath;
+    myAtlas.nullify();
+    myHasJob = true;
+    myMutex.unlock();
+    myEventJob.set();
+}
+
+void StVideoThumbnails::close() {
+    myMutex.lock();
+    ++myGeneration;
+    myFilePath.clear();
+    myAtlas.nullify();
+    myHasJob = false;
+    myMutex.unlock();
+}
+
+bool StVideoThumbnails::getThumbnail(const double                 theProgress,
+                                     StHandle<StThumbnailsAtlas>& theAtlas,
+                                     StRectI_t&                   theCell) const {
+    myMutex.lock();
+    theAtlas = myAtlas;
+    myMutex.unlock();
+    if(theAtlas.isNull()
+    || theAtlas->NbThumbs < 1) {
+        return false;
+    }
+
+    // look for the nearest ready thumbnail
+    const int aNbThumbs = theAtlas->NbThumbs;
+    const int anIndex   = stClamp(int(theProgress * double(aNbThumbs)), 0, aNbThumbs - 1);
+    for(int aDelta = 0; aDelta < aNbThumbs; ++aDelta) {
+        if(anIndex - aDelta >= 0
+        && theAtlas->IsReady[anIndex - aDelta] != 0) {
+            theCell = theAtlas->getCell(anIndex - aDelta);
+            return true;
+        } else if(anIndex + aDelta < aNbThumbs
+               && theAtlas->IsReady[anIndex + aDelta] != 0) {
+            theCell = theAtlas->getCell(anIndex + aDelta);
+            return true;
+        }
+    }
+    return false;
+}
+
+SV_THREAD_FUNCTION StVideoThumbnails::workerThreadFunction(void* theThumbnails) {
+    StVideoThumbnails* aThumbs = (StVideoThumbnails* )theThumbnails;
+    setLowPriority();
+    aThumbs->workerLoop();
+    return SV_THREAD_RETURN 0;
+}
+
+void StVideoThumbnails::workerLoop() {
+    for(;;) {
+        myEventJob.wait();
+        myMutex.lock();
+        if(myToQuit) {
+            myMutex.unlock();
+            return;
+        }
+
+        myEventJob.reset();
+        const StString aFilePath = myFilePath;
+        const int      aGen      = myGeneration;
+        const bool     hasJob    = myHasJob;
+        myHasJob = false;
+        myMutex.unlock();
+
+        if(hasJob
+        && !aFilePath.isEmpty()) {
+            generate(aFilePath, aGen);
+        }
+    }
+}
+
+void StVideoThumbnails::publish(const Entry& theEntry,
+                                const int    theGen) {
+    myMutex.lock();
+    if(myGeneration == theGen) {
+        myAtlas = theEntry.Atlas;
+    }
+
+    for(std::list<Entry>::iterator anIter = myCache.begin(); anIter != myCache.end(); ++anIter) {
+        if(anIter->FilePath == theEntry.FilePath) {
+            myCache.erase(anIter);
+            break;
+        }
+    }
+    myCache.push_front(theEntry);
+    while(myCache.size() > THE_CACHE_NB_ATLASES) {
+        myCache.pop_back();
+    }
+    myMutex.unlock();
+}
+
+void StVideoThumbnails::generate(const StString& theFilePath,
+                                 const int       theGen) {
+    Entry anEntry;
+    anEntry.FilePath = theFilePath;
+    if(!StKeyframeIndex::getFileStats(theFilePath, anEntry.FileSize, anEntry.FileTime)) {
+        return;
+    }
+
+    // look into the memory cache
+    myMutex.lock();
+    for(std::list<Entry>::iterator anIter = myCache.begin(); anIter != myCache.end(); ++anIter) {
+        if(anIter->FilePath == theFilePath) {
+            if(anIter->FileSize == anEntry.FileSize
+            && anIter->FileTime == anEntry.FileTime) {
+                anEntry.Atlas = anIter->Atlas;
+            }
+            myCache.erase(anIter);
+            break;
+        }
+    }
+    myMutex.unlock();
+
+    // look into the disk cache
+    if(anEntry.Atlas.isNull()) {
+        anEntry.Atlas = load(anEntry);
+    }
+
+    size_t aNbReady = 0;
+    if(!anEntry.Atlas.isNull()) {
+        for(int anIter = 0; anIter < anEntry.Atlas->NbThumbs; ++anIter) {
+            aNbReady += anEntry.Atlas->IsReady[anIter] != 0 ? 1 : 0;
+        }
+        publish(anEntry, theGen);
+        if(aNbReady == size_t(anEntry.Atlas->NbThumbs)) {
+            return;
+        }
+    }
+
+    // open our own demuxer, so that playback is not affected
+    AVFormatContext* aFormatCtx = NULL;
+    if(avformat_open_input(&aFormatCtx, theFilePath.toCString(), NULL, NULL) != 0) {
+        return;
+    }
+
+    if(avformat_find_stream_info(aFormatCtx, NULL) < 0
+    || aFormatCtx->duration <= 0
+    || isCancelled(theGen)) {
+        closeFormatCtx(aFormatCtx);
+        return;
+    }
+
+    int aStreamId = -1;
+    for(unsigned int aStreamIter = 0; aStreamIter < aFormatCtx->nb_streams; ++aStreamIter) {
+        AVStream* aStream = aFormatCtx->streams[aStreamIter];
+        if(stAV::getCodecType(aStream) == AVMEDIA_TYPE_VIDEO
+        && !stAV::isAttachedPicture(aStream)) {
+            aStreamId = int(aStreamIter);
+            break;
+        }
+    }
+    if(aStreamId < 0) {
+        closeFormatCtx(aFormatCtx);
+        return;
+    }
+
+    // single-threaded decoder skipping all frames except keyframes
+    AVCodecContext* aCodecCtx = stAV::getCodecCtx(aFormatCtx->streams[aStreamId]);
+    AVCodec*        aCodec    = avcodec_find_decoder(aCodecCtx->codec_id);
+    aCodecCtx->thread_count = 1;
+    aCodecCtx->skip_frame   = AVDISCARD_NONKEY;
+#if(LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(53, 8, 0))
+    if(aCodec == NULL
+    || avcodec_open2(aCodecCtx, aCodec, NULL) < 0) {
+#else
+    if(aCodec == NULL
+    || avcodec_open(aCodecCtx, aCodec) < 0) {
+#endif
+        closeFormatCtx(aFormatCtx);
+        return;
+    }
+
+    if(anEntry.Atlas.isNull()) {
+        if(aCodecCtx->width <= 0
+        || aCodecCtx->height <= 0) {
+            avcodec_close(aCodecCtx);
+            closeFormatCtx(aFormatCtx);
+            return;
+        }
+
+        double aRatio = double(aCodecCtx->width) / double(aCodecCtx->height);
+        if(aCodecCtx->sample_aspect_ratio.num > 0
+        && aCodecCtx->sample_aspect_ratio.den > 0) {
+            aRatio *= double(aCodecCtx->sample_aspect_ratio.num) / double(aCodecCtx->sample_aspect_ratio.den);
+        }
+
+        StHandle<StThumbnailsAtlas> anAtlas = new StThumbnailsAtlas();
+        anAtlas->CellSizeX = THE_CELL_SIZE_X;
+        anAtlas->CellSizeY = stClamp(int(double(THE_CELL_SIZE_X) / aRatio) & ~1, 16, THE_CELL_SIZE_X);
+        anAtlas->NbCols    = THE_NB_COLS;
+        anAtlas->NbThumbs  = THE_NB_THUMBS;
+        anAtlas->IsReady.resize(THE_NB_THUMBS, 0);
+        anAtlas->Image->initZero(StImagePlane::ImgRGB,
+                                size_t(anAtlas->CellSizeX * anAtlas->NbCols),
+                                size_t(anAtlas->CellSizeY * getNbRows(*anAtlas)));
+        anEntry.Atlas = anAtlas;
+    }
+
+    // working copy of the atlas, published atlases should not be modified
+    StThumbnailsAtlas anAtlas;
+    if(!anAtlas.initCopy(*anEntry.Atlas)) {
+        avcodec_close(aCodecCtx);
+        closeFormatCtx(aFormatCtx);
+        return;
+    }
+
+    const int64_t aStartTime = aFormatCtx->start_time != stAV::NOPTS_VALUE ? aFormatCtx->start_time : 0;
+    StAVScaler aScaler;
+    StAVPacket aPacket;
+    StAVFrame  aFrame;
+    size_t     aNbNew = 0;
+
+    // coarse-to-fine order - thumbnails with large step go first
+    int aStep = 1;
+    while(aStep * 2 < anAtlas.NbThumbs) {
+        aStep *= 2;
+    }
+    for(; aStep >= 1 && !isCancelled(theGen); aStep /= 2) {
+        for(int aThumbIter = 0; aThumbIter < anAtlas.NbThumbs && !isCancelled(theGen); aThumbIter += aStep) {
+            if(anAtlas.IsReady[aThumbIter] != 0) {
+                continue;
+            }
+
+            const double  aProgress = (double(aThumbIter) + 0.5) / double(anAtlas.NbThumbs);
+            const int64_t aTarget   = aStartTime + int64_t(aProgress * double(aFormatCtx->duration));
+            if(av_seek_frame(aFormatCtx, -1, aTarget, AVSEEK_FLAG_BACKWARD) < 0) {
+                continue;
+            }
+            avcodec_flush_buffers(aCodecCtx);
+
+            bool isDone = false;
+            bool isEof  = false;
+            for(int aPktIter = 0; aPktIter < THE_MAX_PACKETS && !isDone && !isEof && !isCancelled(theGen);) {
+                if(av_read_frame(aFormatCtx, aPacket.getAVpkt()) < 0) {
+                    // drain the decoder with empty packet
+                    isEof = true;
+                    aPacket.getAVpkt()->data = NULL;
+                    aPacket.getAVpkt()->size = 0;
+                    aPacket.getAVpkt()->stream_index = aStreamId;
+                }
+                if(aPacket.getStreamId() != aStreamId) {
+                    aPacket.free();
+                    continue;
+                }
+                ++aPktIter;
+
+                int isFrameFinished = 0;
+            #if(LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(52, 23, 0))
+                avcodec_decode_video2(aCodecCtx, aFrame.Frame, &isFrameFinished, aPacket.getAVpkt());
+            #else
+                avcodec_decode_video(aCodecCtx, aFrame.Frame, &isFrameFinished,
+                                     aPacket.getData(), aPacket.getSize());
+            #endif
+                aPacket.free();
+                if(isFrameFinished == 0) {
+                    continue;
+                }
+
+                // downsize the frame directly into the atlas
+                const StRectI_t aCell = anAtlas.getCell(aThumbIter);
+                uint8_t* aDstData[4]     = { anAtlas.Image->changeData(size_t(aCell.top()), size_t(aCell.left())), NULL, NULL, NULL };
+                int      aDstLinesize[4] = { (int )anAtlas.Image->getSizeRowBytes(), 0, 0, 0 };
+                if(aFrame.Frame->width  > 0
+                && aFrame.Frame->height > 0
+                && aScaler.init(aFrame.Frame->width, aFrame.Frame->height, (AVPixelFormat )aFrame.Frame->format,
+                                anAtlas.CellSizeX,   anAtlas.CellSizeY,    stAV::PIX_FMT::RGB24, 1)
+                && aScaler.scale(aFrame.Frame->data, aFrame.Frame->linesize,
+                                 aDstData, aDstLinesize)) {
+                    anAtlas.IsReady[aThumbIter] = 1;
+                    ++aNbReady;
+                    ++aNbNew;
+                }
+                aFrame.reset();
+                isDone = true;
+            }
+            aPacket.free();
+
+            if(isDone
+            && (aNbNew == 1 || aNbNew % THE_PUBLISH_STEP == 0)) {
+                anEntry.Atlas = new StThumbnailsAtlas();
+                anEntry.Atlas->initCopy(anAtlas);
+                publish(anEntry, theGen);
+            }
+            StThread::sleep(THE_THUMB_PAUSE_MS);
+        }
+    }
+
+    avcodec_close(aCodecCtx);
+    closeFormatCtx(aFormatCtx);
+    if(aNbNew == 0) {
+        return;
+    }
+
+    anEntry.Atlas = new StThumbnailsAtlas();
+    anEntry.Atlas->initCopy(anAtlas);
+    publish(anEntry, theGen);
+    save(anEntry);
+    ST_DEBUG_LOG("StVideoThumbnails, " + aNbReady + " thumbnails generated for " + theFilePath);
+}
+
+StString StVideoThumbnails::getCachePath(const StString& theFilePath) const {
+    return myCacheFolder + "thumbnails" + SYS_FS_SPLITTER + StKeyframeIndex::getCacheFileName(theFilePath, "thumbs");
+}
+
+StHandle<StThumbnailsAtlas> StVideoThumbnails::load(const Entry& theEntry) const {
+    if(myCacheFolder.isEmpty()) {
+        return StHandle<StThumbnailsAtlas>();
+    }
+
+    const StString aCachePath = getCachePath(theEntry.FilePath);
+    StRawFile aFile; // cache file is rewritten in place by save(), thus should not be mapped
+    if(!StFileNode::isFileExists(aCachePath)
+    || !aFile.readFile(aCachePath)) {
+        return StHandle<StThumbnailsAtlas>();
+    }
+
+    const stUByte_t* anIter = aFile.getBuffer();
+    const stUByte_t* anEnd  = anIter + aFile.getSize();
+    char     aMagic[sizeof(THE_ATLAS_MAGIC)];
+    uint32_t aVersion  = 0;
+    uint64_t aFileSize = 0;
+    int64_t  aFileTime = 0;
+    uint32_t aPathLen  = 0;
+    if(!readValue(anIter, anEnd, aMagic)
+    || std::memcmp(aMagic, THE_ATLAS_MAGIC, sizeof(THE_ATLAS_MAGIC)) != 0
+    || !readValue(anIter, anEnd, aVersion)
+    ||  aVersion != THE_ATLAS_VERSION
+    || !readValue(anIter, anEnd, aFileSize)
+    || !readValue(anIter, anEnd, aFileTime)
+    || !readValue(anIter, anEnd, aPathLen)
+    ||  size_t(anEnd - anIter) < size_t(aPathLen)) {
+        return StHandle<StThumbnailsAtlas>();
+    }
+
+    // file might be replaced or modified since atlas creation
+    const StString aPath((const char* )anIter, size_t(aPathLen));
+    anIter += aPathLen;
+    if(aPath     != theEntry.FilePath
+    || aFileSize != theEntry.FileSize
+    || aFileTime != theEntry.FileTime) {
+        return StHandle<StThumbnailsAtlas>();
+    }
+
+    int32_t aCellSizeX = 0, aCellSizeY = 0, aNbCols = 0, aNbThumbs = 0;
+    if(!readValue(anIter, anEnd, aCellSizeX)
+    || !readValue(anIter, anEnd, aCellSizeY)
+    || !readValue(anIter, anEnd, aNbCols)
+    || !readValue(anIter, anEnd, aNbThumbs)
+    ||  aCellSizeX < 1 || aCellSizeX > 1024
+    ||  aCellSizeY < 1 || aCellSizeY > 1024
+    ||  aNbCols    < 1 || aNbThumbs  < 1 || aNbThumbs > 4096) {
+        return StHandle<StThumbnailsAtlas>();
+    }
+
+    StHandle<StThumbnailsAtlas> anAtlas = new StThumbnailsAtlas();
+    anAtlas->CellSizeX = aCellSizeX;
+    anAtlas->CellSizeY = aCellSizeY;
+    anAtlas->NbCols    = aNbCols;
+    anAtlas->NbThumbs  = aNbThumbs;
+    const size_t aSizeX   = size_t(aCellSizeX * aNbCols);
+    const size_t aSizeY   = size_t(aCellSizeY * getNbRows(*anAtlas));
+    const size_t aRowSize = aSizeX * 3;
+    if(size_t(anEnd - anIter) < size_t(aNbThumbs) + aRowSize * aSizeY
+    || !anAtlas->Image->initTrash(StImagePlane::ImgRGB, aSizeX, aSizeY)) {
+        return StHandle<StThumbnailsAtlas>();
+    }
+
+    anAtlas->IsReady.assign(anIter, anIter + aNbThumbs);
+    anIter += aNbThumbs;
+    for(size_t aRow = 0; aRow < aSizeY; ++aRow, anIter += aRowSize) {
+        stMemCpy(anAtlas->Image->changeData(aRow), anIter, aRowSize);
+    }
+    aFile.freeBuffer();
+
+    // modification time is used as access time by disk cache eviction
+    touchFile(aCachePath);
+    return anAtlas;
+}
+
+void StVideoThumbnails::trimDiskCache(const StString& theFolder) {
+    StArrayList<StString> anExtensions(1);
+    anExtensions.add(StString("thumbs"));
+    StFolder aFolder(theFolder);
+    aFolder.init(anExtensions, 1);
+
+    std::vector<StCacheFileInfo> aFiles;
+    aFiles.reserve(aFolder.size());
+    uint64_t aTotalSize = 0;
+    for(size_t aNodeId = 0; aNodeId < aFolder.size(); ++aNodeId) {
+        const StFileNode* aNode = aFolder.getValue(aNodeId);
+        StCacheFileInfo   aFile;
+        aFile.Path = aNode->getPath();
+        if(aNode->isFolder()
+        || !StKeyframeIndex::getFileStats(aFile.Path, aFile.Size, aFile.Time)) {
+            continue;
+        }
+        aTotalSize += aFile.Size;
+        aFiles.push_back(aFile);
+    }
+    if(aFiles.size() <= THE_DISK_NB_ATLASES
+    && aTotalSize    <= THE_DISK_CACHE_BYTES) {
+        return;
+    }
+
+    // remove least recently used atlases
+    std::sort(aFiles.begin(), aFiles.end(), isCacheFileNewer);
+    while(!aFiles.empty()
+       && (aFiles.size() > THE_DISK_NB_ATLASES
+        || aTotalSize    > THE_DISK_CACHE_BYTES)) {
+        const StCacheFileInfo& anOldest = aFiles.back();
+        if(StFileNode::removeFile(anOldest.Path)) {
+            ST_DEBUG_LOG("StVideoThumbnails, evicted cache file " + anOldest.Path);
+        }
+        aTotalSize -= anOldest.Size;
+        aFiles.pop_back();
+    }
+}
+
+bool StVideoThumbnails::save(const Entry& theEntry) const {
+    if(myCacheFolder.isEmpty()
+    || theEntry.Atlas.isNull()) {
+        return false;
+    }
+
+    const StString aCachePath = getCachePath(theEntry.FilePath);
+    StString aCacheFolder, aCacheName;
+    StFileNode::getFolderAndFile(aCachePath, aCacheFolder, aCacheName);
+    StFolder::createFolder(myCacheFolder);
+    StFolder::createFolder(aCacheFolder);
+
+    const StThumbnailsAtlas& anAtlas = *theEntry.Atlas;
+    const size_t aRowSize = anAtlas.Image->getSizeX() * 3;
+    std::vector<char> aBuffer;
+    aBuffer.reserve(64 + theEntry.FilePath.getSize() + anAtlas.IsReady.size() + aRowSize * anAtlas.Image->getSizeY());
+    aBuffer.insert(aBuffer.end(), THE_ATLAS_MAGIC, THE_ATLAS_MAGIC + sizeof(THE_ATLAS_MAGIC));
+    appendValue(aBuffer, THE_ATLAS_VERSION);
+    appendValue(aBuffer, theEntry.FileSize);
+    appendValue(aBuffer, theEntry.FileTime);
+    appendValue(aBuffer, uint32_t(theEntry.FilePath.getSize()));
+    aBuffer.insert(aBuffer.end(), theEntry.FilePath.toCString(), theEntry.FilePath.toCString() + theEntry.FilePath.getSize());
+    appendValue(aBuffer, int32_t(anAtlas.CellSizeX));
+    appendValue(aBuffer, int32_t(anAtlas.CellSizeY));
+    appendValue(aBuffer, int32_t(anAtlas.NbCols));
+    appendValue(aBuffer, int32_t(anAtlas.NbThumbs));
+    aBuffer.insert(aBuffer.end(), anAtlas.IsReady.begin(), anAtlas.IsReady.end());
+    for(size_t aRow = 0; aRow < anAtlas.Image->getSizeY(); ++aRow) {
+        const char* aRowData = (const char* )anAtlas.Image->getData(aRow);
+        aBuffer.insert(aBuffer.end(), aRowData, aRowData + aRowSize);
+    }
+
+    StRawFile aFile;
+    if(!aFile.openFile(StRawFile::WRITE, aCachePath)
+    ||  aFile.write(&aBuffer[0], aBuffer.size()) != aBuffer.size()) {
+        ST_DEBUG_LOG("StVideoThumbnails, unable to save cache file " + aCachePath);
+        return false;
+    }
+    aFile.closeFile();
+
+    trimDiskCache(aCacheFolder);
+    return true;
+}
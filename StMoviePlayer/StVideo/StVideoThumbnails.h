@@ -0,0 +1,202 @@
+/**
+ * Copyright © 2017 Kirill Gavrilov <kirill@sview.ru>
+ *
+ * StMoviePlayer program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * StMoviePlayer program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __StVideoThumbnails_h_
+#define __StVideoThumbnails_h_
+
+#include <StImage/StImagePlane.h>
+#include <StThreads/StCondition.h>
+#include <StThreads/StMutex.h>
+#include <StThreads/StThread.h>
+#include <StTemplates/StRect.h>
+
+#include <list>
+#include <vector>
+
+/**
+ * Atlas of seek-bar thumbnails of single file.
+ * Thumbnails are placed in a grid (row by row) and cover equal intervals of file duration.
+ * Published atlas is never modified, so that it can be used by GUI without locks.
+ */
+struct StThumbnailsAtlas {
+
+    StHandle<StImagePlane> Image;   //!< RGB image with all thumbnails
+    int                    CellSizeX; //!< thumbnail width
+    int                    CellSizeY; //!< thumbnail height
+    int                    NbCols;    //!< number of thumbnails in a row
+    int                    NbThumbs;  //!< overall number of thumbnails
+    std::vector<uint8_t>   IsReady;   //!< flags indicating decoded thumbnails
+
+    StThumbnailsAtlas() : Image(new StImagePlane()), CellSizeX(0), CellSizeY(0), NbCols(0), NbThumbs(0) {}
+
+    /**
+     * Initialize as copy (image data is copied).
+     */
+    ST_LOCAL bool initCopy(const StThumbnailsAtlas& theCopy) {
+        CellSizeX = theCopy.CellSizeX;
+        CellSizeY = theCopy.CellSizeY;
+        NbCols    = theCopy.NbCols;
+        NbThumbs  = theCopy.NbThumbs;
+        IsReady   = theCopy.IsReady;
+        Image     = new StImagePlane();
+        return Image->initCopy(*theCopy.Image, false);
+    }
+
+    /**
+     * @return rectangle of the thumbnail within the atlas
+     */
+    ST_LOCAL StRectI_t getCell(const int theIndex) const {
+        const int aLeft = (theIndex % NbCols) * CellSizeX;
+        const int aTop  = (theIndex / NbCols) * CellSizeY;
+        return StRectI_t(aTop, aTop + CellSizeY, aLeft, aLeft + CellSizeX);
+    }
+
+};
+
+/**
+ * Background generator of seek-bar thumbnails.
+ * Opens its own demuxer and decoder for the file (so that playback queues are not affected),
+ * decodes only keyframes at regular intervals and downsizes them into the atlas.
+ * Thumbnails are generated coarse-to-fine, so that the whole duration is covered early.
+ * Generated atlases are kept in LRU cache in memory and stored in cache folder,
+ * which is limited by number of atlases and overall size (least recently used atlases are removed).
+ */
+class StVideoThumbnails {
+
+        public:
+
+    /**
+     * Main constructor.
+     * @param theCacheFolder folder to store atlases, empty to disable disk cache
+     */
+    ST_LOCAL StVideoThumbnails(const StString& theCacheFolder);
+
+    /**
+     * Destructor, stops the worker thread.
+     */
+    ST_LOCAL ~StVideoThumbnails();
+
+    /**
+     * Start thumbnails generation for specified file (does nothing if atlas is already available).
+     * Generation of previous file is cancelled.
+     * @param theFilePath path to the local video file
+     */
+    ST_LOCAL void open(const StString& theFilePath);
+
+    /**
+     * Cancel thumbnails generation and release active atlas (but keep it in memory cache).
+     */
+    ST_LOCAL void close();
+
+    /**
+     * Find the thumbnail for specified position.
+     * When the thumbnail is not yet ready, the nearest available one is returned.
+     * @param theProgress position within the file duration, 0..1
+     * @param theAtlas    atlas containing the thumbnail
+     * @param theCell     thumbnail rectangle within the atlas
+     * @return false if there are no thumbnails for the active file
+     */
+    ST_LOCAL bool getThumbnail(const double                  theProgress,
+                               StHandle<StThumbnailsAtlas>&  theAtlas,
+                               StRectI_t&                    theCell) const;
+
+        private:
+
+    /**
+     * Cached atlas.
+     */
+    struct Entry {
+        StString                    FilePath; //!< file path
+        uint64_t                    FileSize; //!< file size
+        int64_t                     FileTime; //!< file modification time
+        StHandle<StThumbnailsAtlas> Atlas;    //!< generated atlas
+    };
+
+    /**
+     * Generate thumbnails for the file.
+     * @param theFilePath path to the file
+     * @param theGen      generation number to detect cancelling
+     */
+    ST_LOCAL void generate(const StString& theFilePath,
+                           const int       theGen);
+
+    /**
+     * Make the atlas active (if job has not been cancelled)
+     * and put it into the memory cache (evicting least recently used ones).
+     */
+    ST_LOCAL void publish(const Entry& theEntry,
+                          const int    theGen);
+
+    /**
+     * @return path to the cache file for specified video file
+     */
+    ST_LOCAL StString getCachePath(const StString& theFilePath) const;
+
+    /**
+     * Read the atlas from disk cache.
+     */
+    ST_LOCAL StHandle<StThumbnailsAtlas> load(const Entry& theEntry) const;
+
+    /**
+     * Write the atlas into disk cache.
+     */
+    ST_LOCAL bool save(const Entry& theEntry) const;
+
+    /**
+     * Remove least recently used atlases from disk cache folder to fit the budget.
+     */
+    ST_LOCAL static void trimDiskCache(const StString& theFolder);
+
+    /**
+     * @return true if generation of specified job has been cancelled
+     */
+    ST_LOCAL bool isCancelled(const int theGen) const {
+        return myToQuit || myGeneration != theGen;
+    }
+
+    /**
+     * Worker thread loop.
+     */
+    ST_LOCAL void workerLoop();
+
+    /**
+     * Worker thread function.
+     */
+    ST_LOCAL static SV_THREAD_FUNCTION workerThreadFunction(void* theThumbnails);
+
+        private:
+
+    mutable StMutex             myMutex;       //!< lock for all fields
+    StHandle<StThread>          myThread;      //!< worker thread
+    StCondition                 myEventJob;    //!< event signaled on new job
+    std::list<Entry>            myCache;       //!< cached atlases, most recently used first
+    StString                    myCacheFolder; //!< disk cache folder
+    StString                    myFilePath;    //!< active file
+    StHandle<StThumbnailsAtlas> myAtlas;       //!< atlas of active file
+    volatile int                myGeneration;  //!< job counter, incremented on each open() / close()
+    volatile bool               myHasJob;      //!< pending job flag
+    volatile bool               myToQuit;      //!< flag to stop the worker
+
+        private: //! @name no copies, please
+
+    StVideoThumbnails(const StVideoThumbnails& theCopy);
+    const StVideoThumbnails& operator=(const StVideoThumbnails& theCopy);
+
+};
+
+#endif // __StVideoThumbnails_h_
@@ -95,7 +95,7 @@ void StVideoTimer::mainLoop() {
                 if(isQuitMessage()) {
                     return;
                 }
-                StThread::sleep(1);
+                myVideo->getTextureQueue()->waitSwap(10);
             }
 
             // store old timer threshold value to check diff at the end
@@ -108,7 +108,7 @@ void StVideoTimer::mainLoop() {
                 if(isQuitMessage()) {
                     return;
                 }
-                StThread::sleep(1);
+                myVideo->getTextureQueue()->waitPush(10);
             }
 
             myDelayVV = getDelayMsec(myVideoPtsNextSec, myVideoPtsCurrSec);
@@ -124,8 +124,11 @@ void StVideoTimer::mainLoop() {
                     myAudioPtsCurrSec = myAudio->getPts();
                     if(myAudioPtsCurrSec > 0.0) {
                         myVideo->setAClock(myAudioPtsCurrSec);
-                        myDiffVA = getDelayMsec(myVideoPtsNextSec, myAudioPtsCurrSec);
-                        myDelayTimer = myDiffVA - double(myDelayVAFixed);
+                        const double aDiffVA = getDelayMsec(myVideoPtsNextSec, myAudioPtsCurrSec);
+                        myInfoLock.lock();
+                        myDiffVA = aDiffVA;
+                        myInfoLock.unlock();
+                        myDelayTimer = aDiffVA - double(myDelayVAFixed);
                     }
                 } else if(myVideoPtsCurrSec < 0.0) {
                     // empty video queue or first frame
@@ -156,6 +159,9 @@ void StVideoTimer::mainLoop() {
                 myTimerThrNext = 0.0;
             }
         }
-        StThread::sleep(1);
+
+        // sleep until next frame threshold, but wake up regularly to handle playback state changes
+        const double aTimeLeft = myTimerThrNext - myTimer.getElapsedTimeInMilliSec();
+        StThread::sleep(aTimeLeft >= 11.0 ? 10 : (aTimeLeft >= 2.0 ? int(aTimeLeft - 1.0) : 1));
     }
 }
@@ -83,6 +83,16 @@ class StVideoTimer {
         return 1000.0 / anAver;
     }
 
+    /**
+     * @return last measured difference between next video frame and audio timestamps (in milliseconds)
+     */
+    ST_LOCAL double getDiffVA() const {
+        myInfoLock.lock();
+        double aDiff = myDiffVA;
+        myInfoLock.unlock();
+        return aDiff;
+    }
+
     /**
      * Main refresher loop function.
      * Should be run on dedicated thread.
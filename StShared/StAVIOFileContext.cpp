@@ -1,5 +1,5 @@
 /**
- * Copyright © 2016 Kirill Gavrilov <kirill@sview.ru>
+ * Copyright © 2016-2017 Kirill Gavrilov <kirill@sview.ru>
  *
  * Distributed under the Boost Software License, Version 1.0.
  * See accompanying file license-boost.txt or copy at
@@ -8,12 +8,54 @@
 
 #include <StAV/StAVIOFileContext.h>
 
+#if !defined(_WIN32)
+    #include <fcntl.h>
+#endif
+
 extern "C" {
     #include <libavutil/error.h>
 };
 
+namespace {
+
+    /**
+     * Consumed amount of data after seeking to consider access sequential, in chunks.
+     */
+    static const int64_t THE_SEQ_CHUNKS = 2;
+
+    /**
+     * Tell the kernel which part of the file will be needed soon.
+     */
+    static void adviseWillNeed(FILE*         theFile,
+                               const int64_t theOffset,
+                               const size_t  theSize) {
+    #if defined(__linux__) && !defined(__ANDROID__)
+        ::posix_fadvise(::fileno(theFile), (off_t )theOffset, (off_t )theSize, POSIX_FADV_WILLNEED);
+    #else
+        (void )theFile;
+        (void )theOffset;
+        (void )theSize;
+    #endif
+    }
+
+}
+
 StAVIOFileContext::StAVIOFileContext()
-: myFile(NULL) {
+: myFile(NULL),
+  myEventData(false),
+  myEventSpace(false),
+  myRing(NULL),
+  myRingSize(0),
+  myChunkSize(0),
+  myRingHead(0),
+  myRingFilled(0),
+  myPosition(0),
+  myFileSize(-1),
+  mySeqBytes(0),
+  myGeneration(0),
+  myIsEof(false),
+  myIsError(false),
+  myToQuit(false) {
     //
 }
 
@@ -22,6 +64,7 @@ StAVIOFileContext::~StAVIOFileContext() {
 }
 
 void StAVIOFileContext::close() {
+    releaseReadAhead();
     if(myFile != NULL) {
         fclose(myFile);
         myFile = NULL;
@@ -38,11 +81,242 @@ bool StAVIOFileContext::openFromDescriptor(int theFD, const char* theMode) {
     return myFile != NULL;
 }
 
+bool StAVIOFileContext::openFile(const StString& thePath) {
+    close();
+#ifdef _WIN32
+    StStringUtfWide aPathWide;
+    aPathWide.fromUnicode(thePath);
+    myFile = ::_wfopen(aPathWide.toCString(), L"rb");
+#else
+    myFile =    ::fopen(thePath.toCString(), "rb");
+#endif
+    return myFile != NULL;
+}
+
+bool StAVIOFileContext::setReadAhead(const size_t theChunkSize,
+                                     const size_t theNbChunks) {
+    releaseReadAhead();
+    if(myFile == NULL
+    || theChunkSize == 0
+    || theNbChunks  == 0) {
+        return false;
+    }
+
+    // determine current position and file size
+#ifdef _WIN32
+    const int64_t aPosition = ::_ftelli64(myFile);
+    if(aPosition < 0
+    || ::_fseeki64(myFile, 0, SEEK_END) != 0) {
+        return false;
+    }
+    myFileSize = ::_ftelli64(myFile);
+    ::_fseeki64(myFile, aPosition, SEEK_SET);
+#else
+    const int64_t aPosition = ::ftello(myFile);
+    if(aPosition < 0
+    || ::fseeko(myFile, 0, SEEK_END) != 0) {
+        return false;
+    }
+    myFileSize = ::ftello(myFile);
+    ::fseeko(myFile, aPosition, SEEK_SET);
+#endif
+
+    // size the ring by the rest of the file - small files do not need a full ring
+    size_t aNbChunks = theNbChunks;
+    if(myFileSize > aPosition) {
+        const int64_t aNbChunksLeft = (myFileSize - aPosition + int64_t(theChunkSize) - 1) / int64_t(theChunkSize);
+        aNbChunks = size_t(stMin(int64_t(theNbChunks), aNbChunksLeft));
+    } else if(myFileSize >= 0) {
+        aNbChunks = 1;
+    }
+
+    myRingSize = theChunkSize * aNbChunks;
+    myRing     = stMemAllocAligned<uint8_t*>(myRingSize, 4096);
+    if(myRing == NULL) {
+        myRingSize = 0;
+        return false;
+    }
+
+    myChunkSize  = theChunkSize;
+    myRingHead   = 0;
+    myRingFilled = 0;
+    myPosition   = aPosition;
+    mySeqBytes   = 0;
+    myIsEof      = false;
+    myIsError    = false;
+    myToQuit     = false;
+#if defined(__linux__) && !defined(__ANDROID__)
+    ::posix_fadvise(::fileno(myFile), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    myReader = new StThread(readerThreadFunction, (void* )this, "StAVIOReadAhead");
+    return true;
+}
+
+void StAVIOFileContext::releaseReadAhead() {
+    if(!myReader.isNull()) {
+        myToQuit = true;
+        myEventSpace.set();
+        myReader->wait();
+        myReader.nullify();
+    }
+    stMemFreeAligned(myRing);
+    myRing       = NULL;
+    myRingSize   = 0;
+    myRingFilled = 0;
+    myRingHead   = 0;
+    myToQuit     = false;
+}
+
+SV_THREAD_FUNCTION StAVIOFileContext::readerThreadFunction(void* theContext) {
+    ((StAVIOFileContext* )theContext)->readerLoop();
+    return SV_THREAD_RETURN 0;
+}
+
+void StAVIOFileContext::readerLoop() {
+    int64_t aFilePos = -1;
+    for(;;) {
+        myRingMutex.lock();
+        if(myToQuit) {
+            myRingMutex.unlock();
+            return;
+        }
+
+        // fill just one chunk until sequential access is detected
+        const bool   isSequential = mySeqBytes >= THE_SEQ_CHUNKS * int64_t(myChunkSize);
+        const size_t aDepth       = isSequential ? myRingSize : myChunkSize;
+        if(myIsEof
+        || myIsError
+        || myRingFilled >= aDepth) {
+            myEventSpace.reset();
+            myRingMutex.unlock();
+            myEventSpace.wait();
+            continue;
+        }
+
+        // read up to the chunk boundary within the file and without wrapping the ring
+        const unsigned int aGeneration = myGeneration;
+        const int64_t      aReadPos    = myPosition + int64_t(myRingFilled);
+        const size_t       aTail       = (myRingHead + myRingFilled) % myRingSize;
+        size_t aLen = myChunkSize - size_t(aReadPos % int64_t(myChunkSize));
+        aLen = stMin(aLen, myRingSize - myRingFilled);
+        aLen = stMin(aLen, myRingSize - aTail);
+        myRingMutex.unlock();
+
+        bool isOk = true;
+        if(aFilePos != aReadPos) {
+        #ifdef _WIN32
+            isOk = ::_fseeki64(myFile, aReadPos, SEEK_SET) == 0;
+        #else
+            isOk =    ::fseeko(myFile, aReadPos, SEEK_SET) == 0;
+        #endif
+        }
+        const size_t aNbRead = isOk ? ::fread(myRing + aTail, 1, aLen, myFile) : 0;
+        const bool   isEof   = isOk && aNbRead < aLen && ::feof(myFile) != 0;
+        aFilePos = isOk ? (aReadPos + int64_t(aNbRead)) : -1;
+        if(isSequential && aNbRead == aLen) {
+            adviseWillNeed(myFile, aFilePos, myChunkSize);
+        }
+
+        myRingMutex.lock();
+        if(aGeneration == myGeneration) {
+            myRingFilled += aNbRead;
+            if(aNbRead < aLen) {
+                if(isEof) {
+                    myIsEof = true;
+                } else {
+                    myIsError = true;
+                }
+            }
+            myEventData.set();
+        } // otherwise position has been changed during reading - discard the data
+        myRingMutex.unlock();
+    }
+}
+
+int StAVIOFileContext::readBuffered(uint8_t* theBuf,
+                                    int      theBufSize) {
+    if(theBufSize <= 0) {
+        return 0;
+    }
+
+    myRingMutex.lock();
+    for(;;) {
+        if(myRingFilled > 0) {
+            const size_t aNbCopy = stMin(size_t(theBufSize), size_t(myRingFilled));
+            const size_t aPart1  = stMin(aNbCopy, myRingSize - myRingHead);
+            stMemCpy(theBuf, myRing + myRingHead, aPart1);
+            if(aNbCopy > aPart1) {
+                stMemCpy(theBuf + aPart1, myRing, aNbCopy - aPart1);
+            }
+            myRingHead    = (myRingHead + aNbCopy) % myRingSize;
+            myRingFilled -= aNbCopy;
+            myPosition   += int64_t(aNbCopy);
+            mySeqBytes   += int64_t(aNbCopy);
+            myEventSpace.set();
+            myRingMutex.unlock();
+            return int(aNbCopy);
+        } else if(myIsEof) {
+            myRingMutex.unlock();
+            return AVERROR_EOF;
+        } else if(myIsError) {
+            myRingMutex.unlock();
+            return -1;
+        }
+
+        // wait for the reader
+        myEventData.reset();
+        myRingMutex.unlock();
+        myEventData.wait();
+        myRingMutex.lock();
+    }
+}
+
+int64_t StAVIOFileContext::seekBuffered(int64_t theOffset,
+                                        int     theWhence) {
+    if(theWhence == AVSEEK_SIZE) {
+        return myFileSize;
+    }
+
+    myRingMutex.lock();
+    int64_t aTarget = -1;
+    switch(theWhence) {
+        case SEEK_SET: aTarget = theOffset; break;
+        case SEEK_CUR: aTarget = myPosition + theOffset; break;
+        case SEEK_END: aTarget = myFileSize >= 0 ? (myFileSize + theOffset) : -1; break;
+    }
+    if(aTarget < 0) {
+        myRingMutex.unlock();
+        return -1;
+    }
+
+    if(aTarget >= myPosition
+    && aTarget <= myPosition + int64_t(myRingFilled)) {
+        // skip data within the buffer
+        const size_t aSkip = size_t(aTarget - myPosition);
+        myRingHead    = (myRingHead + aSkip) % myRingSize;
+        myRingFilled -= aSkip;
+        mySeqBytes   += int64_t(aSkip);
+    } else {
+        // drop the buffer and cancel reading in progress
+        ++myGeneration;
+        myRingHead   = 0;
+        myRingFilled = 0;
+        mySeqBytes   = 0;
+        myIsEof      = false;
+        myIsError    = false;
+    }
+    myPosition = aTarget;
+    myEventSpace.set();
+    myRingMutex.unlock();
+    return aTarget;
+}
+
 int StAVIOFileContext::read(uint8_t* theBuf,
                             int      theBufSize) {
-
     if(myFile == NULL) {
         return -1;
+    } else if(!myReader.isNull()) {
+        return readBuffered(theBuf, theBufSize);
     }
 
     int aNbRead = (int )::fread(theBuf, 1, theBufSize, myFile);
@@ -56,7 +330,8 @@ int StAVIOFileContext::read(uint8_t* theBuf,
 
 int StAVIOFileContext::write(uint8_t* theBuf,
                              int      theBufSize) {
-    if(myFile == NULL) {
+    if(myFile == NULL
+    || !myReader.isNull()) {
         return -1;
     }
 
@@ -65,8 +340,12 @@ int StAVIOFileContext::write(uint8_t* theBuf,
 
 int64_t StAVIOFileContext::seek(int64_t theOffset,
                                 int     theWhence) {
-    if(theWhence == AVSEEK_SIZE
-    || myFile == NULL) {
+    theWhence &= ~AVSEEK_FORCE;
+    if(myFile == NULL) {
+        return -1;
+    } else if(!myReader.isNull()) {
+        return seekBuffered(theOffset, theWhence);
+    } else if(theWhence == AVSEEK_SIZE) {
         return -1;
     }
 
@@ -1,5 +1,5 @@
 /**
- * Copyright © 2011-2015 Kirill Gavrilov <kirill@sview.ru>
+ * Copyright © 2011-2017 Kirill Gavrilov <kirill@sview.ru>
  *
  * Distributed under the Boost Software License, Version 1.0.
  * See accompanying file license-boost.txt or copy at
@@ -9,11 +9,85 @@
 #include <StAV/StAVImage.h>
 
 #include <StAV/StAVPacket.h>
+#include <StAV/StAVScaler.h>
 #include <StFile/StFileNode.h>
 #include <StFile/StRawFile.h>
 #include <StImage/StJpegParser.h>
 #include <StStrings/StLogger.h>
 #include <StAV/StAVIOMemContext.h>
+#include <StAlienData.h>
+
+#ifndef ST_LIBAV_FORK
+namespace {
+
+    /**
+     * Read image dimensions from JPEG header (SOFn marker).
+     */
+    static bool probeJpegSize(const stUByte_t* theData,
+                              const size_t     theSize,
+                              size_t&          theSizeX,
+                              size_t&          theSizeY) {
+        if(theSize < 4
+        || theData[0] != 0xFF
+        || theData[1] != 0xD8) {
+            return false;
+        }
+
+        for(size_t anOffset = 2; anOffset + 9 <= theSize;) {
+            if(theData[anOffset] != 0xFF) {
+                return false;
+            }
+
+            const stUByte_t aMarker = theData[anOffset + 1];
+            if(aMarker == 0xFF) {
+                ++anOffset; // fill byte
+                continue;
+            } else if(aMarker == 0xD9   // EOI
+                   || aMarker == 0xDA) { // SOS
+                return false;
+            } else if(aMarker >= 0xC0 && aMarker <= 0xCF
+                   && aMarker != 0xC4   // DHT
+                   && aMarker != 0xC8   // JPG
+                   && aMarker != 0xCC) { // DAC
+                theSizeY = StAlienData::Get16uBE(theData + anOffset + 5);
+                theSizeX = StAlienData::Get16uBE(theData + anOffset + 7);
+                return theSizeX > 0 && theSizeY > 0;
+            }
+            anOffset += 2 + StAlienData::Get16uBE(theData + anOffset + 2);
+        }
+        return false;
+    }
+
+    /**
+     * Read image dimensions from JPEG2000 codestream header (SIZ marker),
+     * which is located right after SOC marker both in raw codestream and within JP2 container.
+     */
+    static bool probeJpeg2000Size(const stUByte_t* theData,
+                                  const size_t     theSize,
+                                  size_t&          theSizeX,
+                                  size_t&          theSizeY) {
+        const size_t aSearchMax = stMin(theSize, size_t(64 * 1024));
+        for(size_t anOffset = 0; anOffset + 24 <= aSearchMax; ++anOffset) {
+            if(theData[anOffset]     == 0xFF && theData[anOffset + 1] == 0x4F   // SOC
+            && theData[anOffset + 2] == 0xFF && theData[anOffset + 3] == 0x51) { // SIZ
+                const uint32_t aSizeX  = StAlienData::Get32uBE(theData + anOffset + 8);
+                const uint32_t aSizeY  = StAlienData::Get32uBE(theData + anOffset + 12);
+                const uint32_t anOffX  = StAlienData::Get32uBE(theData + anOffset + 16);
+                const uint32_t anOffY  = StAlienData::Get32uBE(theData + anOffset + 20);
+                if(aSizeX <= anOffX
+                || aSizeY <= anOffY) {
+                    return false;
+                }
+                theSizeX = aSizeX - anOffX;
+                theSizeY = aSizeY - anOffY;
+                return true;
+            }
+        }
+        return false;
+    }
+
+}
+#endif
 
 bool StAVImage::init() {
     return stAV::init();
@@ -126,7 +200,8 @@ static void fillPointersAV(const StImage& theImage,
  * Image buffers should be already initialized!
  */
 static bool convert(const StImage& theImageFrom, AVPixelFormat theFormatFrom,
-                          StImage& theImageTo,   AVPixelFormat theFormatTo) {
+                          StImage& theImageTo,   AVPixelFormat theFormatTo,
+                          StAVScaler& theScaler, const int theNbSlices) {
     ST_DEBUG_LOG("StAVImage, convert from " + stAV::PIX_FMT::getString(theFormatFrom) + " " + theImageFrom.getSizeX() + "x" + theImageFrom.getSizeY()
                + " to " + stAV::PIX_FMT::getString(theFormatTo) + " " + theImageTo.getSizeX() + "x" + theImageTo.getSizeY());
     if(theFormatFrom == stAV::PIX_FMT::NONE
@@ -134,10 +209,9 @@ static bool convert(const StImage& theImageFrom, AVPixelFormat theFormatFrom,
         return false;
     }
 
-    SwsContext* aCtxToRgb = sws_getContext((int )theImageFrom.getSizeX(), (int )theImageFrom.getSizeY(), theFormatFrom, // source
-                                           (int )theImageTo.getSizeX(),   (int )theImageTo.getSizeY(),   theFormatTo,   // destination
-                                           SWS_BICUBIC, NULL, NULL, NULL);
-    if(aCtxToRgb == NULL) {
+    if(!theScaler.init((int )theImageFrom.getSizeX(), (int )theImageFrom.getSizeY(), theFormatFrom, // source
+                       (int )theImageTo.getSizeX(),   (int )theImageTo.getSizeY(),   theFormatTo,    // destination
+                       theNbSlices)) {
         return false;
     }
 
@@ -147,17 +221,21 @@ static bool convert(const StImage& theImageFrom, AVPixelFormat theFormatFrom,
     uint8_t* aDstData[4]; int aDstLinesize[4];
     fillPointersAV(theImageTo, aDstData, aDstLinesize);
 
-    sws_scale(aCtxToRgb,
-              aSrcData, aSrcLinesize,
-              0, (int )theImageFrom.getSizeY(),
-              aDstData, aDstLinesize);
-
-    sws_freeContext(aCtxToRgb);
-    return true;
+    return theScaler.scale(aSrcData, aSrcLinesize,
+                           aDstData, aDstLinesize);
 }
 
 bool StAVImage::resize(const StImage& theImageFrom,
                        StImage&       theImageTo) {
+    // single slice - do not spawn threads for one-time scaler
+    StAVScaler aScaler;
+    return resize(theImageFrom, theImageTo, aScaler, 1);
+}
+
+bool StAVImage::resize(const StImage& theImageFrom,
+                       StImage&       theImageTo,
+                       StAVScaler&    theScaler,
+                       const int      theNbSlices) {
     if(theImageFrom.isNull()
     || theImageFrom.getSizeX() < 1
     || theImageFrom.getSizeY() < 1
@@ -173,7 +251,8 @@ bool StAVImage::resize(const StImage& theImageFrom,
     return aFormatFrom != stAV::PIX_FMT::NONE
         && aFormatTo   != stAV::PIX_FMT::NONE
         && convert(theImageFrom, aFormatFrom,
-                   theImageTo,   aFormatTo);
+                   theImageTo,   aFormatTo,
+                   theScaler, theNbSlices);
 }
 
 void StAVImage::close() {
@@ -213,6 +292,8 @@ bool StAVImage::loadExtra(const StString& theFilePath,
     setState();
     close();
     myMetadata.clear();
+    mySrcSizeX = 0;
+    mySrcSizeY = 0;
 
     switch(theImageType) {
         case ST_TYPE_PNG:
@@ -315,17 +396,6 @@ bool StAVImage::loadExtra(const StString& theFilePath,
         return false;
     }
 
-    // open VIDEO codec
-#if(LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(53, 8, 0))
-    if(avcodec_open2(myCodecCtx, myCodec, NULL) < 0) {
-#else
-    if(avcodec_open(myCodecCtx, myCodec) < 0) {
-#endif
-        setState("AVCodec library, could not open video codec");
-        close();
-        return false;
-    }
-
     // read one packet or file
     StRawFile aRawFile(theFilePath);
     StAVPacket anAvPkt;
@@ -340,6 +410,7 @@ bool StAVImage::loadExtra(const StString& theFilePath,
                 return false;
             }
         } else {
+            aRawFile.setMappingAllowed(true);
             if(!aRawFile.readFile()) {
                 setState("StAVImage, could not read the file");
                 close();
@@ -351,6 +422,35 @@ bool StAVImage::loadExtra(const StString& theFilePath,
     }
     anAvPkt.setKeyFrame();
 
+#ifndef ST_LIBAV_FORK
+    // decode image at reduced resolution (JPEG DCT scaling / JPEG2000 resolution levels),
+    // when full resolution is not needed
+    size_t aSrcSizeX = 0, aSrcSizeY = 0;
+    if(myCodec->max_lowres > 0
+    && ((myCodec->id == AV_CODEC_ID_MJPEG
+      && probeJpegSize    (anAvPkt.getAVpkt()->data, (size_t )anAvPkt.getAVpkt()->size, aSrcSizeX, aSrcSizeY))
+     || (myCodec->id == AV_CODEC_ID_JPEG2000
+      && probeJpeg2000Size(anAvPkt.getAVpkt()->data, (size_t )anAvPkt.getAVpkt()->size, aSrcSizeX, aSrcSizeY)))) {
+        // levels above 1/8 are not guaranteed to be present in JPEG2000 codestream
+        myCodecCtx->lowres = getReductionLevel(aSrcSizeX, aSrcSizeY, stMin(int(myCodec->max_lowres), 3));
+        if(myCodecCtx->lowres > 0) {
+            mySrcSizeX = aSrcSizeX;
+            mySrcSizeY = aSrcSizeY;
+        }
+    }
+#endif
+
+    // open VIDEO codec
+#if(LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(53, 8, 0))
+    if(avcodec_open2(myCodecCtx, myCodec, NULL) < 0) {
+#else
+    if(avcodec_open(myCodecCtx, myCodec) < 0) {
+#endif
+        setState("AVCodec library, could not open video codec");
+        close();
+        return false;
+    }
+
     // decode one frame
     int isFrameFinished = 0;
 #if(LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(52, 23, 0))
@@ -493,11 +593,11 @@ bool StAVImage::loadExtra(const StString& theFilePath,
                                    size_t(aDimsYUV.widthV), size_t(aDimsYUV.heightV), myFrame.getLineSize(2));
     } else {
         ///ST_DEBUG_LOG("StAVImage, perform conversion from Pixel format '" + avcodec_get_pix_fmt_name(myCodecCtx->pix_fmt) + "' to RGB");
-        // initialize software scaler/converter
-        SwsContext* pToRgbCtx = sws_getContext(myCodecCtx->width, myCodecCtx->height, myCodecCtx->pix_fmt,    // source
-                                               myCodecCtx->width, myCodecCtx->height, stAV::PIX_FMT::RGB24, // destination
-                                               SWS_BICUBIC, NULL, NULL, NULL);
-        if(pToRgbCtx == NULL) {
+        // initialize software scaler/converter,
+        // local instance so that its worker threads are not kept by decoded (and cached) image
+        StAVScaler aScaler;
+        if(!aScaler.init(myCodecCtx->width, myCodecCtx->height, myCodecCtx->pix_fmt,     // source
+                         myCodecCtx->width, myCodecCtx->height, stAV::PIX_FMT::RGB24)) { // destination
             setState("SWScale library, failed to create SWScaler context");
             close();
             return false;
@@ -513,14 +613,10 @@ bool StAVImage::loadExtra(const StString& theFilePath,
         rgbData[0]     = changePlane(0).changeData();
         rgbLinesize[0] = (int )changePlane(0).getSizeRowBytes();
 
-        sws_scale(pToRgbCtx,
-                  myFrame.Frame->data, myFrame.Frame->linesize,
-                  0, myCodecCtx->height,
-                  rgbData, rgbLinesize);
+        aScaler.scale(myFrame.Frame->data, myFrame.Frame->linesize,
+                      rgbData, rgbLinesize);
         // reset original data
         closeAvCtx();
-
-        sws_freeContext(pToRgbCtx);
     }
 
     // set debug information
@@ -547,7 +643,8 @@ bool StAVImage::save(const StString& theFilePath,
         return false;
     }
 
-    StImage anImage;
+    StImage    anImage;
+    StAVScaler aScaler;
     switch(theImageType) {
         case ST_TYPE_PNG:
         case ST_TYPE_PNS: {
@@ -566,7 +663,8 @@ bool StAVImage::save(const StString& theFilePath,
                 anImage.changePlane().initTrash(StImagePlane::ImgRGB, getSizeX(), getSizeY(), getAligned(getSizeX() * 3));
                 AVPixelFormat aPFrmtTarget = stAV::PIX_FMT::RGB24;
                 if(!convert(*this,   aPFormatAV,
-                            anImage, aPFrmtTarget)) {
+                            anImage, aPFrmtTarget,
+                            aScaler, 0)) {
                     setState("SWScale library, failed to create SWScaler context");
                     close();
                     return false;
@@ -616,7 +714,8 @@ bool StAVImage::save(const StString& theFilePath,
                 anImage.changePlane(2).initTrash(StImagePlane::ImgGray, getSizeX(), getSizeY(), getAligned(getSizeX()));
                 stMemSet(anImage.changePlane(2).changeData(), '\0', anImage.getPlane(2).getSizeBytes());
                 if(!convert(*this,   aPFormatAV,
-                            anImage, aPFrmtTarget)) {
+                            anImage, aPFrmtTarget,
+                            aScaler, 0)) {
                     setState("SWScale library, failed to create SWScaler context");
                     close();
                     return false;
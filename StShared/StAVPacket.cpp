@@ -128,3 +128,36 @@ void StAVPacket::setAVpkt(const AVPacket& theCopy) {
     }
 #endif
 }
+
+void StAVPacket::moveFrom(StAVPacket& theSrc) {
+    if(&theSrc == this) {
+        return;
+    }
+
+    free();
+    myStParams    = theSrc.myStParams;
+    myDurationSec = theSrc.myDurationSec;
+    myType        = theSrc.myType;
+    if(theSrc.myPacket.data == NULL) {
+        theSrc.free();
+        return;
+    }
+
+#if(LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(55, 0, 0))
+    const bool isRefCounted = theSrc.myPacket.buf != NULL;
+#else
+    const bool isRefCounted = theSrc.myPacket.destruct != NULL;
+#endif
+    if(theSrc.myIsOwn || isRefCounted) {
+        // just take the reference
+        myPacket = theSrc.myPacket;
+        myIsOwn  = theSrc.myIsOwn;
+        theSrc.avInitPacket();
+        theSrc.myIsOwn = false;
+        return;
+    }
+
+    // data is owned by demuxer and will be overridden by next read
+    setAVpkt(theSrc.myPacket);
+    theSrc.free();
+}
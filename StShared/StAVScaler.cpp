@@ -0,0 +1,321 @@
+/**
+ * Copyright © 2017 Kirill Gavrilov <kirill@sview.ru>
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * See accompanying file license-boost.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt
+ */
+
+#include <StAV/StAVScaler.h>
+
+#include <StThreads/StCondition.h>
+
+#if(LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(51, 42, 0))
+extern "C" {
+    #include <libavutil/pixdesc.h>
+}
+#endif
+
+namespace {
+
+    /**
+     * Minimal number of rows in slice to make threading worth it.
+     */
+    static const int THE_MIN_SLICE_ROWS = 128;
+
+    /**
+     * Maximum number of slices.
+     */
+    static const int THE_MAX_SLICES = 8;
+
+    /**
+     * Pixel format layout relevant for slicing.
+     */
+    struct StPlanesLayout {
+        int NbPlanes;    //!< number of image planes (palette is not counted)
+        int ChromaShift; //!< vertical chroma subsampling (log2) of planes 1 and 2
+    };
+
+    /**
+     * Fetch pixel format layout.
+     * @return false if pixel format descriptor is unavailable
+     */
+    static bool planesLayout(const AVPixelFormat theFormat,
+                             StPlanesLayout&     theLayout) {
+        theLayout.NbPlanes    = 1;
+        theLayout.ChromaShift = 0;
+    #if(LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(51, 42, 0))
+        const AVPixFmtDescriptor* aDesc = av_pix_fmt_desc_get(theFormat);
+        if(aDesc == NULL) {
+            return false;
+        }
+        for(int aCompIter = 0; aCompIter < aDesc->nb_components; ++aCompIter) {
+            theLayout.NbPlanes = stMax(theLayout.NbPlanes, int(aDesc->comp[aCompIter].plane) + 1);
+        }
+        if(aDesc->nb_components >= 3
+        && theLayout.NbPlanes > 1) {
+            theLayout.ChromaShift = aDesc->log2_chroma_h;
+        }
+        return true;
+    #else
+        (void )theFormat;
+        return false;
+    #endif
+    }
+
+    /**
+     * Offset plane pointers to specified row.
+     */
+    static void offsetPlanes(uint8_t* const theData[],
+                             const int      theLinesize[],
+                             const int      theNbPlanes,
+                             const int      theChromaShift,
+                             const int      theRow,
+                             uint8_t*       theResult[]) {
+        for(int aPlaneIter = 0; aPlaneIter < 4; ++aPlaneIter) {
+            theResult[aPlaneIter] = theData[aPlaneIter];
+            if(theData[aPlaneIter] == NULL
+            || aPlaneIter >= theNbPlanes) {
+                continue;
+            }
+            const int aRow = (aPlaneIter == 1 || aPlaneIter == 2) ? (theRow >> theChromaShift) : theRow;
+            theResult[aPlaneIter] += ptrdiff_t(aRow) * ptrdiff_t(theLinesize[aPlaneIter]);
+        }
+    }
+
+}
+
+/**
+ * Slice definition.
+ */
+struct StAVScaler::Slice {
+
+    StAVScaler*        Scaler;     //!< owner
+    SwsContext*        Context;    //!< swscale context for this slice
+    int                SrcY;       //!< first source row
+    int                SrcSizeY;   //!< number of source rows
+    int                DstY;       //!< first destination row
+    int                DstSizeY;   //!< number of destination rows
+    StHandle<StThread> Thread;     //!< worker thread (NULL for the first slice)
+    StCondition        EventStart; //!< event to start processing
+    StCondition        EventDone;  //!< event indicating processed slice
+
+    Slice(StAVScaler* theScaler)
+    : Scaler(theScaler),
+      Context(NULL),
+      SrcY(0),
+      SrcSizeY(0),
+      DstY(0),
+      DstSizeY(0),
+      EventStart(false),
+      EventDone(true) {}
+
+};
+
+StAVScaler::StAVScaler()
+: mySrcData(NULL),
+  mySrcLinesize(NULL),
+  myDstData(NULL),
+  myDstLinesize(NULL),
+  mySrcSizeX(0),
+  mySrcSizeY(0),
+  mySrcFormat(stAV::PIX_FMT::NONE),
+  myDstSizeX(0),
+  myDstSizeY(0),
+  myDstFormat(stAV::PIX_FMT::NONE),
+  mySrcNbPlanes(1),
+  mySrcChromaShift(0),
+  myDstNbPlanes(1),
+  myDstChromaShift(0),
+  myNbSlicesReq(0),
+  myToQuit(false) {
+    //
+}
+
+StAVScaler::~StAVScaler() {
+    release();
+}
+
+void StAVScaler::release() {
+    myToQuit = true;
+    for(size_t aSliceIter = 0; aSliceIter < mySlices.size(); ++aSliceIter) {
+        Slice* aSlice = mySlices[aSliceIter];
+        if(!aSlice->Thread.isNull()) {
+            aSlice->EventStart.set();
+            aSlice->Thread->wait();
+            aSlice->Thread.nullify();
+        }
+        sws_freeContext(aSlice->Context);
+        delete aSlice;
+    }
+    mySlices.clear();
+    myToQuit    = false;
+    mySrcSizeX  = 0;
+    mySrcSizeY  = 0;
+    mySrcFormat = stAV::PIX_FMT::NONE;
+    myDstSizeX  = 0;
+    myDstSizeY  = 0;
+    myDstFormat = stAV::PIX_FMT::NONE;
+}
+
+bool StAVScaler::init(const int           theSrcSizeX,
+                      const int           theSrcSizeY,
+                      const AVPixelFormat theSrcFormat,
+                      const int           theDstSizeX,
+                      const int           theDstSizeY,
+                      const AVPixelFormat theDstFormat,
+                      const int           theNbSlices) {
+    if(isValid()
+    && mySrcSizeX    == theSrcSizeX
+    && mySrcSizeY    == theSrcSizeY
+    && mySrcFormat   == theSrcFormat
+    && myDstSizeX    == theDstSizeX
+    && myDstSizeY    == theDstSizeY
+    && myDstFormat   == theDstFormat
+    && myNbSlicesReq == theNbSlices) {
+        return true;
+    }
+
+    if(theSrcSizeX <= 0 || theSrcSizeY <= 0
+    || theDstSizeX <= 0 || theDstSizeY <= 0
+    || theSrcFormat == stAV::PIX_FMT::NONE
+    || theDstFormat == stAV::PIX_FMT::NONE) {
+        release();
+        return false;
+    }
+
+    // define number of slices
+    StPlanesLayout aSrcLayout, aDstLayout;
+    const bool hasLayout = planesLayout(theSrcFormat, aSrcLayout)
+                        && planesLayout(theDstFormat, aDstLayout);
+    // chroma subsampling is a power of two, so the larger one is a multiple of another
+    const int anAlign = 1 << stMax(aSrcLayout.ChromaShift, aDstLayout.ChromaShift);
+    int aNbSlices = theNbSlices;
+    if(aNbSlices <= 0) {
+        aNbSlices = stMin(StThread::countLogicalProcessors(), THE_MAX_SLICES);
+    }
+    aNbSlices = stMin(aNbSlices, theDstSizeY / THE_MIN_SLICE_ROWS);
+    if(!hasLayout) {
+        aNbSlices = 1; // pixel format descriptors are unavailable
+    } else if(theSrcSizeX != theDstSizeX
+           || theSrcSizeY != theDstSizeY) {
+        aNbSlices = 1; // filter taps would be clamped at slice edges producing visible seams
+    }
+    aNbSlices = stMax(aNbSlices, 1);
+
+    // release extra slices and create missing ones
+    while((int )mySlices.size() > aNbSlices) {
+        Slice* aSlice = mySlices.back();
+        mySlices.pop_back();
+        if(!aSlice->Thread.isNull()) {
+            myToQuit = true;
+            aSlice->EventStart.set();
+            aSlice->Thread->wait();
+            myToQuit = false;
+        }
+        sws_freeContext(aSlice->Context);
+        delete aSlice;
+    }
+    while((int )mySlices.size() < aNbSlices) {
+        Slice* aSlice = new Slice(this);
+        if(!mySlices.empty()) {
+            aSlice->Thread = new StThread(threadFunction, (void* )aSlice, "StAVScaler");
+        }
+        mySlices.push_back(aSlice);
+    }
+
+    // split image into slices with boundaries aligned to chroma subsampling of both formats;
+    // slicing is done only without resizing, so that source and destination rows match
+    for(int aSliceIter = 0; aSliceIter < aNbSlices; ++aSliceIter) {
+        Slice* aSlice = mySlices[aSliceIter];
+        int aDstFrom = (theDstSizeY *  aSliceIter)      / aNbSlices;
+        int aDstTo   = (theDstSizeY * (aSliceIter + 1)) / aNbSlices;
+        aDstFrom -= aDstFrom % anAlign;
+        if(aSliceIter + 1 == aNbSlices) {
+            aDstTo = theDstSizeY;
+        } else {
+            aDstTo -= aDstTo % anAlign;
+        }
+        const int aSrcFrom = aNbSlices > 1 ? aDstFrom : 0;
+        const int aSrcTo   = aNbSlices > 1 ? aDstTo   : theSrcSizeY;
+
+        aSlice->SrcY     = aSrcFrom;
+        aSlice->SrcSizeY = aSrcTo - aSrcFrom;
+        aSlice->DstY     = aDstFrom;
+        aSlice->DstSizeY = aDstTo - aDstFrom;
+        aSlice->Context  = sws_getCachedContext(aSlice->Context,
+                                                theSrcSizeX, aSlice->SrcSizeY, theSrcFormat, // source
+                                                theDstSizeX, aSlice->DstSizeY, theDstFormat, // destination
+                                                SWS_BICUBIC, NULL, NULL, NULL);
+        if(aSlice->Context == NULL) {
+            release();
+            return false;
+        }
+    }
+
+    mySrcSizeX       = theSrcSizeX;
+    mySrcSizeY       = theSrcSizeY;
+    mySrcFormat      = theSrcFormat;
+    myDstSizeX       = theDstSizeX;
+    myDstSizeY       = theDstSizeY;
+    myDstFormat      = theDstFormat;
+    mySrcNbPlanes    = aSrcLayout.NbPlanes;
+    mySrcChromaShift = aSrcLayout.ChromaShift;
+    myDstNbPlanes    = aDstLayout.NbPlanes;
+    myDstChromaShift = aDstLayout.ChromaShift;
+    myNbSlicesReq    = theNbSlices;
+    return true;
+}
+
+void StAVScaler::scaleSlice(const Slice& theSlice) {
+    uint8_t* aSrcData[4];
+    uint8_t* aDstData[4];
+    offsetPlanes(mySrcData, mySrcLinesize, mySrcNbPlanes, mySrcChromaShift, theSlice.SrcY, aSrcData);
+    offsetPlanes(myDstData, myDstLinesize, myDstNbPlanes, myDstChromaShift, theSlice.DstY, aDstData);
+    sws_scale(theSlice.Context,
+              aSrcData, mySrcLinesize,
+              0, theSlice.SrcSizeY,
+              aDstData, myDstLinesize);
+}
+
+SV_THREAD_FUNCTION StAVScaler::threadFunction(void* theSlice) {
+    Slice*      aSlice  = (Slice* )theSlice;
+    StAVScaler* aScaler = aSlice->Scaler;
+    for(;;) {
+        aSlice->EventStart.wait();
+        aSlice->EventStart.reset();
+        if(aScaler->myToQuit) {
+            return SV_THREAD_RETURN 0;
+        }
+
+        aScaler->scaleSlice(*aSlice);
+        aSlice->EventDone.set();
+    }
+}
+
+bool StAVScaler::scale(uint8_t* const theSrcData[],
+                       const int      theSrcLinesize[],
+                       uint8_t* const theDstData[],
+                       const int      theDstLinesize[]) {
+    if(!isValid()) {
+        return false;
+    }
+
+    mySrcData     = theSrcData;
+    mySrcLinesize = theSrcLinesize;
+    myDstData     = theDstData;
+    myDstLinesize = theDstLinesize;
+    for(size_t aSliceIter = 1; aSliceIter < mySlices.size(); ++aSliceIter) {
+        mySlices[aSliceIter]->EventDone.reset();
+        mySlices[aSliceIter]->EventStart.set();
+    }
+    scaleSlice(*mySlices[0]);
+    for(size_t aSliceIter = 1; aSliceIter < mySlices.size(); ++aSliceIter) {
+        mySlices[aSliceIter]->EventDone.wait();
+    }
+    mySrcData     = NULL;
+    mySrcLinesize = NULL;
+    myDstData     = NULL;
+    myDstLinesize = NULL;
+    return true;
+}
@@ -1,5 +1,5 @@
 /**
- * Copyright © 2009-2014 Kirill Gavrilov <kirill@sview.ru>
+ * Copyright © 2009-2017 Kirill Gavrilov <kirill@sview.ru>
  *
  * Distributed under the Boost Software License, Version 1.0.
  * See accompanying file license-boost.txt or copy at
@@ -7,6 +7,7 @@
  */
 
 #include <StFile/StFolder.h>
+#include <StFile/StFolderScanQueue.h>
 #include <StStrings/StLogger.h>
 
 #ifdef _WIN32
@@ -20,6 +21,106 @@
 namespace {
     static const StString IGNORE_DIR_CURR_NAME('.');
     static const StString IGNORE_DIR_UP_NAME("..");
+
+    static const int THE_SCAN_THREADS_MAX = 8; //!< maximum number of threads scanning subfolders
+}
+
+StFolderScanQueue::StFolderScanQueue(const StArrayList<StString>& theExtensions,
+                                     const int                    theNbThreads)
+: myExtensions(theExtensions),
+  myEventTask(false),
+  myEventIdle(true),
+  myNbActive(0),
+  myToQuit(false) {
+    // calling thread participates in scanning within wait()
+    const int aNbWorkers = stMin(theNbThreads, THE_SCAN_THREADS_MAX) - 1;
+    for(int aThreadIter = 0; aThreadIter < aNbWorkers; ++aThreadIter) {
+        myThreads.push_back(new StThread(workerThreadFunction, (void* )this, "StFolderScan"));
+    }
+}
+
+StFolderScanQueue::~StFolderScanQueue() {
+    myMutex.lock();
+    myToQuit = true;
+    myEventTask.set();
+    myMutex.unlock();
+    for(size_t aThreadIter = 0; aThreadIter < myThreads.size(); ++aThreadIter) {
+        myThreads[aThreadIter]->wait();
+    }
+}
+
+void StFolderScanQueue::push(StFolder* theFolder,
+                             const int theDeep) {
+    myMutex.lock();
+    myTasks.push_back(Task(theFolder, theDeep));
+    myEventIdle.reset();
+    myEventTask.set();
+    myMutex.unlock();
+}
+
+bool StFolderScanQueue::performTask() {
+    myMutex.lock();
+    if(myTasks.empty()) {
+        myMutex.unlock();
+        return false;
+    }
+
+    const Task aTask = myTasks.front();
+    myTasks.pop_front();
+    ++myNbActive;
+    myMutex.unlock();
+
+    aTask.Folder->readFolder(myExtensions, aTask.Deep, false, this);
+
+    myMutex.lock();
+    if(--myNbActive == 0
+    && myTasks.empty()) {
+        myEventIdle.set();
+    }
+    myMutex.unlock();
+    return true;
+}
+
+void StFolderScanQueue::wait() {
+    while(performTask()) {}
+
+    // the last folders might be still scanned by other threads,
+    // which might also queue new subfolders (in this case idle event is reset)
+    for(;;) {
+        myEventIdle.wait();
+        if(!performTask()) {
+            myMutex.lock();
+            const bool isIdle = myNbActive == 0 && myTasks.empty();
+            myMutex.unlock();
+            if(isIdle) {
+                return;
+            }
+        }
+    }
+}
+
+void StFolderScanQueue::workerLoop() {
+    for(;;) {
+        myMutex.lock();
+        if(myToQuit) {
+            myMutex.unlock();
+            return;
+        }
+        if(myTasks.empty()) {
+            myEventTask.reset();
+            myMutex.unlock();
+            myEventTask.wait();
+            continue;
+        }
+        myMutex.unlock();
+
+        performTask();
+    }
+}
+
+SV_THREAD_FUNCTION StFolderScanQueue::workerThreadFunction(void* theQueue) {
+    ((StFolderScanQueue* )theQueue)->workerLoop();
+    return SV_THREAD_RETURN 0;
 }
 
 StFolder::StFolder()
@@ -78,25 +179,23 @@ bool StFolder::createFolder(const StCString& thePath) {
 }
 
 void StFolder::addItem(const StArrayList<StString>& theExtensions,
-                       int theDeep,
-                       const StString& theSearchFolderPath,
-                       const StString& theCurrentItemName,
-                       const bool      theToAddEmptyFolders) {
+                       const int                    theDeep,
+                       const StString&              theCurrentItemName,
+                       const bool                   theIsFolder,
+                       const bool                   theToAddEmptyFolders,
+                       StFolderScanQueue*           theQueue) {
     if(theCurrentItemName == IGNORE_DIR_CURR_NAME || theCurrentItemName == IGNORE_DIR_UP_NAME) {
         return;
     }
 
-    StString aCurrItemFullName = theSearchFolderPath + SYS_FS_SPLITTER + theCurrentItemName;
-    if(isFolder(aCurrItemFullName)) {
+    if(theIsFolder) {
         if(theDeep > 1) {
             StFolder* aSubFolder = new StFolder(theCurrentItemName, this);
-            aSubFolder->init(theExtensions, theDeep - 1);
-            if(aSubFolder->size() > 0
-            || theToAddEmptyFolders) {
-                add(aSubFolder);
+            add(aSubFolder);
+            if(theQueue != NULL) {
+                theQueue->push(aSubFolder, theDeep - 1);
             } else {
-                // ignore empty folders
-                delete aSubFolder;
+                aSubFolder->readFolder(theExtensions, theDeep - 1, false, NULL);
             }
         } else if(theToAddEmptyFolders) {
             StFolder* aSubFolder = new StFolder(theCurrentItemName, this);
@@ -113,22 +212,22 @@ void StFolder::addItem(const StArrayList<StString>& theExtensions,
     }
 }
 
-void StFolder::init(const StArrayList<StString>& theExtensions,
-                    const int                    theDeep,
-                    const bool                   theToAddEmptyFolders) {
-    // clean up old list...
-    clear();
+void StFolder::readFolder(const StArrayList<StString>& theExtensions,
+                          const int                    theDeep,
+                          const bool                   theToAddEmptyFolders,
+                          StFolderScanQueue*           theQueue) {
     StString aSearchFolderPath = getPath();
 #ifdef _WIN32
     WIN32_FIND_DATAW aFindFile;
-    StString aStrSearchMask = getPath() + StString(SYS_FS_SPLITTER) + '*';
+    StString aStrSearchMask = aSearchFolderPath + StString(SYS_FS_SPLITTER) + '*';
 
     HANDLE hFind = FindFirstFileW(aStrSearchMask.toUtfWide().toCString(), &aFindFile);
     for(BOOL hasFile = (hFind != INVALID_HANDLE_VALUE); hasFile == TRUE;
         hasFile = FindNextFileW(hFind, &aFindFile)) {
         //
         StString aCurrItemName(aFindFile.cFileName);
-        addItem(theExtensions, theDeep, aSearchFolderPath, aCurrItemName, theToAddEmptyFolders);
+        const bool isSubFolder = (aFindFile.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+        addItem(theExtensions, theDeep, aCurrItemName, isSubFolder, theToAddEmptyFolders, theQueue);
     }
     FindClose(hFind);
 #else
@@ -145,10 +244,68 @@ void StFolder::init(const StArrayList<StString>& theExtensions,
     #else
         StString aCurrItemName(aDirItem->d_name);
     #endif
-        addItem(theExtensions, theDeep, aSearchFolderPath, aCurrItemName, theToAddEmptyFolders);
+    #ifdef DT_DIR
+        // use entry type returned by readdir() to avoid extra system call,
+        // symbolic links and file systems not filling this field are checked explicitly
+        bool isSubFolder = aDirItem->d_type == DT_DIR;
+        if(aDirItem->d_type != DT_DIR
+        && aDirItem->d_type != DT_REG) {
+            isSubFolder = isFolder(aSearchFolderPath + SYS_FS_SPLITTER + aCurrItemName);
+        }
+    #else
+        const bool isSubFolder = isFolder(aSearchFolderPath + SYS_FS_SPLITTER + aCurrItemName);
+    #endif
+        addItem(theExtensions, theDeep, aCurrItemName, isSubFolder, theToAddEmptyFolders, theQueue);
     }
     closedir(aSearchedFolder);
 #endif
+}
+
+void StFolder::finalize(const bool theToAddEmptyFolders) {
+    for(size_t anIter = 0; anIter < size();) {
+        StFileNode* aNode = changeValue(anIter);
+        if(aNode->getType() != NODE_TYPE_FOLDER) {
+            ++anIter;
+            continue;
+        }
+
+        StFolder* aSubFolder = (StFolder* )aNode;
+        aSubFolder->finalize(false);
+        if(aSubFolder->size() > 0
+        || theToAddEmptyFolders) {
+            ++anIter;
+        } else {
+            // ignore empty folders
+            remove(anIter);
+            delete aSubFolder;
+        }
+    }
+
     // perform sorting...
     sort();
 }
+
+void StFolder::init(const StArrayList<StString>& theExtensions,
+                    const int                    theDeep,
+                    const bool                   theToAddEmptyFolders) {
+    // clean up old list...
+    clear();
+    if(theDeep <= 1) {
+        readFolder(theExtensions, theDeep, theToAddEmptyFolders, NULL);
+        sort();
+        return;
+    }
+
+    // read subfolders in parallel - deep folder trees are mostly bound to file system latency
+    StFolderScanQueue aQueue(theExtensions, stMax(StThread::countLogicalProcessors(), 2));
+    init(aQueue, theDeep, theToAddEmptyFolders);
+}
+
+void StFolder::init(StFolderScanQueue& theQueue,
+                    const int          theDeep,
+                    const bool         theToAddEmptyFolders) {
+    clear();
+    readFolder(theQueue.getExtensions(), theDeep, theToAddEmptyFolders, &theQueue);
+    theQueue.wait();
+    finalize(theToAddEmptyFolders);
+}
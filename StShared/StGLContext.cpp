@@ -52,6 +52,7 @@ StGLContext::StGLContext(const StHandle<StResourceManager>& theResMgr)
   arbNPTW(false),
   arbTexRG(false),
   arbTexClear(false),
+  arbBufStorage(false),
 #if defined(GL_ES_VERSION_2_0)
   hasUnpack(false),
   hasHighp(false),
@@ -105,6 +106,7 @@ StGLContext::StGLContext(const bool theToInitialize)
   arbNPTW(false),
   arbTexRG(false),
   arbTexClear(false),
+  arbBufStorage(false),
 #if defined(GL_ES_VERSION_2_0)
   hasUnpack(false),
   hasHighp(false),
@@ -1518,6 +1520,12 @@ bool StGLContext::stglInit() {
          && STGL_READ_FUNC(glClearTexImage)
          && STGL_READ_FUNC(glClearTexSubImage);
 
+    // load GL_ARB_buffer_storage (added to OpenGL 4.4 core)
+    arbBufStorage = (isGlGreaterEqual(4, 4) || stglCheckExtension("GL_ARB_buffer_storage"))
+         && hasSync
+         && hasMapBufferRange
+         && STGL_READ_FUNC(glBufferStorage);
+
     has44 = isGlGreaterEqual(4, 4)
          && arbTexClear
          && STGL_READ_FUNC(glBufferStorage)
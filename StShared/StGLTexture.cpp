@@ -593,12 +593,23 @@ bool StGLTexture::init(StGLContext&        theCtx,
     return fill(theCtx, theData);
 }
 
+/**
+ * Return pointer to pass into glTexSubImage2D() - either client memory or offset within unpack buffer.
+ */
+inline const GLvoid* unpackPointer(const GLubyte* theData,
+                                   const GLubyte* theUnpackBase) {
+    return theUnpackBase != NULL
+         ? (const GLvoid* )size_t(theData - theUnpackBase)
+         : (const GLvoid* )theData;
+}
+
 bool StGLTexture::fillPatch(StGLContext&        theCtx,
                             const StImagePlane& theData,
                             GLenum              theTarget,
                             const GLsizei       theRowFrom,
                             const GLsizei       theRowTo,
-                            const GLsizei       theBatchRows) {
+                            const GLsizei       theBatchRows,
+                            const GLubyte*      theUnpackBase) {
     if(theTarget == 0) {
         theTarget = myTarget;
     }
@@ -664,7 +675,7 @@ bool StGLTexture::fillPatch(StGLContext&        theCtx,
                                               aPatchWidth, aNbRows,
                                               aPixelFormat,     // format of the pixel data
                                               aDataType,        // data type of the pixel data
-                                              theData.getData(aRow, 0));
+                                              unpackPointer(theData.getData(aRow, 0), theUnpackBase));
         }
 
         if(theCtx.hasUnpack) {
@@ -683,7 +694,7 @@ bool StGLTexture::fillPatch(StGLContext&        theCtx,
                                               aPatchWidth, 1,   // the (width, height) of the texture sub-image
                                               aPixelFormat,     // format of the pixel data
                                               aDataType,        // data type of the pixel data
-                                              theData.getData(aRow, 0));
+                                              unpackPointer(theData.getData(aRow, 0), theUnpackBase));
         }
     }
 
@@ -1,5 +1,5 @@
 /**
- * Copyright © 2009-2015 Kirill Gavrilov <kirill@sview.ru>
+ * Copyright © 2009-2017 Kirill Gavrilov <kirill@sview.ru>
  *
  * Distributed under the Boost Software License, Version 1.0.
  * See accompanying file license-boost.txt or copy at
@@ -9,24 +9,33 @@
 #include <StGLStereo/StGLTextureData.h>
 #include <StStrings/StLogger.h>
 
-#include <StGLCore/StGLCore11.h>
+#include <StGLCore/StGLCore20.h>
+#include <StGL/StGLContext.h>
 
 StGLTextureData::StGLTextureData()
-: myPrev(NULL),
-  myNext(NULL),
-  myDataPtr(NULL),
+: myDataPtr(NULL),
   myDataSizeBytes(0),
+  myCopiedBytes(0),
   myStParams(),
   myPts(0.0),
   mySrcFormat(StFormat_AUTO),
   myCubemapFormat(StCubemap_OFF),
   myFillFromRow(0),
-  myFillRows(0) {
+  myFillRows(0),
+  myPbo(0),
+  myPboFence(NULL),
+  myIsPboBusy(0),
+  myPboPtr(NULL),
+  myPboSizeBytes(0),
+  myPboSizeWanted(0) {
     //
 }
 
 StGLTextureData::~StGLTextureData() {
     reset();
+    if(myPbo != 0) {
+        ST_DEBUG_LOG("StGLTextureData, PBO has not been released!");
+    }
 }
 
 void StGLTextureData::reset() {
@@ -34,19 +43,34 @@ void StGLTextureData::reset() {
     myDataL.nullify();
     myDataR.nullify();
     if(myDataPtr != NULL) {
-        stMemFreeAligned(myDataPtr);
+        if(!isPboData()) {
+            stMemFreeAligned(myDataPtr);
+        }
         myDataPtr = NULL;
     }
     myDataSizeBytes = 0;
     myFillRows = myFillFromRow = 0;
 }
 
-bool StGLTextureData::reAllocate(const size_t theSizeBytes) {
+bool StGLTextureData::reAllocate(const size_t theSizeBytes,
+                                 const bool   theToUsePbo) {
+    if(theToUsePbo) {
+        // write directly into the mapped PBO memory
+        const bool isSwitched = !isPboData();
+        if(isSwitched) {
+            reset();
+            myDataPtr = myPboPtr;
+        }
+        myDataSizeBytes = theSizeBytes;
+        return isSwitched;
+    }
+
     // reallocate only if summary data is not same
     // this allows to smoothly switch to different stereo source formats
     // over/under -> sideBySide -> mono
     // because the summary buffer needed for both views will be same
-    if(myDataSizeBytes != theSizeBytes) {
+    if(myDataSizeBytes != theSizeBytes
+    || isPboData()) {
         reset();
         myDataSizeBytes = theSizeBytes;
         myDataPtr       = stMemAllocAligned<GLubyte*>(myDataSizeBytes);
@@ -185,10 +209,13 @@ static GLubyte* readFromRowInterlace(const StImagePlane& theSrc,
     return &theDataPtr[2 * theDataL.getSizeBytes()];
 }
 
-static GLubyte* readFromTiled4X(const StImagePlane& theDataSrc,
-                                GLubyte*            theDataOutPtr,
-                                StImagePlane&       theDataOutL,
-                                StImagePlane&       theDataOutR) {
+/**
+ * Assemble Right view of tiled 720p frame
+ * from half-width tile at top-right corner and two quarter tiles at bottom.
+ */
+static GLubyte* readFromTiled4XRight(const StImagePlane& theDataSrc,
+                                     GLubyte*            theDataOutPtr,
+                                     StImagePlane&       theDataOutR) {
     if(theDataSrc.isNull()) {
         return theDataOutPtr;
     }
@@ -198,33 +225,19 @@ static GLubyte* readFromTiled4X(const StImagePlane& theDataSrc,
     const size_t aDataSizeXHalf = aDataSizeX / 2;
 
     const size_t anOutRowBytes = getEvenNumber(aDataSizeX * theDataSrc.getSizePixelBytes());
-    theDataOutL.initWrapper(theDataSrc.getFormat(), theDataOutPtr,
+    theDataOutR.initWrapper(theDataSrc.getFormat(), theDataOutPtr,
                             aDataSizeX, aDataSizeY,
                             anOutRowBytes);
-    theDataOutR.initWrapper(theDataSrc.getFormat(), &theDataOutPtr[theDataOutL.getSizeBytes()],
-                            theDataOutL.getSizeX(), theDataOutL.getSizeY(),
-                            anOutRowBytes);
-
-    size_t aCopyRows     = stMin(theDataOutL.getSizeY(), aDataSizeY);
-    size_t aCopyRowBytes = stMin(theDataOutL.getSizeX(), aDataSizeX) * theDataOutL.getSizePixelBytes();
 
     // check if data is upside-down
     size_t aRowSrcTop = theDataSrc.isTopDown() ? 0 : (theDataSrc.getSizeY() - 1);
-
-    // copy Left view (1 big tile at top-left corner)
     const size_t aRowInc = theDataSrc.isTopDown() ? 1 : size_t(-1);
-    size_t aRowTo  = 0;
-    size_t aRowSrc = aRowSrcTop;
-    for(; aRowTo < aCopyRows; ++aRowTo, aRowSrc += aRowInc) {
-        stMemCpy(theDataOutL.changeData(aRowTo, 0),
-                 theDataSrc.getData(aRowSrc, 0),
-                 aCopyRowBytes);
-    }
 
     // copy Right view (first half-width tile at top-right
-    aCopyRowBytes = (aDataSizeX / 2) * theDataOutL.getSizePixelBytes();
-    aRowTo  = 0;
-    aRowSrc = aRowSrcTop;
+    size_t aCopyRows     = aDataSizeY;
+    size_t aCopyRowBytes = aDataSizeXHalf * theDataOutR.getSizePixelBytes();
+    size_t aRowTo  = 0;
+    size_t aRowSrc = aRowSrcTop;
     for(; aRowTo < aCopyRows; ++aRowTo, aRowSrc += aRowInc) {
         stMemCpy(theDataOutR.changeData(aRowTo, 0),
                  theDataSrc.getData(aRowSrc, aDataSizeX),
@@ -252,7 +265,42 @@ static GLubyte* readFromTiled4X(const StImagePlane& theDataSrc,
                  aCopyRowBytes);
     }
 
-    return &theDataOutPtr[2 * theDataOutL.getSizeBytes()];
+    return &theDataOutPtr[theDataOutR.getSizeBytes()];
+}
+
+static GLubyte* readFromTiled4X(const StImagePlane& theDataSrc,
+                                GLubyte*            theDataOutPtr,
+                                StImagePlane&       theDataOutL,
+                                StImagePlane&       theDataOutR) {
+    if(theDataSrc.isNull()) {
+        return theDataOutPtr;
+    }
+
+    const size_t aDataSizeX = (theDataSrc.getSizeX() / 3) * 2;
+    const size_t aDataSizeY = (theDataSrc.getSizeY() / 3) * 2;
+
+    const size_t anOutRowBytes = getEvenNumber(aDataSizeX * theDataSrc.getSizePixelBytes());
+    theDataOutL.initWrapper(theDataSrc.getFormat(), theDataOutPtr,
+                            aDataSizeX, aDataSizeY,
+                            anOutRowBytes);
+
+    const size_t aCopyRows     = stMin(theDataOutL.getSizeY(), aDataSizeY);
+    const size_t aCopyRowBytes = stMin(theDataOutL.getSizeX(), aDataSizeX) * theDataOutL.getSizePixelBytes();
+
+    // check if data is upside-down
+    const size_t aRowSrcTop = theDataSrc.isTopDown() ? 0 : (theDataSrc.getSizeY() - 1);
+
+    // copy Left view (1 big tile at top-left corner)
+    const size_t aRowInc = theDataSrc.isTopDown() ? 1 : size_t(-1);
+    size_t aRowTo  = 0;
+    size_t aRowSrc = aRowSrcTop;
+    for(; aRowTo < aCopyRows; ++aRowTo, aRowSrc += aRowInc) {
+        stMemCpy(theDataOutL.changeData(aRowTo, 0),
+                 theDataSrc.getData(aRowSrc, 0),
+                 aCopyRowBytes);
+    }
+
+    return readFromTiled4XRight(theDataSrc, &theDataOutPtr[theDataOutL.getSizeBytes()], theDataOutR);
 }
 
 static GLubyte* readFromMono(const StImagePlane& theSrc,
@@ -362,7 +410,16 @@ void StGLTextureData::updateData(const StGLDeviceCaps&           theDeviceCaps,
 
     // reset fill texture state
     myFillRows = myFillFromRow = 0;
+    myCopiedBytes = 0;
 
+    // keep reference whenever possible - it will be uploaded by GL thread without extra copies,
+    // while data which should be copied anyway is written directly into mapped PBO (when available)
+    const size_t aNewSizeBytes = computeBufferSize(theDataL) + computeBufferSize(theDataR);
+    myPboSizeWanted = 0;
+    const bool toUsePbo = myPboPtr   != NULL
+                       && StAtomicOp::Load(myIsPboBusy) == 0
+                       && aNewSizeBytes != 0
+                       && aNewSizeBytes <= myPboSizeBytes;
     if(canCopyReference(theDataL)
     && canCopyReference(theDataR)) {
         bool toCopy = false;
@@ -463,11 +520,51 @@ void StGLTextureData::updateData(const StGLDeviceCaps&           theDeviceCaps,
                 }
                 break;
             }
-            case StFormat_Columns:
             case StFormat_Tiled4x: {
-                toCopy = true;
+                if(!theDeviceCaps.hasUnpack) {
+                    // slow copying to GPU memory
+                    toCopy = true;
+                    break;
+                }
+
+                // keep reference to Left view (top-left tile),
+                // only Right view should be assembled from smaller tiles
+                size_t aSizeBytesR = 0;
+                for(size_t aPlaneId = 0; aPlaneId < 4; ++aPlaneId) {
+                    const StImagePlane& aFromPlane = theDataL.getPlane(aPlaneId);
+                    if(!aFromPlane.isNull()) {
+                        aSizeBytesR += getEvenNumber((aFromPlane.getSizeX() / 3) * 2 * aFromPlane.getSizePixelBytes())
+                                     * ((aFromPlane.getSizeY() / 3) * 2);
+                    }
+                }
+                if(aSizeBytesR == 0) {
+                    toCopy = true;
+                    break;
+                }
+
+                reAllocate(aSizeBytesR, false);
+                myDataPair.nullify();
+                myDataL.nullify();
+                myDataR.nullify();
+                copyProps(theDataL, theDataR);
+                myDataPair.initReference(theDataL);
+                GLubyte* aDataDispl = myDataPtr;
+                for(size_t aPlaneId = 0; aPlaneId < 4; ++aPlaneId) {
+                    const StImagePlane& aFromPlane = myDataPair.getPlane(aPlaneId);
+                    if(aFromPlane.isNull()) {
+                        continue;
+                    }
+                    myDataL.changePlane(aPlaneId).initWrapper(aFromPlane.getFormat(),
+                                                              aFromPlane.accessData(0, 0),
+                                                              (aFromPlane.getSizeX() / 3) * 2,
+                                                              (aFromPlane.getSizeY() / 3) * 2,
+                                                              aFromPlane.getSizeRowBytes());
+                    aDataDispl = readFromTiled4XRight(aFromPlane, aDataDispl, myDataR.changePlane(aPlaneId));
+                }
+                myCopiedBytes = size_t(aDataDispl - myDataPtr);
                 break;
             }
+            case StFormat_Columns: // not supported
             case StFormat_Mono:
             case StFormat_SeparateFrames:
             case StFormat_FrameSequence:
@@ -505,7 +602,6 @@ void StGLTextureData::updateData(const StGLDeviceCaps&           theDeviceCaps,
     myDataR.setBufferCounter(NULL);
 
     // reallocate buffer if needed
-    const size_t aNewSizeBytes = computeBufferSize(theDataL) + computeBufferSize(theDataR);
     if(aNewSizeBytes == 0) {
         // invalid data
         myDataPair.nullify();
@@ -515,13 +611,15 @@ void StGLTextureData::updateData(const StGLDeviceCaps&           theDeviceCaps,
         return;
     }
 
-    reAllocate(aNewSizeBytes);
+    // PBO is requested only for copied data
+    myPboSizeWanted = aNewSizeBytes;
+    reAllocate(aNewSizeBytes, toUsePbo);
     copyProps(theDataL, theDataR);
 
+    GLubyte* aDataDispl = myDataPtr;
     switch(mySrcFormat) {
         case StFormat_SideBySide_LR:
         case StFormat_SideBySide_RL: {
-            GLubyte* aDataDispl = myDataPtr;
             for(size_t aPlaneId = 0; aPlaneId < 4; ++aPlaneId) {
                 aDataDispl = readFromParallel(theDataL.getPlane(aPlaneId), aDataDispl,
                                               (mySrcFormat == StFormat_SideBySide_LR) ? myDataL.changePlane(aPlaneId) : myDataR.changePlane(aPlaneId),
@@ -531,7 +629,6 @@ void StGLTextureData::updateData(const StGLDeviceCaps&           theDeviceCaps,
         }
         case StFormat_TopBottom_LR:
         case StFormat_TopBottom_RL: {
-            GLubyte* aDataDispl = myDataPtr;
             for(size_t aPlaneId = 0; aPlaneId < 4; ++aPlaneId) {
                 aDataDispl = readFromOverUnderLR(theDataL.getPlane(aPlaneId), aDataDispl,
                                                  (mySrcFormat == StFormat_TopBottom_LR) ? myDataL.changePlane(aPlaneId) : myDataR.changePlane(aPlaneId),
@@ -542,7 +639,6 @@ void StGLTextureData::updateData(const StGLDeviceCaps&           theDeviceCaps,
         case StFormat_Rows: {
             myDataL.setPixelRatio(theDataL.getPixelRatio() * 0.5f);
             myDataR.setPixelRatio(theDataL.getPixelRatio() * 0.5f);
-            GLubyte* aDataDispl = myDataPtr;
             // TODO (Kirill Gavrilov#9) wrong for yuv420p?
             for(size_t aPlaneId = 0; aPlaneId < 4; ++aPlaneId) {
                 aDataDispl = readFromRowInterlace(theDataL.getPlane(aPlaneId), aDataDispl,
@@ -555,7 +651,6 @@ void StGLTextureData::updateData(const StGLDeviceCaps&           theDeviceCaps,
         case StFormat_SeparateFrames: {
             myDataR.setColorModel(theDataR.getColorModel());
             myDataR.setPixelRatio(theDataR.getPixelRatio());
-            GLubyte* aDataDispl = myDataPtr;
             for(size_t aPlaneId = 0; aPlaneId < 4; ++aPlaneId) {
                 aDataDispl = readFromMono(theDataL.getPlane(aPlaneId), aDataDispl, myDataL.changePlane(aPlaneId));
             }
@@ -565,7 +660,6 @@ void StGLTextureData::updateData(const StGLDeviceCaps&           theDeviceCaps,
             break;
         }
         case StFormat_Tiled4x: {
-            GLubyte* aDataDispl = myDataPtr;
             for(size_t aPlaneId = 0; aPlaneId < 4; ++aPlaneId) {
                 aDataDispl = readFromTiled4X(theDataL.getPlane(aPlaneId), aDataDispl,
                                              myDataL.changePlane(aPlaneId), myDataR.changePlane(aPlaneId));
@@ -578,13 +672,13 @@ void StGLTextureData::updateData(const StGLDeviceCaps&           theDeviceCaps,
         case StFormat_Columns: // not supported
         case StFormat_Mono:
         default: {
-            GLubyte* aDataDispl = myDataPtr;
             for(size_t aPlaneId = 0; aPlaneId < 4; ++aPlaneId) {
                 aDataDispl = readFromMono(theDataL.getPlane(aPlaneId), aDataDispl, myDataL.changePlane(aPlaneId));
             }
             break;
         }
     }
+    myCopiedBytes = size_t(aDataDispl - myDataPtr);
     validateCubemap(theCubemap);
 }
 
@@ -618,13 +712,16 @@ void StGLTextureData::validateCubemap(const StCubemap theCubemap) {
 
 void StGLTextureData::fillTexture(StGLContext&        theCtx,
                                   StGLFrameTexture&   theFrameTexture,
-                                  const StImagePlane& theData) {
+                                  const StImagePlane& theData,
+                                  const GLubyte*      theUnpackBase) {
     if(!theFrameTexture.isValid() || theData.isNull()) {
         return;
     }
 
+    const GLsizei aBatchRows = theUnpackBase != NULL ? 0 : 128;
     if(myCubemapFormat != StCubemap_Packed) {
-        theFrameTexture.fillPatch(theCtx, theData, GL_TEXTURE_2D, myFillFromRow, myFillFromRow + myFillRows);
+        theFrameTexture.fillPatch(theCtx, theData, GL_TEXTURE_2D, myFillFromRow, myFillFromRow + myFillRows,
+                                  aBatchRows, theUnpackBase);
         return;
     }
 
@@ -654,7 +751,8 @@ void StGLTextureData::fillTexture(StGLContext&        theCtx,
             ST_DEBUG_LOG("StGLTextureData::fillTexture(). wrapping failure");
             continue;
         }
-        theFrameTexture.fillPatch(theCtx, aPlane, aTargets[aTargetIter], myFillFromRow, myFillFromRow + myFillRows);
+        theFrameTexture.fillPatch(theCtx, aPlane, aTargets[aTargetIter], myFillFromRow, myFillFromRow + myFillRows,
+                                  aBatchRows, theUnpackBase);
     }
 }
 
@@ -730,8 +828,129 @@ static void prepareTextures(StGLContext&       theCtx,
     }
 }
 
+bool StGLTextureData::stglInitPbo(StGLContext& theCtx,
+                                  const size_t theSizeBytes) {
+    stglReleasePbo(theCtx);
+#if defined(GL_ES_VERSION_2_0)
+    (void )theSizeBytes;
+    return false;
+#else
+    if(!theCtx.arbBufStorage
+    || theSizeBytes == 0) {
+        return false;
+    }
+
+    // buffer is also read back through the mapping (by getCopy() for snapshots and by stglReleasePbo()),
+    // which is undefined without read access (and slow within write-combined memory driver might choose otherwise)
+    const GLbitfield aFlags = GL_MAP_READ_BIT | GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    theCtx.core20fwd->glGenBuffers(1, &myPbo);
+    theCtx.core20fwd->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, myPbo);
+    theCtx.extAll->glBufferStorage(GL_PIXEL_UNPACK_BUFFER, GLsizeiptr(theSizeBytes), NULL, aFlags);
+    myPboPtr = (GLubyte* )theCtx.extAll->glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, GLsizeiptr(theSizeBytes), aFlags);
+    theCtx.core20fwd->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if(myPboPtr == NULL) {
+        theCtx.core20fwd->glDeleteBuffers(1, &myPbo);
+        myPbo = 0;
+        ST_DEBUG_LOG("StGLTextureData, unable to map PBO of " + theSizeBytes + " bytes");
+        return false;
+    }
+
+    myPboSizeBytes = theSizeBytes;
+    ST_DEBUG_LOG("StGLTextureData, PBO (re)allocated to " + theSizeBytes + " bytes");
+    return true;
+#endif
+}
+
+void StGLTextureData::stglReleasePbo(StGLContext& theCtx) {
+    if(isPboData()) {
+        // move the data to the heap
+        GLubyte* aDataPtr = stMemAllocAligned<GLubyte*>(myDataSizeBytes);
+        stMemCpy(aDataPtr, myPboPtr, myDataSizeBytes);
+        StImage* anImages[2] = { &myDataL, &myDataR };
+        for(size_t anImgIter = 0; anImgIter < 2; ++anImgIter) {
+            for(size_t aPlaneId = 0; aPlaneId < 4; ++aPlaneId) {
+                StImagePlane& aPlane = anImages[anImgIter]->changePlane(aPlaneId);
+                if(aPlane.isNull()
+                || aPlane.getData() <  myPboPtr
+                || aPlane.getData() >= myPboPtr + myDataSizeBytes) {
+                    continue;
+                }
+
+                const size_t anOffset = size_t(aPlane.getData() - myPboPtr);
+                aPlane.initWrapper(aPlane.getFormat(), aDataPtr + anOffset,
+                                   aPlane.getSizeX(), aPlane.getSizeY(),
+                                   aPlane.getSizeRowBytes());
+            }
+        }
+        myDataPtr = aDataPtr;
+    }
+
+#if !defined(GL_ES_VERSION_2_0)
+    if(myPboFence != NULL) {
+        theCtx.extAll->glDeleteSync((GLsync )myPboFence);
+        myPboFence = NULL;
+    }
+    StAtomicOp::Store(myIsPboBusy, 0);
+    if(myPbo != 0) {
+        theCtx.core20fwd->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, myPbo);
+        theCtx.core20fwd->glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        theCtx.core20fwd->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        theCtx.core20fwd->glDeleteBuffers(1, &myPbo);
+        myPbo = 0;
+    }
+#else
+    (void )theCtx;
+#endif
+    myPboPtr       = NULL;
+    myPboSizeBytes = 0;
+}
+
+bool StGLTextureData::stglCheckPboFence(StGLContext& theCtx) {
+    if(myPboFence == NULL) {
+        return true;
+    }
+
+#if !defined(GL_ES_VERSION_2_0)
+    const GLenum aResult = theCtx.extAll->glClientWaitSync((GLsync )myPboFence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if(aResult == GL_TIMEOUT_EXPIRED) {
+        return false;
+    } else if(aResult == GL_WAIT_FAILED) {
+        theCtx.core20fwd->glFinish();
+    }
+
+    theCtx.extAll->glDeleteSync((GLsync )myPboFence);
+#else
+    (void )theCtx;
+#endif
+    myPboFence = NULL;
+    StAtomicOp::Store(myIsPboBusy, 0);
+    return true;
+}
+
+void StGLTextureData::finishFill(StGLQuadTexture& theQTexture) {
+    if(!myDataL.isNull() && theQTexture.getBack(StGLQuadTexture::LEFT_TEXTURE).isValid()) {
+        setupAttributes(theQTexture.getBack(StGLQuadTexture::LEFT_TEXTURE), myDataL);
+    }
+    if(!myDataR.isNull() && theQTexture.getBack(StGLQuadTexture::RIGHT_TEXTURE).isValid()) {
+        setupAttributes(theQTexture.getBack(StGLQuadTexture::RIGHT_TEXTURE), myDataR);
+    }
+
+    if(!myStParams.isNull()) {
+        myStParams->StereoFormat = mySrcFormat;
+    }
+}
+
 bool StGLTextureData::fillTexture(StGLContext&     theCtx,
                                   StGLQuadTexture& theQTexture) {
+    const GLubyte* anUnpackBase = isPboData() ? myPboPtr : NULL;
+    if(myPboFence != NULL) {
+        // fence left from previous upload
+        stglCheckPboFence(theCtx);
+    }
+
+    // referenced data is uploaded directly from source memory (PBO is not bound)
+    const StImage& aDataL = myDataL;
+    const StImage& aDataR = myDataR;
 
     // setup rows count to be filled per fillTexture()
     if(myFillRows == 0 || myFillFromRow == 0) {
@@ -752,7 +971,8 @@ bool StGLTextureData::fillTexture(StGLContext&     theCtx,
             maxRows    = stMax(maxRows, stMin(GLsizei(myDataR.getSizeY()), theQTexture.getBack(StGLQuadTexture::RIGHT_TEXTURE).getSizeY()));
             iterations = maxRows / UPDATED_ROWS_MAX + 1;
         }
-        myFillRows = maxRows / iterations;
+        // upload from PBO does not block GL thread - no need to split it
+        myFillRows = anUnpackBase != NULL ? maxRows : (maxRows / iterations);
         myFillFromRow = 0;
     }
 
@@ -761,39 +981,56 @@ bool StGLTextureData::fillTexture(StGLContext&     theCtx,
         return true;
     }
 
+#if !defined(GL_ES_VERSION_2_0)
+    if(anUnpackBase != NULL) {
+        theCtx.core20fwd->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, myPbo);
+    }
+#endif
     if(theQTexture.getBack(StGLQuadTexture::LEFT_TEXTURE).isValid()) {
         for(size_t aPlaneId = 0; aPlaneId < 4; ++aPlaneId) {
             fillTexture(theCtx,
                         theQTexture.getBack(StGLQuadTexture::LEFT_TEXTURE).getPlane(aPlaneId),
-                        myDataL.getPlane(aPlaneId));
+                        aDataL.getPlane(aPlaneId),
+                        anUnpackBase);
         }
     }
     if(theQTexture.getBack(StGLQuadTexture::RIGHT_TEXTURE).isValid()) {
         for(size_t aPlaneId = 0; aPlaneId < 4; ++aPlaneId) {
             fillTexture(theCtx,
                         theQTexture.getBack(StGLQuadTexture::RIGHT_TEXTURE).getPlane(aPlaneId),
-                        myDataR.getPlane(aPlaneId));
+                        aDataR.getPlane(aPlaneId),
+                        anUnpackBase);
         }
     }
+#if !defined(GL_ES_VERSION_2_0)
+    if(anUnpackBase != NULL) {
+        theCtx.core20fwd->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+#endif
     theQTexture.getBack(StGLQuadTexture::LEFT_TEXTURE).unbind(theCtx);
 
     myFillFromRow += myFillRows;
-    if(myFillFromRow >= GLsizei(myDataL.getSizeY())
-    && (myDataR.isNull() || myFillFromRow >= GLsizei(myDataR.getSizeY()))) {
-        if(!myDataL.isNull() && theQTexture.getBack(StGLQuadTexture::LEFT_TEXTURE).isValid()) {
-            setupAttributes(theQTexture.getBack(StGLQuadTexture::LEFT_TEXTURE), myDataL);
-        }
-        if(!myDataR.isNull() && theQTexture.getBack(StGLQuadTexture::RIGHT_TEXTURE).isValid()) {
-            setupAttributes(theQTexture.getBack(StGLQuadTexture::RIGHT_TEXTURE), myDataR);
-        }
+    if(myFillFromRow < GLsizei(myDataL.getSizeY())
+    || (!myDataR.isNull() && myFillFromRow < GLsizei(myDataR.getSizeY()))) {
+        return false;
+    }
 
-        if(!myStParams.isNull()) {
-            myStParams->StereoFormat = mySrcFormat;
+    if(anUnpackBase != NULL) {
+    #if !defined(GL_ES_VERSION_2_0)
+        // the fence only protects the buffer from being overwritten by the next frame - no need to wait for it
+        myPboFence = (void* )theCtx.extAll->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        if(myPboFence != NULL) {
+            StAtomicOp::Store(myIsPboBusy, 1);
         }
-        return true;
-    } else {
-        return false;
+    #endif
+    } else if(theCtx.arbBufStorage
+           && myPboSizeWanted > myPboSizeBytes) {
+        // next frames within this slot will be written directly into PBO
+        stglInitPbo(theCtx, myPboSizeWanted);
     }
+
+    finishFill(theQTexture);
+    return true;
 }
 
 void StGLTextureData::getCopy(StImage* theDataL,
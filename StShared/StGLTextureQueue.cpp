@@ -1,5 +1,5 @@
 /**
- * Copyright © 2009-2016 Kirill Gavrilov <kirill@sview.ru>
+ * Copyright © 2009-2017 Kirill Gavrilov <kirill@sview.ru>
  *
  * Distributed under the Boost Software License, Version 1.0.
  * See accompanying file license-boost.txt or copy at
@@ -11,38 +11,38 @@
 #include <StGL/StGLContext.h>
 
 StGLTextureQueue::StGLTextureQueue(const size_t theQueueSizeMax)
-: myDataFront(NULL),
-  myDataSnap(NULL),
-  myDataBack(NULL),
-  myQueueSize(0),
+: myDataRing(NULL),
   myQueueSizeMax(theQueueSizeMax),
+  myCountPushed(0),
+  myCountPopped(0),
+  myCountDropped(0),
+  myIsPushing(0),
+  myToReleasePbo(0),
+  myDataSnap(NULL),
   mySwapFBCount(0),
+  myUploadTimer(false),
+  myReadyTimer(false),
   myCurrSrcFormat(StFormat_Mono),
+  myCopiedBytes(0),
   myCurrPts(0.0),
   myNewShotEvent(false),
+  myPopEvent(false),
+  myPushEvent(false),
+  mySwapEvent(false),
+  myPushDoneEvent(false),
   myIsInUpdTexture(false),
   myIsReadyToSwap(false),
   myToCompress(false),
-  myHasStream(false) {
+  myHasStream(false),
+  myHasNewCaps(0) {
     ST_ASSERT(myQueueSizeMax >= 2, "StGLTextureQueue() - queue size limit should be >= 2");
 
     // we create 'empty' queue
-    myDataFront = new StGLTextureData();
-    StGLTextureData* iter = myDataFront;
-    for(size_t i = 1; i < myQueueSizeMax; ++i) {
-        iter->setNext(new StGLTextureData());
-        iter = iter->getNext();
-    }
-    iter->setNext(myDataFront); // data in loop
-    myDataBack = myDataFront;
+    myDataRing = new StGLTextureData[myQueueSizeMax];
 }
 
 StGLTextureQueue::~StGLTextureQueue() {
-    for(size_t anIter = 0; anIter < myQueueSizeMax; ++anIter) {
-        StGLTextureData* aRemItem = myDataFront;
-        myDataFront = myDataFront->getNext();
-        delete aRemItem;
-    }
+    delete[] myDataRing;
 }
 
 void StGLTextureQueue::setCompressMemory(const bool theToCompress) {
@@ -60,24 +60,43 @@ bool StGLTextureQueue::push(const StImage&     theSrcDataLeft,
         return false;
     }
 
-    myMutexPush.lock();
-    myDataBack = isEmpty() ? myDataFront : myDataBack->getNext();
-
-    myDataBack->updateData(myDeviceCaps,
-                           theSrcDataLeft,
-                           theSrcDataRight,
-                           theStParams,
-                           theSrcFormat,
-                           theSrcCubemap,
-                           theSrcPTS);
-    myMutexSrcFormat.lock();
-        myCurrSrcFormat = myDataBack->getSourceFormat();
-    myMutexSrcFormat.unlock();
-
-    myMutexSize.lock();
-        ++myQueueSize;
-    myMutexSize.unlock();
-    myMutexPush.unlock();
+    // full barrier - either GL thread will see the flag or we will see the release request
+    StAtomicOp::Increment(myIsPushing);
+    if(StAtomicOp::Load(myToReleasePbo) != 0) {
+        // PBOs are released right now - try again later
+        finishPush();
+        return false;
+    }
+
+    if(StAtomicOp::Load(myHasNewCaps) != 0) {
+        myMutexCaps.lock();
+        myDeviceCaps = myDeviceCapsNew;
+        StAtomicOp::Store(myHasNewCaps, 0);
+        myMutexCaps.unlock();
+    }
+
+    // back slot is owned by producer until the counter is increased
+    const uint32_t aPushed = myCountPushed;
+    StGLTextureData& aDataBack = getSlot(aPushed);
+    const bool toMeasure = myLatencyMeter.isEnabled();
+    StTimer aPushTimer(toMeasure);
+    aDataBack.updateData(myDeviceCaps,
+                         theSrcDataLeft,
+                         theSrcDataRight,
+                         theStParams,
+                         theSrcFormat,
+                         theSrcCubemap,
+                         theSrcPTS);
+    finishPush();
+    if(toMeasure) {
+        myLatencyMeter.addSample(StLatencyMeter::Stage_Push, aPushTimer.getElapsedTimeInMicroSec());
+    }
+    StAtomicOp::Store(myCurrSrcFormat, (int32_t )aDataBack.getSourceFormat());
+    StAtomicOp::Store(myCopiedBytes,   (uint32_t )stMin(aDataBack.getCopiedBytes(), size_t(uint32_t(-1))));
+
+    // publish the frame to consumer
+    StAtomicOp::Store(myCountPushed, aPushed + 1);
+    myPushEvent.set();
     return true;
 }
 
@@ -91,8 +110,12 @@ int StGLTextureQueue::swapFBOnReady(StGLContext& theCtx) {
         myIsReadyToSwap = false;
         --mySwapFBCount;
         mySwapFBMutex.unlock();
+        mySwapEvent.set();
 
         myQTexture.swapFB();
+        if(myLatencyMeter.isEnabled()) {
+            myLatencyMeter.addSample(StLatencyMeter::Stage_Swap, myReadyTimer.getElapsedTimeInMicroSec());
+        }
         if(myToCompress) {
             myQTexture.getBack(StGLQuadTexture::LEFT_TEXTURE ).release(theCtx);
             myQTexture.getBack(StGLQuadTexture::RIGHT_TEXTURE).release(theCtx);
@@ -110,6 +133,10 @@ int StGLTextureQueue::swapFBOnReady(StGLContext& theCtx) {
 
 // this function called ONLY from plugin thread
 bool StGLTextureQueue::stglUpdateStTextures(StGLContext& theCtx) {
+    if(theCtx.isBound()) {
+        stglCheckPboFences(theCtx);
+    }
+
     int aSwapState = swapFBOnReady(theCtx);
     if(aSwapState == SWAPONREADY_WAITLIM) {
         return false;
@@ -136,20 +163,38 @@ bool StGLTextureQueue::stglUpdateStTextures(StGLContext& theCtx) {
         return aSwapState == SWAPONREADY_SWAPPED;
     }
 
-    if(!theCtx.isBound()
-    || myDataFront->fillTexture(theCtx, myQTexture)) {
+    // front slot is owned by consumer until the counter is increased
+    const uint32_t aPopped = myCountPopped;
+    StGLTextureData& aDataFront = getSlot(aPopped);
+    const bool toMeasure = myLatencyMeter.isEnabled();
+    if(toMeasure) {
+        myUploadTimer.resume();
+    }
+    const bool isFilled = !theCtx.isBound()
+                        || aDataFront.fillTexture(theCtx, myQTexture);
+    if(toMeasure) {
+        myUploadTimer.pause();
+    }
+    if(isFilled) {
+        if(toMeasure) {
+            myLatencyMeter.addSample(StLatencyMeter::Stage_Upload, myUploadTimer.getElapsedTimeInMicroSec());
+            myReadyTimer.restart();
+        }
+        myUploadTimer.stop();
         myIsReadyToSwap = true;
-        myMutexSize.lock();
-            myCurrPts   = myDataFront->getPTS();
-            myDataSnap  = myDataFront; myNewShotEvent.set();
-            if(myToCompress) {
-                myDataFront->reset();
-            }
-            myDataFront = myDataFront->getNext();
-            ST_ASSERT(myQueueSize != 0, "StGLTextureQueue::stglUpdateStTextures() - critical error!");
-            --myQueueSize;
-        myMutexSize.unlock();
+        myMutexPts.lock();
+            myCurrPts = aDataFront.getPTS();
+        myMutexPts.unlock();
+        myDataSnap = &aDataFront; myNewShotEvent.set();
+        if(myToCompress) {
+            aDataFront.reset();
+        }
+        ST_ASSERT(StAtomicOp::Load(myCountPushed) != aPopped, "StGLTextureQueue::stglUpdateStTextures() - critical error!");
+
+        // release the slot to producer
+        StAtomicOp::Store(myCountPopped, aPopped + 1);
         myIsInUpdTexture = false;
+        myPopEvent.set();
     }
     myMutexPop.unlock();
 
@@ -161,17 +206,14 @@ bool StGLTextureQueue::stglUpdateStTextures(StGLContext& theCtx) {
 
 void StGLTextureQueue::clear() {
     myMutexPop.lock();
-    myMutexPush.lock();
-    myMutexSize.lock();
     mySwapFBMutex.lock();
         // decrease StStereoSource counters
-        StGLTextureData* anIterFront = myDataFront;
-        for(size_t i = 0; i < myQueueSize; ++i, anIterFront = anIterFront->getNext()) {
-            anIterFront->resetStParams();
+        const uint32_t aPushed = StAtomicOp::Load(myCountPushed);
+        for(uint32_t anIter = myCountPopped; anIter != aPushed; ++anIter) {
+            getSlot(anIter).resetStParams();
         }
         // reset queue
-        myQueueSize     = 0;
-        myDataBack      = myDataFront;
+        StAtomicOp::Store(myCountPopped, aPushed);
         if(myDataSnap != NULL) {
             myDataSnap->resetStParams();
         }
@@ -180,36 +222,71 @@ void StGLTextureQueue::clear() {
         myIsReadyToSwap = false; // invalidate currently uploaded image in back buffer
         // empty texture update sequence
         myIsInUpdTexture = false;
+        myUploadTimer.stop();
     mySwapFBMutex.unlock();
-    myMutexSize.unlock();
-    myMutexPush.unlock();
     myMutexPop.unlock();
+    setTiles(StHandle<StImageTiles>());
+    myPopEvent.set();
+    mySwapEvent.set();
+}
+
+void StGLTextureQueue::finishPush() {
+    StAtomicOp::Decrement(myIsPushing);
+    if(StAtomicOp::Load(myToReleasePbo) != 0) {
+        myPushDoneEvent.set();
+    }
+}
+
+void StGLTextureQueue::stglReleasePbo(StGLContext& theCtx) {
+    // producer does not lock anything while filling the slot - wait until it finishes
+    StAtomicOp::Increment(myToReleasePbo);
+    for(;;) {
+        myPushDoneEvent.reset();
+        if(StAtomicOp::Load(myIsPushing) == 0) {
+            break;
+        }
+        myPushDoneEvent.wait();
+    }
+
+    myMutexPop.lock();
+    for(size_t aSlotIter = 0; aSlotIter < myQueueSizeMax; ++aSlotIter) {
+        myDataRing[aSlotIter].stglReleasePbo(theCtx);
+    }
+    myMutexPop.unlock();
+    StAtomicOp::Decrement(myToReleasePbo);
+}
+
+void StGLTextureQueue::stglCheckPboFences(StGLContext& theCtx) {
+    // fences are polled for all slots, so that producer can write into PBO as soon as possible
+    for(size_t aSlotIter = 0; aSlotIter < myQueueSizeMax; ++aSlotIter) {
+        myDataRing[aSlotIter].stglCheckPboFence(theCtx);
+    }
 }
 
 void StGLTextureQueue::drop(const size_t theCount) {
     myMutexPop.lock();
-    myMutexPush.lock();
-    myMutexSize.lock();
-        if(myQueueSize < 2) {
+        const size_t aQueueSize = getSize();
+        if(aQueueSize < 2) {
             // to small queue
-            myMutexSize.unlock();
-            myMutexPush.unlock();
             myMutexPop.unlock();
             return;
         }
-        size_t decr = (theCount < myQueueSize) ? theCount : (myQueueSize - 1);
+        const uint32_t aDecr = uint32_t((theCount < aQueueSize) ? theCount : (aQueueSize - 1));
 
         // decrease StStereoSource counters
-        for(size_t i = 0; i < decr; ++i, myDataFront = myDataFront->getNext()) {
-            myDataFront->resetStParams();
+        uint32_t aPopped = myCountPopped;
+        for(uint32_t anIter = 0; anIter < aDecr; ++anIter, ++aPopped) {
+            getSlot(aPopped).resetStParams();
         }
         // reset queue
-        myQueueSize -= decr;
+        StAtomicOp::Store(myCountPopped, aPopped);
         // empty texture update sequence
         myIsInUpdTexture = false;
-    myMutexSize.unlock();
-    myMutexPush.unlock();
+        myUploadTimer.stop();
+        myLatencyMeter.addDropped(aDecr);
+        StAtomicOp::Store(myCountDropped, myCountDropped + aDecr);
     myMutexPop.unlock();
+    myPopEvent.set();
 }
 
 int StGLTextureQueue::getSnapshot(StImage* theOutDataLeft,
@@ -0,0 +1,144 @@
+/**
+ * Copyright © 2017 Kirill Gavrilov <kirill@sview.ru>
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * See accompanying file license-boost.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt
+ */
+
+#include <StGLStereo/StGLTileAtlas.h>
+
+#include <StGLCore/StGLCore20.h>
+#include <StGL/StGLContext.h>
+
+namespace {
+    static const GLint THE_ATLAS_SIZE_MAX = 4096; //!< 64 MiB of RGBA8 texture
+}
+
+StGLTileAtlas::StGLTileAtlas()
+#if defined(GL_ES_VERSION_2_0)
+: myTexture(GL_RGBA),
+#else
+: myTexture(GL_RGBA8),
+#endif
+  mySlotsPerRow(0),
+  myFrame(1) {
+    //
+}
+
+StGLTileAtlas::~StGLTileAtlas() {
+    //
+}
+
+void StGLTileAtlas::release(StGLContext& theCtx) {
+    myTexture.release(theCtx);
+    mySlots.clear();
+    mySlotsPerRow = 0;
+}
+
+bool StGLTileAtlas::stglInit(StGLContext& theCtx) {
+    if(myTexture.isValid()) {
+        return true;
+    }
+
+    const GLint aSize = stMin(theCtx.getMaxTextureSize(), THE_ATLAS_SIZE_MAX);
+    mySlotsPerRow = aSize / (StImageTiles::TILE_SIZE + 2 * StImageTiles::TILE_BORDER);
+    if(mySlotsPerRow < 1
+    || !myTexture.initTrash(theCtx, aSize, aSize)) {
+        mySlotsPerRow = 0;
+        return false;
+    }
+
+    mySlots.resize(size_t(mySlotsPerRow * mySlotsPerRow));
+    clear();
+    return true;
+}
+
+void StGLTileAtlas::clear() {
+    for(std::vector<Slot>::iterator aSlotIter = mySlots.begin(); aSlotIter != mySlots.end(); ++aSlotIter) {
+        aSlotIter->SizeX    = 0;
+        aSlotIter->SizeY    = 0;
+        aSlotIter->LastUsed = 0;
+        aSlotIter->IsEmpty  = true;
+    }
+}
+
+bool StGLTileAtlas::find(const StImageTileKey& theKey,
+                         StGLVec4&             theTexData) {
+    const GLfloat aSlotSize = GLfloat(StImageTiles::TILE_SIZE + 2 * StImageTiles::TILE_BORDER);
+    const GLfloat aTexSizeX = GLfloat(myTexture.getSizeX());
+    const GLfloat aTexSizeY = GLfloat(myTexture.getSizeY());
+    for(size_t aSlotIter = 0; aSlotIter < mySlots.size(); ++aSlotIter) {
+        Slot& aSlot = mySlots[aSlotIter];
+        if(aSlot.IsEmpty
+        || aSlot.Key != theKey) {
+            continue;
+        }
+
+        aSlot.LastUsed = myFrame;
+        const int aCol = int(aSlotIter) % mySlotsPerRow;
+        const int aRow = int(aSlotIter) / mySlotsPerRow;
+        theTexData.x() = (GLfloat(aCol) * aSlotSize + GLfloat(StImageTiles::TILE_BORDER)) / aTexSizeX;
+        theTexData.y() = (GLfloat(aRow) * aSlotSize + GLfloat(StImageTiles::TILE_BORDER)) / aTexSizeY;
+        theTexData.z() = GLfloat(aSlot.SizeX) / aTexSizeX;
+        theTexData.w() = GLfloat(aSlot.SizeY) / aTexSizeY;
+        return true;
+    }
+    return false;
+}
+
+bool StGLTileAtlas::stglUpload(StGLContext&       theCtx,
+                               const StImageTile& theTile) {
+    if(mySlots.empty()
+    || theTile.Image.isNull()) {
+        return false;
+    }
+
+    // take the same tile, an empty slot or the least recently used one
+    size_t aSlotId = mySlots.size();
+    for(size_t aSlotIter = 0; aSlotIter < mySlots.size(); ++aSlotIter) {
+        const Slot& aSlot = mySlots[aSlotIter];
+        if(!aSlot.IsEmpty
+         && aSlot.Key == theTile.Key) {
+            aSlotId = aSlotIter;
+            break;
+        } else if(aSlot.LastUsed == myFrame) {
+            continue;
+        } else if(aSlotId == mySlots.size()
+               || aSlot.IsEmpty
+               || (!mySlots[aSlotId].IsEmpty && aSlot.LastUsed < mySlots[aSlotId].LastUsed)) {
+            aSlotId = aSlotIter;
+        }
+    }
+    if(aSlotId == mySlots.size()) {
+        return false;
+    }
+
+    const StImagePlane& aPlane    = theTile.Image->getPlane(0);
+    const GLsizei       aSlotSize = GLsizei(StImageTiles::TILE_SIZE + 2 * StImageTiles::TILE_BORDER);
+    if(aPlane.getFormat() != StImagePlane::ImgRGBA
+    || aPlane.getSizeX()  != size_t(aSlotSize)
+    || aPlane.getSizeY()  != size_t(aSlotSize)) {
+        return false;
+    }
+
+    myTexture.bind(theCtx);
+    theCtx.core20fwd->glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    if(theCtx.hasUnpack) {
+        theCtx.core20fwd->glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    }
+    theCtx.core20fwd->glTexSubImage2D(GL_TEXTURE_2D, 0,
+                                      GLint(aSlotId) % mySlotsPerRow * aSlotSize,
+                                      GLint(aSlotId) / mySlotsPerRow * aSlotSize,
+                                      aSlotSize, aSlotSize,
+                                      GL_RGBA, GL_UNSIGNED_BYTE, aPlane.getData());
+    myTexture.unbind(theCtx);
+
+    Slot& aSlot = mySlots[aSlotId];
+    aSlot.Key      = theTile.Key;
+    aSlot.SizeX    = theTile.SizeX;
+    aSlot.SizeY    = theTile.SizeY;
+    aSlot.LastUsed = myFrame - 1;
+    aSlot.IsEmpty  = false;
+    return true;
+}
@@ -1,5 +1,5 @@
 /**
- * Copyright © 2010-2015 Kirill Gavrilov <kirill@sview.ru>
+ * Copyright © 2010-2017 Kirill Gavrilov <kirill@sview.ru>
  *
  * Distributed under the Boost Software License, Version 1.0.
  * See accompanying file license-boost.txt or copy at
@@ -8,6 +8,262 @@
 
 #include <StImage/StImage.h>
 
+#include <StThreads/StThread.h>
+
+#include <vector>
+
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define ST_IMAGE_SSE2
+#endif
+
+namespace {
+
+    static const int THE_YUV_SLICES_MAX = 8;  //!< maximum number of threads for YUV -> RGB conversion
+    static const int THE_YUV_SLICE_ROWS = 64; //!< minimal number of rows per thread
+
+    /**
+     * Unpack the row of single-component plane into floats.
+     */
+    template<typename Type>
+    inline void unpackRow(const StImagePlane& thePlane,
+                          const size_t        theRow,
+                          float*              theOut) {
+        const Type* aSrc = (const Type* )thePlane.accessData(theRow, 0);
+        for(size_t aCol = 0; aCol < thePlane.getSizeX(); ++aCol) {
+            theOut[aCol] = float(aSrc[aCol]);
+        }
+    }
+
+    /**
+     * Unpack the row of sub-sampled chroma plane into floats of full width.
+     */
+    template<typename Type>
+    inline void unpackRowChroma(const StImagePlane& thePlane,
+                                const size_t        theRow,
+                                const size_t        theDivX,
+                                const size_t        theSizeX,
+                                float*              theOut) {
+        const Type* aSrc = (const Type* )thePlane.accessData(theRow, 0);
+        for(size_t aCol = 0, anOutCol = 0; anOutCol < theSizeX; ++aCol) {
+            const float aValue = float(aSrc[aCol]);
+            for(size_t aRepeat = 0; aRepeat < theDivX && anOutCol < theSizeX; ++aRepeat, ++anOutCol) {
+                theOut[anOutCol] = aValue;
+            }
+        }
+    }
+
+    /**
+     * Round the value half to even (as _mm_cvtps_epi32() does) and clamp into 0..255 range.
+     */
+    inline GLubyte clampByte(const float theValue) {
+    #if defined(ST_IMAGE_SSE2)
+        const int aValue = _mm_cvtss_si32(_mm_set_ss(theValue));
+    #else
+        const int aValue = int(lrintf(theValue));
+    #endif
+        return aValue <= 0 ? 0 : (aValue >= 255 ? 255 : GLubyte(aValue));
+    }
+
+    /**
+     * Conversion of the range of rows from planar (or NV12) YUV image into packed RGB plane.
+     * Coefficients are the same as used by YUV -> RGB shaders in StGLImageProgram,
+     * while black level and neutral chroma offsets are exact for integer samples (16 and 128 for 8-bit MPEG range).
+     */
+    struct StYuvToRgbSlice {
+
+        const StImage* Src;     //!< source YUV image
+        StImagePlane*  Dst;     //!< destination RGB plane
+        size_t         RowFrom; //!< first row to convert
+        size_t         RowTo;   //!< last  row to convert (exclusive)
+        float          YMul;    //!< luma   scale  to 0..255 range
+        float          YAdd;    //!< luma   offset to 0..255 range
+        float          CMul;    //!< chroma scale  to -128..127 range
+        float          CAdd;    //!< chroma offset to -128..127 range
+        float          CoefRV;  //!< V contribution to red
+        float          CoefGU;  //!< U contribution to green (subtracted)
+        float          CoefGV;  //!< V contribution to green (subtracted)
+        float          CoefBU;  //!< U contribution to blue
+
+        /**
+         * Convert single pixel, the same way as SSE2 code path does.
+         */
+        void convertPixel(const float theY,
+                          const float theU,
+                          const float theV,
+                          GLubyte*    theOut) const {
+            const float aY = theY * YMul + YAdd;
+            const float aU = theU * CMul + CAdd;
+            const float aV = theV * CMul + CAdd;
+            theOut[0] = clampByte(aY + aV * CoefRV);
+            theOut[1] = clampByte(aY - (aU * CoefGU + aV * CoefGV));
+            theOut[2] = clampByte(aY + aU * CoefBU);
+        }
+
+        /**
+         * Setup conversion coefficients for specified source image.
+         * @return false if image layout is not supported
+         */
+        bool init(const StImage& theSrc) {
+            const StImagePlane& aPlaneY = theSrc.getPlane(0);
+            const StImagePlane& aPlaneU = theSrc.getPlane(1);
+            const StImagePlane& aPlaneV = theSrc.getPlane(2);
+            const bool is16 = aPlaneY.getFormat() == StImagePlane::ImgGray16;
+            const bool isNV = aPlaneU.getFormat() == StImagePlane::ImgUV;
+            if(theSrc.getColorModel() != StImage::ImgColor_YUV
+            || theSrc.isPacked()
+            || aPlaneU.getSizeX() == 0
+            || aPlaneU.getSizeY() == 0
+            || (aPlaneY.getFormat() != StImagePlane::ImgGray && !is16)
+            || (isNV ? is16
+                     : (aPlaneU.getFormat() != aPlaneY.getFormat()
+                     || aPlaneV.getFormat() != aPlaneY.getFormat()
+                     || aPlaneV.getSizeX()  != aPlaneU.getSizeX()
+                     || aPlaneV.getSizeY()  != aPlaneU.getSizeY()))) {
+                // not supported
+                return false;
+            }
+
+            // define the range of stored values
+            float aMaxValue = is16 ? 65535.0f : 255.0f;
+            bool  isFull    = true;
+            switch(theSrc.getColorScale()) {
+                case StImage::ImgScale_Full:
+                case StImage::ImgScale_NvFull: {
+                    break;
+                }
+                case StImage::ImgScale_Mpeg:
+                case StImage::ImgScale_NvMpeg: {
+                    isFull = false;
+                    break;
+                }
+                case StImage::ImgScale_Mpeg9:
+                case StImage::ImgScale_Jpeg9: {
+                    isFull    = theSrc.getColorScale() == StImage::ImgScale_Jpeg9;
+                    aMaxValue = 511.0f;
+                    break;
+                }
+                case StImage::ImgScale_Mpeg10:
+                case StImage::ImgScale_Jpeg10: {
+                    isFull    = theSrc.getColorScale() == StImage::ImgScale_Jpeg10;
+                    aMaxValue = 1023.0f;
+                    break;
+                }
+            }
+            if(aMaxValue > 255.0f
+            && aMaxValue < 65535.0f
+            && !is16) {
+                return false;
+            }
+
+            // samples of higher bit depth are scaled to 8-bit equivalent,
+            // so that MPEG range is 16..235 for luma and neutral chroma is 128
+            const float aTo8Bit = 256.0f / (aMaxValue + 1.0f);
+            Src     = &theSrc;
+            Dst     = NULL;
+            RowFrom = 0;
+            RowTo   = 0;
+            YMul    = isFull ? 255.0f / aMaxValue : 1.1643f * aTo8Bit;
+            YAdd    = isFull ? 0.0f : -1.1643f * 16.0f;
+            CMul    = aTo8Bit;
+            CAdd    = -128.0f;
+            CoefRV  = isFull ? 1.402f : 1.5958f;
+            CoefGU  = isFull ? 0.344f : 0.39173f;
+            CoefGV  = isFull ? 0.714f : 0.81290f;
+            CoefBU  = isFull ? 1.772f : 2.017f;
+            return true;
+        }
+
+        /**
+         * Perform conversion.
+         */
+        void perform() const {
+            const StImagePlane& aPlaneY = Src->getPlane(0);
+            const StImagePlane& aPlaneU = Src->getPlane(1);
+            const StImagePlane& aPlaneV = Src->getPlane(2);
+            const bool   isNV   = aPlaneU.getFormat() == StImagePlane::ImgUV;
+            const bool   is16   = aPlaneY.getFormat() == StImagePlane::ImgGray16;
+            const size_t aSizeX = aPlaneY.getSizeX();
+            const size_t aDivX  = (aSizeX              + aPlaneU.getSizeX() - 1) / aPlaneU.getSizeX();
+            const size_t aDivY  = (aPlaneY.getSizeY() + aPlaneU.getSizeY() - 1) / aPlaneU.getSizeY();
+
+            std::vector<float> aBuffer(aSizeX * 3 + 4, 0.0f);
+            float* aRowY = &aBuffer[0];
+            float* aRowU = aRowY + aSizeX;
+            float* aRowV = aRowU + aSizeX;
+            for(size_t aRow = RowFrom; aRow < RowTo; ++aRow) {
+                const size_t aRowC = aRow / aDivY;
+                if(is16) {
+                    unpackRow<uint16_t>(aPlaneY, aRow, aRowY);
+                    unpackRowChroma<uint16_t>(aPlaneU, aRowC, aDivX, aSizeX, aRowU);
+                    unpackRowChroma<uint16_t>(aPlaneV, aRowC, aDivX, aSizeX, aRowV);
+                } else if(isNV) {
+                    unpackRow<GLubyte>(aPlaneY, aRow, aRowY);
+                    const GLubyte* aSrcUV = aPlaneU.accessData(aRowC, 0);
+                    for(size_t aCol = 0, anOutCol = 0; anOutCol < aSizeX; ++aCol) {
+                        const float aValueU = float(aSrcUV[aCol * 2]);
+                        const float aValueV = float(aSrcUV[aCol * 2 + 1]);
+                        for(size_t aRepeat = 0; aRepeat < aDivX && anOutCol < aSizeX; ++aRepeat, ++anOutCol) {
+                            aRowU[anOutCol] = aValueU;
+                            aRowV[anOutCol] = aValueV;
+                        }
+                    }
+                } else {
+                    unpackRow<GLubyte>(aPlaneY, aRow, aRowY);
+                    unpackRowChroma<GLubyte>(aPlaneU, aRowC, aDivX, aSizeX, aRowU);
+                    unpackRowChroma<GLubyte>(aPlaneV, aRowC, aDivX, aSizeX, aRowV);
+                }
+
+                GLubyte* anOut = Dst->changeData(aRow, 0);
+                size_t aCol = 0;
+            #if defined(ST_IMAGE_SSE2)
+                const __m128 aYMul = _mm_set1_ps(YMul);
+                const __m128 aYAdd = _mm_set1_ps(YAdd);
+                const __m128 aCMul = _mm_set1_ps(CMul);
+                const __m128 aCAdd = _mm_set1_ps(CAdd);
+                const __m128 aRV   = _mm_set1_ps(CoefRV);
+                const __m128 aGU   = _mm_set1_ps(CoefGU);
+                const __m128 aGV   = _mm_set1_ps(CoefGV);
+                const __m128 aBU   = _mm_set1_ps(CoefBU);
+                GLubyte aPacked[16];
+                for(; aCol + 4 <= aSizeX; aCol += 4, anOut += 12) {
+                    const __m128 aY = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(aRowY + aCol), aYMul), aYAdd);
+                    const __m128 aU = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(aRowU + aCol), aCMul), aCAdd);
+                    const __m128 aV = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(aRowV + aCol), aCMul), aCAdd);
+                    const __m128i aR = _mm_cvtps_epi32(_mm_add_ps(aY, _mm_mul_ps(aV, aRV)));
+                    const __m128i aG = _mm_cvtps_epi32(_mm_sub_ps(aY, _mm_add_ps(_mm_mul_ps(aU, aGU), _mm_mul_ps(aV, aGV))));
+                    const __m128i aB = _mm_cvtps_epi32(_mm_add_ps(aY, _mm_mul_ps(aU, aBU)));
+
+                    // saturated packing into R0..R3 G0..G3 B0..B3 bytes
+                    _mm_storeu_si128((__m128i* )aPacked, _mm_packus_epi16(_mm_packs_epi32(aR, aG), _mm_packs_epi32(aB, aB)));
+                    for(size_t aPixel = 0; aPixel < 4; ++aPixel) {
+                        anOut[aPixel * 3 + 0] = aPacked[aPixel];
+                        anOut[aPixel * 3 + 1] = aPacked[aPixel + 4];
+                        anOut[aPixel * 3 + 2] = aPacked[aPixel + 8];
+                    }
+                }
+            #endif
+                for(; aCol < aSizeX; ++aCol, anOut += 3) {
+                    convertPixel(aRowY[aCol], aRowU[aCol], aRowV[aCol], anOut);
+                }
+            }
+        }
+
+    };
+
+    /**
+     * Thread function converting one slice.
+     */
+    static SV_THREAD_FUNCTION yuvToRgbThread(void* theSlice) {
+        const StYuvToRgbSlice* aSlice = (const StYuvToRgbSlice* )theSlice;
+        aSlice->perform();
+        return SV_THREAD_RETURN 0;
+    }
+
+}
+
 StString StImage::formatImgColorModel(ImgColorModel theColorModel) {
 #ifdef ST_DEBUG
     switch(theColorModel) {
@@ -139,18 +395,39 @@ bool StImage::initTrashLimited(const StImage& theRef,
 }
 
 StPixelRGB StImage::getRGBFromYUV(const size_t theRow, const size_t theCol) const {
-    // this code is not acceptable for full-range YUV!
-    int OY = 298 * (getPlane(0).getFirstByte(theRow, theCol) - 16);
-    int U = getPlane(1).getFirstByte(getScaledRow(1, theRow),
-                                     getScaledCol(1, theCol)) - 128;
-    int V = getPlane(2).getFirstByte(getScaledRow(2, theRow),
-                                     getScaledCol(2, theCol)) - 128;
-    return StPixelRGB(clamp<int>((OY + 409 * V + 128) >> 8),
-                      clamp<int>((OY - 100 * U - 208 * V + 128) >> 8),
-                      clamp<int>((OY + 516 * U + 128) >> 8));
+    StYuvToRgbSlice aConv;
+    if(!aConv.init(*this)) {
+        return StPixelRGB(0, 0, 0);
+    }
+
+    const StImagePlane& aPlaneY = getPlane(0);
+    const StImagePlane& aPlaneU = getPlane(1);
+    const StImagePlane& aPlaneV = getPlane(2);
+    const size_t aRowC = getScaledRow(1, theRow);
+    const size_t aColC = getScaledCol(1, theCol);
+    float aValueY = 0.0f, aValueU = 0.0f, aValueV = 0.0f;
+    if(aPlaneY.getFormat() == StImagePlane::ImgGray16) {
+        aValueY = float(*(const uint16_t* )aPlaneY.accessData(theRow, theCol));
+        aValueU = float(*(const uint16_t* )aPlaneU.accessData(aRowC,  aColC));
+        aValueV = float(*(const uint16_t* )aPlaneV.accessData(aRowC,  aColC));
+    } else if(aPlaneU.getFormat() == StImagePlane::ImgUV) {
+        const GLubyte* aDataUV = aPlaneU.accessData(aRowC, aColC);
+        aValueY = float(aPlaneY.getFirstByte(theRow, theCol));
+        aValueU = float(aDataUV[0]);
+        aValueV = float(aDataUV[1]);
+    } else {
+        aValueY = float(aPlaneY.getFirstByte(theRow, theCol));
+        aValueU = float(aPlaneU.getFirstByte(aRowC,  aColC));
+        aValueV = float(aPlaneV.getFirstByte(aRowC,  aColC));
+    }
+
+    GLubyte anRgb[3];
+    aConv.convertPixel(aValueY, aValueU, aValueV, anRgb);
+    return StPixelRGB(anRgb[0], anRgb[1], anRgb[2]);
 }
 
-bool StImage::initRGB(const StImage& theCopy) {
+bool StImage::initRGB(const StImage& theCopy,
+                      const int      theNbThreads) {
     if(this == &theCopy) {
         // not supported operation
         return false;
@@ -165,21 +442,42 @@ bool StImage::initRGB(const StImage& theCopy) {
             return initWrapper(theCopy);
         }
         case StImage::ImgColor_YUV: {
-            if(isPacked()
-            || theCopy.getColorScale() != StImage::ImgScale_Mpeg
-            || theCopy.getPlane(0).getFormat() != StImagePlane::ImgGray16) {
+            StYuvToRgbSlice aTemplate;
+            if(!aTemplate.init(theCopy)) {
                 // not supported
                 return false;
             }
-            // this is SLOW conversion!
+
             StImagePlane& anRGBPlane = changePlane(0);
-            anRGBPlane.initTrash(StImagePlane::ImgRGB,
-                                 theCopy.getSizeX(), theCopy.getSizeY());
-            for(size_t aRow = 0; aRow < anRGBPlane.getSizeY(); ++aRow) {
-                for(size_t aCol = 0; aCol < anRGBPlane.getSizeX(); ++aCol) {
-                    anRGBPlane.changePixelRGB(aRow, aCol) = theCopy.getRGBFromYUV(aRow, aCol);
+            if(!anRGBPlane.initTrash(StImagePlane::ImgRGB,
+                                     theCopy.getSizeX(), theCopy.getSizeY())) {
+                nullify();
+                return false;
+            }
+            aTemplate.Dst = &anRGBPlane;
+
+            // split rows between threads, the calling thread converts the first slice
+            const size_t aSizeY    = anRGBPlane.getSizeY();
+            const int    aNbMax    = theNbThreads > 0 ? theNbThreads : stMin(StThread::countLogicalProcessors(), THE_YUV_SLICES_MAX);
+            const int    aNbSlices = stMax(stMin(aNbMax, int(aSizeY / THE_YUV_SLICE_ROWS)), 1);
+            std::vector<StYuvToRgbSlice> aSlices(aNbSlices, aTemplate);
+            std::vector< StHandle<StThread> > aThreads;
+            for(int aSliceIter = 0; aSliceIter < aNbSlices; ++aSliceIter) {
+                StYuvToRgbSlice& aSlice = aSlices[aSliceIter];
+                aSlice.RowFrom = (aSizeY * size_t(aSliceIter))     / size_t(aNbSlices);
+                aSlice.RowTo   = (aSizeY * size_t(aSliceIter + 1)) / size_t(aNbSlices);
+                if(aSliceIter != 0) {
+                    aThreads.push_back(new StThread(yuvToRgbThread, (void* )&aSlice, "StImage"));
                 }
             }
+            aSlices[0].perform();
+            for(size_t aThreadIter = 0; aThreadIter < aThreads.size(); ++aThreadIter) {
+                aThreads[aThreadIter]->wait();
+            }
+
+            setColorModel(StImage::ImgColor_RGB);
+            setColorScale(StImage::ImgScale_Full);
+            setPixelRatio(theCopy.getPixelRatio());
             return true;
         }
         case ImgColor_GRAY:
@@ -18,7 +18,11 @@
 #include <StStrings/StLogger.h>
 
 StImageFile::StImageFile()
-: mySrcFormat(StFormat_AUTO) {
+: mySrcFormat(StFormat_AUTO),
+  mySizeHintX(0),
+  mySizeHintY(0),
+  mySrcSizeX(0),
+  mySrcSizeY(0) {
     //
 }
 
@@ -0,0 +1,237 @@
+/**
+ * Copyright © 2017 Kirill Gavrilov <kirill@sview.ru>
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * See accompanying file license-boost.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt
+ */
+
+#include <StImage/StImageTiles.h>
+
+#include <StAV/StAVImage.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    static const int THE_TILES_THREADS_MAX = 4;
+}
+
+StImageTiles::StImageTiles(const StHandle<StStereoParams>& theSource,
+                           const StHandle<StImage>&        theImageL,
+                           const StRectI_t&                theRectL,
+                           const StHandle<StImage>&        theImageR,
+                           const StRectI_t&                theRectR)
+: mySource(theSource),
+  myEventJob(false),
+  myHasFailed(false),
+  myToQuit(false) {
+    myViews[0].Image = theImageL;
+    myViews[0].Rect  = theRectL;
+    if(!theImageR.isNull()
+    && !theImageR->isNull()) {
+        myViews[1].Image = theImageR;
+        myViews[1].Rect  = theRectR;
+    }
+
+    const int aNbThreads = stMin(stMax(StThread::countLogicalProcessors() - 1, 1), THE_TILES_THREADS_MAX);
+    for(int aThreadIter = 0; aThreadIter < aNbThreads; ++aThreadIter) {
+        myThreads.push_back(new StThread(workerThreadFunction, (void* )this, "StImageTiles"));
+    }
+}
+
+StImageTiles::~StImageTiles() {
+    myMutex.lock();
+    myToQuit = true;
+    myPending.clear();
+    myMutex.unlock();
+    myEventJob.set();
+    for(size_t aThreadIter = 0; aThreadIter < myThreads.size(); ++aThreadIter) {
+        myThreads[aThreadIter]->wait();
+    }
+    myThreads.clear();
+}
+
+bool StImageTiles::isKnown(const StImageTileKey& theKey) const {
+    if(std::find(myInProgress.begin(), myInProgress.end(), theKey) != myInProgress.end()) {
+        return true;
+    }
+    for(std::vector<StImageTile>::const_iterator aTileIter = myReady.begin(); aTileIter != myReady.end(); ++aTileIter) {
+        if(aTileIter->Key == theKey) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void StImageTiles::request(const std::vector<StImageTileKey>& theKeys) {
+    myMutex.lock();
+    myPending.clear();
+    if(!myHasFailed) {
+        for(std::vector<StImageTileKey>::const_iterator aKeyIter = theKeys.begin(); aKeyIter != theKeys.end(); ++aKeyIter) {
+            if(hasView(aKeyIter->View)
+            && !isKnown(*aKeyIter)) {
+                myPending.push_back(*aKeyIter);
+            }
+        }
+    }
+    const bool hasJob = !myPending.empty();
+    myMutex.unlock();
+    if(hasJob) {
+        myEventJob.set();
+    }
+}
+
+bool StImageTiles::pop(StImageTile& theTile) {
+    myMutex.lock();
+    if(myReady.empty()) {
+        myMutex.unlock();
+        return false;
+    }
+
+    theTile = myReady.front();
+    myReady.erase(myReady.begin());
+    myMutex.unlock();
+    return true;
+}
+
+bool StImageTiles::generate(const StImageTileKey& theKey,
+                            StImageTile&          theTile,
+                            StAVScaler&           theScaler) const {
+    const View&    aView   = myViews[theKey.View];
+    const StImage& anImage = *aView.Image;
+    const int aLevelSizeX = getLevelSizeX(theKey.View, theKey.Level);
+    const int aLevelSizeY = getLevelSizeY(theKey.View, theKey.Level);
+
+    // tile rectangle and the same rectangle with the border at the pyramid level
+    const int aTileLeft = theKey.Col * TILE_SIZE;
+    const int aTileTop  = theKey.Row * TILE_SIZE;
+    if(aTileLeft >= aLevelSizeX
+    || aTileTop  >= aLevelSizeY) {
+        return false;
+    }
+    const int aTileRight    = stMin(aTileLeft + int(TILE_SIZE), aLevelSizeX);
+    const int aTileBottom   = stMin(aTileTop  + int(TILE_SIZE), aLevelSizeY);
+    const int anOuterLeft   = stMax(aTileLeft   - int(TILE_BORDER), 0);
+    const int anOuterTop    = stMax(aTileTop    - int(TILE_BORDER), 0);
+    const int anOuterRight  = stMin(aTileRight  + int(TILE_BORDER), aLevelSizeX);
+    const int anOuterBottom = stMin(aTileBottom + int(TILE_BORDER), aLevelSizeY);
+
+    // the same area within full-resolution image
+    const int aSrcLeft   = aView.Rect.left() + (anOuterLeft << theKey.Level);
+    const int aSrcTop    = aView.Rect.top()  + (anOuterTop  << theKey.Level);
+    const int aSrcRight  = stMin(aView.Rect.left() + (anOuterRight  << theKey.Level), aView.Rect.right());
+    const int aSrcBottom = stMin(aView.Rect.top()  + (anOuterBottom << theKey.Level), aView.Rect.bottom());
+
+    StImage aSrc;
+    aSrc.setColorModel(anImage.getColorModel());
+    aSrc.setColorScale(anImage.getColorScale());
+    for(size_t aPlaneId = 0; aPlaneId < 4; ++aPlaneId) {
+        const StImagePlane& aPlane = anImage.getPlane(aPlaneId);
+        if(aPlane.isNull()) {
+            continue;
+        }
+
+        // take into account sub-sampled chroma planes
+        const size_t aDivX  = (anImage.getSizeX() + aPlane.getSizeX() - 1) / aPlane.getSizeX();
+        const size_t aDivY  = (anImage.getSizeY() + aPlane.getSizeY() - 1) / aPlane.getSizeY();
+        const size_t aLeft  = size_t(aSrcLeft) / aDivX;
+        const size_t aTop   = size_t(aSrcTop)  / aDivY;
+        if(aLeft >= aPlane.getSizeX()
+        || aTop  >= aPlane.getSizeY()) {
+            return false;
+        }
+
+        const size_t aSizeX = stMin((size_t(aSrcRight  - aSrcLeft) + aDivX - 1) / aDivX, aPlane.getSizeX() - aLeft);
+        const size_t aSizeY = stMin((size_t(aSrcBottom - aSrcTop)  + aDivY - 1) / aDivY, aPlane.getSizeY() - aTop);
+        if(!aSrc.changePlane(aPlaneId).initWrapper(aPlane.getFormat(), aPlane.accessData(aTop, aLeft),
+                                                   aSizeX, aSizeY, aPlane.getSizeRowBytes())) {
+            return false;
+        }
+    }
+
+    // tile buffer has fixed dimensions to be uploaded into atlas slot as is
+    const size_t aBufSize = TILE_SIZE + 2 * TILE_BORDER;
+    StHandle<StImage> aTileImage = new StImage();
+    aTileImage->setColorModel(StImage::ImgColor_RGBA);
+    StImagePlane& aBuf = aTileImage->changePlane(0);
+    if(!aBuf.initTrash(StImagePlane::ImgRGBA, aBufSize, aBufSize, aBufSize * 4)) {
+        return false;
+    }
+
+    StImage aDst;
+    aDst.setColorModel(StImage::ImgColor_RGBA);
+    aDst.changePlane(0).initWrapper(StImagePlane::ImgRGBA,
+                                    aBuf.changeData(TILE_BORDER - (aTileTop - anOuterTop), TILE_BORDER - (aTileLeft - anOuterLeft)),
+                                    size_t(anOuterRight - anOuterLeft), size_t(anOuterBottom - anOuterTop), aBuf.getSizeRowBytes());
+    // single slice - slice edges within the tile would produce seams
+    if(!StAVImage::resize(aSrc, aDst, theScaler, 1)) {
+        return false;
+    }
+
+    // replicate edge pixels where there is no neighbor tile
+    const size_t aSizeX = size_t(aTileRight  - aTileLeft);
+    const size_t aSizeY = size_t(aTileBottom - aTileTop);
+    for(size_t aRow = 1; aRow <= aSizeY; ++aRow) {
+        if(anOuterLeft == aTileLeft) {
+            std::memcpy(aBuf.changeData(aRow, 0), aBuf.accessData(aRow, 1), 4);
+        }
+        if(anOuterRight == aTileRight) {
+            std::memcpy(aBuf.changeData(aRow, aSizeX + 1), aBuf.accessData(aRow, aSizeX), 4);
+        }
+    }
+    if(anOuterTop == aTileTop) {
+        std::memcpy(aBuf.changeData(0, 0), aBuf.accessData(1, 0), (aSizeX + 2) * 4);
+    }
+    if(anOuterBottom == aTileBottom) {
+        std::memcpy(aBuf.changeData(aSizeY + 1, 0), aBuf.accessData(aSizeY, 0), (aSizeX + 2) * 4);
+    }
+
+    theTile.Key   = theKey;
+    theTile.Image = aTileImage;
+    theTile.SizeX = int(aSizeX);
+    theTile.SizeY = int(aSizeY);
+    return true;
+}
+
+SV_THREAD_FUNCTION StImageTiles::workerThreadFunction(void* theTiles) {
+    StImageTiles* aTiles = (StImageTiles* )theTiles;
+    aTiles->workerLoop();
+    return SV_THREAD_RETURN 0;
+}
+
+void StImageTiles::workerLoop() {
+    StAVScaler aScaler; // reused by all tiles generated by this thread
+    for(;;) {
+        myEventJob.wait();
+        myMutex.lock();
+        if(myToQuit) {
+            myMutex.unlock();
+            return;
+        }
+        if(myPending.empty()) {
+            myEventJob.reset();
+            myMutex.unlock();
+            continue;
+        }
+
+        const StImageTileKey aKey = myPending.front();
+        myPending.erase(myPending.begin());
+        myInProgress.push_back(aKey);
+        myMutex.unlock();
+
+        StImageTile aTile;
+        const bool isGenerated = generate(aKey, aTile, aScaler);
+
+        myMutex.lock();
+        myInProgress.erase(std::find(myInProgress.begin(), myInProgress.end(), aKey));
+        if(isGenerated) {
+            myReady.push_back(aTile);
+        } else {
+            // tiles of the same image would fail the same way - do not retry them
+            myHasFailed = true;
+            myPending.clear();
+        }
+        myMutex.unlock();
+    }
+}
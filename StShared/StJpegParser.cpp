@@ -465,13 +465,12 @@ bool StJpegParser::insertSection(const uint8_t   theMarker,
     const size_t aDiff    = size_t(theSectLen) + 2; // 2 bytes for marker
     const size_t aNewSize = myLength + aDiff;
     if(aNewSize > myBuffSize) {
-        myBuffSize = aNewSize + 256;
-        stUByte_t* aNewData = stMemAllocAligned<stUByte_t*>(myBuffSize);
+        const size_t aNewBuffSize = aNewSize + 256;
+        stUByte_t* aNewData = stMemAllocAligned<stUByte_t*>(aNewBuffSize);
         if(aNewData == NULL) {
             return false;
         }
         stMemCpy(aNewData, myBuffer, myLength);
-        stMemFreeAligned(myBuffer);
 
         // update pointers of image(s) data
         for(StHandle<StJpegParser::Image> anImg = myImages;
@@ -490,7 +489,10 @@ bool StJpegParser::insertSection(const uint8_t   theMarker,
             }
         }
 
-        myBuffer = aNewData;
+        // old buffer might be memory-mapped file
+        freeBuffer();
+        myBuffer   = aNewData;
+        myBuffSize = aNewBuffSize;
     }
     myLength = aNewSize;
 
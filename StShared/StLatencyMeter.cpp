@@ -0,0 +1,247 @@
+/**
+ * Copyright © 2017 Kirill Gavrilov <kirill@sview.ru>
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * See accompanying file license-boost.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt
+ */
+
+#include <StThreads/StLatencyMeter.h>
+
+#include <StFile/StRawFile.h>
+#include <StStrings/stUtfTools.h>
+
+#include <cmath>
+
+namespace {
+
+    /**
+     * Format number with fixed precision.
+     */
+    inline StString formatNumber(const double theValue) {
+        char aBuff[64];
+        stsprintf(aBuff, sizeof(aBuff), "%.3f", theValue);
+        return StString(aBuff);
+    }
+
+    /**
+     * Escape string for CSV.
+     */
+    static StString escapeCsv(const StString& theString) {
+        StString anEscaped = "\"";
+        const char* aStr = theString.toCString();
+        for(size_t aByteIter = 0; aByteIter < theString.getSize(); ++aByteIter) {
+            char aBuff[3] = { aStr[aByteIter], '\0', '\0' };
+            if(aStr[aByteIter] == '\"') {
+                aBuff[1] = '\"';
+            }
+            anEscaped += aBuff;
+        }
+        anEscaped += "\"";
+        return anEscaped;
+    }
+
+}
+
+const char* StLatencyMeter::getStageName(const Stage theStage) {
+    switch(theStage) {
+        case Stage_Demux:   return "demux";
+        case Stage_Decode:  return "decode";
+        case Stage_Convert: return "convert";
+        case Stage_Push:    return "push";
+        case Stage_Upload:  return "upload";
+        case Stage_Swap:    return "swap";
+        case Stage_NB:      break;
+    }
+    return "unknown";
+}
+
+StLatencyMeter::StLatencyMeter()
+: myNbDropped(0),
+  myIsEnabled(false) {
+    reset();
+}
+
+void StLatencyMeter::setEnabled(const bool theToEnable) {
+    if(theToEnable && !myIsEnabled) {
+        reset();
+    }
+    myIsEnabled = theToEnable;
+}
+
+void StLatencyMeter::reset() {
+    myMutex.lock();
+    for(int aStageIter = 0; aStageIter < Stage_NB; ++aStageIter) {
+        Histogram& aHist = myStages[aStageIter];
+        stMemZero(aHist.Buckets, sizeof(aHist.Buckets));
+        aHist.NbSamples = 0;
+        aHist.Sum = 0.0;
+        aHist.Min = 0.0;
+        aHist.Max = 0.0;
+    }
+    myNbDropped = 0;
+    myMutex.unlock();
+}
+
+size_t StLatencyMeter::bucketIndex(const uint64_t theMicroSec) {
+    if(theMicroSec < uint64_t(2 * THE_SUB_BUCKETS)) {
+        return size_t(theMicroSec);
+    }
+
+    size_t anExp = 0;
+    for(uint64_t aValue = theMicroSec >> (THE_SUB_BUCKETS_LOG2 + 1); aValue != 0; aValue >>= 1) {
+        ++anExp;
+    }
+    const size_t anIndex = anExp * THE_SUB_BUCKETS + size_t(theMicroSec >> anExp);
+    return stMin(anIndex, size_t(THE_NB_BUCKETS - 1));
+}
+
+uint64_t StLatencyMeter::bucketLowerBound(const size_t theIndex) {
+    if(theIndex < size_t(2 * THE_SUB_BUCKETS)) {
+        return uint64_t(theIndex);
+    }
+
+    const size_t anExp = theIndex / THE_SUB_BUCKETS - 1;
+    return uint64_t(theIndex - anExp * THE_SUB_BUCKETS) << anExp;
+}
+
+void StLatencyMeter::addSample(const Stage  theStage,
+                               const double theMicroSec) {
+    if(!myIsEnabled
+    || theStage >= Stage_NB) {
+        return;
+    }
+
+    const double   aValue = stMax(theMicroSec, 0.0);
+    const size_t   anIndex = bucketIndex(uint64_t(aValue));
+    Histogram&     aHist  = myStages[theStage];
+    myMutex.lock();
+    ++aHist.Buckets[anIndex];
+    if(aHist.NbSamples == 0) {
+        aHist.Min = aValue;
+        aHist.Max = aValue;
+    } else {
+        aHist.Min = stMin(aHist.Min, aValue);
+        aHist.Max = stMax(aHist.Max, aValue);
+    }
+    ++aHist.NbSamples;
+    aHist.Sum += aValue;
+    myMutex.unlock();
+}
+
+void StLatencyMeter::addDropped(const size_t theNbFrames) {
+    if(!myIsEnabled) {
+        return;
+    }
+
+    myMutex.lock();
+    myNbDropped += theNbFrames;
+    myMutex.unlock();
+}
+
+uint64_t StLatencyMeter::getDropped() const {
+    myMutex.lock();
+    const uint64_t aNbDropped = myNbDropped;
+    myMutex.unlock();
+    return aNbDropped;
+}
+
+double StLatencyMeter::quantile(const Histogram& theHist,
+                                const double     theQuantile) {
+    if(theHist.NbSamples == 0) {
+        return 0.0;
+    }
+
+    const uint64_t aRank = stMax(uint64_t(1), uint64_t(std::ceil(theQuantile * double(theHist.NbSamples))));
+    uint64_t aCumul = 0;
+    for(size_t anIndex = 0; anIndex < size_t(THE_NB_BUCKETS); ++anIndex) {
+        aCumul += theHist.Buckets[anIndex];
+        if(aCumul >= aRank) {
+            // take middle of the bucket, but keep it within measured range
+            const double aLower = double(bucketLowerBound(anIndex));
+            const double anUpper = double(bucketLowerBound(anIndex + 1));
+            const double aValue = 0.5 * (aLower + anUpper);
+            return stMin(stMax(aValue, theHist.Min), theHist.Max);
+        }
+    }
+    return theHist.Max;
+}
+
+StLatencyMeter::Summary StLatencyMeter::getSummary(const Stage theStage) const {
+    Summary aSummary;
+    stMemZero(&aSummary, sizeof(aSummary));
+    if(theStage >= Stage_NB) {
+        return aSummary;
+    }
+
+    myMutex.lock();
+    const Histogram& aHist = myStages[theStage];
+    if(aHist.NbSamples != 0) {
+        aSummary.NbSamples = aHist.NbSamples;
+        aSummary.Min = aHist.Min * 0.001;
+        aSummary.Max = aHist.Max * 0.001;
+        aSummary.Avg = aHist.Sum / double(aHist.NbSamples) * 0.001;
+        aSummary.P50 = quantile(aHist, 0.50) * 0.001;
+        aSummary.P99 = quantile(aHist, 0.99) * 0.001;
+    }
+    myMutex.unlock();
+    return aSummary;
+}
+
+StString StLatencyMeter::formatJson(const StString& theTitle) const {
+    StString aJson = StString()
+        + "{\n"
+        + "  \"title\": \"" + stUtfTools::escapeJson(theTitle) + "\",\n"
+        + "  \"units\": \"ms\",\n"
+        + "  \"dropped\": " + StString(getDropped()) + ",\n"
+        + "  \"stages\": [\n";
+    for(int aStageIter = 0; aStageIter < Stage_NB; ++aStageIter) {
+        const Summary aSummary = getSummary((Stage )aStageIter);
+        aJson = aJson
+            + "    { \"stage\": \"" + getStageName((Stage )aStageIter) + "\""
+            + ", \"count\": " + StString(aSummary.NbSamples)
+            + ", \"min\": "   + formatNumber(aSummary.Min)
+            + ", \"avg\": "   + formatNumber(aSummary.Avg)
+            + ", \"p50\": "   + formatNumber(aSummary.P50)
+            + ", \"p99\": "   + formatNumber(aSummary.P99)
+            + ", \"max\": "   + formatNumber(aSummary.Max)
+            + " }" + (aStageIter + 1 < Stage_NB ? ",\n" : "\n");
+    }
+    aJson += "  ]\n}\n";
+    return aJson;
+}
+
+StString StLatencyMeter::formatCsv(const StString& theTitle) const {
+    const StString aTitle   = escapeCsv(theTitle);
+    const StString aDropped = StString(getDropped());
+    StString aCsv = "title,stage,count,min_ms,avg_ms,p50_ms,p99_ms,max_ms,dropped\n";
+    for(int aStageIter = 0; aStageIter < Stage_NB; ++aStageIter) {
+        const Summary aSummary = getSummary((Stage )aStageIter);
+        aCsv = aCsv
+             + aTitle
+             + "," + getStageName((Stage )aStageIter)
+             + "," + StString(aSummary.NbSamples)
+             + "," + formatNumber(aSummary.Min)
+             + "," + formatNumber(aSummary.Avg)
+             + "," + formatNumber(aSummary.P50)
+             + "," + formatNumber(aSummary.P99)
+             + "," + formatNumber(aSummary.Max)
+             + "," + aDropped
+             + "\n";
+    }
+    return aCsv;
+}
+
+bool StLatencyMeter::saveReport(const StString& thePath,
+                                const StString& theTitle) const {
+    StRawFile aFile;
+    if(thePath.isEmpty()
+    || !aFile.openFile(StRawFile::WRITE, thePath)) {
+        return false;
+    }
+
+    const StString aReport = thePath.isEndsWithIgnoreCase(stCString(".json"))
+                           ? formatJson(theTitle)
+                           : formatCsv (theTitle);
+    return aFile.write(aReport) == aReport.getSize();
+}
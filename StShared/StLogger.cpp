@@ -9,6 +9,7 @@
 #include <StStrings/StLogger.h>
 
 #include <StStrings/stConsole.h>
+#include <StThreads/StCondition.h>
 #include <StThreads/StMutexSlim.h>
 #include <StThreads/StProcess.h>
 #include <StThreads/StThread.h>
@@ -17,6 +18,8 @@
     #include <android/log.h>
 #endif
 
+#include <string>
+
 // we do not use st::cerr here to avoid
 // global static variables initialization ambiguity
 #ifdef _WIN32
@@ -26,6 +29,163 @@
     #define ST_LOG_CERR std::cerr
 #endif
 
+namespace {
+
+    static const size_t THE_LOG_BUFFER_BATCH = 64 * 1024;       //!< buffer size to wake up the writer
+    static const size_t THE_LOG_BUFFER_LIMIT = 4 * 1024 * 1024; //!< buffer size to write the messages within producer thread
+    static const size_t THE_LOG_FLUSH_MS     = 200;             //!< interval for writing incomplete batch
+
+    /**
+     * @return message prefix for specified level
+     */
+    static const char* getLevelPrefix(const StLogger::Level theLevel) {
+        switch(theLevel) {
+            case StLogger::ST_PANIC:   return "PANIC !! ";
+            case StLogger::ST_FATAL:   return "FATAL !! ";
+            case StLogger::ST_ERROR:   return "ERROR !! ";
+            case StLogger::ST_WARNING: return "WARN  -- ";
+            case StLogger::ST_INFO:
+            case StLogger::ST_VERBOSE: return "INFO  -- ";
+            case StLogger::ST_TRACE:   return "TRACE -- ";
+            case StLogger::ST_QUIET:   break;
+        }
+        return "";
+    }
+
+}
+
+/**
+ * Asynchronous log file writer.
+ * Producers only append formatted messages to the memory buffer (under short lock),
+ * while the file is kept opened and written by the background thread in batches.
+ */
+class StLogWriter {
+
+        public:
+
+    /**
+     * Open the file and start the writer thread.
+     */
+#ifdef _WIN32
+    StLogWriter(const StStringUtfWide& theFilePath)
+#else
+    StLogWriter(const StString&        theFilePath)
+#endif
+    : myEvent(false),
+      myFileHandle(NULL),
+      myToQuit(false) {
+    #ifdef _WIN32
+        myFileHandle = _wfopen(theFilePath.toCString(), L"ab");
+    #else
+        myFileHandle =   fopen(theFilePath.toCString(),  "ab");
+    #endif
+        myPending.reserve(THE_LOG_BUFFER_BATCH * 2);
+        myThread = new StThread(writerThreadFunction, (void* )this, "StLogWriter");
+    }
+
+    /**
+     * Stop the writer thread, write pending messages and close the file.
+     */
+    ~StLogWriter() {
+        myToQuit = true;
+        myEvent.set();
+        myThread->wait();
+        myThread.nullify();
+        flush();
+        if(myFileHandle != NULL) {
+            fclose(myFileHandle);
+        }
+    }
+
+    /**
+     * Append the message to the buffer.
+     * @param thePrefix  level prefix
+     * @param theThread  thread id prefix (might be empty)
+     * @param theMessage message text
+     * @param theToFlush write the buffer to the file immediately
+     */
+    void append(const char*     thePrefix,
+                const StString& theThread,
+                const StString& theMessage,
+                const bool      theToFlush) {
+        myBufferLock.lock();
+        const size_t aSizeOld = myPending.size();
+        myPending.append(thePrefix);
+        myPending.append(theThread.toCString(),  theThread.getSize());
+        myPending.append(theMessage.toCString(), theMessage.getSize());
+        myPending.append(1, '\n');
+        const size_t aSizeNew = myPending.size();
+        myBufferLock.unlock();
+
+        if(theToFlush
+        || aSizeNew >= THE_LOG_BUFFER_LIMIT) {
+            flush();
+        } else if(aSizeOld <  THE_LOG_BUFFER_BATCH
+               && aSizeNew >= THE_LOG_BUFFER_BATCH) {
+            myEvent.set();
+        }
+    }
+
+    /**
+     * Write pending messages to the file.
+     */
+    void flush() {
+        myFileLock.lock();
+        myBufferLock.lock();
+        myWriting.swap(myPending);
+        myBufferLock.unlock();
+        if(!myWriting.empty()
+        && myFileHandle != NULL) {
+            fwrite(myWriting.c_str(), 1, myWriting.size(), myFileHandle);
+            fflush(myFileHandle);
+        }
+        myWriting.clear();
+        myFileLock.unlock();
+    }
+
+        private:
+
+    /**
+     * Writer thread loop.
+     */
+    void writerLoop() {
+        for(;;) {
+            myEvent.wait(THE_LOG_FLUSH_MS);
+            myEvent.reset();
+            const bool toQuit = myToQuit;
+            flush();
+            if(toQuit) {
+                return;
+            }
+        }
+    }
+
+    /**
+     * Writer thread function.
+     */
+    static SV_THREAD_FUNCTION writerThreadFunction(void* theWriter) {
+        ((StLogWriter* )theWriter)->writerLoop();
+        return SV_THREAD_RETURN 0;
+    }
+
+        private:
+
+    StMutexSlim        myBufferLock; //!< lock for pending buffer
+    StMutexSlim        myFileLock;   //!< lock for writing into the file
+    StCondition        myEvent;      //!< event to wake up the writer
+    StHandle<StThread> myThread;     //!< writer thread
+    std::string        myPending;    //!< pending messages
+    std::string        myWriting;    //!< messages being written, used under file lock
+    FILE*              myFileHandle; //!< file object, kept opened
+    volatile bool      myToQuit;     //!< flag to stop the writer
+
+        private:
+
+    StLogWriter(const StLogWriter& theCopy);
+    const StLogWriter& operator=(const StLogWriter& theOther);
+
+};
+
 StLogger& StLogger::GetDefault() {
     // global instance
     static StLogger THE_DEFAULT_LOGGER(
@@ -40,6 +200,9 @@ StLogger& StLogger::GetDefault() {
         StLogger::ST_VERBOSE,
     #endif
         StLogger::ST_OPT_COUT | StLogger::ST_OPT_LOCK
+    #if defined(ST_DEBUG_LOG_TO_FILE) && defined(ST_DEBUG) && !defined(_WIN32)
+      | StLogger::ST_OPT_ASYNC
+    #endif
     );
     return THE_DEFAULT_LOGGER;
 }
@@ -80,11 +243,15 @@ StLogger::StLogger(const StString&       theLogFile,
   myToLogThreadId(false)
 #endif
 {
-    //
+    if((theOptions & StLogger::ST_OPT_ASYNC) != 0
+    && !myFilePath.isEmpty()) {
+        myWriter = new StLogWriter(myFilePath);
+    }
 }
 
 StLogger::~StLogger() {
-    //
+    // stop the writer and flush pending messages
+    myWriter.nullify();
 }
 
 void StLogger::write(const StString&       theMessage,
@@ -95,29 +262,36 @@ void StLogger::write(const StString&       theMessage,
         return;
     }
 
+    // log to the file asynchronously (without global lock)
+    if(!myWriter.isNull()) {
+        StString aThreadStr;
+        if(myToLogThreadId) {
+            const size_t aThreadId = StThread::getCurrentThreadId();
+            aThreadStr = StString("[") + aThreadId + "]";
+        }
+        myWriter->append(getLevelPrefix(theLevel), aThreadStr, theMessage, theLevel <= ST_ERROR);
+        if(!myToLogCout
+        && !myToLogToSystem) {
+            return;
+        }
+    }
+
     // lock for safety
     if(!myMutex.isNull()) {
         myMutex->lock();
     }
 
     // log to the file
-    if(!myFilePath.isEmpty()) {
+    if(!myFilePath.isEmpty()
+    &&  myWriter.isNull()) {
     #ifdef _WIN32
         myFileHandle = _wfopen(myFilePath.toCString(), L"ab");
     #else
         myFileHandle =   fopen(myFilePath.toCString(),  "ab");
     #endif
         if(myFileHandle != NULL) {
-            switch(theLevel) {
-                case ST_PANIC:   fwrite("PANIC !! ", 1, 9, myFileHandle); break;
-                case ST_FATAL:   fwrite("FATAL !! ", 1, 9, myFileHandle); break;
-                case ST_ERROR:   fwrite("ERROR !! ", 1, 9, myFileHandle); break;
-                case ST_WARNING: fwrite("WARN  -- ", 1, 9, myFileHandle); break;
-                case ST_INFO:
-                case ST_VERBOSE: fwrite("INFO  -- ", 1, 9, myFileHandle); break;
-                case ST_TRACE:   fwrite("TRACE -- ", 1, 9, myFileHandle); break;
-                case ST_QUIET: break;
-            }
+            const char* aPrefix = getLevelPrefix(theLevel);
+            fwrite(aPrefix, 1, std::strlen(aPrefix), myFileHandle);
             if(myToLogThreadId) {
                 const size_t   aThreadId  = StThread::getCurrentThreadId();
                 const StString aThreadStr = StString("[") + aThreadId + "]";
@@ -1,5 +1,5 @@
 /**
- * Copyright © 2009-2015 Kirill Gavrilov <kirill@sview.ru>
+ * Copyright © 2009-2017 Kirill Gavrilov <kirill@sview.ru>
  *
  * Distributed under the Boost Software License, Version 1.0.
  * See accompanying file license-boost.txt or copy at
@@ -8,6 +8,7 @@
 
 #include <StGL/StPlayList.h>
 
+#include <StFile/StFolderScanQueue.h>
 #include <StFile/StRawFile.h>
 #include <StThreads/StProcess.h>
 
@@ -19,51 +20,14 @@ namespace {
 
 StPlayItem::StPlayItem(StFileNode* theFileNode,
                        const StStereoParams& theDefParams)
-: myPrevItem(NULL),
-  myNextItem(NULL),
-  myPosition(0),
+: myPosition(0),
   myFileNode(theFileNode),
-  myStParams(new StStereoParams(theDefParams)),
-  myPlayFlag(false) {
+  myStParams(new StStereoParams(theDefParams)) {
     //
 }
 
 StPlayItem::~StPlayItem() {
-    if(myPrevItem != NULL) {
-        myPrevItem->setNext(myNextItem);
-    } else if(myNextItem != NULL) {
-        myNextItem->setPrev(NULL);
-    }
-}
-
-void StPlayItem::setPrev(StPlayItem* thePrev) {
-    if(myPrevItem == thePrev) {
-        return;
-    }
-    if(myPrevItem != NULL) {
-        // silently remove self
-        myPrevItem->myNextItem = NULL;
-    }
-    myPrevItem = thePrev;
-    if(thePrev != NULL) {
-        // set self as next item
-        thePrev->setNext(this);
-    }
-}
-
-void StPlayItem::setNext(StPlayItem* theNext) {
-    if(myNextItem == theNext) {
-        return;
-    }
-    if(myNextItem != NULL) {
-        // silently remove self
-        myNextItem->myPrevItem = NULL;
-    }
-    myNextItem = theNext;
-    if(theNext != NULL) {
-        // set self as previous item
-        theNext->setPrev(this);
-    }
+    //
 }
 
 StString StPlayItem::getPath() const {
@@ -100,46 +64,70 @@ void StPlayItem::setTitle(const StString& theTitle) {
 }
 
 void StPlayList::addPlayItem(StPlayItem* theNewItem) {
-    if(myFirst == NULL) {
-        myFirst = myLast = myCurrent = theNewItem;
-    } else {
-        myLast->setNext(theNewItem);
-        myLast = theNewItem;
+    if(myItems.isEmpty()) {
+        myCurrent = theNewItem;
     }
-    theNewItem->setPosition(myItemsCount++);
+    theNewItem->setPosition(myItems.size());
+    myItems.add(theNewItem);
+    myShuffleOrder.clear();
 }
 
 void StPlayList::delPlayItem(StPlayItem* theRemItem) {
-    if(myFirst == NULL || theRemItem == NULL) {
+    if(theRemItem == NULL
+    || theRemItem->getPosition() >= myItems.size()
+    || myItems[theRemItem->getPosition()] != theRemItem) {
         // item does not exists in the list
         return;
     }
 
-    // update first/last items
-    if(theRemItem == myLast) {
-        myLast  = myLast->hasPrev()  ? myLast->getPrev()  : NULL;
-    }
-    if(myFirst == theRemItem) {
-        myFirst = myFirst->hasNext() ? myFirst->getNext() : NULL;
-    }
-
     // reset enumeration
-    size_t aPosId = theRemItem->getPosition();
-    for(StPlayItem* anIter = theRemItem->getNext(); anIter != NULL; ++aPosId, anIter = anIter->getNext()) {
-        anIter->setPosition(aPosId);
-    }
-
-    if(theRemItem->hasPrev()) {
-        // connect previous and next items
-        theRemItem->getPrev()->setNext(theRemItem->getNext());
-    } else if(theRemItem->hasNext()) {
-        theRemItem->getNext()->setPrev(NULL);
+    const size_t aRemPos = theRemItem->getPosition();
+    myItems.remove(aRemPos);
+    for(size_t aPosId = aRemPos; aPosId < myItems.size(); ++aPosId) {
+        myItems.changeValue(aPosId)->setPosition(aPosId);
     }
 
     myStackPrev.clear();
     myStackNext.clear();
+    myShuffleOrder.clear();
+}
 
-    --myItemsCount;
+void StPlayList::shuffleItems() {
+#ifdef _WIN32
+    FILETIME aTime;
+    GetSystemTimeAsFileTime(&aTime);
+    myRandGen.setSeed(aTime.dwLowDateTime);
+#else
+    timeval aTime;
+    gettimeofday(&aTime, NULL);
+    myRandGen.setSeed(aTime.tv_usec);
+#endif
+
+    const size_t anItemsCount = myItems.size();
+    myShuffleOrder.clear();
+    myShuffleOrder.initList(anItemsCount);
+    for(size_t aPosId = 0; aPosId < anItemsCount; ++aPosId) {
+        myShuffleOrder.add(aPosId);
+    }
+    for(size_t aPosId = anItemsCount - 1; aPosId > 0; --aPosId) {
+        const size_t aSwapId = stMin(size_t(myRandGen.next() * (aPosId + 1)), aPosId);
+        const size_t aTmp = myShuffleOrder[aPosId];
+        myShuffleOrder.changeValue(aPosId)  = myShuffleOrder[aSwapId];
+        myShuffleOrder.changeValue(aSwapId) = aTmp;
+    }
+
+    // put current item at the beginning
+    myShuffleIter = 0;
+    if(myCurrent != NULL) {
+        for(size_t aPosId = 0; aPosId < anItemsCount; ++aPosId) {
+            if(myShuffleOrder[aPosId] == myCurrent->getPosition()) {
+                myShuffleOrder.changeValue(aPosId) = myShuffleOrder[0];
+                myShuffleOrder.changeValue(0)      = myCurrent->getPosition();
+                break;
+            }
+        }
+    }
+    ST_DEBUG_LOG("Restart the shuffle");
 }
 
 void StPlayList::addToPlayList(StFileNode* theFileNode) {
@@ -153,21 +141,144 @@ void StPlayList::addToPlayList(StFileNode* theFileNode) {
     }
 }
 
+void StPlayList::addScannedNode(StFileNode* theFileNode) {
+    if(theFileNode->isFolder()) {
+        for(size_t aNodeId = 0; aNodeId < theFileNode->size(); ++aNodeId) {
+            addScannedNode(theFileNode->changeValue(aNodeId));
+        }
+        return;
+    }
+
+    if(myScanTarget.isEmpty()
+    || theFileNode->getPath() != myScanTarget) {
+        addPlayItem(new StPlayItem(theFileNode, myDefStParams));
+        return;
+    }
+
+    // reuse item added before scanning to keep its parameters
+    StPlayItem* anItem = NULL;
+    for(size_t anIter = 0; anIter < myItems.size(); ++anIter) {
+        if(myItems[anIter]->getPath() == myScanTarget) {
+            anItem = myItems[anIter];
+            delPlayItem(anItem);
+            break;
+        }
+    }
+    if(anItem == NULL) {
+        // file opened with remembered target item, while opened file without target has been added by open()
+        anItem = new StPlayItem(theFileNode, myDefStParams);
+        if(myPlsFile.isNull()) {
+            addRecentFile(*theFileNode); // append to recent files list
+        }
+    }
+    addPlayItem(anItem);
+    myCurrent = anItem;
+    myScanTarget.clear();
+}
+
+void StPlayList::publishScanned(StFileNode*  theFolder,
+                                const size_t theFrom,
+                                const int    theGen) {
+    StMutexAuto anAutoLock(myMutex);
+    if(myScanGen != theGen) {
+        return;
+    }
+
+    const size_t aNbItemsOld = myItems.size();
+    for(size_t aNodeId = theFrom; aNodeId < theFolder->size(); ++aNodeId) {
+        addScannedNode(theFolder->changeValue(aNodeId));
+    }
+    if(myItems.size() == aNbItemsOld) {
+        return;
+    }
+
+    mySerial.increment();
+    if(myScanTarget.isEmpty()) {
+        myScanFirstEvent.set();
+    }
+    anAutoLock.unlock();
+    signals.onPlaylistChange();
+}
+
+SV_THREAD_FUNCTION StPlayList::scanThreadFunction(void* thePlayList) {
+    ((StPlayList* )thePlayList)->scanLoop();
+    return SV_THREAD_RETURN 0;
+}
+
+void StPlayList::scanLoop() {
+    for(;;) {
+        myScanEvent.wait();
+        myMutex.lock();
+        if(myToQuitScan) {
+            myMutex.unlock();
+            return;
+        }
+
+        myScanEvent.reset();
+        if(!myHasScanJob) {
+            myMutex.unlock();
+            continue;
+        }
+        myHasScanJob = false;
+        StFolder* aFolder = myScanFolder;
+        const StArrayList<StString> anExtensions = myExtensions;
+        const int aDeep = myScanDeep;
+        const int aGen  = myScanGen;
+        myMutex.unlock();
+
+        // read the folder itself, and then subfolders one by one in sorted order,
+        // so that the first items can be added to the list before the whole tree is read;
+        // the same pool of threads is used for all subfolders
+        StHandle<StFolderScanQueue> aQueue;
+        if(aDeep > 2) {
+            aQueue = new StFolderScanQueue(anExtensions, stMax(StThread::countLogicalProcessors(), 2));
+        }
+        aFolder->init(anExtensions, 1, aDeep > 1);
+        for(size_t aNodeId = 0; aNodeId < aFolder->size() && myScanGen == aGen; ++aNodeId) {
+            StFileNode* aNode = aFolder->changeValue(aNodeId);
+            if(!aNode->isFolder()) {
+                // files are sorted after subfolders
+                publishScanned(aFolder, aNodeId, aGen);
+                break;
+            }
+
+            if(!aQueue.isNull()) {
+                ((StFolder* )aNode)->init(*aQueue, aDeep - 1);
+            } else {
+                ((StFolder* )aNode)->init(anExtensions, aDeep - 1);
+            }
+            publishScanned(aNode, 0, aGen);
+        }
+
+        myMutex.lock();
+        if(myScanGen == aGen) {
+            myScanFolder = NULL;
+            myScanTarget.clear();
+            myScanFirstEvent.set();
+        }
+        myMutex.unlock();
+    }
+}
+
 StPlayList::StPlayList(const int  theRecursionDeep,
                        const bool theIsLoop)
-: myFirst(NULL),
-  myLast(NULL),
-  myCurrent(NULL),
-  myItemsCount(0),
+: myCurrent(NULL),
   myDefStParams(),
-  myPlayedCount(0),
+  myShuffleIter(0),
   myRecursionDeep(theRecursionDeep),
   myIsShuffle(false),
   myToLoopSingle(false),
   myIsLoopFlag(theIsLoop),
   myRecentLimit(10),
   myIsNewRecent(false),
-  myWasCleared(false) {
+  myWasCleared(false),
+  myScanEvent(false),
+  myScanFirstEvent(true),
+  myScanFolder(NULL),
+  myScanDeep(1),
+  myScanGen(0),
+  myHasScanJob(false),
+  myToQuitScan(false) {
     //
 }
 
@@ -182,6 +293,16 @@ void StPlayList::setExtensions(const StArrayList<StString>& theExtensions) {
 }
 
 StPlayList::~StPlayList() {
+    if(!myScanThread.isNull()) {
+        myMutex.lock();
+        myToQuitScan = true;
+        ++myScanGen;
+        myMutex.unlock();
+        myScanEvent.set();
+        myScanThread->wait();
+        myScanThread.nullify();
+    }
+
     signals.onTitleChange.disconnect();
     signals.onPositionChange.disconnect();
     signals.onPlaylistChange.disconnect();
@@ -216,7 +337,7 @@ void StPlayList::setShuffle(bool theShuffle) {
 int32_t StPlayList::getSerial() {
     StMutexAuto anAutoLock(myMutex);
     if(myWasCleared
-    && myFirst != NULL) {
+    && !myItems.isEmpty()) {
         myWasCleared = false;
         mySerial.increment();
     }
@@ -225,11 +346,18 @@ int32_t StPlayList::getSerial() {
 
 void StPlayList::clear() {
     StMutexAuto anAutoLock(myMutex);
-    if(myFirst != NULL) {
+    if(!myItems.isEmpty()) {
         myWasCleared = true;
         mySerial.increment();
     }
 
+    // cancel folder scanning
+    ++myScanGen;
+    myHasScanJob = false;
+    myScanFolder = NULL;
+    myScanTarget.clear();
+    myScanFirstEvent.set();
+
     if(!myPlsFile.isNull()
     && myCurrent != NULL) {
         if(myPlsFile->File->isEmpty()) {
@@ -240,16 +368,16 @@ void StPlayList::clear() {
     }
     myPlsFile.nullify();
 
-    // destroy double-linked list content
-    for(StPlayItem *anItem(myFirst), *anItemToDel(NULL); anItem != NULL;) {
-        anItemToDel = anItem;
-        anItem = anItem->getNext();
-        delete anItemToDel;
+    // destroy list content
+    for(size_t anIter = 0; anIter < myItems.size(); ++anIter) {
+        delete myItems[anIter];
     }
+    myItems.clear();
     myStackPrev.clear();
     myStackNext.clear();
-    myFirst = myLast = myCurrent = NULL;
-    myItemsCount = myPlayedCount = 0;
+    myShuffleOrder.clear();
+    myShuffleIter = 0;
+    myCurrent = NULL;
 
     anAutoLock.unlock();
     signals.onPlaylistChange();
@@ -264,12 +392,12 @@ StPlayList::CurrentPosition StPlayList::getCurrentPosition() const {
     StMutexAuto anAutoLock(myMutex);
     if(myCurrent == NULL) {
         return CurrentPosition_NONE;
-    } else if(myCurrent == myFirst) {
-        if(myCurrent == myLast) {
+    } else if(myCurrent == getFirstItem()) {
+        if(myCurrent == getLastItem()) {
             return CurrentPosition_Single;
         }
         return CurrentPosition_First;
-    } else if(myCurrent == myLast) {
+    } else if(myCurrent == getLastItem()) {
         return CurrentPosition_Last;
     }
     return CurrentPosition_Middle;
@@ -282,36 +410,33 @@ StString StPlayList::getCurrentTitle() const {
 
 bool StPlayList::walkToPosition(const size_t theId) {
     StMutexAuto anAutoLock(myMutex);
+    if(theId >= myItems.size()) {
+        return false;
+    }
 
-    size_t anIter = 0;
-    for(StPlayItem* anItem = myFirst; anItem != NULL; anItem = anItem->getNext(), ++anIter) {
-        if(anIter == theId) {
-            if(myCurrent == anItem) {
-                return false;
-            }
-
-            StPlayItem* aPrev = myCurrent;
-            if(aPrev != NULL) {
-                myStackPrev.push_back(aPrev);
-                if(myStackPrev.size() > THE_UNDO_LIMIT) {
-                    myStackPrev.pop_front();
-                }
-            }
+    StPlayItem* anItem = myItems[theId];
+    if(myCurrent == anItem) {
+        return false;
+    }
 
-            myCurrent = anItem;
-            anAutoLock.unlock();
-            signals.onPositionChange(theId);
-            return true;
+    StPlayItem* aPrev = myCurrent;
+    if(aPrev != NULL) {
+        myStackPrev.push_back(aPrev);
+        if(myStackPrev.size() > THE_UNDO_LIMIT) {
+            myStackPrev.pop_front();
         }
     }
 
-    return false;
+    myCurrent = anItem;
+    anAutoLock.unlock();
+    signals.onPositionChange(theId);
+    return true;
 }
 
 bool StPlayList::walkToFirst() {
     StMutexAuto anAutoLock(myMutex);
-    bool wasntFirst = (myCurrent != myFirst);
-    myCurrent = myFirst;
+    bool wasntFirst = (myCurrent != getFirstItem());
+    myCurrent = getFirstItem();
     if(wasntFirst) {
         myStackPrev.clear();
         myStackNext.clear();
@@ -323,8 +448,8 @@ bool StPlayList::walkToFirst() {
 
 bool StPlayList::walkToLast() {
     StMutexAuto anAutoLock(myMutex);
-    bool wasntLast = (myCurrent != myLast);
-    myCurrent = myLast;
+    bool wasntLast = (myCurrent != getLastItem());
+    myCurrent = getLastItem();
     if(wasntLast) {
         myStackPrev.clear();
         myStackNext.clear();
@@ -339,13 +464,18 @@ bool StPlayList::walkToPrev() {
     StMutexAuto anAutoLock(myMutex);
     if(myCurrent == NULL) {
         return false;
-    } else if(myIsShuffle && myItemsCount >= 3) {
+    } else if(myIsShuffle && myItems.size() >= 3) {
         StPlayItem* aNext = myCurrent;
         if(!myStackPrev.empty()) {
             myCurrent = myStackPrev.back();
             myStackPrev.pop_back();
-        } else if(myCurrent != myFirst) {
-            myCurrent = myCurrent->getPrev();
+        } else if(myShuffleIter > 0
+               && myShuffleIter < myShuffleOrder.size()
+               && myItems[myShuffleOrder[myShuffleIter]] == myCurrent) {
+            // walk back within the shuffle permutation
+            myCurrent = myItems[myShuffleOrder[--myShuffleIter]];
+        } else if(myCurrent != getFirstItem()) {
+            myCurrent = myItems[myCurrent->getPosition() - 1];
         } else {
             aNext = NULL;
         }
@@ -362,8 +492,8 @@ bool StPlayList::walkToPrev() {
             return true;
         }
         return false;
-    } else if(myCurrent != myFirst) {
-        myCurrent = myCurrent->getPrev();
+    } else if(myCurrent != getFirstItem()) {
+        myCurrent = myItems[myCurrent->getPosition() - 1];
         const size_t anItemId = myCurrent->getPosition();
         anAutoLock.unlock();
         signals.onPositionChange(anItemId);
@@ -379,77 +509,30 @@ bool StPlayList::walkToNext(const bool theToForce) {
     if(myCurrent == NULL
     || (myToLoopSingle && !theToForce)) {
         return false;
-    } else if(myIsShuffle && myItemsCount >= 3) {
+    } else if(myIsShuffle && myItems.size() >= 3) {
         StPlayItem* aPrev = myCurrent;
         if(!myStackNext.empty()) {
             myCurrent = myStackNext.front();
             myStackNext.pop_front();
         } else {
-            if((myPlayedCount >= (myItemsCount - 1)) || (myPlayedCount == 0)) {
-                // reset the playback counter
-            #ifdef _WIN32
-                FILETIME aTime;
-                GetSystemTimeAsFileTime(&aTime);
-                myRandGen.setSeed(aTime.dwLowDateTime);
-            #else
-                timeval aTime;
-                gettimeofday(&aTime, NULL);
-                myRandGen.setSeed(aTime.tv_usec);
-            #endif
-                myPlayedCount = 0;
-                myCurrent->setPlayedFlag(!myCurrent->getPlayedFlag());
-                ST_DEBUG_LOG("Restart the shuffle");
+            // take next item from the shuffle permutation,
+            // generate new permutation when all items have been played
+            if(myShuffleOrder.size() != myItems.size()) {
+                shuffleItems();
             }
-
-            // determine next random position
-            const size_t aCurrPos  = myCurrent->getPosition();
-            bool         aCurrFlag = myCurrent->getPlayedFlag();
-            StPlayItem*  aNextItem = myCurrent;
-            const size_t aNextPos  = stMin(size_t(myRandGen.next() * myItemsCount), myItemsCount - 1);
-            if(aNextPos > aCurrPos) {
-                // forward direction
-                for(size_t aNextDiff = aNextPos - aCurrPos; aNextItem != NULL && aNextDiff != 0; --aNextDiff) {
-                    aNextItem = aNextItem->getNext();
-                }
-            } else {
-                // backward direction
-                for(size_t aNextDiff = aCurrPos - aNextPos; aNextItem != NULL && aNextDiff != 0; --aNextDiff) {
-                    aNextItem = aNextItem->getPrev();
-                }
+            if(++myShuffleIter >= myShuffleOrder.size()) {
+                shuffleItems();
+                myShuffleIter = 1;
             }
-            if(aCurrFlag == aNextItem->getPlayedFlag()) {
-                // find nearest position not yet played - prefer item farther from current one
-                StPlayItem* aNextItem1 = aNextPos > aCurrPos ? aNextItem->getNext() : aNextItem->getPrev();
-                StPlayItem* aNextItem2 = aNextPos > aCurrPos ? aNextItem->getPrev() : aNextItem->getNext();
-                for(; aNextItem1 != NULL || aNextItem2 != NULL;) {
-                    if(aNextItem1 != NULL) {
-                        if(aCurrFlag != aNextItem1->getPlayedFlag()) {
-                            aNextItem = aNextItem1;
-                            break;
-                        }
-                        aNextItem1 = aNextPos > aCurrPos ? aNextItem1->getNext() : aNextItem1->getPrev();
-                    }
-                    if(aNextItem2 != NULL) {
-                        if(aCurrFlag != aNextItem2->getPlayedFlag()) {
-                            aNextItem = aNextItem2;
-                            break;
-                        }
-                        aNextItem2 = aNextPos > aCurrPos ? aNextItem2->getPrev() : aNextItem2->getNext();
-                    }
-                }
-                if(aCurrFlag == aNextItem->getPlayedFlag()) {
-                    // something wrong!
-                    ST_DEBUG_LOG("Disaster - next shuffle position not found!");
-                    aCurrFlag     = !aCurrFlag;
-                    myPlayedCount = 0;
+            if(myItems[myShuffleOrder[myShuffleIter]] == myCurrent) {
+                // current item has been chosen explicitly - skip it
+                if(++myShuffleIter >= myShuffleOrder.size()) {
+                    shuffleItems();
+                    myShuffleIter = 1;
                 }
             }
 
-            ST_DEBUG_LOG(aCurrPos + " -> " + aNextItem->getPosition());
-            ++myPlayedCount;
-
-            aNextItem->setPlayedFlag(aCurrFlag);
-            myCurrent = aNextItem;
+            myCurrent = myItems[myShuffleOrder[myShuffleIter]];
         }
 
         if(aPrev != myCurrent
@@ -464,8 +547,8 @@ bool StPlayList::walkToNext(const bool theToForce) {
         anAutoLock.unlock();
         signals.onPositionChange(anItemId);
         return true;
-    } else if(myCurrent != myLast) {
-        myCurrent = myCurrent->getNext();
+    } else if(myCurrent != getLastItem()) {
+        myCurrent = myItems[myCurrent->getPosition() + 1];
         const size_t anItemId = myCurrent->getPosition();
         anAutoLock.unlock();
         signals.onPositionChange(anItemId);
@@ -532,6 +615,115 @@ bool StPlayList::getCurrentFile(StHandle<StFileNode>&     theFileNode,
     return true;
 }
 
+void StPlayList::getNeighbourFiles(const size_t                         theRadius,
+                                   std::vector< StHandle<StFileNode> >& theFiles) {
+    theFiles.clear();
+    StMutexAuto anAutoLock(myMutex);
+    if(myCurrent == NULL) {
+        return;
+    }
+
+    StArrayList<StPlayItem*> aNextItems(theRadius), aPrevItems(theRadius);
+    const size_t anItemsCount = myItems.size();
+    if(myIsShuffle && anItemsCount >= 3) {
+        for(std::deque<StPlayItem*>::const_iterator anIter = myStackNext.begin();
+            anIter != myStackNext.end() && aNextItems.size() < theRadius; ++anIter) {
+            aNextItems.add(*anIter);
+        }
+        if(aNextItems.size() < theRadius) {
+            // generate permutation in advance - walkToNext() would do the same
+            if(myShuffleOrder.size() != anItemsCount) {
+                shuffleItems();
+            }
+            for(size_t anIter = myShuffleIter + 1; anIter < anItemsCount && aNextItems.size() < theRadius; ++anIter) {
+                StPlayItem* anItem = myItems[myShuffleOrder[anIter]];
+                if(anItem != myCurrent) {
+                    aNextItems.add(anItem);
+                }
+            }
+        }
+        for(std::deque<StPlayItem*>::const_reverse_iterator anIter = myStackPrev.rbegin();
+            anIter != myStackPrev.rend() && aPrevItems.size() < theRadius; ++anIter) {
+            aPrevItems.add(*anIter);
+        }
+    } else {
+        const size_t aCurrPos = myCurrent->getPosition();
+        for(size_t aDist = 1; aDist <= theRadius && aDist < anItemsCount; ++aDist) {
+            if(aCurrPos + aDist < anItemsCount) {
+                aNextItems.add(myItems[aCurrPos + aDist]);
+            } else if(myIsLoopFlag) {
+                aNextItems.add(myItems[(aCurrPos + aDist) % anItemsCount]);
+            }
+            if(aCurrPos >= aDist) {
+                aPrevItems.add(myItems[aCurrPos - aDist]);
+            } else if(myIsLoopFlag) {
+                aPrevItems.add(myItems[aCurrPos + anItemsCount - aDist]);
+            }
+        }
+    }
+
+    for(size_t anIter = 0; anIter < theRadius; ++anIter) {
+        StPlayItem* anItems[2] = {
+            anIter < aNextItems.size() ? aNextItems[anIter] : NULL,
+            anIter < aPrevItems.size() ? aPrevItems[anIter] : NULL
+        };
+        for(size_t aDirIter = 0; aDirIter < 2; ++aDirIter) {
+            StPlayItem* anItem = anItems[aDirIter];
+            if(anItem == NULL
+            || anItem == myCurrent
+            || anItem->getFileNode() == NULL) {
+                continue;
+            }
+            theFiles.push_back(anItem->getFileNode()->detach());
+        }
+    }
+}
+
+bool StPlayList::getNextFile(StHandle<StFileNode>& theFileNode) {
+    theFileNode.nullify();
+    StMutexAuto anAutoLock(myMutex);
+    if(myCurrent == NULL) {
+        return false;
+    }
+
+    // should follow walkToNext(false) logic
+    StPlayItem* aNextItem = NULL;
+    const size_t anItemsCount = myItems.size();
+    if(myToLoopSingle) {
+        // the same item is played again - it is already opened
+        return false;
+    } else if(myIsShuffle && anItemsCount >= 3) {
+        if(!myStackNext.empty()) {
+            aNextItem = myStackNext.front();
+        } else {
+            if(myShuffleOrder.size() != anItemsCount) {
+                shuffleItems();
+            }
+            size_t aShuffleIter = myShuffleIter + 1;
+            if(aShuffleIter < anItemsCount
+            && myItems[myShuffleOrder[aShuffleIter]] == myCurrent) {
+                ++aShuffleIter;
+            }
+            // new permutation will be generated at the end - the next item is unknown yet
+            if(aShuffleIter < anItemsCount) {
+                aNextItem = myItems[myShuffleOrder[aShuffleIter]];
+            }
+        }
+    } else if(myCurrent != getLastItem()) {
+        aNextItem = myItems[myCurrent->getPosition() + 1];
+    } else if(myIsLoopFlag) {
+        aNextItem = getFirstItem();
+    }
+
+    if(aNextItem == NULL
+    || aNextItem == myCurrent
+    || aNextItem->getFileNode() == NULL) {
+        return false;
+    }
+    theFileNode = aNextItem->getFileNode()->detach();
+    return true;
+}
+
 void StPlayList::addToNode(const StHandle<StFileNode>& theFileNode,
                            const StString&             thePathToAdd) {
     StString aPath = theFileNode->getPath();
@@ -539,9 +731,9 @@ void StPlayList::addToNode(const StHandle<StFileNode>& theFileNode,
     if(myCurrent == NULL) {
         return;
     } else if(aPath != myCurrent->getPath()) {
-        for(StPlayItem* anItem = myFirst; anItem != NULL; anItem = anItem->getNext()) {
-            if(aPath == anItem->getPath()) {
-                myCurrent = anItem;
+        for(size_t anIter = 0; anIter < myItems.size(); ++anIter) {
+            if(aPath == myItems[anIter]->getPath()) {
+                myCurrent = myItems[anIter];
                 break;
             }
         }
@@ -567,33 +759,22 @@ bool StPlayList::remove(const StString& thePath,
         return false;
     } else if(aPath != myCurrent->getPath()) {
         // search play item
-        for(StPlayItem* anItem = myFirst; anItem != NULL; anItem = anItem->getNext()) {
-            if(aPath == anItem->getPath()) {
-                aRemItem = anItem;
+        for(size_t anIter = 0; anIter < myItems.size(); ++anIter) {
+            if(aPath == myItems[anIter]->getPath()) {
+                aRemItem = myItems[anIter];
                 break;
             }
         }
     } else {
         // walk to another playlist position
         aRemItem = myCurrent;
-        const bool aPlayedFlag = aRemItem->getPlayedFlag();
-        if(myCurrent->hasNext()) {
-            myCurrent = myCurrent->getNext();
-        } else if(myCurrent->hasPrev()) {
-            myCurrent = myCurrent->getPrev();
+        const size_t aCurrPos = myCurrent->getPosition();
+        if(aCurrPos + 1 < myItems.size()) {
+            myCurrent = myItems[aCurrPos + 1];
+        } else if(aCurrPos > 0) {
+            myCurrent = myItems[aCurrPos - 1];
         } else {
-            myCurrent     = NULL;
-            myPlayedCount = 0;
-        }
-
-        if(myCurrent != NULL) {
-            if(myCurrent->getPlayedFlag() != aPlayedFlag) {
-                // the item has not been played yet - mark it as such
-                myCurrent->setPlayedFlag(aPlayedFlag);
-            } else {
-                // one played item has been removed
-                --myPlayedCount;
-            }
+            myCurrent = NULL;
         }
     }
 
@@ -731,7 +912,8 @@ bool StPlayList::saveM3U(const StCString& thePath) {
     StMutexAuto anAutoLock(myMutex);
     aFile.write(stCString("#EXTM3U"));
 
-    for(StPlayItem* anItem = myFirst; anItem != NULL; anItem = anItem->getNext()) {
+    for(size_t anIter = 0; anIter < myItems.size(); ++anIter) {
+        StPlayItem* anItem = myItems[anIter];
         const StFileNode* aNode = anItem->getFileNode();
         if(aNode == NULL) {
             continue;
@@ -754,24 +936,9 @@ void StPlayList::getSubList(StArrayList<StString>& theList,
     theList.clear();
     StMutexAuto anAutoLock(myMutex);
 
-    size_t anIter = 0;
-    StPlayItem* anItem = myFirst;
-    for(; anItem != NULL; anItem = anItem->getNext(), ++anIter) {
-        if(anIter == theStart) {
-            break;
-        }
-    }
-
-    if(anIter != theStart) {
-        return;
-    }
-
-    for(; anItem != NULL; anItem = anItem->getNext(), ++anIter) {
-        if(anIter == theEnd) {
-            break;
-        }
-
-        theList.add(anItem->getTitle());
+    const size_t anEnd = stMin(theEnd, myItems.size());
+    for(size_t anIter = theStart; anIter < anEnd; ++anIter) {
+        theList.add(myItems[anIter]->getTitle());
     }
 }
 
@@ -1078,9 +1245,8 @@ void StPlayList::open(const StCString& thePath,
                 }
                 aRawFile.nullify();
 
-                if(myFirst != nullptr
-                && myFirst->getNext() == nullptr) {
-                    const StString aFirstPath = myFirst->getPath();
+                if(myItems.size() == 1) {
+                    const StString aFirstPath = myItems.getFirst()->getPath();
                     StString anItemExt = StFileNode::getExtension(aFirstPath);
                     if(anItemExt.isEqualsIgnoreCase(stCString("m3u"))
                     || anItemExt.isEqualsIgnoreCase(stCString("m3u8"))) {
@@ -1098,9 +1264,9 @@ void StPlayList::open(const StCString& thePath,
                 myPlsFile = addRecentFile(StFileNode(thePath)); // append to recent files list
                 if(hasTarget) {
                     // set current item
-                    for(StPlayItem* anItem = myFirst; anItem != NULL; anItem = anItem->getNext()) {
-                        if(anItem->getPath() == aTarget) {
-                            myCurrent = anItem;
+                    for(size_t anIter = 0; anIter < myItems.size(); ++anIter) {
+                        if(myItems[anIter]->getPath() == aTarget) {
+                            myCurrent = myItems[anIter];
                             break;
                         }
                     }
@@ -1117,6 +1283,16 @@ void StPlayList::open(const StCString& thePath,
             StFileNode* aFileNode = new StFileNode(thePath, &myFoldersRoot);
             myFoldersRoot.add(aFileNode);
             addPlayItem(new StPlayItem(aFileNode, myDefStParams));
+            if(!hasTarget) {
+                addRecentFile(*aFileNode); // append to recent files list
+            }
+        } else if(!hasTarget) {
+            // add opened file immediately, the rest of the folder is read in background
+            StFileNode* aFileNode = new StFileNode(thePath, &myFoldersRoot);
+            myFoldersRoot.add(aFileNode);
+            addPlayItem(new StPlayItem(aFileNode, myDefStParams));
+            addRecentFile(*aFileNode); // append to recent files list
+            myScanTarget = thePath;
         }
     } else {
         // not a filesystem element - probably url or invalid path
@@ -1129,26 +1305,29 @@ void StPlayList::open(const StCString& thePath,
         signals.onPlaylistChange();
         return;
     }
+    // read the folder in background
     StFolder* aSubFolder = new StFolder(aFolderPath, &myFoldersRoot);
-    aSubFolder->init(myExtensions, aSearchDeep);
     myFoldersRoot.add(aSubFolder);
-
-    addToPlayList(aSubFolder);
-
-    myCurrent = myFirst;
-    if(hasTarget || !aFileName.isEmpty()) {
-        // set current item
-        for(StPlayItem* anItem = myFirst; anItem != NULL; anItem = anItem->getNext()) {
-            if(anItem->getPath() == aTarget) {
-                myCurrent = anItem;
-                if(myPlsFile.isNull()) {
-                    addRecentFile(*anItem->getFileNode()); // append to recent files list
-                }
-                break;
-            }
-        }
+    if(hasTarget) {
+        myScanTarget = aTarget;
+    }
+    myScanFolder = aSubFolder;
+    myScanDeep   = aSearchDeep;
+    myHasScanJob = true;
+    if(myScanThread.isNull()) {
+        myScanThread = new StThread(scanThreadFunction, (void* )this, "StPlayList");
     }
 
+    const bool toWait = myItems.isEmpty();
+    if(toWait) {
+        myScanFirstEvent.reset();
+    }
     anAutoLock.unlock();
-    signals.onPlaylistChange();
+    myScanEvent.set();
+    if(toWait) {
+        // wait for the first items or target item
+        myScanFirstEvent.wait();
+    } else {
+        signals.onPlaylistChange();
+    }
 }
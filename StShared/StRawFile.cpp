@@ -1,5 +1,5 @@
 /**
- * Copyright © 2009-2014 Kirill Gavrilov <kirill@sview.ru>
+ * Copyright © 2009-2017 Kirill Gavrilov <kirill@sview.ru>
  *
  * Distributed under the Boost Software License, Version 1.0.
  * See accompanying file license-boost.txt or copy at
@@ -15,6 +15,13 @@
 #include <iostream>
 #include <fstream>
 #include <limits>
+#include <ctime>
+
+#if !defined(_WIN32)
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
 
 #if defined(_WIN32)
     #define ftell64(a)     _ftelli64(a)
@@ -28,6 +35,11 @@
     #undef max
 #endif
 
+namespace {
+    static const size_t THE_MAP_SIZE_MIN   = 1024 * 1024; //!< smaller files are read - mapping gives no benefit for them
+    static const time_t THE_MAP_STABLE_SEC = 10;          //!< files modified more recently might be still written
+}
+
 int StRawFile::avInterruptCallback(void* thePtr) {
     StRawFile* aRawFile = reinterpret_cast<StRawFile*>(thePtr);
     return aRawFile != NULL
@@ -42,7 +54,9 @@ StRawFile::StRawFile(const StCString& theFilePath,
   myFileHandle(NULL),
   myBuffer(NULL),
   myBuffSize(0),
-  myLength(0) {
+  myLength(0),
+  myMapSize(0),
+  myToMap(false) {
     //
 }
 
@@ -125,11 +139,64 @@ void StRawFile::initBuffer(size_t theDataSize) {
 }
 
 void StRawFile::freeBuffer() {
+#if !defined(_WIN32)
+    if(myMapSize != 0) {
+        ::munmap(myBuffer, myMapSize);
+        myMapSize = 0;
+        myBuffer = NULL;
+    }
+#endif
     stMemFreeAligned(myBuffer);
     myBuffer = NULL;
     myBuffSize = 0;
 }
 
+bool StRawFile::mapOpenedFile() {
+#if !defined(_WIN32)
+    const int aFileDesc = ::fileno(myFileHandle);
+    struct stat aStat;
+    if(aFileDesc == -1
+    || ::fstat(aFileDesc, &aStat) != 0
+    || !S_ISREG(aStat.st_mode)
+    ||  uint64_t(aStat.st_size) < uint64_t(THE_MAP_SIZE_MIN)
+    ||  uint64_t(aStat.st_size) > uint64_t(std::numeric_limits<ptrdiff_t>::max() / 2)
+    ||  ::time(NULL) - aStat.st_mtime < THE_MAP_STABLE_SEC) {
+        return false;
+    }
+
+    // reserve zero-filled anonymous region and map the file over its beginning,
+    // so that padding is guaranteed even for files ending exactly at the page boundary
+    const size_t aFileLen  = size_t(aStat.st_size);
+    const size_t aPageSize = size_t(::sysconf(_SC_PAGESIZE));
+    const size_t aMapSize  = ((aFileLen + THE_MAP_PADDING + aPageSize - 1) / aPageSize) * aPageSize;
+    void* aBase = ::mmap(NULL, aMapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+    if(aBase == MAP_FAILED) {
+        return false;
+    }
+    if(::mmap(aBase, aFileLen, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, aFileDesc, 0) == MAP_FAILED) {
+        ::munmap(aBase, aMapSize);
+        return false;
+    }
+
+    // fallback to reading if file has been modified meanwhile
+    struct stat aStatMapped;
+    if(::fstat(aFileDesc, &aStatMapped) != 0
+    || aStatMapped.st_size  != aStat.st_size
+    || aStatMapped.st_mtime != aStat.st_mtime) {
+        ::munmap(aBase, aMapSize);
+        return false;
+    }
+    ::madvise(aBase, aFileLen, MADV_WILLNEED);
+
+    myBuffer   = (stUByte_t* )aBase;
+    myBuffSize = aFileLen;
+    myMapSize  = aMapSize;
+    return true;
+#else
+    return false;
+#endif
+}
+
 bool StRawFile::readFile(const StCString& theFilePath,
                          const int        theOpenedFd,
                          const size_t     theReadMax) {
@@ -139,6 +206,14 @@ bool StRawFile::readFile(const StCString& theFilePath,
         return false;
     }
 
+    if(myToMap
+    && theReadMax   == 0
+    && myFileHandle != NULL
+    && mapOpenedFile()) {
+        closeFile();
+        return true;
+    }
+
     if(myContextIO != NULL) {
         int64_t aFileLen = avio_size(myContextIO);
         if(aFileLen > 0) {
@@ -111,6 +111,16 @@ bool StWebPImage::loadInternal(const StString& theFilePath,
         return false;
     }
 
+    // let decoder downscale the image when full resolution is not needed
+    const int aReduction = getReductionLevel((size_t )myConfig.input.width, (size_t )myConfig.input.height, 3);
+    if(aReduction > 0) {
+        mySrcSizeX = (size_t )myConfig.input.width;
+        mySrcSizeY = (size_t )myConfig.input.height;
+        myConfig.options.use_scaling   = 1;
+        myConfig.options.scaled_width  = myConfig.input.width  >> aReduction;
+        myConfig.options.scaled_height = myConfig.input.height >> aReduction;
+    }
+
     if(myConfig.input.has_alpha) {
         // sView currently doesn't support YUVA - force RGBA
         myConfig.output.colorspace = MODE_RGBA;
@@ -174,10 +184,13 @@ bool StWebPImage::loadExtra(const StString& theFilePath,
     StImage::nullify();
     setState();
     close();
+    mySrcSizeX = 0;
+    mySrcSizeY = 0;
 
     // read file
     StRawFile aRawFile(theFilePath);
     if(theDataPtr == NULL || theDataSize == 0) {
+        aRawFile.setMappingAllowed(true);
         if(!aRawFile.readFile()) {
             setState("StWebPImage, could not read the file");
             close();
@@ -1,5 +1,5 @@
 /**
- * Copyright © 2009-2011 Kirill Gavrilov <kirill@sview.ru>
+ * Copyright © 2009-2017 Kirill Gavrilov <kirill@sview.ru>
  *
  * Distributed under the Boost Software License, Version 1.0.
  * See accompanying file license-boost.txt or copy at
@@ -35,3 +35,22 @@ bool stUtfTools::isInteger(const StString& theString) {
     }
     return true;
 }
+
+StString stUtfTools::escapeJson(const StString& theString) {
+    // escaped characters are all ASCII, so UTF-8 string can be processed byte-by-byte
+    StString anEscaped;
+    const char* aStr = theString.toCString();
+    for(size_t aByteIter = 0; aByteIter < theString.getSize(); ++aByteIter) {
+        const unsigned char aChar = (unsigned char )aStr[aByteIter];
+        char aBuff[8] = { (char )aChar, '\0' };
+        if(aChar == '\"' || aChar == '\\') {
+            aBuff[0] = '\\';
+            aBuff[1] = (char )aChar;
+            aBuff[2] = '\0';
+        } else if(aChar < 0x20) {
+            stsprintf(aBuff, sizeof(aBuff), "\\u%04X", (unsigned int )aChar);
+        }
+        anEscaped += aBuff;
+    }
+    return anEscaped;
+}
@@ -58,11 +58,17 @@ void StTestImageLib::perform() {
 
     myTimer.restart();
     StRawFile aRawFile(myFilePath);
+    aRawFile.setMappingAllowed(true);
     if(!aRawFile.readFile()) {
         st::cout << stostream_text("  file can not be read.\n");
         return;
     }
     st::cout << stostream_text("  read in:\t") << myTimer.getElapsedTimeInMilliSec() << stostream_text(" msec\n");
+    if(aRawFile.isMapped()) {
+        st::cout << stostream_text("  mapped:\t") << aRawFile.getSize() << stostream_text(" bytes copy saved\n");
+    } else {
+        st::cout << stostream_text("  mapped:\tno, ") << aRawFile.getSize() << stostream_text(" bytes copied\n");
+    }
     myDataPtr  = (uint8_t* )aRawFile.getBuffer();
     myDataSize = (int )aRawFile.getSize();
 
@@ -0,0 +1,70 @@
+/**
+ * Copyright © 2017 Kirill Gavrilov <kirill@sview.ru>
+ *
+ * StTests program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * StTests program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StTestLogger.h"
+
+#include <StFile/StFileNode.h>
+#include <StStrings/stConsole.h>
+#include <StThreads/StProcess.h>
+
+namespace {
+
+    static const size_t THREADS_NB          = 8;
+    static const size_t MESSAGES_PER_THREAD = 20000;
+
+}
+
+SV_THREAD_FUNCTION StTestLogger::writeLoop(void* theLogger) {
+    StLogger* aLogger = (StLogger* )theLogger;
+    for(size_t anIter = 0; anIter < MESSAGES_PER_THREAD; ++anIter) {
+        aLogger->write(StString("Decoded frame #") + anIter + ", pts= " + (double(anIter) / 25.0), StLogger::ST_VERBOSE);
+    }
+    return SV_THREAD_RETURN 0;
+}
+
+void StTestLogger::testLogger(const char* theTitle,
+                              const int   theOptions) {
+    const StString aFilePath = StProcess::getTempFolder() + "sViewTestLogger.log";
+    StFileNode::removeFile(aFilePath);
+
+    myTimer.restart();
+    {
+        StLogger aLogger(aFilePath, StLogger::ST_VERBOSE, theOptions);
+        StHandle<StThread> aThreads[THREADS_NB];
+        for(size_t aThreadIter = 0; aThreadIter < THREADS_NB; ++aThreadIter) {
+            aThreads[aThreadIter] = new StThread(writeLoop, (void* )&aLogger);
+        }
+        for(size_t aThreadIter = 0; aThreadIter < THREADS_NB; ++aThreadIter) {
+            aThreads[aThreadIter]->wait();
+        }
+    } // pending messages are written by logger destructor
+    const double aTimeSec = myTimer.getElapsedTimeInSec();
+
+    const double aNbMsgs = double(THREADS_NB * MESSAGES_PER_THREAD);
+    st::cout << stostream_text("  ") << theTitle << stostream_text(":\t")
+             << (aTimeSec * 1000.0) << stostream_text(" msec (")
+             << (aNbMsgs / aTimeSec) << stostream_text(" messages/sec)\n");
+    StFileNode::removeFile(aFilePath);
+}
+
+void StTestLogger::perform() {
+    st::cout << stostream_text("Logger speed tests (") << THREADS_NB << stostream_text(" threads, ")
+             << MESSAGES_PER_THREAD << stostream_text(" messages per thread).\n");
+    testLogger("Synchronous ",  StLogger::ST_OPT_LOCK);
+    testLogger("Asynchronous", StLogger::ST_OPT_LOCK | StLogger::ST_OPT_ASYNC);
+}
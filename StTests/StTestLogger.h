@@ -0,0 +1,53 @@
+/**
+ * Copyright © 2017 Kirill Gavrilov <kirill@sview.ru>
+ *
+ * StTests program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * StTests program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __StTestLogger_h_
+#define __StTestLogger_h_
+
+#include "StTest.h"
+#include <StStrings/StLogger.h>
+#include <StThreads/StThread.h>
+
+/**
+ * Tests logging throughput from multiple threads
+ * with synchronous and asynchronous file writing.
+ */
+class ST_LOCAL StTestLogger : public StTest {
+
+        public:
+
+    virtual void perform() ST_ATTR_OVERRIDE;
+
+        private:
+
+    /**
+     * Write messages into the logger in loop.
+     */
+    static SV_THREAD_FUNCTION writeLoop(void* theLogger);
+
+    /**
+     * Write messages from several threads and print the throughput.
+     * @param theTitle   test name
+     * @param theOptions logger options
+     */
+    void testLogger(const char* theTitle,
+                    const int   theOptions);
+
+};
+
+#endif // __StTestLogger_h_
@@ -0,0 +1,271 @@
+/**
+ * Copyright © 2017 Kirill Gavrilov <kirill@sview.ru>
+ *
+ * StTests program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * StTests program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StTestPacketQueue.h"
+#include "../StMoviePlayer/StVideo/StAVPacketQueue.h"
+
+#include <StStrings/stConsole.h>
+#include <StThreads/StMutex.h>
+#include <StAV/StAVPacket.h>
+
+#include <cstring>
+
+namespace {
+
+    static const size_t PACKETS_NB  = 100000;
+    static const size_t PACKET_SIZE = 64 * 1024; // high-bitrate video packet
+    static const size_t QUEUE_SIZE  = 256;
+
+    /**
+     * Fill packet data with pattern defined by packet index.
+     */
+    static void fillPacket(uint8_t*     theData,
+                           const size_t thePacketIter) {
+        const uint64_t anIndex = uint64_t(thePacketIter);
+        std::memcpy(theData, &anIndex, sizeof(anIndex));
+        for(size_t aByteIter = sizeof(anIndex); aByteIter < PACKET_SIZE; aByteIter += 4096) {
+            theData[aByteIter] = uint8_t(thePacketIter * 31 + aByteIter / 4096);
+        }
+        theData[PACKET_SIZE - 1] = uint8_t(thePacketIter * 7);
+    }
+
+    /**
+     * Check that packet has expected size and content.
+     */
+    static bool checkPacket(const StAVPacket& thePacket,
+                            const size_t      thePacketIter) {
+        const uint8_t* aData = thePacket.getData();
+        if(aData == NULL
+        || thePacket.getSize() != int(PACKET_SIZE)) {
+            return false;
+        }
+
+        uint64_t anIndex = 0;
+        std::memcpy(&anIndex, aData, sizeof(anIndex));
+        if(anIndex != uint64_t(thePacketIter)
+        || aData[PACKET_SIZE - 1] != uint8_t(thePacketIter * 7)) {
+            return false;
+        }
+        for(size_t aByteIter = sizeof(anIndex); aByteIter < PACKET_SIZE; aByteIter += 4096) {
+            if(aData[aByteIter] != uint8_t(thePacketIter * 31 + aByteIter / 4096)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+}
+
+/**
+ * Common interface for tested queues.
+ */
+class StTestPacketQueueImpl {
+
+        public:
+
+    virtual ~StTestPacketQueueImpl() {}
+
+    /**
+     * @return true if packet has been added
+     */
+    virtual bool push(StAVPacket& thePacket) = 0;
+
+    /**
+     * @return true if packet has been retrieved
+     */
+    virtual bool pop(StAVPacket& thePacket) = 0;
+
+};
+
+namespace {
+
+    /**
+     * Linked list of heap-allocated packet copies - the former StAVPacketQueue implementation.
+     */
+    class StPacketList : public StTestPacketQueueImpl {
+
+            public:
+
+        StPacketList() : myFront(NULL), myBack(NULL), mySize(0) {}
+
+        virtual ~StPacketList() {
+            StAVPacket aPacket;
+            while(pop(aPacket)) {}
+        }
+
+        virtual bool push(StAVPacket& thePacket) ST_ATTR_OVERRIDE {
+            StMutexAuto aLock(myMutex);
+            if(mySize >= QUEUE_SIZE) {
+                return false;
+            }
+
+            QueueItem* anItem = new QueueItem(thePacket);
+            if(myBack == NULL) {
+                myFront = myBack = anItem;
+            } else {
+                myBack->Next = anItem;
+                myBack = anItem;
+            }
+            ++mySize;
+            thePacket.free();
+            return true;
+        }
+
+        virtual bool pop(StAVPacket& thePacket) ST_ATTR_OVERRIDE {
+            myMutex.lock();
+            if(myFront == NULL) {
+                myMutex.unlock();
+                return false;
+            }
+            QueueItem* anItem = myFront;
+            myFront = anItem->Next;
+            if(myFront == NULL) {
+                myBack = NULL;
+            }
+            --mySize;
+            myMutex.unlock();
+
+            thePacket.moveFrom(*anItem->Packet);
+            delete anItem;
+            return true;
+        }
+
+            private:
+
+        struct QueueItem {
+            StHandle<StAVPacket> Packet;
+            QueueItem*           Next;
+
+            QueueItem(const StAVPacket& thePacket) : Packet(new StAVPacket(thePacket)), Next(NULL) {}
+        };
+
+            private:
+
+        StMutex    myMutex;
+        QueueItem* myFront;
+        QueueItem* myBack;
+        size_t     mySize;
+
+    };
+
+    /**
+     * Wrapper over StAVPacketQueue used by movie player.
+     */
+    class StPacketQueue : public StTestPacketQueueImpl {
+
+            public:
+
+        StPacketQueue() : myQueue(QUEUE_SIZE) {}
+
+        virtual bool push(StAVPacket& thePacket) ST_ATTR_OVERRIDE {
+            if(myQueue.isFull()) {
+                return false;
+            }
+            myQueue.push(thePacket);
+            return true;
+        }
+
+        virtual bool pop(StAVPacket& thePacket) ST_ATTR_OVERRIDE {
+            return myQueue.pop(thePacket);
+        }
+
+            private:
+
+        StAVPacketQueue myQueue;
+
+    };
+
+}
+
+/**
+ * Emulate demuxer - allocate new packet and push it into the queue.
+ */
+SV_THREAD_FUNCTION StTestPacketQueue::pushLoop(void* theTest) {
+    StTestPacketQueue* aTest = (StTestPacketQueue* )theTest;
+    StAVPacket aPacket;
+    for(size_t aPacketIter = 0; aPacketIter < PACKETS_NB;) {
+        if(aPacket.getData() == NULL) {
+            av_new_packet(aPacket.getAVpkt(), int(PACKET_SIZE));
+            fillPacket(aPacket.changeData(), aPacketIter);
+        }
+        if(aTest->myQueue->push(aPacket)) {
+            ++aPacketIter;
+        } else {
+            StThread::sleep(0); // queue is full - yield to decoder
+        }
+    }
+    aPacket.free();
+    return SV_THREAD_RETURN 0;
+}
+
+double StTestPacketQueue::testQueue(StTestPacketQueueImpl& theQueue,
+                                    size_t&                theNbErrors) {
+    myQueue = &theQueue;
+    myTimer.restart();
+    StThread aPushThread(pushLoop, this);
+
+    // emulate decoder - packets should come in the same order and with the same content
+    StAVPacket aPacket;
+    theNbErrors = 0;
+    for(size_t aPacketIter = 0; aPacketIter < PACKETS_NB;) {
+        if(!theQueue.pop(aPacket)) {
+            StThread::sleep(0); // queue is empty - yield to demuxer
+            continue;
+        }
+        if(!checkPacket(aPacket, aPacketIter)) {
+            ++theNbErrors;
+        }
+        aPacket.free();
+        ++aPacketIter;
+    }
+    aPushThread.wait();
+    const double aTimeMSec = myTimer.getElapsedTimeInMilliSec();
+    myQueue = NULL;
+    return aTimeMSec;
+}
+
+void StTestPacketQueue::printResult(const char*  theTitle,
+                                    const double theTimeMSec,
+                                    const size_t theNbErrors) {
+    const double aSizeMiB = double(PACKETS_NB) * double(PACKET_SIZE) / (1024.0 * 1024.0);
+    st::cout << stostream_text("  ") << theTitle << stostream_text(":\t") << theTimeMSec << stostream_text(" msec")
+             << stostream_text(" (") << (1000.0 * double(PACKETS_NB) / theTimeMSec) << stostream_text(" packets/sec, ")
+             << (1000.0 * aSizeMiB / theTimeMSec) << stostream_text(" MiB/sec)");
+    if(theNbErrors != 0) {
+        st::cout << stostream_text(" FAILED, ") << theNbErrors << stostream_text(" packets are corrupted or reordered");
+    }
+    st::cout << stostream_text("\n");
+}
+
+void StTestPacketQueue::perform() {
+    st::cout << stostream_text("Packet queue stress tests (") << PACKETS_NB << stostream_text(" packets, ")
+             << (PACKET_SIZE / 1024) << stostream_text(" KiB each).\n");
+
+    {
+        StPacketList aList;
+        size_t aNbErrors = 0;
+        const double aTimeMSec = testQueue(aList, aNbErrors);
+        printResult("list (copy)", aTimeMSec, aNbErrors);
+    }
+    {
+        StPacketQueue aQueue;
+        size_t aNbErrors = 0;
+        const double aTimeMSec = testQueue(aQueue, aNbErrors);
+        printResult("StAVPacketQueue", aTimeMSec, aNbErrors);
+    }
+}
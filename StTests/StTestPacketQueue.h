@@ -0,0 +1,69 @@
+/**
+ * Copyright © 2017 Kirill Gavrilov <kirill@sview.ru>
+ *
+ * StTests program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * StTests program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __StTestPacketQueue_h_
+#define __StTestPacketQueue_h_
+
+#include "StTest.h"
+#include <StThreads/StThread.h>
+
+class StTestPacketQueueImpl;
+
+/**
+ * Stress test for demuxer -> decoder packets handoff:
+ * former linked list of copied packets versus StAVPacketQueue (ring of recycled packet slots).
+ * Packets order and content are verified on the decoder side.
+ */
+class ST_LOCAL StTestPacketQueue : public StTest {
+
+        public:
+
+    StTestPacketQueue() : myQueue(NULL) {}
+
+    virtual void perform() ST_ATTR_OVERRIDE;
+
+        private:
+
+    /**
+     * Run demuxer and decoder threads over the queue.
+     * @param theQueue    queue to test
+     * @param theNbErrors number of packets retrieved out of order or with unexpected content
+     * @return elapsed time in milliseconds
+     */
+    double testQueue(StTestPacketQueueImpl& theQueue,
+                     size_t&                theNbErrors);
+
+    /**
+     * Print test result.
+     */
+    void printResult(const char*  theTitle,
+                     const double theTimeMSec,
+                     const size_t theNbErrors);
+
+    /**
+     * Push packets in loop.
+     */
+    static SV_THREAD_FUNCTION pushLoop(void* theTest);
+
+        private:
+
+    StTestPacketQueueImpl* myQueue;
+
+};
+
+#endif // __StTestPacketQueue_h_
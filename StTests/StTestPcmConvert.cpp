@@ -0,0 +1,126 @@
+/**
+ * Copyright © 2017 Kirill Gavrilov <kirill@sview.ru>
+ *
+ * StTests program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * StTests program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StTestPcmConvert.h"
+#include "../StMoviePlayer/StVideo/StPCMBuffer.h"
+
+#include <StStrings/stConsole.h>
+#include <StThreads/StTimer.h>
+
+namespace {
+
+    static const size_t FRAMES_NB     = 1024;  // frames within single buffer
+    static const size_t ITERATIONS_NB = 4000;
+
+    /**
+     * @return sample size in bytes
+     */
+    static size_t sampleSize(const StPcmFormat theFormat) {
+        switch(theFormat) {
+            case StPcmFormat_UInt8:   return sizeof(uint8_t);
+            case StPcmFormat_Int16:   return sizeof(int16_t);
+            case StPcmFormat_Int32:   return sizeof(int32_t);
+            case StPcmFormat_Float32: return sizeof(float);
+            case StPcmFormat_Float64: return sizeof(double);
+        }
+        return 0;
+    }
+
+    /**
+     * Fill the buffer with pseudo-random samples.
+     */
+    static void fillBuffer(StPCMBuffer& theBuffer,
+                           const size_t theChNb) {
+        const size_t aSampleSize = sampleSize(theBuffer.getFormat());
+        const size_t aPlaneSize  = FRAMES_NB * aSampleSize * (theBuffer.getPlanesNb() > 1 ? 1 : theChNb);
+        unsigned int aSeed = 12345;
+        for(size_t aPlaneIter = 0; aPlaneIter < theBuffer.getPlanesNb(); ++aPlaneIter) {
+            uint8_t* aPlane = theBuffer.getPlane(aPlaneIter);
+            for(size_t aByteIter = 0; aByteIter < aPlaneSize; aByteIter += aSampleSize) {
+                aSeed = aSeed * 1103515245 + 12345;
+                const float aValue = float(aSeed >> 8) / float(1 << 24) * 2.2f - 1.1f; // slightly out of range to test saturation
+                switch(theBuffer.getFormat()) {
+                    case StPcmFormat_UInt8:   *(uint8_t* )&aPlane[aByteIter] = uint8_t(aSeed >> 24); break;
+                    case StPcmFormat_Int16:   *(int16_t* )&aPlane[aByteIter] = int16_t(aSeed >> 16); break;
+                    case StPcmFormat_Int32:   *(int32_t* )&aPlane[aByteIter] = int32_t(aSeed);       break;
+                    case StPcmFormat_Float32: *(float*   )&aPlane[aByteIter] = aValue;               break;
+                    case StPcmFormat_Float64: *(double*  )&aPlane[aByteIter] = aValue;               break;
+                }
+            }
+        }
+        theBuffer.setPlaneSize(aPlaneSize);
+    }
+
+}
+
+void StTestPcmConvert::testConvert(const char*        theTitle,
+                                   const StPCMBuffer& theSrc,
+                                   StPCMBuffer&       theOut,
+                                   const size_t       theChNb) {
+    StTimer aTimer(true);
+    for(size_t anIter = 0; anIter < ITERATIONS_NB; ++anIter) {
+        theOut.setPlaneSize(0);
+        if(!theOut.addData(theSrc)) {
+            st::cout << stostream_text("  ") << theTitle << stostream_text(":\tFAILED\n");
+            return;
+        }
+    }
+    const double aTimeSec = aTimer.getElapsedTimeInSec();
+    const double aSamples = double(FRAMES_NB * theChNb * ITERATIONS_NB);
+    st::cout << stostream_text("  ") << theTitle << stostream_text(":\t")
+             << (aSamples / aTimeSec * 0.000001) << stostream_text(" Msamples/sec\n");
+}
+
+void StTestPcmConvert::perform() {
+    st::cout << stostream_text("PCM conversion tests (") << FRAMES_NB << stostream_text(" frames x ")
+             << ITERATIONS_NB << stostream_text(" iterations).\n");
+
+    struct {
+        const char*              Title;
+        StPcmFormat              SrcFormat;
+        StPcmFormat              OutFormat;
+        StChannelMap::Channels   Channels;
+        StChannelMap::OrderRules SrcRules;
+        bool                     IsSrcPlanar;
+        bool                     IsOutPlanar;
+    } aPairs[] = {
+        { "s16  -> f32,  2ch interleaved -> planar     ", StPcmFormat_Int16,   StPcmFormat_Float32, StChannelMap::CH20, StChannelMap::PCM, false, true  },
+        { "s16  -> f32,  2ch interleaved -> interleaved", StPcmFormat_Int16,   StPcmFormat_Float32, StChannelMap::CH20, StChannelMap::PCM, false, false },
+        { "s32  -> f32,  2ch planar      -> interleaved", StPcmFormat_Int32,   StPcmFormat_Float32, StChannelMap::CH20, StChannelMap::PCM, true,  false },
+        { "f32  -> s16,  2ch interleaved -> interleaved", StPcmFormat_Float32, StPcmFormat_Int16,   StChannelMap::CH20, StChannelMap::PCM, false, false },
+        { "f32  -> s16,  2ch planar      -> interleaved", StPcmFormat_Float32, StPcmFormat_Int16,   StChannelMap::CH20, StChannelMap::PCM, true,  false },
+        { "f32  -> f32,  2ch planar      -> interleaved", StPcmFormat_Float32, StPcmFormat_Float32, StChannelMap::CH20, StChannelMap::PCM, true,  false },
+        { "f32  -> f32,  6ch planar      -> interleaved", StPcmFormat_Float32, StPcmFormat_Float32, StChannelMap::CH51, StChannelMap::PCM, true,  false },
+        { "f32  -> f32,  8ch planar      -> interleaved", StPcmFormat_Float32, StPcmFormat_Float32, StChannelMap::CH71, StChannelMap::PCM, true,  false },
+        { "f32  -> f32,  6ch interleaved -> planar     ", StPcmFormat_Float32, StPcmFormat_Float32, StChannelMap::CH51, StChannelMap::PCM, false, true  },
+        { "f32  -> f32,  8ch interleaved -> planar     ", StPcmFormat_Float32, StPcmFormat_Float32, StChannelMap::CH71, StChannelMap::PCM, false, true  },
+        { "f32  -> s16,  6ch AC3 planar  -> interleaved", StPcmFormat_Float32, StPcmFormat_Int16,   StChannelMap::CH51, StChannelMap::AC3, true,  false },
+        { "f64  -> f32,  2ch planar      -> interleaved", StPcmFormat_Float64, StPcmFormat_Float32, StChannelMap::CH20, StChannelMap::PCM, true,  false },
+    };
+
+    for(size_t aPairIter = 0; aPairIter < sizeof(aPairs) / sizeof(aPairs[0]); ++aPairIter) {
+        const StChannelMap aChMapSrc(aPairs[aPairIter].Channels, aPairs[aPairIter].SrcRules);
+        const StChannelMap aChMapOut(aPairs[aPairIter].Channels, StChannelMap::PCM);
+        StPCMBuffer aSrc(aPairs[aPairIter].SrcFormat);
+        StPCMBuffer anOut(aPairs[aPairIter].OutFormat);
+        aSrc .setupChannels(aChMapSrc, aPairs[aPairIter].IsSrcPlanar ? aChMapSrc.count : 1);
+        anOut.setupChannels(aChMapOut, aPairs[aPairIter].IsOutPlanar ? aChMapOut.count : 1);
+        fillBuffer(aSrc, aChMapSrc.count);
+        testConvert(aPairs[aPairIter].Title, aSrc, anOut, aChMapSrc.count);
+    }
+}
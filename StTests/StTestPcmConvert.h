@@ -0,0 +1,52 @@
+/**
+ * Copyright © 2017 Kirill Gavrilov <kirill@sview.ru>
+ *
+ * StTests program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * StTests program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __StTestPcmConvert_h_
+#define __StTestPcmConvert_h_
+
+#include "StTest.h"
+
+class StPCMBuffer;
+
+/**
+ * Performance test for PCM samples conversion
+ * between formats and planar / interleaved layouts.
+ */
+class ST_LOCAL StTestPcmConvert : public StTest {
+
+        public:
+
+    virtual void perform() ST_ATTR_OVERRIDE;
+
+        private:
+
+    /**
+     * Convert the source buffer in loop and print the conversion speed.
+     * @param theTitle  conversion name
+     * @param theSrc    source buffer
+     * @param theOut    output buffer
+     * @param theChNb   channels number
+     */
+    void testConvert(const char*        theTitle,
+                     const StPCMBuffer& theSrc,
+                     StPCMBuffer&       theOut,
+                     const size_t       theChNb);
+
+};
+
+#endif // __StTestPcmConvert_h_
@@ -0,0 +1,103 @@
+/**
+ * Copyright © 2017 Kirill Gavrilov <kirill@sview.ru>
+ *
+ * StTests program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * StTests program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StTestTextureQueue.h"
+
+#include <StStrings/stConsole.h>
+#include <StGLStereo/StGLTextureQueue.h>
+#include <StGL/StGLContext.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+    static const size_t FRAMES_NB   = 200000;
+    static const size_t QUEUE_SIZE  = 4;
+    static const size_t FRAME_SIZEX = 64;
+    static const size_t FRAME_SIZEY = 32;
+
+}
+
+/**
+ * Push frames in loop, PTS of each frame is set to the frame index.
+ */
+SV_THREAD_FUNCTION StTestTextureQueue::pushLoop(void* theTest) {
+    StTestTextureQueue* aTest = (StTestTextureQueue* )theTest;
+    StImage anImage;
+    anImage.setColorModel(StImage::ImgColor_RGB);
+    anImage.changePlane(0).initTrash(StImagePlane::ImgRGB, FRAME_SIZEX, FRAME_SIZEY);
+    const StImage anEmpty;
+    const StHandle<StStereoParams> aParams;
+    for(size_t aFrameIter = 0; aFrameIter < FRAMES_NB;) {
+        aTest->myPushTimes[aFrameIter] = aTest->myTimer.getElapsedTimeInSec();
+        if(aTest->myQueue->push(anImage, anEmpty, aParams, StFormat_Mono, StCubemap_OFF, double(aFrameIter))) {
+            ++aFrameIter;
+        } else {
+            aTest->myQueue->waitPop(10); // queue is full - wait for consumer
+        }
+    }
+    return SV_THREAD_RETURN 0;
+}
+
+void StTestTextureQueue::perform() {
+    st::cout << stostream_text("Texture queue handoff tests (") << FRAMES_NB << stostream_text(" frames).\n");
+
+    StGLTextureQueue aQueue(QUEUE_SIZE);
+    StGLContext      aCtx(false); // unbound context - frames are popped without upload
+    myQueue = &aQueue;
+    aQueue.setConnectedStream(true);
+
+    std::vector<double> aPushTimes(FRAMES_NB, 0.0);
+    std::vector<double> aLatencies;
+    aLatencies.reserve(FRAMES_NB);
+    myPushTimes = &aPushTimes.front();
+    myTimer.restart();
+    StThread aPushThread(pushLoop, this);
+    double aPtsLast = -1.0;
+    while(aLatencies.size() < FRAMES_NB) {
+        aQueue.stglSwapFB(0);
+        if(!aQueue.stglUpdateStTextures(aCtx)) {
+            aQueue.waitPush(10); // queue is empty - wait for producer
+            continue;
+        }
+
+        const double aPts = aQueue.getPTSCurr();
+        if(aPts != aPtsLast) {
+            aLatencies.push_back(myTimer.getElapsedTimeInSec() - aPushTimes[size_t(aPts)]);
+            aPtsLast = aPts;
+        }
+    }
+    aPushThread.wait();
+    const double aTimeAllMSec = myTimer.getElapsedTimeInMilliSec();
+    myQueue     = NULL;
+    myPushTimes = NULL;
+
+    std::sort(aLatencies.begin(), aLatencies.end());
+    double aLatencyAvg = 0.0;
+    for(size_t anIter = 0; anIter < aLatencies.size(); ++anIter) {
+        aLatencyAvg += aLatencies[anIter];
+    }
+    aLatencyAvg /= double(aLatencies.size());
+    const double aLatencyP99 = aLatencies[(aLatencies.size() * 99) / 100];
+
+    st::cout << stostream_text("  throughput:\t")  << (1000.0 * double(FRAMES_NB) / aTimeAllMSec) << stostream_text(" frames/sec")
+             << stostream_text(" (")              << aTimeAllMSec << stostream_text(" msec)\n");
+    st::cout << stostream_text("  latency avg:\t") << (aLatencyAvg * 1000000.0) << stostream_text(" microsec\n");
+    st::cout << stostream_text("  latency p99:\t") << (aLatencyP99 * 1000000.0) << stostream_text(" microsec\n");
+}
@@ -0,0 +1,53 @@
+/**
+ * Copyright © 2017 Kirill Gavrilov <kirill@sview.ru>
+ *
+ * StTests program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * StTests program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __StTestTextureQueue_h_
+#define __StTestTextureQueue_h_
+
+#include "StTest.h"
+#include <StThreads/StThread.h>
+
+class StGLTextureQueue;
+
+/**
+ * Tests frames handoff performance through StGLTextureQueue
+ * (push from video thread, pop from GL thread).
+ */
+class ST_LOCAL StTestTextureQueue : public StTest {
+
+        public:
+
+    StTestTextureQueue() : myQueue(NULL), myPushTimes(NULL) {}
+
+    virtual void perform() ST_ATTR_OVERRIDE;
+
+        private:
+
+    /**
+     * Push frames into queue in loop.
+     */
+    static SV_THREAD_FUNCTION pushLoop(void* theTest);
+
+        private:
+
+    StGLTextureQueue* myQueue;
+    double*           myPushTimes; //!< push time of each frame
+
+};
+
+#endif // __StTestTextureQueue_h_
@@ -0,0 +1,279 @@
+/**
+ * Copyright © 2017 Kirill Gavrilov <kirill@sview.ru>
+ *
+ * StTests program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * StTests program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StTestYuvConvert.h"
+
+#include <StStrings/stConsole.h>
+#include <StThreads/StThread.h>
+#include <StThreads/StTimer.h>
+
+namespace {
+
+    static const size_t FRAME_SIZE_X  = 3840; // 4K frame
+    static const size_t FRAME_SIZE_Y  = 2160;
+    static const size_t CHECK_SIZE_X  = 638;  // width is not multiple of 4 to cover scalar tail after SSE2 loop
+    static const size_t CHECK_SIZE_Y  = 358;
+    static const size_t ITERATIONS_NB = 20;
+
+    /**
+     * Tested YUV layout.
+     */
+    struct YuvFormat {
+        const char*             Title;
+        StImage::ImgColorScale  Scale;
+        StImagePlane::ImgFormat Format;
+        unsigned int            MaxValue;
+        size_t                  DivX;
+        size_t                  DivY;
+        bool                    IsNV;
+    };
+
+    /**
+     * Initialize the plane and fill it with pseudo-random values within specified range.
+     */
+    static bool fillPlane(StImagePlane&                 thePlane,
+                          const StImagePlane::ImgFormat theFormat,
+                          const size_t                  theSizeX,
+                          const size_t                  theSizeY,
+                          const unsigned int            theMaxValue) {
+        if(!thePlane.initTrash(theFormat, theSizeX, theSizeY)) {
+            return false;
+        }
+
+        unsigned int aSeed = 12345;
+        const size_t aNbComps = theFormat == StImagePlane::ImgUV ? 2 : 1;
+        for(size_t aRow = 0; aRow < theSizeY; ++aRow) {
+            GLubyte* aData = thePlane.changeData(aRow, 0);
+            for(size_t aCol = 0; aCol < theSizeX * aNbComps; ++aCol) {
+                aSeed = aSeed * 1103515245 + 12345;
+                const unsigned int aValue = (aSeed >> 8) % (theMaxValue + 1);
+                if(theFormat == StImagePlane::ImgGray16) {
+                    ((uint16_t* )aData)[aCol] = uint16_t(aValue);
+                } else {
+                    aData[aCol] = GLubyte(aValue);
+                }
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Tested YUV sample with expected RGB result.
+     */
+    struct YuvKnownValue {
+        const char*  Title;
+        YuvFormat    Format;
+        unsigned int Y, U, V;
+        unsigned int R, G, B;
+    };
+
+    /**
+     * Initialize the plane and fill it with the same sample.
+     */
+    static bool fillPlaneConst(StImagePlane&                 thePlane,
+                               const StImagePlane::ImgFormat theFormat,
+                               const size_t                  theSizeX,
+                               const size_t                  theSizeY,
+                               const unsigned int            theValue1,
+                               const unsigned int            theValue2) {
+        if(!thePlane.initTrash(theFormat, theSizeX, theSizeY)) {
+            return false;
+        }
+
+        for(size_t aRow = 0; aRow < theSizeY; ++aRow) {
+            GLubyte* aData = thePlane.changeData(aRow, 0);
+            for(size_t aCol = 0; aCol < theSizeX; ++aCol) {
+                if(theFormat == StImagePlane::ImgGray16) {
+                    ((uint16_t* )aData)[aCol] = uint16_t(theValue1);
+                } else if(theFormat == StImagePlane::ImgUV) {
+                    aData[aCol * 2]     = GLubyte(theValue1);
+                    aData[aCol * 2 + 1] = GLubyte(theValue2);
+                } else {
+                    aData[aCol] = GLubyte(theValue1);
+                }
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Initialize YUV image of specified layout filled with pseudo-random values.
+     */
+    static bool initYuv(StImage&         theImage,
+                        const YuvFormat& theFormat,
+                        const size_t     theSizeX,
+                        const size_t     theSizeY) {
+        const size_t aSizeXC = (theSizeX + theFormat.DivX - 1) / theFormat.DivX;
+        const size_t aSizeYC = (theSizeY + theFormat.DivY - 1) / theFormat.DivY;
+        theImage.setColorModel(StImage::ImgColor_YUV);
+        theImage.setColorScale(theFormat.Scale);
+        if(!fillPlane(theImage.changePlane(0), theFormat.Format, theSizeX, theSizeY, theFormat.MaxValue)) {
+            return false;
+        }
+        if(theFormat.IsNV) {
+            return fillPlane(theImage.changePlane(1), StImagePlane::ImgUV, aSizeXC, aSizeYC, theFormat.MaxValue);
+        }
+        return fillPlane(theImage.changePlane(1), theFormat.Format, aSizeXC, aSizeYC, theFormat.MaxValue)
+            && fillPlane(theImage.changePlane(2), theFormat.Format, aSizeXC, aSizeYC, theFormat.MaxValue);
+    }
+
+}
+
+bool StTestYuvConvert::testCheck(const StImage& theSrc) {
+    // several slices (threads) and single slice should produce the same result as per-pixel reference
+    for(int aNbThreads = 0; aNbThreads < 2; ++aNbThreads) {
+        StImage anRgb;
+        if(!anRgb.initRGB(theSrc, aNbThreads)) {
+            return false;
+        }
+
+        const StImagePlane& aPlane = anRgb.getPlane(0);
+        for(size_t aRow = 0; aRow < aPlane.getSizeY(); ++aRow) {
+            for(size_t aCol = 0; aCol < aPlane.getSizeX(); ++aCol) {
+                const StPixelRGB  aRef = theSrc.getRGBFromYUV(aRow, aCol);
+                const GLubyte*    aRes = aPlane.getData(aRow, aCol);
+                if(aRes[0] != aRef.r()
+                || aRes[1] != aRef.g()
+                || aRes[2] != aRef.b()) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool StTestYuvConvert::testKnownValues() {
+    // samples with well-known results (BT.601), checking range offsets, coefficients and chroma planes order
+    const YuvKnownValue aValues[] = {
+        { "yuv420p   mpeg black  ", { "", StImage::ImgScale_Mpeg,   StImagePlane::ImgGray,   255,  2, 2, false },   16,  128,  128,   0,   0,   0 },
+        { "yuv420p   mpeg white  ", { "", StImage::ImgScale_Mpeg,   StImagePlane::ImgGray,   255,  2, 2, false },  235,  128,  128, 255, 255, 255 },
+        { "yuv420p   mpeg red    ", { "", StImage::ImgScale_Mpeg,   StImagePlane::ImgGray,   255,  2, 2, false },   16,  128,  240, 179,   0,   0 },
+        { "yuv420p   mpeg pink   ", { "", StImage::ImgScale_Mpeg,   StImagePlane::ImgGray,   255,  2, 2, false },  235,  128,  240, 255, 164, 255 },
+        { "yuv420p   mpeg green  ", { "", StImage::ImgScale_Mpeg,   StImagePlane::ImgGray,   255,  2, 2, false },   16,   16,  128,   0,  44,   0 },
+        { "nv12      mpeg red    ", { "", StImage::ImgScale_NvMpeg, StImagePlane::ImgGray,   255,  2, 2, true  },   16,  128,  240, 179,   0,   0 },
+        { "yuvj420p  full black  ", { "", StImage::ImgScale_Full,   StImagePlane::ImgGray,   255,  2, 2, false },    0,  128,  128,   0,   0,   0 },
+        { "yuvj420p  full white  ", { "", StImage::ImgScale_Full,   StImagePlane::ImgGray,   255,  2, 2, false },  255,  128,  128, 255, 255, 255 },
+        { "yuvj420p  full blue   ", { "", StImage::ImgScale_Full,   StImagePlane::ImgGray,   255,  2, 2, false },    0,  255,  128,   0,   0, 225 },
+        { "yuv420p10 mpeg black  ", { "", StImage::ImgScale_Mpeg10, StImagePlane::ImgGray16, 1023, 2, 2, false },   64,  512,  512,   0,   0,   0 },
+        { "yuv420p10 mpeg white  ", { "", StImage::ImgScale_Mpeg10, StImagePlane::ImgGray16, 1023, 2, 2, false },  940,  512,  512, 255, 255, 255 },
+        { "yuv420p10 mpeg red    ", { "", StImage::ImgScale_Mpeg10, StImagePlane::ImgGray16, 1023, 2, 2, false },   64,  512,  960, 179,   0,   0 },
+        { "yuv444p10 full black  ", { "", StImage::ImgScale_Jpeg10, StImagePlane::ImgGray16, 1023, 1, 1, false },    0,  512,  512,   0,   0,   0 },
+        { "yuv444p10 full white  ", { "", StImage::ImgScale_Jpeg10, StImagePlane::ImgGray16, 1023, 1, 1, false }, 1023,  512,  512, 255, 255, 255 },
+    };
+
+    bool isOk = true;
+    for(size_t aValueIter = 0; aValueIter < sizeof(aValues) / sizeof(aValues[0]); ++aValueIter) {
+        const YuvKnownValue& aValue = aValues[aValueIter];
+        const size_t aSizeX  = 6; // SSE2 loop and scalar tail
+        const size_t aSizeY  = 4;
+        const size_t aSizeXC = aSizeX / aValue.Format.DivX;
+        const size_t aSizeYC = aSizeY / aValue.Format.DivY;
+        StImage aYuv;
+        aYuv.setColorModel(StImage::ImgColor_YUV);
+        aYuv.setColorScale(aValue.Format.Scale);
+        bool isInit = fillPlaneConst(aYuv.changePlane(0), aValue.Format.Format, aSizeX, aSizeY, aValue.Y, 0);
+        if(aValue.Format.IsNV) {
+            isInit = isInit && fillPlaneConst(aYuv.changePlane(1), StImagePlane::ImgUV, aSizeXC, aSizeYC, aValue.U, aValue.V);
+        } else {
+            isInit = isInit
+                  && fillPlaneConst(aYuv.changePlane(1), aValue.Format.Format, aSizeXC, aSizeYC, aValue.U, 0)
+                  && fillPlaneConst(aYuv.changePlane(2), aValue.Format.Format, aSizeXC, aSizeYC, aValue.V, 0);
+        }
+
+        StImage anRgb;
+        bool isSame = isInit && anRgb.initRGB(aYuv, 1);
+        for(size_t aRow = 0; isSame && aRow < aSizeY; ++aRow) {
+            for(size_t aCol = 0; isSame && aCol < aSizeX; ++aCol) {
+                const GLubyte* aRes = anRgb.getPlane(0).getData(aRow, aCol);
+                isSame = aRes[0] == aValue.R
+                      && aRes[1] == aValue.G
+                      && aRes[2] == aValue.B;
+            }
+        }
+        if(!isSame) {
+            const GLubyte* aRes = anRgb.isNull() ? NULL : anRgb.getPlane(0).getData(0, 0);
+            st::cout << stostream_text("  ") << aValue.Title << stostream_text(":\tFAILED, (")
+                     << aValue.Y << stostream_text(", ") << aValue.U << stostream_text(", ") << aValue.V
+                     << stostream_text(") -> (")
+                     << (aRes != NULL ? int(aRes[0]) : -1) << stostream_text(", ")
+                     << (aRes != NULL ? int(aRes[1]) : -1) << stostream_text(", ")
+                     << (aRes != NULL ? int(aRes[2]) : -1) << stostream_text(") instead of (")
+                     << aValue.R << stostream_text(", ") << aValue.G << stostream_text(", ") << aValue.B
+                     << stostream_text(")\n");
+            isOk = false;
+        }
+    }
+    return isOk;
+}
+
+double StTestYuvConvert::testConvert(const StImage& theSrc,
+                                     const int      theNbThreads) {
+    StImage anRgb;
+    StTimer aTimer(true);
+    for(size_t anIter = 0; anIter < ITERATIONS_NB; ++anIter) {
+        if(!anRgb.initRGB(theSrc, theNbThreads)) {
+            return 0.0;
+        }
+    }
+    const double aTimeSec = aTimer.getElapsedTimeInSec();
+    const double aPixels  = double(theSrc.getSizeX() * theSrc.getSizeY() * ITERATIONS_NB);
+    return aPixels / aTimeSec * 0.000001;
+}
+
+void StTestYuvConvert::perform() {
+    st::cout << stostream_text("YUV -> RGB conversion tests (") << FRAME_SIZE_X << stostream_text("x") << FRAME_SIZE_Y
+             << stostream_text(" frame x ") << ITERATIONS_NB << stostream_text(" iterations), Mpixels/sec.\n");
+
+    if(testKnownValues()) {
+        st::cout << stostream_text("  known values:\tOK\n");
+    }
+
+    const YuvFormat aFormats[] = {
+        { "yuv420p   mpeg   ", StImage::ImgScale_Mpeg,   StImagePlane::ImgGray,   255,   2, 2, false },
+        { "yuvj420p  full   ", StImage::ImgScale_Full,   StImagePlane::ImgGray,   255,   2, 2, false },
+        { "yuv422p   mpeg   ", StImage::ImgScale_Mpeg,   StImagePlane::ImgGray,   255,   2, 1, false },
+        { "yuv444p   mpeg   ", StImage::ImgScale_Mpeg,   StImagePlane::ImgGray,   255,   1, 1, false },
+        { "nv12      mpeg   ", StImage::ImgScale_NvMpeg, StImagePlane::ImgGray,   255,   2, 2, true  },
+        { "yuv420p9  mpeg   ", StImage::ImgScale_Mpeg9,  StImagePlane::ImgGray16, 511,   2, 2, false },
+        { "yuv420p10 mpeg   ", StImage::ImgScale_Mpeg10, StImagePlane::ImgGray16, 1023,  2, 2, false },
+        { "yuv444p10 full   ", StImage::ImgScale_Jpeg10, StImagePlane::ImgGray16, 1023,  1, 1, false },
+        { "yuv420p16 mpeg   ", StImage::ImgScale_Mpeg,   StImagePlane::ImgGray16, 65535, 2, 2, false },
+    };
+
+    for(size_t aFormatIter = 0; aFormatIter < sizeof(aFormats) / sizeof(aFormats[0]); ++aFormatIter) {
+        const YuvFormat& aFormat = aFormats[aFormatIter];
+        StImage aYuvCheck, aYuv;
+        if(!initYuv(aYuvCheck, aFormat, CHECK_SIZE_X, CHECK_SIZE_Y)
+        || !initYuv(aYuv,      aFormat, FRAME_SIZE_X, FRAME_SIZE_Y)) {
+            st::cout << stostream_text("  ") << aFormat.Title << stostream_text(":\tFAILED to allocate\n");
+            continue;
+        }
+
+        if(!testCheck(aYuvCheck)) {
+            st::cout << stostream_text("  ") << aFormat.Title << stostream_text(":\tFAILED (result differs from getRGBFromYUV())\n");
+            continue;
+        }
+
+        const double aSpeedSingle = testConvert(aYuv, 1);
+        const double aSpeedMulti  = testConvert(aYuv, 0);
+        st::cout << stostream_text("  ") << aFormat.Title << stostream_text(":\t")
+                 << aSpeedSingle << stostream_text(" (1 thread)\t")
+                 << aSpeedMulti  << stostream_text(" (") << StThread::countLogicalProcessors() << stostream_text(" logical processors)\n");
+    }
+}
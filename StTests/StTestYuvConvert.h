@@ -0,0 +1,61 @@
+/**
+ * Copyright © 2017 Kirill Gavrilov <kirill@sview.ru>
+ *
+ * StTests program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * StTests program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __StTestYuvConvert_h_
+#define __StTestYuvConvert_h_
+
+#include "StTest.h"
+
+#include <StImage/StImage.h>
+
+/**
+ * Correctness and performance test for YUV -> RGB conversion of the images (StImage::initRGB()).
+ */
+class ST_LOCAL StTestYuvConvert : public StTest {
+
+        public:
+
+    virtual void perform() ST_ATTR_OVERRIDE;
+
+        private:
+
+    /**
+     * Compare conversion result (using several threads and single thread) with per-pixel StImage::getRGBFromYUV().
+     * @param theSrc source YUV image
+     * @return true if results are identical
+     */
+    bool testCheck(const StImage& theSrc);
+
+    /**
+     * Convert samples with well-known RGB results (black, white, saturated colors) for several layouts.
+     * @return true if all results are as expected, failures are printed
+     */
+    bool testKnownValues();
+
+    /**
+     * Convert the source image in loop and measure the conversion speed.
+     * @param theSrc       source YUV image
+     * @param theNbThreads number of threads, 0 means all logical processors
+     * @return conversion speed in Mpixels/sec, 0 on failure
+     */
+    double testConvert(const StImage& theSrc,
+                       const int      theNbThreads);
+
+};
+
+#endif // __StTestYuvConvert_h_
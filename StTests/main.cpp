@@ -21,9 +21,14 @@
 #include <StFile/StFolder.h>
 
 #include "StTestMutex.h"
+#include "StTestLogger.h"
 #include "StTestGlBand.h"
 #include "StTestEmbed.h"
 #include "StTestImageLib.h"
+#include "StTestTextureQueue.h"
+#include "StTestPcmConvert.h"
+#include "StTestYuvConvert.h"
+#include "StTestPacketQueue.h"
 #include "StTestGlStress.h"
 
 int main(int , char** ) { // force console output
@@ -50,10 +55,15 @@ int main(int , char** ) { // force console output
 
     StArrayList<StString> anArgs = StProcess::getArguments();
     const StString ST_TEST_MUTICES = "mutex";
+    const StString ST_TEST_LOGGER  = "logger";
     const StString ST_TEST_GLBAND  = "glband";
     const StString ST_TEST_GLHANG  = "glhang";
     const StString ST_TEST_EMBED   = "embed";
     const StString ST_TEST_IMAGE   = "image";
+    const StString ST_TEST_TEXQUEUE = "texqueue";
+    const StString ST_TEST_PKTQUEUE = "pktqueue";
+    const StString ST_TEST_PCMCONV = "pcmconv";
+    const StString ST_TEST_YUVCONV = "yuvconv";
     const StString ST_TEST_ALL     = "all";
     size_t aFound = 0;
     for(size_t anArgId = 0; anArgId < anArgs.size(); ++anArgId) {
@@ -63,6 +73,11 @@ int main(int , char** ) { // force console output
             StTestMutex aMutices;
             aMutices.perform();
             ++aFound;
+        } else if(aParam == ST_TEST_LOGGER) {
+            // logger throughput test
+            StTestLogger aLogger;
+            aLogger.perform();
+            ++aFound;
         } else if(aParam == ST_TEST_GLBAND) {
             // gl <-> cpu trasfer speed test
             StTestGlBand aGlBand;
@@ -88,11 +103,47 @@ int main(int , char** ) { // force console output
             StTestImageLib anImage(anArgs[anArgId]);
             anImage.perform();
             ++aFound;
+        } else if(aParam == ST_TEST_TEXQUEUE) {
+            // texture queue handoff speed test
+            StTestTextureQueue aTexQueue;
+            aTexQueue.perform();
+            ++aFound;
+        } else if(aParam == ST_TEST_PKTQUEUE) {
+            // packet queue stress test
+            StTestPacketQueue aPacketQueue;
+            aPacketQueue.perform();
+            ++aFound;
+        } else if(aParam == ST_TEST_PCMCONV) {
+            // PCM samples conversion speed test
+            StTestPcmConvert aPcmConvert;
+            aPcmConvert.perform();
+            ++aFound;
+        } else if(aParam == ST_TEST_YUVCONV) {
+            // YUV -> RGB conversion speed test
+            StTestYuvConvert aYuvConvert;
+            aYuvConvert.perform();
+            ++aFound;
         } else if(aParam == ST_TEST_ALL) {
             // mutex speed test
             StTestMutex aMutices;
             aMutices.perform();
 
+            // logger throughput test
+            StTestLogger aLogger;
+            aLogger.perform();
+
+            // texture queue handoff speed test
+            StTestTextureQueue aTexQueue;
+            aTexQueue.perform();
+
+            // PCM samples conversion speed test
+            StTestPcmConvert aPcmConvert;
+            aPcmConvert.perform();
+
+            // YUV -> RGB conversion speed test
+            StTestYuvConvert aYuvConvert;
+            aYuvConvert.perform();
+
             // gl <-> cpu trasfer speed test
             StTestGlBand aGlBand;
             aGlBand.perform();
@@ -111,7 +162,12 @@ int main(int , char** ) { // force console output
         st::cout << stostream_text("No test selected. Options:\n")
                  << stostream_text("  all    - execute all available tests\n")
                  << stostream_text("  mutex  - mutex speed test\n")
+                 << stostream_text("  logger - logger throughput test\n")
                  << stostream_text("  glband - gl <-> cpu trasfer speed test\n")
+                 << stostream_text("  texqueue - texture queue handoff speed test\n")
+                 << stostream_text("  pktqueue - packet queue stress test\n")
+                 << stostream_text("  pcmconv - PCM samples conversion speed test\n")
+                 << stostream_text("  yuvconv - YUV to RGB conversion speed test\n")
                  << stostream_text("  glhang - gl stress test\n")
                  << stostream_text("  embed  - test window embedding\n")
                  << stostream_text("  image fileName - test image libraries\n");
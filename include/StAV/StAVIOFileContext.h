@@ -10,9 +10,18 @@
 #define __StAVIOFileContext_h_
 
 #include <StAV/StAVIOContext.h>
+#include <StStrings/StString.h>
+#include <StThreads/StCondition.h>
+#include <StThreads/StMutex.h>
+#include <StThreads/StThread.h>
 
 /**
  * Custom AVIO context for the file.
+ *
+ * Optional read-ahead engine (see setReadAhead()) moves file reading into background thread
+ * filling a ring buffer of chunks, so that demuxer is not blocked by slow storage (spinning disks, network mounts).
+ * Ring is filled only by single chunk after seeking and switched to full depth once sequential access is detected,
+ * so that random access (probing, index reading) does not waste I/O bandwidth.
  */
 class StAVIOFileContext : public StAVIOContext {
 
@@ -39,6 +48,39 @@ class StAVIOFileContext : public StAVIOContext {
      */
     ST_CPPEXPORT bool openFromDescriptor(int theFD, const char* theMode);
 
+    /**
+     * Open the file for reading.
+     */
+    ST_CPPEXPORT bool openFile(const StString& thePath);
+
+    /**
+     * Enable read-ahead for the file opened for reading.
+     * Can be called for the file already being read (reading continues from current file position),
+     * but not concurrently with read/seek.
+     * Ring buffer is never larger than the rest of the file.
+     * @param theChunkSize size of single read request in bytes
+     * @param theNbChunks  maximum number of chunks in ring buffer, 0 disables read-ahead
+     * @return true if read-ahead has been enabled
+     */
+    ST_CPPEXPORT bool setReadAhead(const size_t theChunkSize,
+                                   const size_t theNbChunks);
+
+    /**
+     * @return true if read-ahead is active
+     */
+    ST_LOCAL bool hasReadAhead() const {
+        return !myReader.isNull();
+    }
+
+    /**
+     * @return read-ahead buffer fill level within 0..1 range (0 if read-ahead is disabled)
+     */
+    ST_LOCAL double getBufferFill() const {
+        return myRingSize != 0
+             ? double(myRingFilled) / double(myRingSize)
+             : 0.0;
+    }
+
     /**
      * Read from the file.
      */
@@ -59,7 +101,55 @@ class StAVIOFileContext : public StAVIOContext {
 
         protected:
 
-    FILE* myFile;
+    /**
+     * Read from the file through read-ahead buffer.
+     */
+    ST_LOCAL int readBuffered(uint8_t* theBuf,
+                              int      theBufSize);
+
+    /**
+     * Seek within the file with read-ahead.
+     */
+    ST_LOCAL int64_t seekBuffered(int64_t theOffset,
+                                  int     theWhence);
+
+    /**
+     * Stop read-ahead thread and release the buffer.
+     */
+    ST_LOCAL void releaseReadAhead();
+
+    /**
+     * Read-ahead loop.
+     */
+    ST_LOCAL void readerLoop();
+
+    /**
+     * Read-ahead thread function.
+     */
+    ST_LOCAL static SV_THREAD_FUNCTION readerThreadFunction(void* theContext);
+
+        protected:
+
+    FILE*              myFile;
+
+        protected: //! @name read-ahead state, protected by myRingMutex
+
+    StHandle<StThread> myReader;        //!< read-ahead thread
+    StMutex            myRingMutex;     //!< lock for ring state
+    StCondition        myEventData;     //!< signaled when new data, end of file or error reached
+    StCondition        myEventSpace;    //!< signaled when ring has been consumed or position changed
+    uint8_t*           myRing;          //!< ring buffer
+    size_t             myRingSize;      //!< ring buffer size
+    size_t             myChunkSize;     //!< size of single read request
+    size_t             myRingHead;      //!< index of the first valid byte in the ring
+    volatile size_t    myRingFilled;    //!< number of valid bytes in the ring
+    int64_t            myPosition;      //!< consumer position (file offset of myRingHead)
+    int64_t            myFileSize;      //!< file size or -1 if unknown
+    int64_t            mySeqBytes;      //!< bytes consumed since last seek outside of the buffer
+    unsigned int       myGeneration;    //!< incremented on each buffer reset to cancel in-flight read
+    bool               myIsEof;         //!< end of file has been reached by reader
+    bool               myIsError;       //!< read error
+    volatile bool      myToQuit;        //!< flag to stop reader
 
 };
 
@@ -1,5 +1,5 @@
 /**
- * Copyright © 2011-2015 Kirill Gavrilov <kirill@sview.ru>
+ * Copyright © 2011-2017 Kirill Gavrilov <kirill@sview.ru>
  *
  * Distributed under the Boost Software License, Version 1.0.
  * See accompanying file license-boost.txt or copy at
@@ -11,6 +11,7 @@
 
 #include <StImage/StImageFile.h>
 #include <StAV/StAVFrame.h>
+#include <StAV/StAVScaler.h>
 
 struct AVInputFormat;
 struct AVFormatContext;
@@ -46,6 +47,16 @@ class StAVImage : public StImageFile {
     ST_CPPEXPORT static bool resize(const StImage& theImageFrom,
                                     StImage&       theImageTo);
 
+    /**
+     * Same as resize() above but reuses specified scaler.
+     * @param theScaler   scaler to be (re)initialized for this conversion
+     * @param theNbSlices number of slices for StAVScaler::init()
+     */
+    ST_CPPEXPORT static bool resize(const StImage& theImageFrom,
+                                    StImage&       theImageTo,
+                                    StAVScaler&    theScaler,
+                                    const int      theNbSlices = 0);
+
         public:
 
     /**
@@ -61,10 +61,23 @@ class StAVPacket {
 
     ST_CPPEXPORT void setAVpkt(const AVPacket& theCopy);
 
+    /**
+     * Take packet content from another packet without copying reference-counted data.
+     * Packet data is copied only when it is owned by demuxer and can not be referenced.
+     * The source packet is emptied but keeps its properties (type, stereo parameters),
+     * so that it can be reused for reading the next packet.
+     * @param theSrc packet to move content from
+     */
+    ST_CPPEXPORT void moveFrom(StAVPacket& theSrc);
+
     inline const StHandle<StStereoParams>& getSource() const {
         return myStParams;
     }
 
+    inline void setSource(const StHandle<StStereoParams>& theStParams) {
+        myStParams = theStParams;
+    }
+
     inline int getType() const {
         return myType;
     }
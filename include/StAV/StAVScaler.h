@@ -0,0 +1,130 @@
+/**
+ * Copyright © 2017 Kirill Gavrilov <kirill@sview.ru>
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * See accompanying file license-boost.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt
+ */
+
+#ifndef __StAVScaler_h_
+#define __StAVScaler_h_
+
+#include <StAV/stAV.h>
+#include <StThreads/StThread.h>
+
+#include <vector>
+
+/**
+ * Wrapper over swscale performing conversion within horizontal slices in parallel.
+ * Each slice has dedicated SwsContext and (except the first one processed by calling thread) dedicated worker thread.
+ * Slicing is used only for pixel format conversion without resizing; slice boundaries are aligned to chroma subsampling.
+ * Note that each slice is converted as a standalone image, so that the result is NOT bit-exact to single-threaded swscale
+ * for conversions involving vertical filtering (e.g. chroma upsampling/downsampling) - rows near slice boundaries
+ * might differ slightly, since filter does not see rows of neighbor slice.
+ * Resizing is always performed by single context to avoid seams at slice edges.
+ */
+class StAVScaler {
+
+        public:
+
+    /**
+     * Empty constructor.
+     */
+    ST_CPPEXPORT StAVScaler();
+
+    /**
+     * Destructor.
+     */
+    ST_CPPEXPORT ~StAVScaler();
+
+    /**
+     * Release contexts and stop worker threads.
+     */
+    ST_CPPEXPORT void release();
+
+    /**
+     * @return true if scaler has been successfully initialized
+     */
+    ST_LOCAL bool isValid() const {
+        return !mySlices.empty();
+    }
+
+    /**
+     * @return number of slices
+     */
+    ST_LOCAL int getNbSlices() const {
+        return (int )mySlices.size();
+    }
+
+    /**
+     * (Re-)initialize the scaler.
+     * Does nothing if parameters were not changed; existing contexts are reused via sws_getCachedContext() otherwise.
+     * @param theSrcSizeX  source width
+     * @param theSrcSizeY  source height
+     * @param theSrcFormat source pixel format
+     * @param theDstSizeX  destination width
+     * @param theDstSizeY  destination height
+     * @param theDstFormat destination pixel format
+     * @param theNbSlices  number of slices, 0 means auto (limited by number of logical processors and image height);
+     *                     ignored when image is resized
+     * @return true on success
+     */
+    ST_CPPEXPORT bool init(const int           theSrcSizeX,
+                           const int           theSrcSizeY,
+                           const AVPixelFormat theSrcFormat,
+                           const int           theDstSizeX,
+                           const int           theDstSizeY,
+                           const AVPixelFormat theDstFormat,
+                           const int           theNbSlices = 0);
+
+    /**
+     * Perform conversion of entire image.
+     * Returns when all slices have been processed.
+     */
+    ST_CPPEXPORT bool scale(uint8_t* const theSrcData[],
+                            const int      theSrcLinesize[],
+                            uint8_t* const theDstData[],
+                            const int      theDstLinesize[]);
+
+        private:
+
+    struct Slice;
+
+    /**
+     * Convert single slice.
+     */
+    ST_LOCAL void scaleSlice(const Slice& theSlice);
+
+    /**
+     * Worker thread function.
+     */
+    ST_LOCAL static SV_THREAD_FUNCTION threadFunction(void* theSlice);
+
+        private:
+
+    std::vector<Slice*> mySlices;        //!< slices, the first one is processed by calling thread
+    uint8_t* const*     mySrcData;       //!< source planes for current scale() call
+    const int*          mySrcLinesize;   //!< source strides for current scale() call
+    uint8_t* const*     myDstData;       //!< destination planes for current scale() call
+    const int*          myDstLinesize;   //!< destination strides for current scale() call
+    int                 mySrcSizeX;      //!< source width
+    int                 mySrcSizeY;      //!< source height
+    AVPixelFormat       mySrcFormat;     //!< source pixel format
+    int                 myDstSizeX;      //!< destination width
+    int                 myDstSizeY;      //!< destination height
+    AVPixelFormat       myDstFormat;     //!< destination pixel format
+    int                 mySrcNbPlanes;   //!< number of source image planes
+    int                 mySrcChromaShift;//!< vertical chroma subsampling of the source (log2)
+    int                 myDstNbPlanes;   //!< number of destination image planes
+    int                 myDstChromaShift;//!< vertical chroma subsampling of the destination (log2)
+    int                 myNbSlicesReq;   //!< requested number of slices
+    volatile bool       myToQuit;        //!< flag to stop worker threads
+
+        private: //! @name no copies, please
+
+    StAVScaler(const StAVScaler& theCopy);
+    const StAVScaler& operator=(const StAVScaler& theCopy);
+
+};
+
+#endif // __StAVScaler_h_
@@ -1,5 +1,5 @@
 /**
- * Copyright © 2009-2014 Kirill Gavrilov <kirill@sview.ru>
+ * Copyright © 2009-2017 Kirill Gavrilov <kirill@sview.ru>
  *
  * Distributed under the Boost Software License, Version 1.0.
  * See accompanying file license-boost.txt or copy at
@@ -11,6 +11,9 @@
 
 #include <StFile/StFileNode.h>
 
+// forward declarations
+class StFolderScanQueue;
+
 class StFolder : public StFileNode {
 
         public:
@@ -48,6 +51,7 @@ class StFolder : public StFileNode {
 
     /**
      * Read files list in this folder.
+     * Subfolders (when theDeep is greater than 1) are read by several threads.
      * @param theExtensions Extensions filter
      * @param theDeep       Recursion level to read subfolders
      */
@@ -55,13 +59,47 @@ class StFolder : public StFileNode {
                            const int                    theDeep = 1,
                            const bool                   theToAddEmptyFolders = false);
 
+    /**
+     * Read files list in this folder using specified pool of threads for reading subfolders.
+     * The pool can be reused for several folders to avoid creating threads for each one.
+     * @param theQueue pool of threads, defines extensions filter
+     * @param theDeep  Recursion level to read subfolders
+     */
+    ST_CPPEXPORT void init(StFolderScanQueue& theQueue,
+                           const int          theDeep,
+                           const bool         theToAddEmptyFolders = false);
+
         private:
 
+    /**
+     * Add directory entry.
+     * @param theIsFolder entry is a folder
+     * @param theQueue    queue to scan subfolders, or NULL to scan them recursively
+     */
     ST_LOCAL void addItem(const StArrayList<StString>& theExtensions,
-                          int             theDeep,
-                          const StString& theSearchFolderPath,
-                          const StString& theCurrentItemName,
-                          const bool      theToAddEmptyFolders);
+                          const int                    theDeep,
+                          const StString&              theCurrentItemName,
+                          const bool                   theIsFolder,
+                          const bool                   theToAddEmptyFolders,
+                          StFolderScanQueue*           theQueue);
+
+    /**
+     * Read directory entries without sorting.
+     * @param theQueue queue to scan subfolders, or NULL to scan them recursively
+     */
+    ST_LOCAL void readFolder(const StArrayList<StString>& theExtensions,
+                             const int                    theDeep,
+                             const bool                   theToAddEmptyFolders,
+                             StFolderScanQueue*           theQueue);
+
+    /**
+     * Remove empty subfolders and sort the tree.
+     */
+    ST_LOCAL void finalize(const bool theToAddEmptyFolders);
+
+        private:
+
+    friend class StFolderScanQueue;
 
 };
 
@@ -0,0 +1,112 @@
+/**
+ * Copyright © 2017 Kirill Gavrilov <kirill@sview.ru>
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * See accompanying file license-boost.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt
+ */
+
+#ifndef __StFolderScanQueue_h__
+#define __StFolderScanQueue_h__
+
+#include <StStrings/StString.h>
+#include <StTemplates/StArrayList.h>
+#include <StThreads/StCondition.h>
+#include <StThreads/StMutex.h>
+#include <StThreads/StThread.h>
+
+#include <deque>
+#include <vector>
+
+class StFolder;
+
+/**
+ * Queue of subfolders to be scanned by the pool of threads.
+ * Each folder node is filled only by the thread which took it from the queue,
+ * so that the tree can be built without locking the nodes.
+ * Threads are kept until the queue is destroyed, so that the same pool
+ * can be used for several StFolder::init() calls within one scanning job.
+ */
+class StFolderScanQueue {
+
+        public:
+
+    /**
+     * Main constructor.
+     * @param theExtensions extensions filter, should not be modified while queue is alive
+     * @param theNbThreads  number of threads scanning subfolders (including the one calling wait())
+     */
+    ST_CPPEXPORT StFolderScanQueue(const StArrayList<StString>& theExtensions,
+                                   const int                    theNbThreads);
+
+    /**
+     * Destructor, stops the threads.
+     */
+    ST_CPPEXPORT ~StFolderScanQueue();
+
+    /**
+     * @return extensions filter
+     */
+    ST_LOCAL const StArrayList<StString>& getExtensions() const {
+        return myExtensions;
+    }
+
+    /**
+     * Put the folder into the queue.
+     */
+    ST_CPPEXPORT void push(StFolder* theFolder,
+                           const int theDeep);
+
+    /**
+     * Help the pool scanning queued folders until all of them are scanned.
+     */
+    ST_CPPEXPORT void wait();
+
+        private:
+
+    /**
+     * Take the folder from the queue and scan it.
+     * @return false if queue is empty
+     */
+    ST_LOCAL bool performTask();
+
+    /**
+     * Worker loop - takes folders from the queue until the pool is stopped.
+     */
+    ST_LOCAL void workerLoop();
+
+    /**
+     * Worker thread function.
+     */
+    ST_LOCAL static SV_THREAD_FUNCTION workerThreadFunction(void* theQueue);
+
+        private:
+
+    /**
+     * Folder to be scanned.
+     */
+    struct Task {
+        StFolder* Folder;
+        int       Deep;
+        Task(StFolder* theFolder, const int theDeep) : Folder(theFolder), Deep(theDeep) {}
+    };
+
+        private:
+
+    const StArrayList<StString>&      myExtensions; //!< extensions filter
+    std::vector< StHandle<StThread> > myThreads;    //!< worker threads
+    StMutex                           myMutex;      //!< lock for the queue
+    StCondition                       myEventTask;  //!< event signaled on new task or when pool is stopped
+    StCondition                       myEventIdle;  //!< event signaled when all tasks are done
+    std::deque<Task>                  myTasks;      //!< folders to scan
+    int                               myNbActive;   //!< number of folders being scanned
+    volatile bool                     myToQuit;     //!< flag to stop the threads
+
+        private: //! @name no copies, please
+
+    StFolderScanQueue(const StFolderScanQueue& theCopy);
+    const StFolderScanQueue& operator=(const StFolderScanQueue& theCopy);
+
+};
+
+#endif // __StFolderScanQueue_h__
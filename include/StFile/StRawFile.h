@@ -1,5 +1,5 @@
 /**
- * Copyright © 2009-2014 Kirill Gavrilov <kirill@sview.ru>
+ * Copyright © 2009-2017 Kirill Gavrilov <kirill@sview.ru>
  *
  * Distributed under the Boost Software License, Version 1.0.
  * See accompanying file license-boost.txt or copy at
@@ -72,6 +72,29 @@ class StRawFile : public StFileNode {
      */
     ST_CPPEXPORT void freeBuffer();
 
+    /**
+     * Allow readFile() to map local files into memory instead of reading them into allocated buffer.
+     * Mapping is private (copy-on-write), so that the buffer still can be modified,
+     * and is zero-padded after the end (at least THE_MAP_PADDING bytes, enough for FFmpeg input padding).
+     * Reading is used as fallback for remote protocols, partial reading and when mapping fails or is unsupported.
+     *
+     * Only stable files are mapped - regular files of at least 1 MiB not modified within last seconds
+     * and not modified while being mapped; the others are read.
+     * Beware that truncating the file by another process while the buffer is in use
+     * would raise SIGBUS on access to the lost pages, so that mapping should not be allowed
+     * for files which might be rewritten in place (like cache files written by the application itself).
+     */
+    void setMappingAllowed(const bool theToAllow) {
+        myToMap = theToAllow;
+    }
+
+    /**
+     * @return true if the buffer is a memory-mapped file
+     */
+    bool isMapped() const {
+        return myMapSize != 0;
+    }
+
     /**
      * Returns true if file is opened.
      */
@@ -139,8 +162,19 @@ class StRawFile : public StFileNode {
      */
     ST_CPPEXPORT static StString readTextFile(const StCString& theFilePath);
 
+    /**
+     * Minimal number of zero bytes after the end of mapped file.
+     */
+    static const size_t THE_MAP_PADDING = 64;
+
         private:
 
+    /**
+     * Map opened local file into memory.
+     * @return false if file can not be mapped
+     */
+    ST_LOCAL bool mapOpenedFile();
+
     /**
      * Interruption callback.
      */
@@ -159,6 +193,8 @@ class StRawFile : public StFileNode {
     stUByte_t*   myBuffer;     //!< buffer with file content
     size_t       myBuffSize;   //!< buffer size
     size_t       myLength;     //!< data length
+    size_t       myMapSize;    //!< size of mapped region including padding (0 if buffer is allocated)
+    bool         myToMap;      //!< allow mapping the file in readFile()
 
 };
 
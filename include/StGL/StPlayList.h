@@ -1,5 +1,5 @@
 /**
- * Copyright © 2009-2015 Kirill Gavrilov <kirill@sview.ru>
+ * Copyright © 2009-2017 Kirill Gavrilov <kirill@sview.ru>
  *
  * Distributed under the Boost Software License, Version 1.0.
  * See accompanying file license-boost.txt or copy at
@@ -13,10 +13,13 @@
 #include <StGL/StParams.h>
 
 #include <StGLStereo/StGLTextureQueue.h>
+#include <StThreads/StCondition.h>
 #include <StThreads/StMinGen.h>
+#include <StThreads/StThread.h>
 #include <StSlots/StSignal.h>
 
 #include <deque>
+#include <vector>
 
 /**
  * Playlist node.
@@ -36,26 +39,6 @@ class StPlayItem {
      */
     ST_CPPEXPORT ~StPlayItem();
 
-    inline StPlayItem* getPrev() {
-        return myPrevItem;
-    }
-
-    ST_CPPEXPORT void setPrev(StPlayItem* thePrev);
-
-    inline StPlayItem* getNext() {
-        return myNextItem;
-    }
-
-    ST_CPPEXPORT void setNext(StPlayItem* theNext);
-
-    inline bool hasPrev() const {
-        return myPrevItem != NULL;
-    }
-
-    inline bool hasNext() const {
-        return myNextItem != NULL;
-    }
-
     inline size_t getPosition() const {
         return myPosition;
     }
@@ -84,29 +67,19 @@ class StPlayItem {
         return myStParams;
     }
 
-    inline bool getPlayedFlag() const {
-        return myPlayFlag;
-    }
-
-    inline void setPlayedFlag(bool theFlag) {
-        myPlayFlag = theFlag;
-    }
-
         private:
 
-    StPlayItem* myPrevItem; //!< previous item in list
-    StPlayItem* myNextItem; //!< next item in list
     size_t      myPosition; //!< position in list
     StFileNode* myFileNode; //!< link to file node
     StHandle<StStereoParams> myStParams; //!< stereo parameters
     StString    myTitle;    //!< item title
-    bool        myPlayFlag; //!< flag for shuffle check
 
 };
 
 /**
- * This is playlist class. All items stored in double-linked list
- * and provides fast sequential (but not random) access.
+ * This is playlist class. All items stored in array (item position is an index in this array)
+ * and provides fast random access.
+ * Shuffle playback walks through the random permutation of items generated for each iteration.
  * All public methods are thread-safe, thus returns the objects copies.
  */
 class StPlayList {
@@ -202,6 +175,26 @@ class StPlayList {
         return getCurrentFile(theFileNode, theParams, aPlsFile);
     }
 
+    /**
+     * Returns files of the items which are likely to be opened after the current one.
+     * The list is sorted by priority: next item (within shuffle order when shuffle is enabled),
+     * previous item, then items on distance 2 and so on.
+     * Current position is not changed.
+     * @param theRadius number of items to retrieve in each direction
+     * @param theFiles  output list of file nodes
+     */
+    ST_CPPEXPORT void getNeighbourFiles(const size_t                         theRadius,
+                                        std::vector< StHandle<StFileNode> >& theFiles);
+
+    /**
+     * Returns file of the item which will be opened after the current one on playback end
+     * (the same item as walkToNext(false) would choose).
+     * Current position is not changed.
+     * @param theFileNode output file node
+     * @return false if there is no next item, it is not yet determined or it is the current item (loop single / one-item loop)
+     */
+    ST_CPPEXPORT bool getNextFile(StHandle<StFileNode>& theFileNode);
+
     ST_CPPEXPORT void addToNode(const StHandle<StFileNode>& theFileNode,
                                 const StString&             thePathToAdd);
 
@@ -247,12 +240,12 @@ class StPlayList {
      * @return current playlist size
      */
     ST_LOCAL inline size_t getItemsCount() const {
-        return myItemsCount;
+        return myItems.size();
     }
 
     ST_LOCAL bool isEmpty() const {
         StMutexAuto anAutoLock(myMutex);
-        return myFirst == NULL;
+        return myItems.isEmpty();
     }
 
     /**
@@ -309,6 +302,10 @@ class StPlayList {
      * If given path is a folder than it content will be added to list.
      * If given path is a file than playlist will be fill with folder content
      * and playlist position will be set to this file.
+     * Folder content is read in background and appended to the list incrementally
+     * (onPlaylistChange is emitted for each portion):
+     * the opened file is added to the list immediately,
+     * while for opened folder the method returns as soon as the first items are available.
      */
     ST_CPPEXPORT void open(const StCString& thePath,
                            const StCString& theItem = stCString(""));
@@ -411,20 +408,67 @@ class StPlayList {
         private:
 
     /**
-     * Add new item to double-linked list.
+     * Add new item to the end of the list.
      */
     ST_LOCAL void addPlayItem(StPlayItem* theNewItem);
 
     /**
-     * Remove the item from double-linked list but NOT destroy it.
+     * Remove the item from the list but NOT destroy it.
      */
     ST_LOCAL void delPlayItem(StPlayItem* theRemItem);
 
+    /**
+     * Generate new random permutation of items for shuffle playback (Fisher-Yates shuffle).
+     * Current item is put at the beginning of permutation.
+     */
+    ST_LOCAL void shuffleItems();
+
+    /**
+     * @return first item or NULL if list is empty
+     */
+    ST_LOCAL StPlayItem* getFirstItem() const {
+        return !myItems.isEmpty() ? myItems.getFirst() : NULL;
+    }
+
+    /**
+     * @return last item or NULL if list is empty
+     */
+    ST_LOCAL StPlayItem* getLastItem() const {
+        return !myItems.isEmpty() ? myItems.getLast() : NULL;
+    }
+
     /**
      * Recursively add all file nodes to playlist.
      */
     ST_LOCAL void addToPlayList(StFileNode* theFileNode);
 
+    /**
+     * Recursively add scanned file nodes to playlist.
+     * Item matching the scan target is made current (existing item with the same path is moved instead of creating new one).
+     * Should be called under lock.
+     */
+    ST_LOCAL void addScannedNode(StFileNode* theFileNode);
+
+    /**
+     * Append scanned file nodes to playlist (if scan job has not been cancelled).
+     * @param theFolder scanned folder
+     * @param theFrom   index of the first node within the folder to add
+     * @param theGen    scan job number
+     */
+    ST_LOCAL void publishScanned(StFileNode*  theFolder,
+                                 const size_t theFrom,
+                                 const int    theGen);
+
+    /**
+     * Folder scanning thread loop.
+     */
+    ST_LOCAL void scanLoop();
+
+    /**
+     * Folder scanning thread function.
+     */
+    ST_LOCAL static SV_THREAD_FUNCTION scanThreadFunction(void* thePlayList);
+
     /**
      * Add file to list of recent files.
      */
@@ -447,16 +491,15 @@ class StPlayList {
 
     mutable StMutex         myMutex;         //!< mutex for thread-safe access
     StFolder                myFoldersRoot;   //!< common root for all file nodes
-    StPlayItem*             myFirst;         //!< double-linked list, start node
-    StPlayItem*             myLast;          //!< double-linked list, last node
+    StArrayList<StPlayItem*> myItems;        //!< playlist items, item position is an index in this array
     StPlayItem*             myCurrent;       //!< current playback node
     std::deque<StPlayItem*> myStackPrev;     //!< stack of previous items (for shuffle playback)
     std::deque<StPlayItem*> myStackNext;     //!< stack of next     items (for shuffle playback)
-    size_t                  myItemsCount;    //!< current playlist size
     StArrayList<StString>   myExtensions;    //!< extensions list
     StStereoParams          myDefStParams;   //!< default stereo parameters
     StMinGen                myRandGen;       //!< random number generator for shuffle playback
-    size_t                  myPlayedCount;   //!< played items in current iteration (< myItemsCount)
+    StArrayList<size_t>     myShuffleOrder;  //!< random permutation of items positions for shuffle playback (empty if invalidated)
+    size_t                  myShuffleIter;   //!< position of last walked item within myShuffleOrder
     int                     myRecursionDeep;
     bool                    myIsShuffle;
     bool                    myToLoopSingle;  //!< play single item in loop
@@ -470,6 +513,16 @@ class StPlayList {
     StAtomic<int32_t>       mySerial;        //!< serial number of playlist content
     bool                    myWasCleared;    //!< flag to indicate that playlist was cleared recently
 
+    StHandle<StThread>      myScanThread;    //!< folder scanning thread, created on first use
+    StCondition             myScanEvent;     //!< event signaled on new scan job
+    StCondition             myScanFirstEvent;//!< event signaled when first items (or target item) have been added by scan job
+    StFolder*               myScanFolder;    //!< folder to scan (owned by myFoldersRoot)
+    StString                myScanTarget;    //!< path to the item to be made current by scan job
+    int                     myScanDeep;      //!< recursion level for scan job
+    volatile int            myScanGen;       //!< scan job counter, incremented on open() / clear()
+    bool                    myHasScanJob;    //!< pending scan job flag
+    volatile bool           myToQuitScan;    //!< flag to stop scanning thread
+
 };
 
 #endif // __StPlayList_h__
@@ -1,5 +1,5 @@
 /**
- * Copyright © 2009-2016 Kirill Gavrilov <kirill@sview.ru>
+ * Copyright © 2009-2017 Kirill Gavrilov <kirill@sview.ru>
  *
  * Distributed under the Boost Software License, Version 1.0.
  * See accompanying file license-boost.txt or copy at
@@ -12,12 +12,21 @@
 #include <StImage/StImage.h>
 #include <StGLStereo/StGLQuadTexture.h>
 #include <StGL/StGLDeviceCaps.h>
+#include <StThreads/StAtomicOp.h>
 
 /**
  * This class represents stereo data for textures
  * in separate buffers.
  * Also structure store pointers for next and previous
  * StTextureData in queue.
+ *
+ * When OpenGL context supports persistently mapped buffers,
+ * the data is copied by updateData() directly into the Pixel Buffer Object
+ * allocated for this slot (within first fillTexture() call),
+ * so that GL thread uploads the frame from buffer offsets asynchronously.
+ * The slot is released to producer right after the upload commands have been issued;
+ * producer falls back to the heap memory until GL thread finds the fence put behind these commands signaled
+ * (see stglCheckPboFence()), so that the buffer is never overwritten while GL still reads it.
  */
 class StGLTextureData {
 
@@ -83,41 +92,12 @@ class StGLTextureData {
     }
 
     /**
-     * Iterator's function.
-     * @return previous item
+     * Return the number of bytes copied by last updateData() call.
+     * Zero means that the frame is uploaded directly from decoder buffers (by reference).
+     * Copying into mapped Pixel Buffer Object is counted as well.
      */
-    inline StGLTextureData* getPrev() {
-        return myPrev;
-    }
-
-    /**
-     * Iterator's function, communicate queue.
-     * @param textureData setted previous item
-     */
-    inline void setPrev(StGLTextureData* theTextureData) {
-        myPrev = theTextureData;
-        if(theTextureData != NULL) {
-            theTextureData->myNext = this;
-        }
-    }
-
-    /**
-     * Iterator's function.
-     * @return next item
-     */
-    inline StGLTextureData* getNext() {
-        return myNext;
-    }
-
-    /**
-     * Iterator's function, communicate queue.
-     * @param textureData setted next item
-     */
-    inline void setNext(StGLTextureData* theTextureData) {
-        myNext = theTextureData;
-        if(theTextureData != NULL) {
-            theTextureData->myPrev = this;
-        }
+    ST_LOCAL size_t getCopiedBytes() const {
+        return myCopiedBytes;
     }
 
     /**
@@ -151,12 +131,42 @@ class StGLTextureData {
 
     /**
      * Release memory.
+     * Pixel Buffer Object is preserved, see stglReleasePbo().
      */
     ST_CPPEXPORT void reset();
 
+    /**
+     * Release Pixel Buffer Object.
+     * The data currently located within the buffer is moved to the heap memory.
+     * Should be called from GL thread while the slot is not accessed by producer.
+     */
+    ST_CPPEXPORT void stglReleasePbo(StGLContext& theCtx);
+
+    /**
+     * @return true if the data is located within mapped Pixel Buffer Object
+     */
+    ST_LOCAL bool isPboData() const {
+        return myDataPtr != NULL
+            && myDataPtr == myPboPtr;
+    }
+
+    /**
+     * Check the fence put after last upload from Pixel Buffer Object.
+     * Should be called from GL thread, the slot might be filled by producer concurrently.
+     * @return true if buffer is not used by GL anymore
+     */
+    ST_CPPEXPORT bool stglCheckPboFence(StGLContext& theCtx);
+
         private:
 
-    ST_LOCAL bool reAllocate(const size_t theSizeBytes);
+    ST_LOCAL bool reAllocate(const size_t theSizeBytes,
+                             const bool   theToUsePbo);
+
+    /**
+     * (Re)create persistently mapped Pixel Buffer Object of requested size.
+     */
+    ST_LOCAL bool stglInitPbo(StGLContext& theCtx,
+                              const size_t theSizeBytes);
 
     ST_LOCAL void copyProps(const StImage& theDataL,
                             const StImage& theDataR);
@@ -171,17 +181,21 @@ class StGLTextureData {
      */
     ST_LOCAL void fillTexture(StGLContext&        theCtx,
                               StGLFrameTexture&   theFrameTexture,
-                              const StImagePlane& theData);
+                              const StImagePlane& theData,
+                              const GLubyte*      theUnpackBase);
 
     ST_LOCAL void setupAttributes(StGLFrameTextures& stFrameTextures, const StImage& theImage);
 
-        private:
+    /**
+     * Setup texture attributes when all data has been uploaded.
+     */
+    ST_LOCAL void finishFill(StGLQuadTexture& theQTexture);
 
-    StGLTextureData*         myPrev;          //!< pointer to previous item in the list
-    StGLTextureData*         myNext;          //!< pointer to next item
+        private:
 
     GLubyte*                 myDataPtr;       //!< data for left and right views
     size_t                   myDataSizeBytes; //!< allocated data size in bytes
+    size_t                   myCopiedBytes;   //!< number of bytes copied by last updateData()
     StImage                  myDataPair;
     StImage                  myDataL;
     StImage                  myDataR;
@@ -194,6 +208,13 @@ class StGLTextureData {
     GLsizei                  myFillFromRow;
     GLsizei                  myFillRows;
 
+    GLuint                   myPbo;           //!< persistently mapped Pixel Buffer Object
+    void*                    myPboFence;      //!< GLsync fence put after upload commands from PBO
+    volatile int32_t         myIsPboBusy;     //!< flag indicating that the fence is not yet signaled, read by producer
+    GLubyte*                 myPboPtr;        //!< mapped PBO memory
+    size_t                   myPboSizeBytes;  //!< allocated PBO size in bytes
+    size_t                   myPboSizeWanted; //!< PBO size requested by last updateData()
+
 };
 
 #endif // __StGLTextureData_h_
@@ -1,5 +1,5 @@
 /**
- * Copyright © 2009-2016 Kirill Gavrilov <kirill@sview.ru>
+ * Copyright © 2009-2017 Kirill Gavrilov <kirill@sview.ru>
  *
  * Distributed under the Boost Software License, Version 1.0.
  * See accompanying file license-boost.txt or copy at
@@ -9,11 +9,15 @@
 #ifndef __StGLTextureQueue_h_
 #define __StGLTextureQueue_h_
 
+#include <StThreads/StAtomicOp.h>
 #include <StThreads/StCondition.h>
 #include <StThreads/StFPSMeter.h>
+#include <StThreads/StLatencyMeter.h>
 #include <StThreads/StMutex.h>
+#include <StThreads/StMutexSlim.h>
 
 #include <StGL/StGLDeviceCaps.h>
+#include <StImage/StImageTiles.h>
 
 #include "StGLQuadTexture.h"
 #include "StGLTextureData.h"
@@ -26,6 +30,11 @@
  * Method stglUpdateStTextures() should be called each rendering call from GL thread to update textures.
  * Method push() should be used to fill in queue with new frames and stglSwapFB() to pop frame from queue
  * to display.
+ *
+ * Frames are stored within fixed-size ring buffer shared by single producer (video thread)
+ * and single consumer (GL thread) using atomic counters of pushed and popped frames,
+ * so that push() / stglUpdateStTextures() / popPTSNext() do not lock each other.
+ * Rare control operations (clear(), drop(), getSnapshot()) are still serialized with consumer.
  */
 class StGLTextureQueue {
 
@@ -45,9 +54,10 @@ class StGLTextureQueue {
      * Set device capabilities.
      */
     ST_LOCAL void setDeviceCaps(const StGLDeviceCaps& theCaps) {
-        myMutexPush.lock();
-        myDeviceCaps = theCaps;
-        myMutexPush.unlock();
+        myMutexCaps.lock();
+        myDeviceCapsNew = theCaps;
+        StAtomicOp::Store(myHasNewCaps, 1);
+        myMutexCaps.unlock();
     }
 
     /**
@@ -89,6 +99,26 @@ class StGLTextureQueue {
                            const StCubemap    theSrcCubemap,
                            const double       theSrcPTS);
 
+    /**
+     * Attach full-resolution tiles source to the pushed image which has been downscaled to fit texture limits.
+     * This function called from video thread right after push().
+     */
+    ST_LOCAL void setTiles(const StHandle<StImageTiles>& theTiles) {
+        myMutexTiles.lock();
+        myTiles = theTiles;
+        myMutexTiles.unlock();
+    }
+
+    /**
+     * @return full-resolution tiles source (might be NULL or belong to another image than the front one)
+     */
+    ST_LOCAL StHandle<StImageTiles> getTiles() const {
+        myMutexTiles.lock();
+        const StHandle<StImageTiles> aTiles = myTiles;
+        myMutexTiles.unlock();
+        return aTiles;
+    }
+
     /**
      * Retrieve queue statistics.
      */
@@ -97,7 +127,7 @@ class StGLTextureQueue {
                                       double& theFps) {
         myMeterMutex.lock();
         if(myHasStream) {
-            theQueued   = int(myQueueSize + 1);
+            theQueued   = int(getSize() + 1);
             theQueueLen = int(myQueueSizeMax);
             theFps      = myFPSMeter.getAverage();
         } else {
@@ -108,10 +138,32 @@ class StGLTextureQueue {
         const bool isUpdated = myFPSMeter.isUpdated();
         myMeterMutex.unlock();
         if(isUpdated) {
-            ST_DEBUG_LOG("Queue playback FPS " + theFps + ", buffers: " + theQueued + "/" + theQueueLen);
+            ST_DEBUG_LOG("Queue playback FPS " + theFps + ", buffers: " + theQueued + "/" + theQueueLen
+                       + ", copied: " + (getCopiedBytes() / 1024) + " KiB/frame");
         }
     }
 
+    /**
+     * @return per-stage latency statistics (disabled by default)
+     */
+    ST_LOCAL StLatencyMeter& changeLatencyMeter() {
+        return myLatencyMeter;
+    }
+
+    /**
+     * @return overall number of frames dropped to catch up playback
+     */
+    ST_LOCAL uint32_t getDroppedFrames() const {
+        return StAtomicOp::Load(myCountDropped);
+    }
+
+    /**
+     * @return number of bytes copied (not passed by reference) while pushing the last frame
+     */
+    ST_LOCAL size_t getCopiedBytes() const {
+        return (size_t )StAtomicOp::Load(myCopiedBytes);
+    }
+
     /**
      * Function called in loop from general GL draw loop
      * and do update quad texture data / state (display frame).
@@ -119,41 +171,41 @@ class StGLTextureQueue {
      */
     ST_CPPEXPORT bool stglUpdateStTextures(StGLContext& theCtx);
 
+    /**
+     * @return number of frames in queue.
+     */
     ST_LOCAL size_t getSize() const {
-        myMutexSize.lock();
-            const size_t aResult = myQueueSize;
-        myMutexSize.unlock();
-        return aResult;
+        // popped counter should be read first - it never overtakes pushed one
+        const uint32_t aPopped = StAtomicOp::Load(myCountPopped);
+        const uint32_t aPushed = StAtomicOp::Load(myCountPushed);
+        return size_t(aPushed - aPopped);
     }
 
     /**
      * @return true if queue is EMPTY.
      */
     ST_LOCAL bool isEmpty() const {
-        myMutexSize.lock();
-            const bool aResult = (myQueueSize == 0);
-        myMutexSize.unlock();
-        return aResult;
+        return getSize() == 0;
     }
 
     /**
      * @return true if queue is FULL.
      */
     ST_LOCAL bool isFull() const {
-        myMutexSize.lock();
-            const bool aResult = ((myQueueSize + 1) == myQueueSizeMax);
-        myMutexSize.unlock();
-        return aResult;
+        // one slot is always reserved for the last shown frame (snapshot)
+        return (getSize() + 1) >= myQueueSizeMax;
     }
 
     /**
      * @return presentation timestamp of currently shown frame (or -1 if none).
      */
     ST_LOCAL double getPTSCurr() const {
-        myMutexSize.lock();
-            const double aPts = (myHasStream || myQueueSize != 0)
-                              ? myCurrPts : -1.0;
-        myMutexSize.unlock();
+        if(!myHasStream && isEmpty()) {
+            return -1.0;
+        }
+        myMutexPts.lock();
+        const double aPts = myCurrPts;
+        myMutexPts.unlock();
         return aPts;
     }
 
@@ -161,22 +213,21 @@ class StGLTextureQueue {
      * @param thePts - next (front) stereo frame PTS (presentation timestamp);
      * @return false if next PTS not available.
      */
-    ST_LOCAL bool popPTSNext(double& thePts) {
-        bool aRes = false;
-        myMutexPop.lock();
-        myMutexPush.lock();
-        myMutexSize.lock();
-            // make sure front data is valid
-            if(myQueueSize < 1) {
-                aRes = false;
-            } else {
-                aRes = true;
-                thePts = myDataFront->getPTS();
+    ST_LOCAL bool popPTSNext(double& thePts) const {
+        for(;;) {
+            const uint32_t aPopped = StAtomicOp::Load(myCountPopped);
+            if(StAtomicOp::Load(myCountPushed) == aPopped) {
+                return false;
+            }
+
+            // front frame can not be overridden by producer until consumer pops it,
+            // so the value is valid if front frame remained the same after reading
+            const double aPts = myDataRing[aPopped % myQueueSizeMax].getPTS();
+            if(StAtomicOp::Load(myCountPopped) == aPopped) {
+                thePts = aPts;
+                return true;
             }
-        myMutexSize.unlock();
-        myMutexPush.unlock();
-        myMutexPop.unlock();
-        return aRes;
+        }
     }
 
     /**
@@ -195,6 +246,52 @@ class StGLTextureQueue {
         return false;
     }
 
+    /**
+     * Wait until frame is popped from the queue (displayed or dropped).
+     * Should be used by producer instead of polling full queue.
+     * Notice that caller should re-check the queue state after waiting.
+     * @param theTimeMilliseconds wait limit
+     * @return true if event has been signaled
+     */
+    ST_LOCAL bool waitPop(const size_t theTimeMilliseconds) {
+        const bool isSignaled = myPopEvent.wait(theTimeMilliseconds);
+        myPopEvent.reset();
+        return isSignaled;
+    }
+
+    /**
+     * Wait until new frame is pushed into the queue.
+     * Should be used by timer thread instead of polling empty queue.
+     * @param theTimeMilliseconds wait limit
+     * @return true if event has been signaled
+     */
+    ST_LOCAL bool waitPush(const size_t theTimeMilliseconds) {
+        const bool isSignaled = myPushEvent.wait(theTimeMilliseconds);
+        myPushEvent.reset();
+        return isSignaled;
+    }
+
+    /**
+     * Wait until swap counter is decreased by GL thread.
+     * Should be used by timer thread instead of polling stglSwapFB().
+     * @param theTimeMilliseconds wait limit
+     * @return true if event has been signaled
+     */
+    ST_LOCAL bool waitSwap(const size_t theTimeMilliseconds) {
+        const bool isSignaled = mySwapEvent.wait(theTimeMilliseconds);
+        mySwapEvent.reset();
+        return isSignaled;
+    }
+
+    /**
+     * Wake up all threads waiting for queue events (e.g. on flush or quit).
+     */
+    ST_LOCAL void wakeUp() {
+        myPopEvent.set();
+        myPushEvent.set();
+        mySwapEvent.set();
+    }
+
     /**
      * Release unused memory as fast as possible.
      */
@@ -205,6 +302,14 @@ class StGLTextureQueue {
      */
     ST_CPPEXPORT void clear();
 
+    /**
+     * Release Pixel Buffer Objects within all slots.
+     * Should be called from GL thread before releasing the GL context.
+     * Queued frames are preserved (moved into the heap memory).
+     * Waits for producer in case it is filling the slot at this moment.
+     */
+    ST_CPPEXPORT void stglReleasePbo(StGLContext& theCtx);
+
     /**
      * This function clean up only requested number of frames but prevents queue emptying.
      * At least one frame will remain in queue.
@@ -215,12 +320,9 @@ class StGLTextureQueue {
      * Function used to get current showed source format.
      * At this moment function used just for stereo/mono recognizing.
      */
-    ST_LOCAL int getSrcFormat() {
-        myMutexSrcFormat.lock();
-            // TODO (Kirill Gavrilov#4#) source format should be defined like front PTS to prevent early changes
-            const int aSrcFrmt = myCurrSrcFormat;
-        myMutexSrcFormat.unlock();
-        return aSrcFrmt;
+    ST_LOCAL int getSrcFormat() const {
+        // TODO (Kirill Gavrilov#4#) source format should be defined like front PTS to prevent early changes
+        return StAtomicOp::Load(myCurrSrcFormat);
     }
 
     enum {
@@ -244,17 +346,35 @@ class StGLTextureQueue {
 
     ST_CPPEXPORT int swapFBOnReady(StGLContext& theCtx);
 
+    /**
+     * @return frame slot for specified counter value
+     */
+    ST_LOCAL StGLTextureData& getSlot(const uint32_t theCounter) {
+        return myDataRing[theCounter % myQueueSizeMax];
+    }
+
+    /**
+     * Reset the flag set by producer while filling the slot.
+     */
+    ST_LOCAL void finishPush();
+
+    /**
+     * Check fences put after uploads from Pixel Buffer Objects within all slots.
+     */
+    ST_LOCAL void stglCheckPboFences(StGLContext& theCtx);
+
         private:
 
-    StMutex          myMutexPop;
-    StGLTextureData* myDataFront;      //!< queue pointer
-    StGLTextureData* myDataSnap;       //!< snapshot pointer
-    StMutex          myMutexPush;
-    StGLTextureData* myDataBack;       //!< queue pointer
+    StGLTextureData* myDataRing;       //!< ring buffer of frames
+    size_t           myQueueSizeMax;   //!< ring buffer size
+    volatile uint32_t myCountPushed;   //!< number of pushed frames, modified only by producer (back of the queue)
+    volatile uint32_t myCountPopped;   //!< number of popped frames, modified only by consumer (front of the queue)
+    volatile uint32_t myCountDropped;  //!< number of frames dropped by drop()
 
-    mutable StMutex  myMutexSize;
-    size_t           myQueueSize;
-    size_t           myQueueSizeMax;
+    volatile int32_t myIsPushing;      //!< flag indicating that producer fills the back slot
+    volatile int32_t myToReleasePbo;   //!< flag indicating that GL thread waits for producer to release PBOs
+    StMutex          myMutexPop;       //!< lock consumer for control operations (clear, drop, snapshot)
+    StGLTextureData* myDataSnap;       //!< snapshot pointer
 
     StGLQuadTexture  myQTexture;       //!< quad stereo texture
 
@@ -263,19 +383,33 @@ class StGLTextureQueue {
 
     StMutex          myMeterMutex;
     StFPSMeter       myFPSMeter;
+    StLatencyMeter   myLatencyMeter;   //!< per-stage latency statistics (benchmark mode)
+    StTimer          myUploadTimer;    //!< accumulated upload time of the front frame
+    StTimer          myReadyTimer;     //!< time elapsed since the uploaded frame became ready to swap
+
+    volatile int32_t myCurrSrcFormat;  //!< current source format
+    volatile uint32_t myCopiedBytes;   //!< number of bytes copied by last push()
 
-    StMutex          myMutexSrcFormat;
-    int              myCurrSrcFormat;  //!< current source format
+    mutable StMutexSlim myMutexPts;
+    double           myCurrPts;        //!< presentation timestamp of currently shown frame
 
-    double           myCurrPts;
+    mutable StMutexSlim    myMutexTiles;
+    StHandle<StImageTiles> myTiles;    //!< full-resolution tiles of the last pushed image
 
     StCondition      myNewShotEvent;
+    StCondition      myPopEvent;       //!< event signaled when frame is popped from the queue
+    StCondition      myPushEvent;      //!< event signaled when frame is pushed into the queue
+    StCondition      mySwapEvent;      //!< event signaled when swap counter is decreased
+    StCondition      myPushDoneEvent;  //!< event signaled when producer has finished filling the slot while PBOs are released
     bool             myIsInUpdTexture; //!< private bools for plugin thread
     bool             myIsReadyToSwap;
     bool             myToCompress;     //!< release unused memory as fast as possible
     volatile bool    myHasStream;      //!< flag indicates that some stream connected to this queue
 
-    StGLDeviceCaps   myDeviceCaps;     //!< device capabilities
+    StGLDeviceCaps   myDeviceCaps;     //!< device capabilities, used by producer
+    StMutex          myMutexCaps;
+    StGLDeviceCaps   myDeviceCapsNew;  //!< device capabilities to be picked up by producer
+    volatile int32_t myHasNewCaps;
 
 };
 
@@ -0,0 +1,111 @@
+/**
+ * Copyright © 2017 Kirill Gavrilov <kirill@sview.ru>
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * See accompanying file license-boost.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt
+ */
+
+#ifndef __StGLTileAtlas_h_
+#define __StGLTileAtlas_h_
+
+#include <StGL/StGLTexture.h>
+#include <StGL/StGLVec.h>
+#include <StImage/StImageTiles.h>
+
+#include <vector>
+
+/**
+ * Texture atlas holding fixed number of image tiles (StImageTiles).
+ * The atlas texture size defines the video memory budget for tiles,
+ * least recently used tiles are replaced by new ones.
+ */
+class StGLTileAtlas : public StGLResource {
+
+        public:
+
+    /**
+     * Empty constructor.
+     */
+    ST_CPPEXPORT StGLTileAtlas();
+
+    /**
+     * Destructor.
+     */
+    ST_CPPEXPORT virtual ~StGLTileAtlas();
+
+    /**
+     * Release GL resources.
+     */
+    ST_CPPEXPORT virtual void release(StGLContext& theCtx) ST_ATTR_OVERRIDE;
+
+    /**
+     * @return the atlas texture
+     */
+    ST_LOCAL StGLTexture& changeTexture() {
+        return myTexture;
+    }
+
+    /**
+     * @return number of tile slots (0 if atlas is not initialized)
+     */
+    ST_LOCAL int getNbSlots() const {
+        return int(mySlots.size());
+    }
+
+    /**
+     * Initialize the atlas texture (does nothing if already initialized).
+     */
+    ST_CPPEXPORT bool stglInit(StGLContext& theCtx);
+
+    /**
+     * Forget all uploaded tiles.
+     */
+    ST_CPPEXPORT void clear();
+
+    /**
+     * Start the new frame - tiles used within this frame are not replaced.
+     */
+    ST_LOCAL void nextFrame() {
+        ++myFrame;
+    }
+
+    /**
+     * Find the tile and mark it as used within current frame.
+     * @param theKey     tile identifier
+     * @param theTexData tile data rectangle in the texture (offset and size)
+     * @return false if the tile is not in the atlas
+     */
+    ST_CPPEXPORT bool find(const StImageTileKey& theKey,
+                           StGLVec4&             theTexData);
+
+    /**
+     * Upload the tile into the atlas, replacing least recently used one.
+     * @return false if there is no slot to replace
+     */
+    ST_CPPEXPORT bool stglUpload(StGLContext&       theCtx,
+                                 const StImageTile& theTile);
+
+        private:
+
+    /**
+     * Tile slot within the atlas.
+     */
+    struct Slot {
+        StImageTileKey Key;      //!< tile identifier
+        int            SizeX;    //!< tile width
+        int            SizeY;    //!< tile height
+        unsigned int   LastUsed; //!< frame when the tile was used last time
+        bool           IsEmpty;  //!< empty slot flag
+    };
+
+        private:
+
+    StGLTexture       myTexture;     //!< atlas texture
+    std::vector<Slot> mySlots;       //!< tile slots
+    int               mySlotsPerRow; //!< number of slots within the texture row
+    unsigned int      myFrame;       //!< current frame
+
+};
+
+#endif // __StGLTileAtlas_h_
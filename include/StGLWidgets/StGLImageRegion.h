@@ -16,6 +16,7 @@
 #include <StGLWidgets/StGLWidget.h>
 #include <StGLWidgets/StGLImageProgram.h>
 #include <StGLStereo/StGLTextureQueue.h>
+#include <StGLStereo/StGLTileAtlas.h>
 
 #include <StGL/StParams.h>
 
@@ -303,6 +304,32 @@ class StGLImageRegion : public StGLWidget {
 
     ST_LOCAL void stglDrawView(unsigned int theView);
 
+    /**
+     * Pick up the tiles source of the front image, upload generated tiles
+     * and request the tiles missed within the previous frame.
+     */
+    ST_LOCAL void stglUpdateTiles();
+
+    /**
+     * Draw full-resolution tiles over the downscaled image in flat mode.
+     * @param theCtx          active context
+     * @param theView         tiles view (0 for left and 1 for right texture)
+     * @param theProjMat      projection matrix
+     * @param theModelMat     model matrix of the image quad
+     * @param theFrameRectPx  viewport rectangle
+     * @param theTexSizePx    dimensions of the image within the main texture
+     * @param theColorScale   de-anaglyph color filter
+     * @param theToUseNearest use nearest texture filter
+     */
+    ST_LOCAL void stglDrawTiles(StGLContext&      theCtx,
+                                const int         theView,
+                                const StGLMatrix& theProjMat,
+                                const StGLMatrix& theModelMat,
+                                const StRectI_t&  theFrameRectPx,
+                                const StGLVec2&   theTexSizePx,
+                                const StGLVec3&   theColorScale,
+                                const bool        theToUseNearest);
+
         private: //! @name private fields
 
     StArrayList< StHandle<StAction> >
@@ -312,6 +339,10 @@ class StGLImageRegion : public StGLWidget {
     StGLUVSphere               myUVSphere;       //!< sphere output helper class
     StGLProjCamera             myProjCam;        //!< copy of projection camera
     StGLImageProgram           myProgram;        //!< GL program to draw flat image
+    StGLImageProgram           myTileProgram;    //!< GL program to draw full-resolution tiles
+    StGLTileAtlas              myTileAtlas;      //!< texture atlas for full-resolution tiles
+    StHandle<StImageTiles>     myTiles;          //!< full-resolution tiles source of the shown image
+    std::vector<StImageTileKey> myTileRequests;  //!< tiles missed within current frame
     StHandle<StGLTextureQueue> myTextureQueue;   //!< shared texture queue
     StPointD_t                 myClickPntZo;     //!< remembered mouse click position
     StTimer                    myClickTimer;     //!< timer to delay dragging action
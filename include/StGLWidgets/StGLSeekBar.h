@@ -1,6 +1,6 @@
 /**
  * StGLWidgets, small C++ toolkit for writing GUI using OpenGL.
- * Copyright © 2009-2016 Kirill Gavrilov <kirill@sview.ru>
+ * Copyright © 2009-2017 Kirill Gavrilov <kirill@sview.ru>
  *
  * Distributed under the Boost Software License, Version 1.0.
  * See accompanying file license-boost.txt or copy at
@@ -11,7 +11,9 @@
 #define __StGLSeekBar_h_
 
 #include <StGLWidgets/StGLWidget.h>
+#include <StGL/StGLTexture.h>
 #include <StGL/StGLVertexBuffer.h>
+#include <StImage/StImagePlane.h>
 
 /**
  * Simple seeking bar widget.
@@ -44,6 +46,23 @@ class StGLSeekBar : public StGLWidget {
         myMoveTolerPx = theTolerPx;
     }
 
+    /**
+     * @return position under cursor from 0.0 to 1.0 while the bar is hovered or dragged, or -1.0 otherwise
+     */
+    ST_LOCAL double getPreviewProgress() const {
+        return myPreviewPos;
+    }
+
+    /**
+     * Set preview image to be shown above the cursor while the bar is hovered or dragged.
+     * The texture is uploaded only when another image is specified,
+     * so that single image (atlas) with many previews can be shared.
+     * @param theImage RGB image with preview, NULL to hide preview
+     * @param theCell  preview rectangle within the image
+     */
+    ST_CPPEXPORT void setPreview(const StHandle<StImagePlane>& theImage,
+                                 const StRectI_t&              theCell);
+
     ST_CPPEXPORT virtual void stglResize() ST_ATTR_OVERRIDE;
     ST_CPPEXPORT virtual bool stglInit() ST_ATTR_OVERRIDE;
     ST_CPPEXPORT virtual void stglUpdate(const StPointD_t& theCursor,
@@ -77,6 +96,7 @@ class StGLSeekBar : public StGLWidget {
 
     ST_LOCAL void stglUpdateVertices();
     ST_LOCAL double getPointInEx(const StPointD_t& thePointZo) const;
+    ST_LOCAL void stglDrawPreview(StGLContext& theCtx);
 
         private:
 
@@ -90,6 +110,16 @@ class StGLSeekBar : public StGLWidget {
     int                   myClickPos;
     int                   myMoveTolerPx;
 
+    class StPreviewProgram;
+    StHandle<StPreviewProgram> myPreviewProgram;  //!< GLSL program for preview
+    StGLVertexBuffer       myPreviewVertices;     //!< preview vertices VBO
+    StGLVertexBuffer       myPreviewTCoords;      //!< preview texture coordinates VBO
+    StGLTexture            myPreviewTexture;      //!< texture with preview image
+    StHandle<StImagePlane> myPreviewTextureImage; //!< image uploaded into texture
+    StHandle<StImagePlane> myPreviewImage;        //!< image with preview
+    StRectI_t              myPreviewCell;         //!< preview rectangle within the image
+    double                 myPreviewPos;          //!< position under cursor or -1.0
+
 };
 
 #endif // __StGLSeekBar_h_
@@ -1,5 +1,5 @@
 /**
- * Copyright © 2010-2015 Kirill Gavrilov <kirill@sview.ru>
+ * Copyright © 2010-2017 Kirill Gavrilov <kirill@sview.ru>
  *
  * Distributed under the Boost Software License, Version 1.0.
  * See accompanying file license-boost.txt or copy at
@@ -108,8 +108,13 @@ class StImage {
     /**
      * Initialize as wrapper of input data in RGB format
      * or tries to convert data to RGB.
+     * Planar YUV (4:4:4, 4:2:2, 4:2:0 and others, 8/9/10/16 bits, MPEG or full range) and NV12 images
+     * are converted into 8-bit RGB using several threads.
+     * @param theCopy      source image
+     * @param theNbThreads maximum number of threads for YUV conversion, 0 means number of logical processors
      */
-    ST_CPPEXPORT bool initRGB(const StImage& theCopy);
+    ST_CPPEXPORT bool initRGB(const StImage& theCopy,
+                              const int      theNbThreads = 0);
 
     /**
      * Method initialize the cross-eyed stereoscopic image.
@@ -278,6 +283,13 @@ class StImage {
      */
     ST_LOCAL void setBufferCounter(const StHandle<StBufferCounter>& theCounter) { myBufCounter = theCounter; }
 
+    /**
+     * Decode single pixel of YUV image (any layout supported by initRGB()) into RGB pixel.
+     * This is slow per-pixel reference for initRGB() conversion.
+     */
+    ST_CPPEXPORT StPixelRGB getRGBFromYUV(const size_t theRow,
+                                          const size_t theCol) const;
+
         protected:
 
     ST_LOCAL inline StString getDescription() const {
@@ -288,12 +300,6 @@ class StImage {
 
         private:
 
-    /**
-     * Decode yuv420p pixel into RGB pixel.
-     */
-    ST_CPPEXPORT StPixelRGB getRGBFromYUV(const size_t theRow,
-                                          const size_t theCol) const;
-
     inline float getScaleFactorX(const size_t thePlane) const {
         return float(getPlane(thePlane).getSizeX()) / float(getPlane(0).getSizeX());
     }
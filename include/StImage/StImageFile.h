@@ -111,6 +111,32 @@ class StImageFile : public StImage {
         return mySrcFormat;
     }
 
+    /**
+     * Set the dimensions limits the image will be fitted into (preserving aspect ratio) after decoding.
+     * Decoders supporting reduced-resolution decoding (JPEG DCT scaling, JPEG2000 resolution levels, WebP scaling)
+     * will downscale the image by power-of-two factor at decoding time as long as the result is not smaller than the fitted image.
+     * Zero dimensions (default) disable reduced-resolution decoding.
+     */
+    ST_LOCAL void setSizeHint(const size_t theSizeX,
+                              const size_t theSizeY) {
+        mySizeHintX = theSizeX;
+        mySizeHintY = theSizeY;
+    }
+
+    /**
+     * Return the image width stored in the file, which is larger than decoded one when reduced-resolution decoding has been applied.
+     */
+    ST_LOCAL size_t getSrcSizeX() const {
+        return mySrcSizeX != 0 ? mySrcSizeX : getSizeX();
+    }
+
+    /**
+     * Return the image height stored in the file, which is larger than decoded one when reduced-resolution decoding has been applied.
+     */
+    ST_LOCAL size_t getSrcSizeY() const {
+        return mySrcSizeY != 0 ? mySrcSizeY : getSizeY();
+    }
+
     /**
      * Returns the number of frames in multi-page image.
      */
@@ -163,9 +189,43 @@ class StImageFile : public StImage {
 
         protected:
 
+    /**
+     * Compute the reduction for decoding the image of specified dimensions according to size hint.
+     * @param theSizeX   image width stored in the file
+     * @param theSizeY   image height stored in the file
+     * @param theMaxLog2 maximum reduction level supported by decoder
+     * @return reduction level (image should be downscaled by 2^level), 0 for full resolution
+     */
+    ST_LOCAL int getReductionLevel(const size_t theSizeX,
+                                   const size_t theSizeY,
+                                   const int    theMaxLog2) const {
+        if(mySizeHintX == 0
+        || mySizeHintY == 0
+        || theSizeX == 0
+        || theSizeY == 0) {
+            return 0;
+        }
+
+        // scale factor to fit the image into limits
+        const double aFitScale = stMin(double(mySizeHintX) / double(theSizeX),
+                                       double(mySizeHintY) / double(theSizeY));
+        int aLevel = 0;
+        while(aLevel < theMaxLog2
+           && double(1 << (aLevel + 1)) * aFitScale <= 1.0) {
+            ++aLevel;
+        }
+        return aLevel;
+    }
+
+        protected:
+
     StDictionary myMetadata;
     StString     myStateDescr;
     StFormat     mySrcFormat;
+    size_t       mySizeHintX; //!< width  limit the image will be fitted into after decoding
+    size_t       mySizeHintY; //!< height limit the image will be fitted into after decoding
+    size_t       mySrcSizeX;  //!< image width in the file when reduced-resolution decoding has been applied, 0 otherwise
+    size_t       mySrcSizeY;  //!< image height in the file when reduced-resolution decoding has been applied, 0 otherwise
 
 };
 
@@ -0,0 +1,218 @@
+/**
+ * Copyright © 2017 Kirill Gavrilov <kirill@sview.ru>
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * See accompanying file license-boost.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt
+ */
+
+#ifndef __StImageTiles_h_
+#define __StImageTiles_h_
+
+#include <StImage/StImage.h>
+#include <StGL/StParams.h>
+#include <StTemplates/StRect.h>
+#include <StThreads/StCondition.h>
+#include <StThreads/StMutex.h>
+#include <StThreads/StThread.h>
+
+#include <vector>
+
+class StAVScaler;
+
+/**
+ * Identifier of the tile within the tiles pyramid.
+ */
+struct StImageTileKey {
+
+    int View;  //!< view index (0 for left texture, 1 for right texture)
+    int Level; //!< pyramid level, 0 for full resolution, each next level halves the resolution
+    int Col;   //!< tile column within the level
+    int Row;   //!< tile row    within the level
+
+    StImageTileKey() : View(0), Level(0), Col(0), Row(0) {}
+
+    StImageTileKey(const int theView,
+                   const int theLevel,
+                   const int theCol,
+                   const int theRow)
+    : View(theView), Level(theLevel), Col(theCol), Row(theRow) {}
+
+    bool operator==(const StImageTileKey& theOther) const {
+        return View  == theOther.View
+            && Level == theOther.Level
+            && Col   == theOther.Col
+            && Row   == theOther.Row;
+    }
+
+    bool operator!=(const StImageTileKey& theOther) const {
+        return !operator==(theOther);
+    }
+
+};
+
+/**
+ * Generated tile.
+ */
+struct StImageTile {
+
+    StImageTileKey    Key;   //!< tile identifier
+    StHandle<StImage> Image; //!< RGBA image of (TILE_SIZE + 2) x (TILE_SIZE + 2) pixels, tile data starts at (1, 1)
+    int               SizeX; //!< tile width  (less than TILE_SIZE for the last column)
+    int               SizeY; //!< tile height (less than TILE_SIZE for the last row)
+
+    StImageTile() : SizeX(0), SizeY(0) {}
+
+};
+
+/**
+ * Source of full-resolution tiles for the image which does not fit into texture.
+ * Each view (left / right texture) is defined by the decoded image and the rectangle within it
+ * (e.g. half of side-by-side pair).
+ * Tiles of the pyramid are generated on demand by worker threads from the full-resolution image
+ * and converted into RGBA with 1 pixel border taken from neighbors,
+ * so that filtering within the texture atlas produces no seams.
+ * Pyramid levels are not stored - tiles of coarse levels are downscaled directly from the full-resolution image,
+ * which is affordable since only levels exceeding the base texture size are requested (usually 0 and 1).
+ */
+class StImageTiles {
+
+        public:
+
+    enum {
+        TILE_SIZE   = 256, //!< tile dimensions in pixels (without border)
+        TILE_BORDER = 1,   //!< border taken from neighbor tiles
+    };
+
+        public:
+
+    /**
+     * Main constructor.
+     * @param theSource stereo parameters of the image (to match the image shown)
+     * @param theImageL full-resolution image for the left  texture
+     * @param theRectL  view rectangle within the left image
+     * @param theImageR full-resolution image for the right texture, might be NULL
+     * @param theRectR  view rectangle within the right image
+     */
+    ST_CPPEXPORT StImageTiles(const StHandle<StStereoParams>& theSource,
+                              const StHandle<StImage>&        theImageL,
+                              const StRectI_t&                theRectL,
+                              const StHandle<StImage>&        theImageR,
+                              const StRectI_t&                theRectR);
+
+    /**
+     * Destructor, stops worker threads.
+     */
+    ST_CPPEXPORT ~StImageTiles();
+
+    /**
+     * @return stereo parameters of the image
+     */
+    ST_LOCAL const StHandle<StStereoParams>& getSource() const {
+        return mySource;
+    }
+
+    /**
+     * @return true if specified view is defined
+     */
+    ST_LOCAL bool hasView(const int theView) const {
+        return theView >= 0 && theView < 2
+           && !myViews[theView].Image.isNull();
+    }
+
+    /**
+     * @return full-resolution width of the view
+     */
+    ST_LOCAL int getSizeX(const int theView) const {
+        return myViews[theView].Rect.width();
+    }
+
+    /**
+     * @return full-resolution height of the view
+     */
+    ST_LOCAL int getSizeY(const int theView) const {
+        return myViews[theView].Rect.height();
+    }
+
+    /**
+     * @return width of the view at specified pyramid level
+     */
+    ST_LOCAL int getLevelSizeX(const int theView,
+                               const int theLevel) const {
+        return (getSizeX(theView) + (1 << theLevel) - 1) >> theLevel;
+    }
+
+    /**
+     * @return height of the view at specified pyramid level
+     */
+    ST_LOCAL int getLevelSizeY(const int theView,
+                               const int theLevel) const {
+        return (getSizeY(theView) + (1 << theLevel) - 1) >> theLevel;
+    }
+
+    /**
+     * Replace the list of wanted tiles (sorted by priority).
+     * Tiles which are already generated or being generated are ignored,
+     * pending tiles which are not in the new list are cancelled.
+     */
+    ST_CPPEXPORT void request(const std::vector<StImageTileKey>& theKeys);
+
+    /**
+     * Retrieve the next generated tile.
+     * @return false if there are no generated tiles
+     */
+    ST_CPPEXPORT bool pop(StImageTile& theTile);
+
+        private:
+
+    /**
+     * View definition.
+     */
+    struct View {
+        StHandle<StImage> Image; //!< full-resolution image
+        StRectI_t         Rect;  //!< view rectangle within the image
+    };
+
+    /**
+     * Generate the tile.
+     */
+    ST_LOCAL bool generate(const StImageTileKey& theKey,
+                           StImageTile&          theTile,
+                           StAVScaler&           theScaler) const;
+
+    /**
+     * @return true if the tile is pending, being generated or generated
+     */
+    ST_LOCAL bool isKnown(const StImageTileKey& theKey) const;
+
+    /**
+     * Worker thread loop.
+     */
+    ST_LOCAL void workerLoop();
+
+    /**
+     * Worker thread function.
+     */
+    ST_LOCAL static SV_THREAD_FUNCTION workerThreadFunction(void* theTiles);
+
+        private:
+
+    StHandle<StStereoParams>         mySource;     //!< stereo parameters of the image
+    View                             myViews[2];   //!< views definition
+    mutable StMutex                  myMutex;      //!< lock for the lists below
+    StCondition                      myEventJob;   //!< event signaled when there are pending tiles
+    std::vector<StImageTileKey>      myPending;    //!< wanted tiles, first has the highest priority
+    std::vector<StImageTileKey>      myInProgress; //!< tiles being generated
+    std::vector<StImageTile>         myReady;      //!< generated tiles
+    std::vector< StHandle<StThread> > myThreads;   //!< worker threads
+    volatile bool                    myHasFailed;  //!< tile generation has failed, further requests are ignored
+    volatile bool                    myToQuit;     //!< flag to stop workers
+
+        private: //! @name no copies, please
+
+    StImageTiles(const StImageTiles& theCopy);
+    const StImageTiles& operator=(const StImageTiles& theCopy);
+
+};
+
+#endif // __StImageTiles_h_
@@ -16,6 +16,7 @@
 
 // forward declarations
 class StMutexSlim;
+class StLogWriter;
 
 /**
  * Logging context identifier.
@@ -70,9 +71,11 @@ class StLogger {
     } Level;
 
     enum {
-        ST_OPT_NONE = 0x00, //!< no options
-        ST_OPT_COUT = 0x01, //!< (additionally) write into standard streams std::cerr and std::cout.
-        ST_OPT_LOCK = 0x02, //!< use mutex to ensure thread-safety
+        ST_OPT_NONE  = 0x00, //!< no options
+        ST_OPT_COUT  = 0x01, //!< (additionally) write into standard streams std::cerr and std::cout.
+        ST_OPT_LOCK  = 0x02, //!< use mutex to ensure thread-safety
+        ST_OPT_ASYNC = 0x04, //!< keep log file opened and write it from background thread,
+                             //!  messages with ST_ERROR and higher severity are flushed immediately
     };
 
         public:
@@ -119,6 +122,7 @@ class StLogger {
         private:
 
     StHandle<StMutexSlim> myMutex;         //!< mutex lock for thread-safety
+    StHandle<StLogWriter> myWriter;        //!< asynchronous log file writer (ST_OPT_ASYNC)
 #ifdef _WIN32
     StStringUtfWide       myFilePath;      //!< file to write into
 #else
@@ -1,5 +1,5 @@
 /**
- * Copyright © 2009-2011 Kirill Gavrilov <kirill@sview.ru>
+ * Copyright © 2009-2017 Kirill Gavrilov <kirill@sview.ru>
  *
  * Distributed under the Boost Software License, Version 1.0.
  * See accompanying file license-boost.txt or copy at
@@ -15,6 +15,11 @@ namespace stUtfTools {
 
     ST_CPPEXPORT bool isInteger(const StString& theString);
 
+    /**
+     * Escape string for embedding into JSON string literal (quotes, backslashes and control characters).
+     */
+    ST_CPPEXPORT StString escapeJson(const StString& theString);
+
 };
 
 #endif //__stUtfTools_h__
@@ -104,7 +104,8 @@ class StArrayList : public StArray<Element_t> {
      */
     StArrayList& add(const size_t theIndex, const Element_t& theElement) {
         if(theIndex >= mySizeMax) {
-            size_t aNewSize = getAligned(theIndex + 7); // increment with 8 elements...
+            // grow geometrically to keep sequential add() amortized O(1)
+            size_t aNewSize = getAligned(stMax(theIndex + 7, mySizeMax * 2));
             Element_t* aNewArray = new Element_t[aNewSize];
             for(size_t anElem = 0; anElem < mySizeMax; ++anElem) {
                 aNewArray[anElem] = StArray<Element_t>::myArray[anElem];
@@ -93,6 +93,79 @@ class StAtomicOp {
         return (uint32_t )Decrement((volatile int32_t& )theValue);
     }
 
+    /**
+     * Read the value with acquire semantics,
+     * so that memory reads following this call are not reordered before it.
+     * @param theValue (const volatile int32_t& ) - input value;
+     * @return current value.
+     */
+    static inline int32_t Load(const volatile int32_t& theValue) {
+    #if defined(__GNUC__) && defined(__ATOMIC_ACQUIRE)
+        // g++ compiler
+        return __atomic_load_n(&theValue, __ATOMIC_ACQUIRE);
+    #elif defined(_WIN32)
+        const int32_t aValue = theValue;
+        MemoryBarrier();
+        return aValue;
+    #elif defined(__APPLE__)
+        const int32_t aValue = theValue;
+        OSMemoryBarrier();
+        return aValue;
+    #elif defined(__GNUC__)
+        const int32_t aValue = theValue;
+        __sync_synchronize();
+        return aValue;
+    #else
+        #error "Atomic operation doesn't implemented for current platform!"
+        return theValue;
+    #endif
+    }
+
+    /**
+     * Write the value with release semantics,
+     * so that memory writes preceding this call are visible before the new value.
+     * @param theValue (volatile int32_t& ) - value to modify;
+     * @param theNewValue (const int32_t )  - new value.
+     */
+    static inline void Store(volatile int32_t& theValue,
+                             const int32_t     theNewValue) {
+    #if defined(__GNUC__) && defined(__ATOMIC_RELEASE)
+        // g++ compiler
+        __atomic_store_n(&theValue, theNewValue, __ATOMIC_RELEASE);
+    #elif defined(_WIN32)
+        MemoryBarrier();
+        theValue = theNewValue;
+    #elif defined(__APPLE__)
+        OSMemoryBarrier();
+        theValue = theNewValue;
+    #elif defined(__GNUC__)
+        __sync_synchronize();
+        theValue = theNewValue;
+    #else
+        #error "Atomic operation doesn't implemented for current platform!"
+        theValue = theNewValue;
+    #endif
+    }
+
+    /**
+     * Read the value with acquire semantics.
+     * @param theValue (const volatile uint32_t& ) - input value;
+     * @return current value.
+     */
+    static inline uint32_t Load(const volatile uint32_t& theValue) {
+        return (uint32_t )Load((const volatile int32_t& )theValue);
+    }
+
+    /**
+     * Write the value with release semantics.
+     * @param theValue (volatile uint32_t& ) - value to modify;
+     * @param theNewValue (const uint32_t )  - new value.
+     */
+    static inline void Store(volatile uint32_t& theValue,
+                             const uint32_t     theNewValue) {
+        Store((volatile int32_t& )theValue, (int32_t )theNewValue);
+    }
+
     // int64_t, actually available on win32 too, but since WinNT 5.2 (Windows XP x64)
 #if (defined(_WIN64) || defined(__WIN64__))\
  || (defined(_LP64)  || defined(__LP64__))
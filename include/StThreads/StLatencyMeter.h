@@ -0,0 +1,170 @@
+/**
+ * Copyright © 2017 Kirill Gavrilov <kirill@sview.ru>
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * See accompanying file license-boost.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt
+ */
+
+#ifndef __StLatencyMeter_h_
+#define __StLatencyMeter_h_
+
+#include <StStrings/StString.h>
+#include <StThreads/StMutexSlim.h>
+
+/**
+ * Collects per-stage latency histograms of the video playback pipeline.
+ * Samples are put into log-linear buckets (64 sub-buckets per power of two, ~1.5% relative error),
+ * so that memory usage is constant regardless of the number of frames.
+ * Methods are thread-safe - stages are usually measured by different threads (demuxer, decoder, GL).
+ */
+class StLatencyMeter {
+
+        public:
+
+    /**
+     * Pipeline stage.
+     */
+    enum Stage {
+        Stage_Demux = 0, //!< packet reading from container
+        Stage_Decode,    //!< frame decoding
+        Stage_Convert,   //!< pixel format conversion / frame preparation
+        Stage_Push,      //!< frame push into the texture queue (including copy)
+        Stage_Upload,    //!< texture upload from the queue
+        Stage_Swap,      //!< time between finished upload and frame presentation
+        Stage_NB
+    };
+
+    /**
+     * Stage statistics, in milliseconds.
+     */
+    struct Summary {
+        uint64_t NbSamples;
+        double   Min;
+        double   Avg;
+        double   P50;
+        double   P99;
+        double   Max;
+    };
+
+    /**
+     * Return stage name.
+     */
+    ST_CPPEXPORT static const char* getStageName(const Stage theStage);
+
+        public:
+
+    /**
+     * Empty constructor.
+     */
+    ST_CPPEXPORT StLatencyMeter();
+
+    /**
+     * @return true if measurements are enabled
+     */
+    ST_LOCAL bool isEnabled() const {
+        return myIsEnabled;
+    }
+
+    /**
+     * Enable/disable measurements, collected statistics are reset on enabling.
+     */
+    ST_CPPEXPORT void setEnabled(const bool theToEnable);
+
+    /**
+     * Reset collected statistics.
+     */
+    ST_CPPEXPORT void reset();
+
+    /**
+     * Put new sample (does nothing if meter is disabled).
+     * @param theStage    pipeline stage
+     * @param theMicroSec stage duration in microseconds
+     */
+    ST_CPPEXPORT void addSample(const Stage  theStage,
+                                const double theMicroSec);
+
+    /**
+     * Increment dropped frames counter (does nothing if meter is disabled).
+     */
+    ST_CPPEXPORT void addDropped(const size_t theNbFrames);
+
+    /**
+     * @return number of dropped frames
+     */
+    ST_CPPEXPORT uint64_t getDropped() const;
+
+    /**
+     * Compute statistics for specified stage.
+     */
+    ST_CPPEXPORT Summary getSummary(const Stage theStage) const;
+
+    /**
+     * Format report in JSON format.
+     * @param theTitle report title (e.g. file name)
+     */
+    ST_CPPEXPORT StString formatJson(const StString& theTitle) const;
+
+    /**
+     * Format report in CSV format (one line per stage).
+     * @param theTitle report title (e.g. file name)
+     */
+    ST_CPPEXPORT StString formatCsv(const StString& theTitle) const;
+
+    /**
+     * Save report into the file.
+     * JSON format is used for files with .json extension and CSV otherwise.
+     */
+    ST_CPPEXPORT bool saveReport(const StString& thePath,
+                                 const StString& theTitle) const;
+
+        private:
+
+    enum {
+        THE_SUB_BUCKETS_LOG2 = 6,
+        THE_SUB_BUCKETS      = 1 << THE_SUB_BUCKETS_LOG2,
+        THE_NB_BUCKETS       = THE_SUB_BUCKETS * 34
+    };
+
+    /**
+     * Histogram of single stage.
+     */
+    struct Histogram {
+        uint32_t Buckets[THE_NB_BUCKETS];
+        uint64_t NbSamples;
+        double   Sum;
+        double   Min;
+        double   Max;
+    };
+
+    /**
+     * Return bucket index for specified value in microseconds.
+     */
+    ST_LOCAL static size_t bucketIndex(const uint64_t theMicroSec);
+
+    /**
+     * Return the lowest value in microseconds within the bucket.
+     */
+    ST_LOCAL static uint64_t bucketLowerBound(const size_t theIndex);
+
+    /**
+     * Find the value for specified quantile.
+     */
+    ST_LOCAL static double quantile(const Histogram& theHist,
+                                    const double     theQuantile);
+
+        private:
+
+    mutable StMutexSlim myMutex;             //!< lock for histograms
+    Histogram           myStages[Stage_NB];  //!< per-stage histograms
+    uint64_t            myNbDropped;         //!< dropped frames counter
+    volatile bool       myIsEnabled;         //!< measurements flag
+
+        private: //! @name no copies, please
+
+    StLatencyMeter(const StLatencyMeter& theCopy);
+    const StLatencyMeter& operator=(const StLatencyMeter& theCopy);
+
+};
+
+#endif // __StLatencyMeter_h_
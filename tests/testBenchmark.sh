@@ -0,0 +1,23 @@
+#!/usr/bash
+
+# This is test script plays video files in benchmark mode (as fast as possible, without vsync)
+# and collects per-stage latency reports (demux, decode, convert, push, upload, swap).
+# $StCore environment variable should be set before to the sView path.
+# Usage: bash testBenchmark.sh video1.mkv [video2.mkv ...]
+
+rm -f testBenchmark.log
+aReportIter=1
+for aVideo in "$@"
+do
+  aReport="testBenchmark_$aReportIter.json"
+  rm -f "$aReport"
+  echo " -=- Benchmark TEST. $aVideo -=- " | tee -a testBenchmark.log
+  bash timeout.sh -t 600 "$StCore/sView" --in=StMoviePlayer --out=StOutAnaglyph --viewMode=flat --benchmarkReport="$PWD/$aReport" - "$aVideo" &>> testBenchmark.log
+  if [ -f "$aReport" ]; then
+    cat "$aReport" | tee -a testBenchmark.log
+  else
+    echo "Error: benchmark report has not been created" | tee -a testBenchmark.log
+  fi
+  aReportIter=`expr $aReportIter + 1`;
+done
+echo " -=- Benchmark TEST finished -=- " >> testBenchmark.log